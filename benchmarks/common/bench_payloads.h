@@ -0,0 +1,133 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef BENCH_PAYLOADS_H
+#define BENCH_PAYLOADS_H
+
+#include "dtkaitypes.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+// Daemon replies and requests shaped like the real ones, built outside of the measured loops.
+namespace BenchPayloads {
+
+// About bytes UTF-8 bytes of mixed English and Chinese words, different for each seed.
+inline QString text(int bytes, int seed = 0)
+{
+    static const QStringList words {
+        "the", "desktop", "model", "session", "window", "桌面", "模型", "系统", "文件", "设置",
+        "resolution", "display", "network", "深度", "搜索", "document", "index", "chunk", "语音", "识别"
+    };
+    QString result;
+    int size = 0;
+    for (int i = seed; size < bytes; ++i) {
+        const QString &word = words.at(i % words.size());
+        result += word;
+        result += QLatin1Char(' ');
+        size += word.toUtf8().size() + 1;
+    }
+    return result;
+}
+
+inline QString compact(const QJsonObject &obj)
+{
+    return QString::fromUtf8(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+}
+
+// Alternating user and assistant turns of about bytes each.
+inline QList<DAI_NAMESPACE::ChatHistory> chatHistory(int messages, int bytes)
+{
+    QList<DAI_NAMESPACE::ChatHistory> history;
+    for (int i = 0; i < messages; ++i)
+        history.append({ i % 2 ? DAI_NAMESPACE::kChatRoleAssistant : DAI_NAMESPACE::kChatRoleUser, text(bytes, i) });
+    return history;
+}
+
+inline QVariantHash chatParams()
+{
+    return { { "model", "deepseek-chat" }, { "temperature", 0.7 }, { "max_tokens", 2048 }, { "stream", true } };
+}
+
+// Reply of EmbeddingPlatform.search.
+inline QString searchReply(int hits, int chunkBytes)
+{
+    const QString timestamp = QDateTime(QDate(2025, 6, 1), QTime(12, 0)).toString(Qt::ISODate);
+    QJsonArray results;
+    for (int i = 0; i < hits; ++i) {
+        const QJsonObject chunk {
+            { "chunk_index", i },
+            { "content", text(chunkBytes, i) },
+            { "tokens", chunkBytes / 4 },
+            { "timestamp", QJsonArray { timestamp } },
+        };
+        results.append(QJsonObject {
+            { "id", QString("doc_%1").arg(i % 50) },
+            { "model", "bge-large-zh" },
+            { "distance", 0.1 + i * 0.001 },
+            { "chunk", chunk },
+        });
+    }
+    return compact({ { "results", results } });
+}
+
+// Reply of EmbeddingPlatform.documentsInfo.
+inline QString documentsInfoReply(int documents)
+{
+    const QString created = QDateTime(QDate(2025, 6, 1), QTime(12, 0)).toString(Qt::ISODate);
+    QJsonArray results;
+    for (int i = 0; i < documents; ++i) {
+        results.append(QJsonObject {
+            { "id", QString("doc_%1").arg(i) },
+            { "file_path", QString("/home/user/Documents/report-%1.pdf").arg(i) },
+            { "created_at", created },
+            { "metadata", QJsonObject { { "source", "upload" }, { "pages", 12 + i % 30 }, { "language", "zh_CN" } } },
+        });
+    }
+    return compact({ { "results", results } });
+}
+
+// Reply of EmbeddingPlatform.uploadDocuments.
+inline QString uploadReply(int documents)
+{
+    QJsonArray results;
+    for (int i = 0; i < documents; ++i)
+        results.append(QJsonObject { { "documentID", QString("doc_%1").arg(i) },
+                                     { "file", QString("/home/user/Documents/report-%1.pdf").arg(i) } });
+    return compact({ { "results", results } });
+}
+
+inline QJsonObject model(int i)
+{
+    static const QStringList capabilities {
+        "Chat", "FunctionCalling", "SpeechToText", "TextToSpeech", "ImageRecognition", "OCR", "Embedding"
+    };
+    const QString capability = capabilities.at(i % capabilities.size());
+    return {
+        { "name", QString("%1-model-%2").arg(capability.toLower()).arg(i) },
+        { "provider", QString("provider%1").arg(i % 4) },
+        { "description", text(160, i) },
+        { "capability", capability },
+        { "isAvailable", i % 5 != 4 },
+        { "deployType", i % 2 ? "Cloud" : "Local" },
+        { "parameters", QJsonObject { { "temperature", 0.7 }, { "max_tokens", 4096 }, { "context_length", 32768 },
+                                      { "top_p", 0.9 } } },
+    };
+}
+
+// Reply of ModelInfo.GetAllModels.
+inline QString modelCatalog(int models)
+{
+    QJsonArray array;
+    for (int i = 0; i < models; ++i)
+        array.append(model(i));
+    return compact({ { "models", array } });
+}
+
+} // namespace BenchPayloads
+
+#endif // BENCH_PAYLOADS_H
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+#
+# SPDX-License-Identifier: LGPL-3.0-or-later
+
+"""Runs the dtkai benchmarks and compares them with a baseline.
+
+    compare.py run BUILD_DIR [-o results.json] [--baseline baseline.json] [--repeat N] [-- qtest options]
+    compare.py compare baseline.json results.json [--threshold PCT]
+
+"run" executes every bench-* executable of BUILD_DIR/benchmarks with QtTest's
+XML output and keeps the median of --repeat runs per case. Options after "--"
+go to the executables, e.g. -callgrind or -perf for steadier numbers than
+wall time. A saved result serves as the baseline of later runs.
+
+"compare" prints the change of every case and exits with 1 when one got
+slower by more than --threshold percent. Cases missing from the baseline, or
+that were measured with another metric, are listed without judging them. It
+exits with 2 when no case could be judged at all, a baseline that compares
+nothing must not pass.
+"""
+
+import argparse
+import json
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import tempfile
+import xml.etree.ElementTree as ElementTree
+
+
+def find_benchmarks(build_dir):
+    found = []
+    for root, _, files in os.walk(os.path.join(build_dir, "benchmarks")):
+        for name in files:
+            path = os.path.join(root, name)
+            if name.startswith("bench-") and os.access(path, os.X_OK) and os.path.isfile(path):
+                found.append(path)
+    return sorted(found)
+
+
+def parse_qtest_xml(path):
+    """Returns {case: (metric, value per iteration, iterations)} and the failed functions."""
+    tree = ElementTree.parse(path)
+    root = tree.getroot()
+    test_case = root.get("name", os.path.basename(path))
+    results, failures = {}, []
+    for function in root.iter("TestFunction"):
+        name = function.get("name")
+        for incident in function.iter("Incident"):
+            if incident.get("type") in ("fail", "xpass"):
+                failures.append("%s::%s" % (test_case, name))
+        for result in function.iter("BenchmarkResult"):
+            tag = result.get("tag")
+            case = "%s::%s" % (test_case, name) + ("/" + tag if tag else "")
+            results[case] = (result.get("metric"), float(result.get("value")), int(result.get("iterations")))
+    return results, failures
+
+
+def run_once(executable, qtest_args):
+    with tempfile.TemporaryDirectory() as tmp:
+        output = os.path.join(tmp, "result.xml")
+        process = subprocess.run([executable, "-o", output + ",xml"] + qtest_args,
+                                 stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, universal_newlines=True)
+        if not os.path.exists(output):
+            sys.exit("%s produced no results:\n%s" % (executable, process.stderr))
+        results, failures = parse_qtest_xml(output)
+    if process.returncode != 0 or failures:
+        sys.exit("%s failed: %s\n%s" % (executable, ", ".join(failures), process.stderr))
+    return results
+
+
+def run(args):
+    benchmarks = find_benchmarks(args.build_dir)
+    if not benchmarks:
+        sys.exit("No bench-* executables under %s, configure with -DBUILD_BENCHMARKS=ON"
+                 % os.path.join(args.build_dir, "benchmarks"))
+
+    samples = {}
+    for executable in benchmarks:
+        for _ in range(args.repeat):
+            print("running %s" % os.path.basename(executable), file=sys.stderr)
+            for case, (metric, value, iterations) in run_once(executable, args.qtest_args).items():
+                samples.setdefault(case, (metric, [], iterations))[1].append(value)
+
+    results = {
+        "context": {
+            "machine": platform.machine(),
+            "system": platform.platform(),
+            "repeat": args.repeat,
+            "options": args.qtest_args,
+        },
+        "results": {case: {"metric": metric, "value": statistics.median(values), "iterations": iterations}
+                    for case, (metric, values, iterations) in sorted(samples.items())},
+    }
+
+    text = json.dumps(results, indent=4, ensure_ascii=False) + "\n"
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            f.write(text)
+    elif not args.baseline:
+        sys.stdout.write(text)
+
+    if args.baseline:
+        with open(args.baseline, encoding="utf-8") as f:
+            return report(json.load(f), results, args.threshold)
+    return 0
+
+
+def report(baseline, current, threshold):
+    base_results = baseline.get("results", {})
+    current_results = current.get("results", {})
+    regressions = 0
+    judged = 0
+    width = max([len(case) for case in list(base_results) + list(current_results)] + [4])
+    print("%-*s %14s %14s %9s" % (width, "case", "baseline", "current", "change"))
+    for case in sorted(set(base_results) | set(current_results)):
+        base = base_results.get(case)
+        cur = current_results.get(case)
+        if cur is None:
+            print("%-*s %14s %14s %9s" % (width, case, fmt(base), "-", "missing"))
+            continue
+        if base is None or base.get("value") is None:
+            print("%-*s %14s %14s %9s" % (width, case, "-", fmt(cur), "new"))
+            continue
+        if base.get("metric") != cur.get("metric"):
+            print("%-*s %14s %14s %9s" % (width, case, fmt(base), fmt(cur), "metric"))
+            continue
+
+        judged += 1
+        change = (cur["value"] / base["value"] - 1) * 100 if base["value"] else 0.0
+        verdict = ""
+        if change > threshold:
+            verdict = "  SLOWER"
+            regressions += 1
+        elif change < -threshold:
+            verdict = "  faster"
+        print("%-*s %14s %14s %+8.1f%%%s" % (width, case, fmt(base), fmt(cur), change, verdict))
+
+    if not judged:
+        print("No case of the baseline could be compared")
+        return 2
+    if regressions:
+        print("%d case(s) slower than the baseline by more than %g%%" % (regressions, threshold))
+        return 1
+    return 0
+
+
+def fmt(result):
+    if not result or result.get("value") is None:
+        return "-"
+    units = {"WalltimeMilliseconds": "ms", "CPUTicks": "ticks", "InstructionReads": "instr",
+             "CPUCycles": "cycles", "Events": "events"}
+    return "%.4g %s" % (result["value"], units.get(result["metric"], ""))
+
+
+def compare(args):
+    with open(args.baseline, encoding="utf-8") as f:
+        baseline = json.load(f)
+    with open(args.results, encoding="utf-8") as f:
+        current = json.load(f)
+    return report(baseline, current, args.threshold)
+
+
+def main():
+    argv = sys.argv[1:]
+    qtest_args = []
+    if "--" in argv:
+        qtest_args = argv[argv.index("--") + 1:]
+        argv = argv[:argv.index("--")]
+
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command")
+    commands.required = True
+
+    run_parser = commands.add_parser("run", help="run the benchmarks of a build directory")
+    run_parser.add_argument("build_dir")
+    run_parser.add_argument("-o", "--output", help="write the results here, to stdout without it or --baseline")
+    run_parser.add_argument("--baseline", help="compare the results with this file")
+    run_parser.add_argument("--repeat", type=int, default=3, help="runs per executable, the median is kept")
+    run_parser.add_argument("--threshold", type=float, default=10.0, help="percent slower that fails")
+    run_parser.set_defaults(func=run)
+
+    compare_parser = commands.add_parser("compare", help="compare two result files")
+    compare_parser.add_argument("baseline")
+    compare_parser.add_argument("results")
+    compare_parser.add_argument("--threshold", type=float, default=10.0, help="percent slower that fails")
+    compare_parser.set_defaults(func=compare)
+
+    args = parser.parse_args(argv)
+    args.qtest_args = qtest_args
+    if args.command == "run" and args.repeat < 1:
+        parser.error("--repeat must be at least 1")
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
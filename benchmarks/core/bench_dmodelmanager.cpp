@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "bench_payloads.h"
+
+#include "dmodelmanager_p.h"
+
+#include <QtTest>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Parsing of the model catalog replies of the ModelInfo service
+ */
+class BenchDModelManager : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void parseModelsFromJson_data();
+    void parseModelsFromJson();
+    void parseModelFromJson();
+};
+
+void BenchDModelManager::parseModelsFromJson_data()
+{
+    QTest::addColumn<int>("models");
+    QTest::newRow("16 models") << 16;
+    QTest::newRow("200 models") << 200;
+}
+
+void BenchDModelManager::parseModelsFromJson()
+{
+    QFETCH(int, models);
+    const QString reply = BenchPayloads::modelCatalog(models);
+
+    QList<ModelInfo> infos;
+    QBENCHMARK {
+        infos = DModelManagerPrivate::parseModelsFromJson(reply);
+    }
+    QCOMPARE(infos.size(), models);
+}
+
+void BenchDModelManager::parseModelFromJson()
+{
+    const QString reply = BenchPayloads::compact(BenchPayloads::model(0));
+
+    ModelInfo info;
+    QBENCHMARK {
+        info = DModelManagerPrivate::parseModelFromJson(reply);
+    }
+    QVERIFY(!info.modelName.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(BenchDModelManager)
+
+#include "bench_dmodelmanager.moc"
@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "bench_payloads.h"
+
+#include "nlp/dchatcompletions_p.h"
+#include "nlp/dfunctioncalling_p.h"
+
+#include <QtTest>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Encoding of chat and function calling requests
+ */
+class BenchDChatCompletions : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void packageParamsFirst_data();
+    void packageParamsFirst();
+    void packageParamsNextTurn_data();
+    void packageParamsNextTurn();
+    void parseChatResult_data();
+    void parseChatResult();
+    void functionCallingPackageParams();
+};
+
+static void historySizes()
+{
+    QTest::addColumn<int>("messages");
+    QTest::newRow("10 messages") << 10;
+    QTest::newRow("50 messages") << 50;
+    QTest::newRow("200 messages") << 200;
+}
+
+void BenchDChatCompletions::packageParamsFirst_data()
+{
+    historySizes();
+}
+
+// A conversation none of whose messages were encoded before.
+void BenchDChatCompletions::packageParamsFirst()
+{
+    QFETCH(int, messages);
+    const QList<ChatHistory> history = BenchPayloads::chatHistory(messages, 600);
+    const QVariantHash params = BenchPayloads::chatParams();
+    DChatCompletions chat;
+
+    QString json;
+    QBENCHMARK {
+        chat.d->encodedHistory.clear();
+        chat.d->encodedMessages.clear();
+        json = chat.d->packageParams(history, params);
+    }
+    QVERIFY(json.startsWith("{\"messages\":["));
+}
+
+void BenchDChatCompletions::packageParamsNextTurn_data()
+{
+    historySizes();
+}
+
+// The usual chat, the history of each request is the previous one plus the latest turn.
+void BenchDChatCompletions::packageParamsNextTurn()
+{
+    QFETCH(int, messages);
+    QList<ChatHistory> history = BenchPayloads::chatHistory(messages, 600);
+    const QVariantHash params = BenchPayloads::chatParams();
+    const ChatHistory turns[2] = { history.takeLast(), { kChatRoleAssistant, BenchPayloads::text(600, messages + 1) } };
+    DChatCompletions chat;
+
+    QString json;
+    int turn = 0;
+    QBENCHMARK {
+        history.append(turns[turn]);
+        turn = 1 - turn;
+        json = chat.d->packageParams(history, params);
+        history.removeLast();
+    }
+    QVERIFY(json.endsWith('}'));
+}
+
+void BenchDChatCompletions::parseChatResult_data()
+{
+    QTest::addColumn<int>("bytes");
+    QTest::newRow("short answer") << 256;
+    QTest::newRow("long answer") << 16 * 1024;
+}
+
+void BenchDChatCompletions::parseChatResult()
+{
+    QFETCH(int, bytes);
+    const QString reply = BenchPayloads::compact({ { "content", BenchPayloads::text(bytes) } });
+
+    DTK_CORE_NAMESPACE::DError error(NoError, "");
+    QString content;
+    QBENCHMARK {
+        content = DChatCompletionsPrivate::parseChatResult(reply, &error);
+    }
+    QCOMPARE(error.getErrorCode(), int(NoError));
+    QVERIFY(!content.isEmpty());
+}
+
+void BenchDChatCompletions::functionCallingPackageParams()
+{
+    const QVariantHash params { { "model", "deepseek-chat" }, { "temperature", 0.2 }, { "tool_choice", "auto" } };
+
+    QString json;
+    QBENCHMARK {
+        json = DFunctionCallingPrivate::packageParams(params);
+    }
+    QVERIFY(!json.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(BenchDChatCompletions)
+
+#include "bench_dchatcompletions.moc"
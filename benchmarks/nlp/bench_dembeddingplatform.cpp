@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "bench_payloads.h"
+
+#include "nlp/dembeddingplatform_p.h"
+
+#include <QtTest>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Parsing of the search, documentsInfo and uploadDocuments replies
+ */
+class BenchDEmbeddingPlatform : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void parseSearchResults_data();
+    void parseSearchResults();
+    void parseDocumentsInfo_data();
+    void parseDocumentsInfo();
+    void parseUploadResults();
+};
+
+void BenchDEmbeddingPlatform::parseSearchResults_data()
+{
+    QTest::addColumn<int>("hits");
+    QTest::addColumn<int>("chunkBytes");
+    QTest::newRow("10 hits") << 10 << 512;
+    QTest::newRow("100 hits") << 100 << 512;
+    QTest::newRow("1000 hits") << 1000 << 512;
+}
+
+void BenchDEmbeddingPlatform::parseSearchResults()
+{
+    QFETCH(int, hits);
+    QFETCH(int, chunkBytes);
+    const QString reply = BenchPayloads::searchReply(hits, chunkBytes);
+
+    DTK_CORE_NAMESPACE::DError error(NoError, "");
+    QList<DEmbeddingPlatform::SearchResult> results;
+    QBENCHMARK {
+        results = DEmbeddingPlatformPrivate::parseSearchResults(reply, &error);
+    }
+    QCOMPARE(results.size(), hits);
+}
+
+void BenchDEmbeddingPlatform::parseDocumentsInfo_data()
+{
+    QTest::addColumn<int>("documents");
+    QTest::newRow("10 documents") << 10;
+    QTest::newRow("1000 documents") << 1000;
+}
+
+void BenchDEmbeddingPlatform::parseDocumentsInfo()
+{
+    QFETCH(int, documents);
+    const QString reply = BenchPayloads::documentsInfoReply(documents);
+
+    DTK_CORE_NAMESPACE::DError error(NoError, "");
+    QList<DEmbeddingPlatform::DocumentInfo> infos;
+    QBENCHMARK {
+        infos = DEmbeddingPlatformPrivate::parseDocumentsInfo(reply, &error);
+    }
+    QCOMPARE(infos.size(), documents);
+}
+
+void BenchDEmbeddingPlatform::parseUploadResults()
+{
+    const QString reply = BenchPayloads::uploadReply(100);
+
+    DTK_CORE_NAMESPACE::DError error(NoError, "");
+    QList<DEmbeddingPlatform::DocumentInfo> infos;
+    QBENCHMARK {
+        infos = DEmbeddingPlatformPrivate::parseUploadResults(reply, &error);
+    }
+    QCOMPARE(infos.size(), 100);
+}
+
+QTEST_GUILESS_MAIN(BenchDEmbeddingPlatform)
+
+#include "bench_dembeddingplatform.moc"
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "bench_payloads.h"
+
+#include "speech/dspeechtotext_p.h"
+
+#include <QtTest>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Encoding of recognition requests and parsing of their results
+ */
+class BenchDSpeechToText : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void parseRecognitionResult_data();
+    void parseRecognitionResult();
+    void packageParams();
+};
+
+void BenchDSpeechToText::parseRecognitionResult_data()
+{
+    QTest::addColumn<QString>("reply");
+    QTest::addColumn<int>("errorCode");
+    QTest::newRow("sentence") << BenchPayloads::compact({ { "text", BenchPayloads::text(120) } }) << 0;
+    QTest::newRow("long transcript") << BenchPayloads::compact({ { "text", BenchPayloads::text(8 * 1024) } }) << 0;
+    QTest::newRow("error") << BenchPayloads::compact({ { "error_code", 3 }, { "error_message", "Audio format not supported" } })
+                           << 3;
+}
+
+void BenchDSpeechToText::parseRecognitionResult()
+{
+    QFETCH(QString, reply);
+    QFETCH(int, errorCode);
+
+    DTK_CORE_NAMESPACE::DError error(NoError, "");
+    QString text;
+    QBENCHMARK {
+        text = DSpeechToTextPrivate::parseRecognitionResult(reply, &error);
+    }
+    QCOMPARE(error.getErrorCode(), errorCode);
+}
+
+void BenchDSpeechToText::packageParams()
+{
+    const QVariantHash params { { "model", "paraformer-zh" }, { "language", "zh-CN" }, { "sample_rate", 16000 },
+                                { "format", "pcm" }, { "enable_punctuation", true } };
+
+    QString json;
+    QBENCHMARK {
+        json = DSpeechToTextPrivate::packageParams(params);
+    }
+    QVERIFY(!json.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(BenchDSpeechToText)
+
+#include "bench_dspeechtotext.moc"
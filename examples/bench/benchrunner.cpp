@@ -0,0 +1,261 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "benchrunner.h"
+
+#include <DAIMetrics>
+
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+
+#include <sys/resource.h>
+
+DAI_USE_NAMESPACE
+
+namespace {
+
+struct Usage
+{
+    qint64 user = 0;    // usec
+    qint64 system = 0;  // usec
+    qint64 time = 0;    // nsec since the start of the run
+};
+
+Usage sampleUsage(const QElapsedTimer &clock)
+{
+    Usage usage;
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        usage.user = qint64(ru.ru_utime.tv_sec) * 1000000 + ru.ru_utime.tv_usec;
+        usage.system = qint64(ru.ru_stime.tv_sec) * 1000000 + ru.ru_stime.tv_usec;
+    }
+    usage.time = clock.nsecsElapsed();
+    return usage;
+}
+
+// Value in kB of a line like "VmRSS:    12345 kB" of /proc/self/status.
+qint64 statusValue(const QByteArray &status, const QByteArray &key)
+{
+    const int from = status.indexOf("\n" + key + ":");
+    if (from < 0)
+        return -1;
+    const int to = status.indexOf('\n', from + 1);
+    return status.mid(from + key.size() + 2, to - from - key.size() - 2).replace("kB", "").trimmed().toLongLong();
+}
+
+// Percentiles of nsec samples in usec, like the series of DAIMetrics.
+QJsonObject distribution(QVector<qint64> values)
+{
+    QJsonObject obj;
+    obj.insert("count", values.size());
+    if (values.isEmpty())
+        return obj;
+
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (qint64 value : values)
+        sum += value;
+    const auto percentile = [&values](double q) {
+        const int rank = int(std::ceil(q * values.size()));
+        return double(values.at(qBound(0, rank - 1, int(values.size()) - 1)) / 1000);
+    };
+
+    obj.insert("min", double(values.first() / 1000));
+    obj.insert("mean", sum / values.size() / 1000);
+    obj.insert("p50", percentile(0.5));
+    obj.insert("p90", percentile(0.9));
+    obj.insert("p99", percentile(0.99));
+    obj.insert("p999", percentile(0.999));
+    obj.insert("max", double(values.last() / 1000));
+    return obj;
+}
+
+} // namespace
+
+void BenchSamples::merge(const BenchSamples &other)
+{
+    latency += other.latency;
+    service += other.service;
+    firstOutput += other.firstOutput;
+    outputRate += other.outputRate;
+    for (auto it = other.errors.constBegin(); it != other.errors.constEnd(); ++it)
+        errors[it.key()] += it.value();
+    completed += other.completed;
+    outputs += other.outputs;
+}
+
+BenchClient::BenchClient(BenchRunner *runner)
+    : runner(runner)
+{
+}
+
+void BenchClient::run()
+{
+    // Created here so the client object and its session proxies belong to this thread.
+    QScopedPointer<BenchScenario> scenario(BenchScenario::create(runner->config.scenario, &runner->payload));
+
+    bool measured = false;
+    qint64 scheduled = 0;
+    while ((scheduled = runner->next(&measured)) >= 0) {
+        const qint64 sent = runner->clock.nsecsElapsed();
+        const BenchResult result = scenario->run();
+        const qint64 done = runner->clock.nsecsElapsed();
+        if (!measured)
+            continue;
+
+        if (result.error != 0) {
+            ++samples.errors[result.error];
+            continue;
+        }
+
+        ++samples.completed;
+        samples.latency.append(done - scheduled);
+        samples.service.append(done - sent);
+        samples.outputs += result.outputs;
+        if (result.firstOutput >= 0)
+            samples.firstOutput.append(result.firstOutput);
+        if (result.outputsPerSecond > 0)
+            samples.outputRate.append(result.outputsPerSecond);
+    }
+}
+
+BenchRunner::BenchRunner(const BenchConfig &config, const BenchPayload &payload, QObject *parent)
+    : QObject(parent)
+    , config(config)
+    , payload(payload)
+{
+}
+
+BenchRunner::~BenchRunner()
+{
+    qDeleteAll(clients);
+}
+
+qint64 BenchRunner::next(bool *measured)
+{
+    qint64 scheduled = 0;
+    if (config.rate > 0) {
+        scheduled = qint64(ticket.fetch_add(1) * 1e9 / config.rate);
+        if (end > 0 && scheduled >= end)
+            return -1;
+        const qint64 ahead = scheduled - clock.nsecsElapsed();
+        if (ahead > 0)
+            QThread::usleep(ahead / 1000);
+    } else {
+        scheduled = clock.nsecsElapsed();
+        if (end > 0 && scheduled >= end)
+            return -1;
+    }
+
+    *measured = scheduled >= measureStart;
+    if (*measured && config.requests > 0 && issued.fetch_add(1) >= config.requests)
+        return -1;
+    return scheduled;
+}
+
+QJsonObject BenchRunner::run()
+{
+    measureStart = qint64(config.warmup * 1e9);
+    end = config.duration > 0 ? measureStart + qint64(config.duration * 1e9) : 0;
+
+    QEventLoop loop;
+    int running = config.clients;
+    for (int i = 0; i < config.clients; ++i) {
+        BenchClient *client = new BenchClient(this);
+        connect(client, &QThread::finished, &loop, [&loop, &running]() {
+            if (--running == 0)
+                loop.quit();
+        });
+        clients.append(client);
+    }
+
+    // CPU time and metrics of the warmup are left out.
+    bool started = false;
+    Usage start;
+    const auto startMeasuring = [this, &started, &start]() {
+        if (started)
+            return;
+        started = true;
+        start = sampleUsage(clock);
+        if (config.metrics)
+            DAIMetrics::instance()->reset();
+    };
+
+    clock.start();
+    if (measureStart == 0)
+        startMeasuring();
+    else
+        QTimer::singleShot(int(measureStart / 1000000), &loop, startMeasuring);
+
+    for (BenchClient *client : clients)
+        client->start();
+    loop.exec();
+
+    BenchSamples samples;
+    for (BenchClient *client : clients) {
+        client->wait();
+        samples.merge(client->samples);
+    }
+
+    startMeasuring();
+    const Usage stop = sampleUsage(clock);
+    const qint64 measuredTime = stop.time - start.time;
+
+    QJsonObject result = report(samples, measuredTime);
+
+    QFile status("/proc/self/status");
+    const QByteArray statusData = status.open(QIODevice::ReadOnly) ? status.readAll() : QByteArray();
+    const qint64 cpu = (stop.user - start.user) + (stop.system - start.system);
+    result.insert("client", QJsonObject {
+        { "cpuUser", (stop.user - start.user) / 1e6 },
+        { "cpuSystem", (stop.system - start.system) / 1e6 },
+        { "cpuPercent", stop.time > start.time ? cpu * 1000.0 / (stop.time - start.time) * 100 : 0.0 },
+        { "rss", double(statusValue(statusData, "VmRSS")) },
+        { "peakRss", double(statusValue(statusData, "VmHWM")) },
+    });
+
+    if (config.metrics)
+        result.insert("metrics", QJsonDocument::fromJson(DAIMetrics::instance()->toJson()).array());
+    return result;
+}
+
+QJsonObject BenchRunner::report(const BenchSamples &samples, qint64 measuredTime) const
+{
+    QJsonObject errors;
+    quint64 failed = 0;
+    for (auto it = samples.errors.constBegin(); it != samples.errors.constEnd(); ++it) {
+        errors.insert(QString::number(it.key()), double(it.value()));
+        failed += it.value();
+    }
+
+    QJsonObject obj;
+    obj.insert("scenario", config.scenario);
+    obj.insert("clients", config.clients);
+    obj.insert("rate", config.rate);
+    obj.insert("warmup", config.warmup);
+    obj.insert("duration", measuredTime / 1e9);
+    obj.insert("requests", double(samples.completed + failed));
+    obj.insert("completed", double(samples.completed));
+    obj.insert("errors", errors);
+    obj.insert("throughput", measuredTime > 0 ? samples.completed * 1e9 / measuredTime : 0.0);
+    obj.insert("latency", distribution(samples.latency));
+    if (config.rate > 0)
+        obj.insert("serviceTime", distribution(samples.service));
+
+    if (BenchScenario::isStream(config.scenario)) {
+        double rate = 0;
+        for (double value : samples.outputRate)
+            rate += value;
+        obj.insert("ttft", distribution(samples.firstOutput));
+        obj.insert("outputs", double(samples.outputs));
+        obj.insert("outputsPerSecond", samples.outputRate.isEmpty() ? 0.0 : rate / samples.outputRate.size());
+    }
+    return obj;
+}
@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+
+#include "benchscenario.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QThread>
+#include <QVector>
+
+#include <atomic>
+
+struct BenchConfig
+{
+    QString scenario;
+    int clients = 1;
+    double rate = 0;        // requests per second of all clients together, 0 runs a closed loop
+    double warmup = 2;      // seconds, requests sent before are not measured
+    double duration = 10;   // seconds measured, 0 runs until requests were sent
+    int requests = 0;       // measured requests, 0 for no limit
+    bool metrics = false;   // add the DAIMetrics series of the measured phase
+};
+
+// Samples of one client, merged once the run is over.
+struct BenchSamples
+{
+    QVector<qint64> latency;    // nsec from the scheduled send to completion
+    QVector<qint64> service;    // nsec from the actual send to completion
+    QVector<qint64> firstOutput;
+    QVector<double> outputRate;
+    QHash<int, quint64> errors;
+    quint64 completed = 0;
+    qint64 outputs = 0;
+
+    void merge(const BenchSamples &other);
+};
+
+class BenchRunner;
+class BenchClient : public QThread
+{
+    Q_OBJECT
+public:
+    explicit BenchClient(BenchRunner *runner);
+
+    BenchSamples samples;
+
+protected:
+    void run() override;
+
+private:
+    BenchRunner *runner;
+};
+
+/**
+ * @brief Drives one scenario with concurrent clients
+ *
+ * Every client owns a client object on a thread of its own and sends one
+ * request at a time. In closed loop a client sends the next request as soon
+ * as the previous one completed. At a fixed rate the requests are scheduled
+ * at even intervals and handed to whichever client is free, latency counts
+ * from the scheduled time so a saturated daemon shows up as queueing instead
+ * of a lower rate.
+ */
+class BenchRunner : public QObject
+{
+    Q_OBJECT
+public:
+    BenchRunner(const BenchConfig &config, const BenchPayload &payload, QObject *parent = nullptr);
+    ~BenchRunner() override;
+
+    // Runs the event loop of the calling thread until every client is done.
+    QJsonObject run();
+
+private:
+    friend class BenchClient;
+
+    // Returns the scheduled time of the next request in nsec since the start, -1 once the run is over.
+    qint64 next(bool *measured);
+    QJsonObject report(const BenchSamples &samples, qint64 measuredTime) const;
+
+    BenchConfig config;
+    BenchPayload payload;
+    QList<BenchClient *> clients;
+
+    QElapsedTimer clock;
+    qint64 measureStart = 0;
+    qint64 end = 0;
+    std::atomic<quint64> ticket { 0 };
+    std::atomic<int> issued { 0 };
+};
+
+#endif // BENCHRUNNER_H
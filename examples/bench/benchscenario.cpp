@@ -0,0 +1,371 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "benchscenario.h"
+
+#include <DChatCompletions>
+#include <DFunctionCalling>
+#include <DEmbeddingPlatform>
+#include <DSpeechToText>
+#include <DTextToSpeech>
+#include <DImageRecognition>
+#include <DOCRRecognition>
+#include <DAIError>
+#include <DAIRequestOptions>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+
+DCORE_USE_NAMESPACE
+DAI_USE_NAMESPACE
+
+// Streams are given this long past their deadline to report it before they are terminated.
+static const int kStreamGrace = 1000;
+
+static DAIRequestOptions requestOptions(const BenchPayload *payload)
+{
+    DAIRequestOptions options;
+    options.deadline = QDeadlineTimer(payload->timeout);
+    return options;
+}
+
+// -1 when a request failed without the client setting an error code.
+static int errorCode(const DError &error)
+{
+    return error.getErrorCode() != NoError ? error.getErrorCode() : -1;
+}
+
+static QList<ChatHistory> makeHistory(int count)
+{
+    QList<ChatHistory> history;
+    for (int i = 0; i < count; ++i) {
+        const QString line = QString("Message %1 of the conversation so far. ").arg(i);
+        history.append({ i % 2 ? kChatRoleAssistant : kChatRoleUser, line.repeated(8) });
+    }
+    return history;
+}
+
+// Runs the event loop of the calling thread until finish() or a timeout.
+class StreamWait
+{
+public:
+    void reset() { done = false; }
+
+    void finish()
+    {
+        done = true;
+        if (loop)
+            loop->quit();
+    }
+
+    bool wait(int msec)
+    {
+        if (done)
+            return true;
+        QEventLoop eventLoop;
+        loop = &eventLoop;
+        QTimer::singleShot(msec, &eventLoop, &QEventLoop::quit);
+        eventLoop.exec();
+        loop = nullptr;
+        return done;
+    }
+
+private:
+    QEventLoop *loop = nullptr;
+    bool done = false;
+};
+
+class ChatScenario : public BenchScenario
+{
+public:
+    explicit ChatScenario(const BenchPayload *payload)
+        : BenchScenario(payload)
+        , history(makeHistory(payload->history)) {}
+
+    BenchResult run() override
+    {
+        BenchResult result;
+        const QString content = chat.chat(payload->prompt, history, payload->params, requestOptions(payload));
+        if (content.isEmpty())
+            result.error = errorCode(chat.lastError());
+        return result;
+    }
+
+private:
+    DChatCompletions chat;
+    QList<ChatHistory> history;
+};
+
+class ChatStreamScenario : public BenchScenario
+{
+public:
+    explicit ChatStreamScenario(const BenchPayload *payload)
+        : BenchScenario(payload)
+        , history(makeHistory(payload->history))
+    {
+        QObject::connect(&chat, &DChatCompletions::requestStreamOutput, &chat, [this](quint64 id, const QString &) {
+            if (id != current)
+                return;
+            if (result.firstOutput < 0)
+                result.firstOutput = clock.nsecsElapsed();
+            ++result.outputs;
+        });
+        QObject::connect(&chat, &DChatCompletions::requestStreamStats, &chat, [this](quint64 id, const DAIStreamStats &stats) {
+            if (id == current)
+                result.outputsPerSecond = stats.tokensPerSecond;
+        });
+        QObject::connect(&chat, &DChatCompletions::requestStreamFinished, &chat, [this](quint64 id, int error) {
+            if (id != current)
+                return;
+            result.error = error;
+            wait.finish();
+        });
+    }
+
+    BenchResult run() override
+    {
+        result = BenchResult();
+        wait.reset();
+        clock.start();
+        current = chat.startChatStream(payload->prompt, history, payload->params, requestOptions(payload));
+        if (current == 0) {
+            result.error = errorCode(chat.lastError());
+            return result;
+        }
+
+        if (!wait.wait(payload->timeout + kStreamGrace)) {
+            chat.terminateRequest(current);
+            result.error = RequestTimeout;
+        }
+        current = 0;
+        return result;
+    }
+
+private:
+    DChatCompletions chat;
+    QList<ChatHistory> history;
+    QElapsedTimer clock;
+    StreamWait wait;
+    quint64 current = 0;
+    BenchResult result;
+};
+
+class ParseScenario : public BenchScenario
+{
+public:
+    using BenchScenario::BenchScenario;
+
+    BenchResult run() override
+    {
+        BenchResult result;
+        const QString function = fc.parse(payload->prompt, payload->functions, payload->params, requestOptions(payload));
+        if (function.isEmpty())
+            result.error = errorCode(fc.lastError());
+        return result;
+    }
+
+private:
+    DFunctionCalling fc;
+};
+
+class OcrScenario : public BenchScenario
+{
+public:
+    using BenchScenario::BenchScenario;
+
+    BenchResult run() override
+    {
+        BenchResult result;
+        if (ocr.recognizeImage(payload->data, payload->params).isEmpty())
+            result.error = errorCode(ocr.lastError());
+        return result;
+    }
+
+private:
+    DOCRRecognition ocr;
+};
+
+class ImageScenario : public BenchScenario
+{
+public:
+    using BenchScenario::BenchScenario;
+
+    BenchResult run() override
+    {
+        BenchResult result;
+        if (image.recognizeImageData(payload->data, payload->prompt, payload->params).isEmpty())
+            result.error = errorCode(image.lastError());
+        return result;
+    }
+
+private:
+    DImageRecognition image;
+};
+
+class SttStreamScenario : public BenchScenario
+{
+public:
+    explicit SttStreamScenario(const BenchPayload *payload)
+        : BenchScenario(payload)
+    {
+        stt.setStreamTransport(payload->sharedMemory ? DSpeechToText::SharedMemoryTransport
+                                                     : DSpeechToText::DBusTransport);
+        QObject::connect(&stt, &DSpeechToText::requestRecognitionPartialResult, &stt, [this](quint64 id, const QString &) {
+            if (id != current)
+                return;
+            if (result.firstOutput < 0)
+                result.firstOutput = clock.nsecsElapsed();
+            ++result.outputs;
+        });
+        QObject::connect(&stt, &DSpeechToText::requestRecognitionError, &stt, [this](quint64 id, int error, const QString &) {
+            if (id == current)
+                result.error = error;
+        });
+    }
+
+    BenchResult run() override
+    {
+        result = BenchResult();
+        clock.start();
+        current = stt.startRecognitionStream(payload->params, requestOptions(payload));
+        if (current == 0) {
+            result.error = errorCode(stt.lastError());
+            return result;
+        }
+
+        for (int offset = 0; offset < payload->data.size() && result.error == 0; offset += payload->chunkSize) {
+            if (!stt.sendStreamAudio(current, payload->data.mid(offset, payload->chunkSize))) {
+                result.error = errorCode(stt.lastError());
+                break;
+            }
+            // Partial results are handled in between, also when chunks are sent back to back.
+            if (payload->chunkInterval > 0)
+                wait.wait(payload->chunkInterval);
+            else
+                QCoreApplication::processEvents();
+        }
+
+        const QString text = stt.endRecognitionStream(current);
+        QCoreApplication::processEvents();
+        if (result.error == 0 && text.isEmpty())
+            result.error = errorCode(stt.lastError());
+        current = 0;
+        return result;
+    }
+
+private:
+    DSpeechToText stt;
+    QElapsedTimer clock;
+    StreamWait wait;
+    quint64 current = 0;
+    BenchResult result;
+};
+
+class TtsStreamScenario : public BenchScenario
+{
+public:
+    explicit TtsStreamScenario(const BenchPayload *payload)
+        : BenchScenario(payload)
+    {
+        QObject::connect(&tts, &DTextToSpeech::requestSynthesisResult, &tts, [this](quint64 id, const QByteArray &) {
+            if (id != current)
+                return;
+            if (result.firstOutput < 0)
+                result.firstOutput = clock.nsecsElapsed();
+            ++result.outputs;
+        });
+        QObject::connect(&tts, &DTextToSpeech::requestSynthesisError, &tts, [this](quint64 id, int error, const QString &) {
+            if (id != current)
+                return;
+            result.error = error != 0 ? error : -1;
+            wait.finish();
+        });
+        QObject::connect(&tts, &DTextToSpeech::requestSynthesisCompleted, &tts, [this](quint64 id, const QByteArray &) {
+            if (id == current)
+                wait.finish();
+        });
+    }
+
+    BenchResult run() override
+    {
+        result = BenchResult();
+        wait.reset();
+        clock.start();
+        current = tts.startSynthesisStream(payload->prompt, payload->params, requestOptions(payload));
+        if (current == 0) {
+            result.error = errorCode(tts.lastError());
+            return result;
+        }
+
+        if (!wait.wait(payload->timeout + kStreamGrace)) {
+            tts.terminateRequest(current);
+            result.error = RequestTimeout;
+        } else if (result.outputs > 1 && result.firstOutput >= 0) {
+            const qint64 streaming = clock.nsecsElapsed() - result.firstOutput;
+            if (streaming > 0)
+                result.outputsPerSecond = (result.outputs - 1) * 1e9 / streaming;
+        }
+        current = 0;
+        return result;
+    }
+
+private:
+    DTextToSpeech tts;
+    QElapsedTimer clock;
+    StreamWait wait;
+    quint64 current = 0;
+    BenchResult result;
+};
+
+class SearchScenario : public BenchScenario
+{
+public:
+    using BenchScenario::BenchScenario;
+
+    BenchResult run() override
+    {
+        BenchResult result;
+        const QList<DEmbeddingPlatform::SearchResult> hits = platform.search(payload->appId, payload->prompt);
+        if (platform.lastError().getErrorCode() != NoError)
+            result.error = platform.lastError().getErrorCode();
+        result.outputs = hits.size();
+        return result;
+    }
+
+private:
+    DEmbeddingPlatform platform;
+};
+
+QStringList BenchScenario::names()
+{
+    return { "chat", "chatStream", "parse", "ocr", "image", "sttStream", "ttsStream", "search" };
+}
+
+bool BenchScenario::isStream(const QString &name)
+{
+    return name == "chatStream" || name == "sttStream" || name == "ttsStream";
+}
+
+BenchScenario *BenchScenario::create(const QString &name, const BenchPayload *payload)
+{
+    if (name == "chat")
+        return new ChatScenario(payload);
+    if (name == "chatStream")
+        return new ChatStreamScenario(payload);
+    if (name == "parse")
+        return new ParseScenario(payload);
+    if (name == "ocr")
+        return new OcrScenario(payload);
+    if (name == "image")
+        return new ImageScenario(payload);
+    if (name == "sttStream")
+        return new SttStreamScenario(payload);
+    if (name == "ttsStream")
+        return new TtsStreamScenario(payload);
+    if (name == "search")
+        return new SearchScenario(payload);
+    return nullptr;
+}
@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef BENCHSCENARIO_H
+#define BENCHSCENARIO_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVariantHash>
+
+// What is sent by every request of a run, shared read-only by all clients.
+struct BenchPayload
+{
+    QString prompt;             // chat and function calling prompt, synthesized text, search query
+    int history = 0;            // chat history messages sent along with the prompt
+    QString functions;          // function calling definitions
+    QVariantHash params;
+    QByteArray data;            // image or 16 kHz 16 bit mono PCM audio
+    int chunkSize = 3200;       // audio bytes per sendStreamAudio()
+    int chunkInterval = 0;      // msec between audio chunks, 0 sends them back to back
+    bool sharedMemory = false;  // recognition audio through the shared-memory ring
+    QString appId;
+    int timeout = 30000;        // msec, deadline of each request
+};
+
+struct BenchResult
+{
+    int error = 0;              // AIErrorCode or daemon error code, 0 on success
+    qint64 firstOutput = -1;    // nsec from sending to the first token, partial result or audio chunk
+    int outputs = 0;            // tokens, partial results or audio chunks
+    double outputsPerSecond = 0;
+};
+
+/**
+ * @brief One client of a benchmark run
+ *
+ * Created on the thread of the client and used from it only. run() sends one
+ * request and blocks until it completed, running the event loop of the thread
+ * while a stream is open.
+ */
+class BenchScenario
+{
+public:
+    explicit BenchScenario(const BenchPayload *payload)
+        : payload(payload) {}
+    virtual ~BenchScenario() = default;
+
+    virtual BenchResult run() = 0;
+
+    static QStringList names();
+    static bool isStream(const QString &name);
+    static BenchScenario *create(const QString &name, const BenchPayload *payload);
+
+protected:
+    const BenchPayload *payload;
+};
+
+#endif // BENCHSCENARIO_H
@@ -0,0 +1,173 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "benchrunner.h"
+
+#include <DAITransport>
+#include <DSessionPool>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <stdio.h>
+
+DAI_USE_NAMESPACE
+
+static const char *kFunctions = R"([
+    {
+        "name": "switchSystemTheme",
+        "description": "Switch the system theme to light or dark",
+        "parameters": {
+            "type": "object",
+            "properties": {
+                "theme": { "type": "string", "enum": ["Light", "Dark"] }
+            },
+            "required": ["theme"]
+        }
+    }
+])";
+
+static QString defaultPrompt(const QString &scenario)
+{
+    if (scenario == "parse")
+        return "Switch to the dark theme";
+    if (scenario == "image")
+        return "Describe this image";
+    if (scenario == "ttsStream")
+        return "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog.";
+    if (scenario == "search")
+        return "How do I change the screen resolution?";
+    return "Write a short paragraph about the history of the Linux desktop.";
+}
+
+// Generated data is enough for dtkai-mock-daemon, a real daemon needs --input.
+static int defaultPayloadSize(const QString &scenario)
+{
+    if (scenario == "sttStream")
+        return 32000;   // one second of 16 kHz 16 bit mono audio
+    if (scenario == "ocr" || scenario == "image")
+        return 64 * 1024;
+    return 0;
+}
+
+static int fail(const QString &message)
+{
+    fprintf(stderr, "%s\n", qPrintable(message));
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("dtkai-bench");
+    app.setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Load generator for the dtkai clients, reports throughput, latency, "
+                                     "time to first output and client CPU and memory as JSON.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    const QCommandLineOption scenarioOption({ "s", "scenario" },
+                                            "One of " + BenchScenario::names().join(", ") + ".", "name");
+    const QCommandLineOption clientsOption({ "c", "clients" }, "Concurrent clients, default 1.", "n", "1");
+    const QCommandLineOption rateOption({ "r", "rate" }, "Requests per second of all clients together. "
+                                                        "Without it each client sends as fast as it gets replies.", "rps", "0");
+    const QCommandLineOption durationOption({ "d", "duration" }, "Seconds measured, default 10. "
+                                                                 "0 runs until --requests were sent.", "sec", "10");
+    const QCommandLineOption warmupOption({ "w", "warmup" }, "Seconds before measuring, default 2.", "sec", "2");
+    const QCommandLineOption requestsOption({ "n", "requests" }, "Stop after this many measured requests.", "n", "0");
+    const QCommandLineOption timeoutOption("timeout", "Deadline of each request in msec, default 30000.", "msec", "30000");
+    const QCommandLineOption promptOption("prompt", "Prompt, synthesized text or search query.", "text");
+    const QCommandLineOption historyOption("history", "Chat history messages sent with each prompt.", "n", "0");
+    const QCommandLineOption functionsOption("functions", "JSON file with the function definitions of parse.", "file");
+    const QCommandLineOption paramOption("param", "Request parameter, may be repeated.", "key=value");
+    const QCommandLineOption inputOption("input", "Image for ocr and image, raw 16 kHz 16 bit mono PCM for sttStream.", "file");
+    const QCommandLineOption sizeOption("payload-size", "Bytes of generated image or audio data without --input.", "bytes");
+    const QCommandLineOption chunkOption("chunk-size", "Audio bytes per chunk of sttStream, default 3200.", "bytes", "3200");
+    const QCommandLineOption intervalOption("chunk-interval", "Msec between audio chunks, 100 paces 3200 byte "
+                                                              "chunks in real time. Default 0.", "msec", "0");
+    const QCommandLineOption shmOption("shm", "Send recognition audio through the shared-memory ring.");
+    const QCommandLineOption appIdOption("app-id", "Embedding index searched, default dtkai-bench.", "id", "dtkai-bench");
+    const QCommandLineOption peerOption("peer", "Talk to the daemon over a peer-to-peer connection.");
+    const QCommandLineOption ioThreadOption("io-thread", "Handle D-Bus traffic on the dtkai I/O thread.");
+    const QCommandLineOption metricsOption("metrics", "Add the DAIMetrics series of the measured phase.");
+    const QCommandLineOption outputOption({ "o", "output" }, "Write the report to file instead of stdout.", "file");
+    parser.addOptions({ scenarioOption, clientsOption, rateOption, durationOption, warmupOption, requestsOption,
+                        timeoutOption, promptOption, historyOption, functionsOption, paramOption, inputOption,
+                        sizeOption, chunkOption, intervalOption, shmOption, appIdOption, peerOption, ioThreadOption,
+                        metricsOption, outputOption });
+    parser.process(app);
+
+    BenchConfig config;
+    config.scenario = parser.value(scenarioOption);
+    config.clients = parser.value(clientsOption).toInt();
+    config.rate = parser.value(rateOption).toDouble();
+    config.duration = parser.value(durationOption).toDouble();
+    config.warmup = parser.value(warmupOption).toDouble();
+    config.requests = parser.value(requestsOption).toInt();
+    config.metrics = parser.isSet(metricsOption);
+    if (!BenchScenario::names().contains(config.scenario))
+        return fail("--scenario must be one of " + BenchScenario::names().join(", "));
+    if (config.clients < 1 || config.rate < 0 || config.warmup < 0 || config.duration < 0 || config.requests < 0)
+        return fail("--clients, --rate, --warmup, --duration and --requests must not be negative");
+    if (config.duration == 0 && config.requests == 0)
+        return fail("--duration 0 needs --requests");
+
+    BenchPayload payload;
+    payload.prompt = parser.isSet(promptOption) ? parser.value(promptOption) : defaultPrompt(config.scenario);
+    payload.history = parser.value(historyOption).toInt();
+    payload.functions = QString::fromUtf8(kFunctions);
+    payload.chunkSize = qMax(1, parser.value(chunkOption).toInt());
+    payload.chunkInterval = parser.value(intervalOption).toInt();
+    payload.sharedMemory = parser.isSet(shmOption);
+    payload.appId = parser.value(appIdOption);
+    payload.timeout = parser.value(timeoutOption).toInt();
+    for (const QString &param : parser.values(paramOption)) {
+        const int eq = param.indexOf('=');
+        if (eq <= 0)
+            return fail("--param expects key=value, got " + param);
+        payload.params.insert(param.left(eq), param.mid(eq + 1));
+    }
+    if (parser.isSet(functionsOption)) {
+        QFile file(parser.value(functionsOption));
+        if (!file.open(QIODevice::ReadOnly))
+            return fail("Cannot read " + file.fileName());
+        payload.functions = QString::fromUtf8(file.readAll());
+    }
+    if (parser.isSet(inputOption)) {
+        QFile file(parser.value(inputOption));
+        if (!file.open(QIODevice::ReadOnly))
+            return fail("Cannot read " + file.fileName());
+        payload.data = file.readAll();
+    } else {
+        const int size = parser.isSet(sizeOption) ? parser.value(sizeOption).toInt() : defaultPayloadSize(config.scenario);
+        payload.data = QByteArray(qMax(0, size), '\0');
+    }
+
+    DAITransport::instance()->setIOThreadEnabled(parser.isSet(ioThreadOption));
+    if (parser.isSet(peerOption))
+        DAITransport::instance()->setConnectionMode(DAITransport::PeerToPeer);
+
+    if (!DSessionPool::instance()->isDaemonAvailable()) {
+        fprintf(stderr, "The ai-daemon is not available\n");
+        return 1;
+    }
+
+    BenchRunner runner(config, payload);
+    const QByteArray report = QJsonDocument(runner.run()).toJson();
+
+    if (!parser.isSet(outputOption)) {
+        printf("%s", report.constData());
+        return 0;
+    }
+    QSaveFile file(parser.value(outputOption));
+    if (!file.open(QIODevice::WriteOnly) || file.write(report) != report.size() || !file.commit()) {
+        fprintf(stderr, "Cannot write %s\n", qPrintable(parser.value(outputOption)));
+        return 1;
+    }
+    return 0;
+}
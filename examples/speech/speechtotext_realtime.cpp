@@ -27,6 +27,8 @@ public:
         : QObject(parent)
     {
         speechToText = new DSpeechToText(this);
+        // 50ms chunks go through shared memory instead of one D-Bus call each
+        speechToText->setStreamTransport(DSpeechToText::SharedMemoryTransport);
         sendTimer = new QTimer(this);
         qDebug() << "RealTimeSpeechTest constructor - creating DSpeechToText instance";
         
@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAICIRCUITBREAKER_H
+#define DAICIRCUITBREAKER_H
+
+#include "dtkai_global.h"
+
+#include <QObject>
+#include <QScopedPointer>
+
+DAI_BEGIN_NAMESPACE
+
+/**
+ * @brief Process-wide circuit breaker in front of the ai-daemon
+ *
+ * Every dtkai client reports whether the daemon answered its D-Bus calls.
+ * After failureThreshold() consecutive transport failures the breaker opens
+ * and requests fail at once with APIServerNotAvailable instead of waiting
+ * for a D-Bus timeout. After openDuration() a single probe request is let
+ * through (half-open), successThreshold() successful probes close it again.
+ */
+class DAICircuitBreakerPrivate;
+class DAICircuitBreaker : public QObject
+{
+    Q_OBJECT
+    friend class DAICircuitBreakerPrivate;
+public:
+    enum State {
+        Closed,     // requests pass through
+        Open,       // requests fail fast
+        HalfOpen    // one probe request at a time decides
+    };
+    Q_ENUM(State)
+
+    static DAICircuitBreaker *instance();
+
+    // Consecutive failures that open the breaker, 0 disables it.
+    void setFailureThreshold(int count);
+    int failureThreshold() const;
+    // Time the breaker stays open before a probe is allowed.
+    void setOpenDuration(int msec);
+    int openDuration() const;
+    // Successful probes needed to close the breaker again.
+    void setSuccessThreshold(int count);
+    int successThreshold() const;
+
+    State state() const;
+
+    // Whether a request may go to the daemon now, it must report its outcome.
+    bool allowRequest();
+    void recordSuccess();
+    void recordFailure();
+    // Close the breaker and forget all failures.
+    void reset();
+
+Q_SIGNALS:
+    void stateChanged(DAICircuitBreaker::State state);
+
+private:
+    explicit DAICircuitBreaker(QObject *parent = nullptr);
+    ~DAICircuitBreaker() override;
+    QScopedPointer<DAICircuitBreakerPrivate> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAICIRCUITBREAKER_H
@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIENCODEDPARAMS_H
+#define DAIENCODEDPARAMS_H
+
+#include "dtkai_global.h"
+
+#include <QByteArray>
+#include <QExplicitlySharedDataPointer>
+#include <QString>
+#include <QVariant>
+
+DAI_BEGIN_NAMESPACE
+
+// Request parameter keys understood by the ai-daemon.
+inline constexpr char kParamModel[] { "model" };
+inline constexpr char kParamTemperature[] { "temperature" };
+inline constexpr char kParamMaxTokens[] { "max_tokens" };
+inline constexpr char kParamTopP[] { "top_p" };
+inline constexpr char kParamLanguage[] { "language" };
+inline constexpr char kParamFormat[] { "format" };
+inline constexpr char kParamSampleRate[] { "sampleRate" };
+inline constexpr char kParamVoice[] { "voice" };
+inline constexpr char kParamSpeed[] { "speed" };
+inline constexpr char kParamVolume[] { "volume" };
+inline constexpr char kParamPitch[] { "pitch" };
+
+// Parameters of DChatCompletions and DFunctionCalling, unset members are left out.
+struct DAIChatParams
+{
+    QString model;
+    double temperature = -1;    // negative keeps the default of the model
+    int maxTokens = 0;          // 0 keeps the default of the model
+    double topP = -1;           // negative keeps the default of the model
+    QVariantHash extra;         // passed as is, overrides the members above
+
+    QVariantHash toHash() const;
+};
+
+// Parameters of DSpeechToText, unset members are left out.
+struct DAISpeechParams
+{
+    QString model;
+    QString language;
+    QString format;
+    int sampleRate = 0;
+    QVariantHash extra;
+
+    QVariantHash toHash() const;
+};
+
+// Parameters of DTextToSpeech, unset members are left out.
+struct DAISynthesisParams
+{
+    QString model;
+    QString voice;
+    QString language;
+    QString format;
+    int sampleRate = 0;
+    int speed = -1;
+    int volume = -1;
+    int pitch = -1;
+    QVariantHash extra;
+
+    QVariantHash toHash() const;
+};
+
+/**
+ * @brief Request parameters serialized once for many requests
+ *
+ * The JSON is built when the handle is created. Passing the handle, or a
+ * copy of params() that was not modified, as the params of any client
+ * reuses it instead of serializing the hash again for every request.
+ * Copies are cheap and share the encoding, a handle may be used from
+ * any thread.
+ */
+class DAIEncodedParamsData;
+class DAIEncodedParams
+{
+public:
+    DAIEncodedParams();
+    explicit DAIEncodedParams(const QVariantHash &params);
+    explicit DAIEncodedParams(const DAIChatParams &params);
+    explicit DAIEncodedParams(const DAISpeechParams &params);
+    explicit DAIEncodedParams(const DAISynthesisParams &params);
+    DAIEncodedParams(const DAIEncodedParams &other);
+    DAIEncodedParams &operator=(const DAIEncodedParams &other);
+    ~DAIEncodedParams();
+
+    bool isEmpty() const;
+    QVariant value(const QString &key) const;
+    QVariantHash params() const;
+    operator QVariantHash() const { return params(); }
+
+    // Compact JSON object of the parameters.
+    QByteArray json() const;
+
+private:
+    QExplicitlySharedDataPointer<DAIEncodedParamsData> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIENCODEDPARAMS_H
@@ -15,7 +15,10 @@ enum AIErrorCode {
     NoError = 0,
     APIServerNotAvailable = 1,
     InvalidParameter = 2,
-    ResponseParseError = 3
+    ResponseParseError = 3,
+    RequestCancelled = 4,
+    RequestTimeout = 5,
+    RequestRejected = 6     // refused by DAIScheduler without waiting, the daemon was not asked
 };
 
 DAI_END_NAMESPACE
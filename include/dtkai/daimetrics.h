@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIMETRICS_H
+#define DAIMETRICS_H
+
+#include "dtkai_global.h"
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QScopedPointer>
+
+DAI_BEGIN_NAMESPACE
+
+/**
+ * @brief Process-wide latency and throughput metrics of the dtkai clients
+ *
+ * Each request records into the series named after its client class and
+ * method, e.g. "DChatCompletions.chatAsync". Stages of a request record
+ * into series with a suffix:
+ * - ".firstToken", ".firstAudio" and ".firstResult" for the time from
+ *   sending a stream request to its first output
+ * - ".interToken" for each gap between the tokens of a chat stream and
+ *   ".timePerToken" for the mean gap of each stream
+ * - "DSessionPool.createSession.<type>" for opening a session with the daemon
+ *
+ * Latencies are kept in log-linear histograms with about 1.5% relative
+ * precision. Percentiles are reported in microseconds.
+ */
+class DAIMetricsPrivate;
+class DAIMetrics : public QObject
+{
+    Q_OBJECT
+    friend class DAIMetricsPrivate;
+public:
+    enum DumpFormat {
+        Prometheus = 0,
+        Json = 1
+    };
+    Q_ENUM(DumpFormat)
+
+    struct Series
+    {
+        QString name;
+        quint64 calls = 0;
+        QHash<int, quint64> errors;     // failed calls by error code
+        quint64 bytesSent = 0;
+        quint64 bytesReceived = 0;
+
+        // Latency in microseconds.
+        qint64 min = 0;
+        qint64 max = 0;
+        double mean = 0;
+        qint64 p50 = 0;
+        qint64 p90 = 0;
+        qint64 p99 = 0;
+        qint64 p999 = 0;
+    };
+
+    static DAIMetrics *instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // Series sorted by name.
+    QList<Series> snapshot() const;
+    Series series(const QString &name) const;
+    void reset();
+
+    QByteArray toPrometheus() const;
+    QByteArray toJson() const;
+
+    // Emits dumped() every interval msec, and writes the dump to filePath when it is set,
+    // replacing the file atomically. An interval of 0 stops dumping.
+    void setDump(int interval, DumpFormat format, const QString &filePath = QString());
+
+Q_SIGNALS:
+    void dumped(const QByteArray &data);
+
+private:
+    explicit DAIMetrics(QObject *parent = nullptr);
+    ~DAIMetrics() override;
+    QScopedPointer<DAIMetricsPrivate> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIMETRICS_H
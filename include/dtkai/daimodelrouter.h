@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIMODELROUTER_H
+#define DAIMODELROUTER_H
+
+#include "dtkai_global.h"
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QVariantHash>
+
+DAI_BEGIN_NAMESPACE
+
+// Service level a routed request asks for.
+struct DAIModelSLO
+{
+    int latency = 0;            // msec, 0 for no bound
+    double maxErrorRate = 0.1;  // share of recent requests that failed
+};
+
+/**
+ * @brief Picks the model of a request from how the models actually performed
+ *
+ * The router keeps a moving average of latency and error rate per model,
+ * fed by the outcome of every chat and function calling request that named
+ * its model in params. route() picks among the available models of a
+ * capability: the current model of the daemon while it meets the SLO,
+ * otherwise the fastest model that does, otherwise one not measured
+ * recently, otherwise the least bad one. The choice is written to
+ * params["model"], so traffic moves away from a slow provider on its own
+ * and comes back once its scores went stale and it measures well again.
+ */
+class DAIModelRouterPrivate;
+class DAIModelRouter : public QObject
+{
+    Q_OBJECT
+    friend class DAIModelRouterPrivate;
+public:
+    struct Score {
+        double latency = 0;     // msec, moving average
+        double errorRate = 0;   // moving average, 0 to 1
+        quint64 samples = 0;
+    };
+
+    static DAIModelRouter *instance();
+
+    // Picks a model for a request of capability and stores it in params, returns it.
+    // Params that already name a model and unknown capabilities are left alone.
+    QString route(const QString &capability, QVariantHash *params, const DAIModelSLO &slo = {});
+    QString selectModel(const QString &capability, const DAIModelSLO &slo = {});
+
+    // Outcome of a request, the clients report theirs, applications may add their own.
+    void recordOutcome(const QString &capability, const QString &model, qint64 latency, bool success);
+    Score score(const QString &capability, const QString &model) const;
+
+    // Weight of the newest outcome in the moving averages, 0 to 1.
+    void setSmoothing(double alpha);
+    double smoothing() const;
+    // Scores without a new outcome for this long no longer count, the model is tried again.
+    void setStaleAfter(int msec);
+    int staleAfter() const;
+    // Forget all scores and cached model lists.
+    void reset();
+
+private:
+    explicit DAIModelRouter(QObject *parent = nullptr);
+    ~DAIModelRouter() override;
+    QScopedPointer<DAIModelRouterPrivate> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIMODELROUTER_H
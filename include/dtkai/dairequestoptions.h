@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIREQUESTOPTIONS_H
+#define DAIREQUESTOPTIONS_H
+
+#include "dtkai_global.h"
+
+#include <QDeadlineTimer>
+#include <QObject>
+#include <QExplicitlySharedDataPointer>
+
+#include <functional>
+
+DAI_BEGIN_NAMESPACE
+
+/**
+ * @brief Cancels one or more requests from any thread
+ *
+ * Copies share their state, cancelling any copy cancels all of them.
+ * A request is aborted with RequestCancelled and stopped in the daemon,
+ * other requests of the same client object keep running.
+ */
+class DAICancellationTokenPrivate;
+class DAICancellationToken
+{
+public:
+    DAICancellationToken();
+    DAICancellationToken(const DAICancellationToken &other);
+    DAICancellationToken &operator=(const DAICancellationToken &other);
+    ~DAICancellationToken();
+
+    void cancel();
+    bool isCancelled() const;
+
+    // Invokes func in the thread of context once cancelled, soon after this call when already cancelled.
+    // Nothing is invoked if context is destroyed first.
+    QMetaObject::Connection onCancelled(QObject *context, const std::function<void()> &func) const;
+
+private:
+    friend class DAIRequestWatches;
+    QExplicitlySharedDataPointer<DAICancellationTokenPrivate> d;
+};
+
+// Scheduling class of a request, see DAIScheduler.
+enum class DAIRequestPriority {
+    Interactive = 0,
+    Background = 1,
+    Batch = 2
+};
+
+/**
+ * @brief Per-request limits of the request-id APIs
+ *
+ * deadline is absolute, e.g. QDeadlineTimer(800) gives up 800ms after it
+ * was created no matter how long the request waited for a session. An
+ * expired request finishes with RequestTimeout, a cancelled one with
+ * RequestCancelled, and in both cases the daemon is told to stop it.
+ * Blocking calls honor the deadline only, they cannot be cancelled
+ * while they wait.
+ *
+ * priority orders the request in the queue of DAIScheduler when its
+ * capability is at its concurrency or rate limit.
+ */
+struct DAIRequestOptions
+{
+    QDeadlineTimer deadline { QDeadlineTimer::Forever };
+    DAICancellationToken cancellation;
+    DAIRequestPriority priority { DAIRequestPriority::Interactive };
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIREQUESTOPTIONS_H
@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIRETRYPOLICY_H
+#define DAIRETRYPOLICY_H
+
+#include "dtkai_global.h"
+
+#include <QObject>
+#include <QScopedPointer>
+
+DAI_BEGIN_NAMESPACE
+
+/**
+ * @brief Process-wide retry of idempotent calls to the ai-daemon
+ *
+ * Read-only calls like the DModelManager queries, DEmbeddingPlatform::search
+ * and documentsInfo or the getSupported* methods are retried when the daemon
+ * did not answer at all, e.g. it timed out or is restarting. Requests that
+ * change state or run a model are never retried. A call is tried at most
+ * maxAttempts() times, retry n (the first retry being n = 1) waits a random
+ * delay between 0 and min(maximumDelay(), baseDelay() * 2^(n-1)), and no
+ * retry starts once the deadline of the call would pass during the wait.
+ * Every attempt is issued with a D-Bus timeout cut to what is left of the
+ * deadline, so a single attempt cannot outlive it either.
+ *
+ * Retries are paid from a budget: every call earns retryBudget() retries,
+ * up to a few in reserve. When the daemon is down for good the budget runs
+ * dry and calls fail after their first attempt instead of piling up retries.
+ * Nothing is retried while the circuit breaker is open.
+ */
+class DAIRetryPolicyPrivate;
+class DAIRetryPolicy : public QObject
+{
+    Q_OBJECT
+    friend class DAIRetryPolicyPrivate;
+public:
+    struct Statistics {
+        quint64 calls = 0;              // idempotent calls made
+        quint64 retries = 0;            // attempts after the first one
+        quint64 budgetExhausted = 0;    // retries refused for lack of budget
+    };
+
+    static DAIRetryPolicy *instance();
+
+    // Attempts per call including the first one, 1 disables retries.
+    void setMaxAttempts(int count);
+    int maxAttempts() const;
+    void setBaseDelay(int msec);
+    int baseDelay() const;
+    void setMaximumDelay(int msec);
+    int maximumDelay() const;
+    // Retries earned per call, 0.2 allows one retry for every five calls.
+    void setRetryBudget(double ratio);
+    double retryBudget() const;
+
+    Statistics statistics() const;
+
+private:
+    explicit DAIRetryPolicy(QObject *parent = nullptr);
+    ~DAIRetryPolicy() override;
+    QScopedPointer<DAIRetryPolicyPrivate> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIRETRYPOLICY_H
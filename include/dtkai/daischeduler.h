@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAISCHEDULER_H
+#define DAISCHEDULER_H
+
+#include "dtkai_global.h"
+
+#include <QObject>
+#include <QScopedPointer>
+
+DAI_BEGIN_NAMESPACE
+
+/**
+ * @brief Process-wide admission control of requests to the ai-daemon
+ *
+ * Requests of the dtkai clients are admitted per capability, e.g. "Chat",
+ * "OCR" or "Embedding". A capability can be limited in the number of
+ * requests running at once and in the rate requests are started at, the
+ * latter as a token bucket of rate tokens per second holding up to burst
+ * tokens. Requests that do not fit wait in a queue and are started in
+ * the order of DAIRequestOptions::priority, first come first served
+ * within one priority. A queued request still honors its deadline and
+ * cancellation.
+ *
+ * Blocking calls wait for admission on the calling thread. On the thread of
+ * the scheduler, the main thread, they never wait for a concurrency slot and
+ * fail with RequestRejected instead: the asynchronous requests holding the
+ * slots could only finish on that very thread. The legacy chatStream() and
+ * startStreamRecognition() are admitted the same way and hold their slot
+ * until the stream ends.
+ *
+ * Nothing is limited by default.
+ */
+class DAISchedulerPrivate;
+class DAIScheduler : public QObject
+{
+    Q_OBJECT
+    friend class DAISchedulerPrivate;
+public:
+    struct Statistics {
+        int queued = 0;             // requests waiting for admission
+        int running = 0;            // admitted requests not finished yet
+        quint64 dispatched = 0;     // requests admitted so far
+        quint64 expired = 0;        // requests that gave up while queued
+        qint64 totalWaitTime = 0;   // msec spent queued by the dispatched requests
+        qint64 maxWaitTime = 0;     // longest msec a dispatched request was queued
+    };
+
+    static DAIScheduler *instance();
+
+    // Requests of capability running at once, 0 means no limit.
+    void setConcurrencyLimit(const QString &capability, int limit);
+    int concurrencyLimit(const QString &capability) const;
+    // Requests of capability started per second, rate 0 means no limit.
+    void setRateLimit(const QString &capability, double rate, int burst = 1);
+    double rateLimit(const QString &capability) const;
+    int rateBurst(const QString &capability) const;
+
+    Statistics statistics(const QString &capability) const;
+    Statistics statistics() const;
+
+private:
+    explicit DAIScheduler(QObject *parent = nullptr);
+    ~DAIScheduler() override;
+    QScopedPointer<DAISchedulerPrivate> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAISCHEDULER_H
@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAITRANSPORT_H
+#define DAITRANSPORT_H
+
+#include "dtkai_global.h"
+
+#include <QObject>
+#include <QScopedPointer>
+
+DAI_BEGIN_NAMESPACE
+
+/**
+ * @brief Process-wide settings of the D-Bus transport to the ai-daemon
+ *
+ * With the I/O thread enabled, the session proxies of all dtkai clients
+ * live on one internal thread. Stream signals like streamOutput or
+ * requestSynthesisResult are emitted from that thread and reach receivers
+ * through queued connections, so a busy thread that owns a client object
+ * no longer holds back the delivery of tokens or audio to other threads.
+ * Receivers may connect with Qt::DirectConnection to handle them right on
+ * the I/O thread, they must not block there.
+ *
+ * In PeerToPeer mode the session proxies talk to the ai-daemon over a
+ * private connection it hands out, so session traffic skips the routing
+ * hop through the session bus broker. Sessions are still created and
+ * watched on the session bus. When the daemon does not offer a peer
+ * address, or the connection fails, clients fall back to the session bus
+ * until the daemon restarts.
+ *
+ * With per-thread connections enabled, DModelManager queries made from
+ * threads other than the main one go over a bus connection of the calling
+ * thread, so the threads of a QThreadPool do not queue up on the one
+ * connection of the process. A connection is closed when its thread exits.
+ *
+ * Settings apply to sessions opened afterwards.
+ */
+class DAITransportPrivate;
+class DAITransport : public QObject
+{
+    Q_OBJECT
+    friend class DAITransportPrivate;
+public:
+    enum ConnectionMode {
+        SessionBus = 0,
+        PeerToPeer = 1
+    };
+    Q_ENUM(ConnectionMode)
+
+    static DAITransport *instance();
+
+    void setIOThreadEnabled(bool enabled);
+    bool isIOThreadEnabled() const;
+
+    void setConnectionMode(ConnectionMode mode);
+    ConnectionMode connectionMode() const;
+
+    void setPerThreadConnectionsEnabled(bool enabled);
+    bool isPerThreadConnectionsEnabled() const;
+
+private:
+    explicit DAITransport(QObject *parent = nullptr);
+    ~DAITransport() override;
+    QScopedPointer<DAITransportPrivate> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAITRANSPORT_H
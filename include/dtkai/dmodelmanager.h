@@ -7,6 +7,7 @@
 
 #include "dtkai_global.h"
 #include "dtkaitypes.h"
+#include "dairequestoptions.h"
 
 #include <QStringList>
 #include <QVariantHash>
@@ -34,22 +35,29 @@ class DModelManager
 public:
     // Get supported capabilities
     // return "Chat", "SpeechToText" etc.
-    static QStringList supportedCapabilities();
-    static bool isCapabilityAvailable(const QString &capability);
+    static QStringList supportedCapabilities(const DAIRequestOptions &options = {});
+    static bool isCapabilityAvailable(const QString &capability, const DAIRequestOptions &options = {});
 
     // Static query interfaces - read-only model information
     // capability is query from supportedCapabilities.
-    static QList<ModelInfo> availableModels(const QString &capability);
-    static QList<ModelInfo> availableModels(); // All models
-    static ModelInfo modelInfo(const QString &modelName);
+    static QList<ModelInfo> availableModels(const QString &capability, const DAIRequestOptions &options = {});
+    static QList<ModelInfo> availableModels(const DAIRequestOptions &options = {}); // All models
+    static ModelInfo modelInfo(const QString &modelName, const DAIRequestOptions &options = {});
     
     // Get the currently selected model for a specific capability
-    static QString currentModelForCapability(const QString &capability);
+    static QString currentModelForCapability(const QString &capability, const DAIRequestOptions &options = {});
 
     // Get list of all available model providers
-    static QStringList getProviderList();
+    static QStringList getProviderList(const DAIRequestOptions &options = {});
     // Get list of models for a specific provider
-    static QList<ModelInfo> getModelsForProvider(const QString &provider);
+    static QList<ModelInfo> getModelsForProvider(const QString &provider, const DAIRequestOptions &options = {});
+
+    // Identical availableModels() and modelInfo() queries running at the same
+    // time in different threads share one D-Bus call, unless they have a
+    // deadline. Disabled by default.
+    static void setRequestCoalescingEnabled(bool enabled);
+    static bool isRequestCoalescingEnabled();
+    static DAICoalescingStatistics coalescingStatistics();
 
 private:
     // Private constructor - static class only
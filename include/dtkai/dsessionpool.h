@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DSESSIONPOOL_H
+#define DSESSIONPOOL_H
+
+#include "dtkai_global.h"
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+
+DAI_BEGIN_NAMESPACE
+
+/**
+ * @brief Process-wide pool of warm ai-daemon sessions
+ *
+ * Sessions are keyed by capability type ("Chat", "FunctionCalling",
+ * "SpeechToText", "OCR" ...). Client objects lease a session with acquire()
+ * and hand it back with release() instead of creating and destroying a
+ * daemon session for every object.
+ *
+ * The pool watches the daemon on the session bus. When it goes away every
+ * session is forgotten and generation() changes, once it is back the types
+ * in use are warmed up again in the background.
+ */
+class DSessionPoolPrivate;
+class DSessionPool : public QObject
+{
+    Q_OBJECT
+    friend class DSessionPoolPrivate;
+public:
+    struct Statistics {
+        quint64 hits = 0;       // acquire() served from an idle session
+        quint64 misses = 0;     // acquire() had to create a session
+        quint64 evictions = 0;  // idle sessions destroyed by the pool
+        int idle = 0;
+        int leased = 0;
+    };
+
+    static DSessionPool *instance();
+
+    // Idle sessions kept per type even when they exceed the idle timeout.
+    void setMinimumSize(int count);
+    int minimumSize() const;
+    // Idle sessions retained per type, surplus sessions are destroyed on release.
+    void setMaximumSize(int count);
+    int maximumSize() const;
+    // Idle sessions older than this are evicted, 0 disables eviction.
+    void setIdleTimeout(int msec);
+    int idleTimeout() const;
+
+    QString acquire(const QString &type);
+    // Sessions not leased from the pool in the current generation are ignored.
+    void release(const QString &type, const QString &sessionId);
+    // Drop a leased session that is known to be broken.
+    void discard(const QString &type, const QString &sessionId);
+
+    // Create sessions until minimumSize() idle sessions of type are available.
+    void warmUp(const QString &type);
+    void evictIdle();
+    // Destroy the idle sessions and stop pooling, sessions released afterwards are destroyed.
+    void clear();
+
+    Statistics statistics(const QString &type) const;
+    Statistics statistics() const;
+
+    // Changes whenever the daemon goes away, sessions leased under an older
+    // generation no longer exist.
+    quint64 generation() const;
+    bool isDaemonAvailable() const;
+
+Q_SIGNALS:
+    void daemonStopped();
+    void daemonStarted();
+
+private:
+    explicit DSessionPool(QObject *parent = nullptr);
+    ~DSessionPool() override;
+    QScopedPointer<DSessionPoolPrivate> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DSESSIONPOOL_H
@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DSTREAMREADER_H
+#define DSTREAMREADER_H
+
+#include "dtkai_global.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QScopedPointer>
+
+DAI_BEGIN_NAMESPACE
+
+class DChatCompletions;
+class DTextToSpeech;
+
+/**
+ * @brief Pull-based reader of a chat or synthesis stream with a bounded buffer
+ *
+ * The reader takes the output of one request straight from the thread
+ * that delivers it, so no signal event is queued per token or audio chunk.
+ * The consumer pulls with read() when readyRead() tells it, or blocks in
+ * waitForData() from a worker thread. readyRead() is emitted once whenever
+ * the buffer stops being empty, not for every chunk.
+ *
+ * At most capacity() bytes are buffered. When the consumer falls behind,
+ * overflowPolicy() decides what happens. The daemon cannot be paused, so
+ * the default DropOldest and DropNewest keep the buffer bounded at the cost
+ * of the data counted in droppedBytes(). A chunk larger than the whole
+ * buffer keeps only its last capacity() bytes under DropOldest.
+ *
+ * With Block a delivering thread of its own waits until the buffer drains
+ * below lowWatermark(). Streams are delivered in the thread of the reader
+ * or in the shared I/O thread of DAITransport though. Waiting in the former
+ * would keep the consumer from reading and in the latter would stall every
+ * other proxy and stream, so Block falls back to DropOldest there. It does
+ * not hold back the daemon.
+ *
+ * There is no policy coalescing the data itself: tokens and audio chunks
+ * take as many bytes merged as apart, so merging them would not bound the
+ * buffer. What piles up without a reader is one signal event per chunk,
+ * and those are coalesced into a single readyRead() already.
+ *
+ * Attach right after starting the stream, in the thread that started it.
+ */
+class DStreamReaderPrivate;
+class DStreamReader : public QObject
+{
+    Q_OBJECT
+    friend class DStreamReaderPrivate;
+public:
+    enum OverflowPolicy {
+        Block,          // a delivering thread of its own waits for the consumer
+        DropOldest,     // buffered data makes room for new data
+        DropNewest      // new data is discarded while the buffer is full
+    };
+    Q_ENUM(OverflowPolicy)
+
+    explicit DStreamReader(QObject *parent = nullptr);
+    ~DStreamReader() override;
+
+    // Reads the output of startChatStream(), as UTF-8 text.
+    bool attach(DChatCompletions *chat, quint64 requestId);
+    // Reads the audio of startSynthesisStream().
+    bool attach(DTextToSpeech *tts, quint64 requestId);
+
+    void setCapacity(qint64 bytes);
+    qint64 capacity() const;
+    void setLowWatermark(qint64 bytes);
+    qint64 lowWatermark() const;
+    void setOverflowPolicy(OverflowPolicy policy);
+    OverflowPolicy overflowPolicy() const;
+
+    qint64 bytesAvailable() const;
+    // Up to maxSize bytes, everything buffered when maxSize is negative.
+    QByteArray read(qint64 maxSize = -1);
+    // Everything buffered as text, a character split by the chunk boundary is kept for the next call.
+    QString readText();
+    // Waits until data is available or the stream ended, returns whether data is available.
+    bool waitForData(int msecs = -1);
+    // The stream ended and everything was read.
+    bool atEnd() const;
+    // Error the stream ended with, 0 while it runs or when it succeeded.
+    int error() const;
+    quint64 droppedBytes() const;
+
+Q_SIGNALS:
+    void readyRead();
+    void finished(int error);
+
+private:
+    QScopedPointer<DStreamReaderPrivate> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DSTREAMREADER_H
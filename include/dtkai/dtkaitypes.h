@@ -7,8 +7,13 @@
 
 #include "dtkai_global.h"
 
+#include <DError>
+
+#include <QMetaType>
 #include <QString>
 
+#include <functional>
+
 DAI_BEGIN_NAMESPACE
 
 struct ChatHistory
@@ -21,6 +26,47 @@ inline constexpr char kChatRoleUser[] { "user" };
 inline constexpr char kChatRoleAssistant[] { "assistant" };
 inline constexpr char kChatRoleSystem[] { "system" };
 
+// Completion callback of the asynchronous requests, invoked on the thread of the client object.
+template <typename T>
+using DAIReplyCallback = std::function<void(const T &result, const DTK_CORE_NAMESPACE::DError &error)>;
+
+// Counters of in-flight request coalescing, see setRequestCoalescingEnabled() of the clients.
+struct DAICoalescingStatistics
+{
+    quint64 calls = 0;  // requests that went to the daemon
+    quint64 hits = 0;   // requests that shared the reply of an identical one in flight
+};
+
+// Duplicate requests to a second model, see setHedgingPolicy() of the clients.
+// Typically the primary model is a local one and the secondary a cloud one, see ModelInfo::deployType.
+struct DAIHedgingPolicy
+{
+    QString secondaryModel;     // model of the duplicate, empty disables hedging
+    double percentile = 95;     // of the recent latencies of the primary model
+    int minimumDelay = 100;     // msec, the duplicate is never sent sooner
+};
+
+// Timing of one streamed chat, see DChatCompletions::requestStreamStats().
+// Times are in microseconds from sending the request to the daemon. The daemon
+// emits one output per token, so outputs are counted as tokens.
+struct DAIStreamStats
+{
+    int tokens = 0;
+    qint64 timeToFirstToken = -1;   // -1 when nothing was streamed
+    qint64 duration = 0;            // until the stream finished
+
+    // Gaps between consecutive tokens.
+    qint64 gapMin = 0;
+    qint64 gapP50 = 0;
+    qint64 gapP90 = 0;
+    qint64 gapP99 = 0;
+    qint64 gapMax = 0;
+
+    double tokensPerSecond = 0;     // from the first to the last token, 0 with fewer than two
+};
+
 DAI_END_NAMESPACE
 
+Q_DECLARE_METATYPE(DAI_NAMESPACE::DAIStreamStats)
+
 #endif // DTKAITYPES_H
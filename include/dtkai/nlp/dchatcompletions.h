@@ -7,6 +7,7 @@
 
 #include "dtkai_global.h"
 #include "dtkaitypes.h"
+#include "dairequestoptions.h"
 
 #include <DError>
 
@@ -24,12 +25,37 @@ public:
     explicit DChatCompletions(QObject *parent = nullptr);
     ~DChatCompletions();
     bool chatStream(const QString &prompt, const QList<ChatHistory> &history = {}, const QVariantHash &params = {});
-    QString chat(const QString &prompt, const QList<ChatHistory> &history = {}, const QVariantHash &params = {});
+    QString chat(const QString &prompt, const QList<ChatHistory> &history = {}, const QVariantHash &params = {},
+                 const DAIRequestOptions &options = {});
+
+    // Per-request API, any number of requests may be outstanding on one object.
+    // Both return the request id, or 0 when the request could not be sent.
+    // Non-blocking chat, callback receives the content once the daemon replies.
+    quint64 chatAsync(const QString &prompt, const DAIReplyCallback<QString> &callback,
+                      const QList<ChatHistory> &history = {}, const QVariantHash &params = {},
+                      const DAIRequestOptions &options = {});
+    // Streaming chat reported through requestStreamOutput and requestStreamFinished,
+    // requestStreamStats is emitted right before requestStreamFinished.
+    quint64 startChatStream(const QString &prompt, const QList<ChatHistory> &history = {}, const QVariantHash &params = {},
+                            const DAIRequestOptions &options = {});
+    void terminateRequest(quint64 requestId);
+
+    // Hedging of chatAsync() and startChatStream(). When the model asked for has not
+    // replied, or streamed its first token, within the percentile of its recent latency,
+    // the request is sent to policy.secondaryModel as well. The first to answer wins and
+    // the other one is terminated. Requests are hedged once a few latencies are known.
+    void setHedgingPolicy(const DAIHedgingPolicy &policy);
+    DAIHedgingPolicy hedgingPolicy() const;
+
     void terminate();
     DTK_CORE_NAMESPACE::DError lastError() const;
 Q_SIGNALS:
     void streamOutput(const QString &content);
     void streamFinished(int error);
+    void streamStats(const DAIStreamStats &stats);
+    void requestStreamOutput(quint64 requestId, const QString &content);
+    void requestStreamFinished(quint64 requestId, int error);
+    void requestStreamStats(quint64 requestId, const DAIStreamStats &stats);
 private:
     QScopedPointer<DChatCompletionsPrivate> d;
 };
@@ -6,6 +6,8 @@
 #define DEMBEDDINGPLATFORM_H
 
 #include <dtkai_global.h>
+#include <dtkaitypes.h>
+#include <dairequestoptions.h>
 
 #include <DObject>
 #include <DError>
@@ -65,14 +67,34 @@ public:
     ~DEmbeddingPlatform();
 
     QString embeddingModels();
-    QList<DocumentInfo> uploadDocuments(const QString &appId, const QStringList &files, const QString &extensionParams = QString());
-    bool deleteDocuments(const QString &appId, const QStringList &documentIds);
-    QList<SearchResult> search(const QString &appId, const QString &query, const QString &extensionParams = QString());
+    QList<DocumentInfo> uploadDocuments(const QString &appId, const QStringList &files, const QString &extensionParams = QString(),
+                                        const DAIRequestOptions &options = {});
+    bool deleteDocuments(const QString &appId, const QStringList &documentIds, const DAIRequestOptions &options = {});
+    QList<SearchResult> search(const QString &appId, const QString &query, const QString &extensionParams = QString(),
+                               const DAIRequestOptions &options = {});
     // TODO: taskId not found.
     bool cancelTask(const QString &taskId);
-    QList<DocumentInfo> documentsInfo(const QString &appId, const QStringList &documentIds = {});
-    bool buildIndex(const QString &appId, const QString &docId, const QString &extensionParams = QString());
-    bool destroyIndex(const QString &appId, bool allIndex, const QString &extensionParams = QString());
+    QList<DocumentInfo> documentsInfo(const QString &appId, const QStringList &documentIds = {}, const DAIRequestOptions &options = {});
+    bool buildIndex(const QString &appId, const QString &docId, const QString &extensionParams = QString(),
+                    const DAIRequestOptions &options = {});
+    bool destroyIndex(const QString &appId, bool allIndex, const QString &extensionParams = QString(),
+                      const DAIRequestOptions &options = {});
+
+    // Asynchronous variants, callback receives the result once the daemon replies.
+    quint64 uploadDocumentsAsync(const QString &appId, const QStringList &files,
+                                 const DAIReplyCallback<QList<DocumentInfo>> &callback,
+                                 const QString &extensionParams = QString(), const DAIRequestOptions &options = {});
+    quint64 searchAsync(const QString &appId, const QString &query,
+                        const DAIReplyCallback<QList<SearchResult>> &callback,
+                        const QString &extensionParams = QString(), const DAIRequestOptions &options = {});
+    // The callback of requestId is invoked with RequestCancelled, the daemon finishes the work anyway.
+    void terminateRequest(quint64 requestId);
+
+    // Identical blocking search() calls running at the same time in different
+    // threads share one D-Bus call and its parsed result. Disabled by default.
+    static void setRequestCoalescingEnabled(bool enabled);
+    static bool isRequestCoalescingEnabled();
+    static DAICoalescingStatistics coalescingStatistics();
 
     DTK_CORE_NAMESPACE::DError lastError() const;
 };
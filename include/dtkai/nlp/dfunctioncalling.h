@@ -7,6 +7,7 @@
 
 #include "dtkai_global.h"
 #include "dtkaitypes.h"
+#include "dairequestoptions.h"
 
 #include <DError>
 
@@ -23,7 +24,16 @@ class DFunctionCalling : public QObject
 public:
     explicit DFunctionCalling(QObject *parent = nullptr);
     ~DFunctionCalling();
-    QString parse(const QString &prompt, const QString &functions, const QVariantHash &params = {});
+    QString parse(const QString &prompt, const QString &functions, const QVariantHash &params = {},
+                  const DAIRequestOptions &options = {});
+    // Non-blocking parse, callback receives the function JSON once the daemon replies.
+    // Returns the request id, or 0 when the request could not be sent.
+    quint64 parseAsync(const QString &prompt, const QString &functions, const DAIReplyCallback<QString> &callback,
+                       const QVariantHash &params = {}, const DAIRequestOptions &options = {});
+    void terminateRequest(quint64 requestId);
+    // Hedging of parseAsync(), see DChatCompletions::setHedgingPolicy().
+    void setHedgingPolicy(const DAIHedgingPolicy &policy);
+    DAIHedgingPolicy hedgingPolicy() const;
     void terminate();
     DTK_CORE_NAMESPACE::DError lastError() const;
 private:
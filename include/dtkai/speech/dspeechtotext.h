@@ -7,6 +7,7 @@
 
 #include "dtkai_global.h"
 #include "dtkaitypes.h"
+#include "dairequestoptions.h"
 
 #include <DError>
 
@@ -22,22 +23,44 @@ class DSpeechToText : public QObject
     Q_OBJECT
     friend class DSpeechToTextPrivate;
 public:
+    // How audio of stream recognition reaches the daemon.
+    enum StreamTransport {
+        DBusTransport,          // One D-Bus call per audio chunk
+        SharedMemoryTransport   // A shared-memory ring, falls back to D-Bus if the daemon lacks support
+    };
+    Q_ENUM(StreamTransport)
+
     explicit DSpeechToText(QObject *parent = nullptr);
     ~DSpeechToText();
     
     // File-based recognition
-    QString recognizeFile(const QString &audioFile, const QVariantHash &params = {});
+    QString recognizeFile(const QString &audioFile, const QVariantHash &params = {}, const DAIRequestOptions &options = {});
+    // Returns the request id, or 0 when the request could not be sent.
+    quint64 recognizeFileAsync(const QString &audioFile, const DAIReplyCallback<QString> &callback,
+                               const QVariantHash &params = {}, const DAIRequestOptions &options = {});
     
     // Stream-based recognition
     bool startStreamRecognition(const QVariantHash &params = {});
     bool sendAudioData(const QByteArray &audioData);
     QString endStreamRecognition();
+
+    // Per-request stream recognition, any number of streams may run on one object.
+    // Progress is reported through the request* signals, 0 is returned on failure.
+    quint64 startRecognitionStream(const QVariantHash &params = {}, const DAIRequestOptions &options = {});
+    bool sendStreamAudio(quint64 requestId, const QByteArray &audioData);
+    QString endRecognitionStream(quint64 requestId);
+
+    // Applies to streams started afterwards. With SharedMemoryTransport, sending
+    // audio fails instead of blocking when the daemon falls too far behind.
+    void setStreamTransport(StreamTransport transport);
+    StreamTransport streamTransport() const;
     
     // Control methods
     void terminate();
+    void terminateRequest(quint64 requestId);
     
     // Information methods
-    QStringList getSupportedFormats();
+    QStringList getSupportedFormats(const DAIRequestOptions &options = {});
     
     // Error handling
     DTK_CORE_NAMESPACE::DError lastError() const;
@@ -48,6 +71,11 @@ Q_SIGNALS:
     void recognitionPartialResult(const QString &partialText);
     void recognitionError(int errorCode, const QString &errorMessage);
     void recognitionCompleted(const QString &finalText);
+
+    void requestRecognitionResult(quint64 requestId, const QString &text);
+    void requestRecognitionPartialResult(quint64 requestId, const QString &partialText);
+    void requestRecognitionError(quint64 requestId, int errorCode, const QString &errorMessage);
+    void requestRecognitionCompleted(quint64 requestId, const QString &finalText);
     
 private:
     QScopedPointer<DSpeechToTextPrivate> d;
@@ -7,6 +7,7 @@
 
 #include "dtkai_global.h"
 #include "dtkaitypes.h"
+#include "dairequestoptions.h"
 
 #include <DError>
 
@@ -28,12 +29,18 @@ public:
     // Stream-based synthesis
     bool startStreamSynthesis(const QString &text, const QVariantHash &params = {});
     QByteArray endStreamSynthesis();
+
+    // Per-request stream synthesis, any number of streams may run on one object.
+    // Progress is reported through the request* signals, 0 is returned on failure.
+    quint64 startSynthesisStream(const QString &text, const QVariantHash &params = {}, const DAIRequestOptions &options = {});
+    QByteArray endSynthesisStream(quint64 requestId);
     
     // Control methods
     void terminate();
+    void terminateRequest(quint64 requestId);
     
     // Information methods
-    QStringList getSupportedVoices();
+    QStringList getSupportedVoices(const DAIRequestOptions &options = {});
     
     // Error handling
     DTK_CORE_NAMESPACE::DError lastError() const;
@@ -43,6 +50,10 @@ Q_SIGNALS:
     void synthesisResult(const QByteArray &audioData);
     void synthesisError(int errorCode, const QString &errorMessage);
     void synthesisCompleted(const QByteArray &finalAudio);
+
+    void requestSynthesisResult(quint64 requestId, const QByteArray &audioData);
+    void requestSynthesisError(quint64 requestId, int errorCode, const QString &errorMessage);
+    void requestSynthesisCompleted(quint64 requestId, const QByteArray &finalAudio);
     
 private:
     QScopedPointer<DTextToSpeechPrivate> d;
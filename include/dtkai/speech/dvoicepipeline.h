@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DVOICEPIPELINE_H
+#define DVOICEPIPELINE_H
+
+#include "dtkai_global.h"
+#include "dtkaitypes.h"
+
+#include <DError>
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QVariant>
+
+DAI_BEGIN_NAMESPACE
+
+class DSpeechToText;
+class DChatCompletions;
+class DTextToSpeech;
+
+/**
+ * @brief Spoken turn of an assistant: speech recognition, chat and speech synthesis
+ *
+ * The stages overlap. Chat starts on the final recognition, the streamed
+ * reply is cut at sentence boundaries and every sentence is synthesized
+ * while the model is still generating the next one. Audio is emitted in
+ * the order of the reply, so the first sentence is heard as soon as it
+ * is synthesized. Finished turns are appended to history().
+ *
+ * A turn starts with start() and audio of the user, or with respond() and
+ * text. Signals are emitted in the thread of the pipeline, which must run
+ * an event loop.
+ */
+class DVoicePipelinePrivate;
+class DVoicePipeline : public QObject
+{
+    Q_OBJECT
+    friend class DVoicePipelinePrivate;
+public:
+    // Latencies of the last turn in msec, -1 until reached.
+    struct Latency {
+        qint64 recognition = -1;    // end of speech to the final recognition
+        qint64 firstToken = -1;     // final recognition to the first token of the reply
+        qint64 firstSentence = -1;  // final recognition to the first sentence sent to synthesis
+        qint64 firstAudio = -1;     // end of speech to the first audio, the time to first audio
+        qint64 chat = -1;           // final recognition to the end of the reply
+        qint64 total = -1;          // end of speech to the last audio
+    };
+
+    explicit DVoicePipeline(QObject *parent = nullptr);
+    ~DVoicePipeline();
+
+    // The clients of the stages, e.g. to set their transport or hedging policy.
+    DSpeechToText *speechToText() const;
+    DChatCompletions *chatCompletions() const;
+    DTextToSpeech *textToSpeech() const;
+
+    void setRecognitionParams(const QVariantHash &params);
+    void setChatParams(const QVariantHash &params);
+    void setSynthesisParams(const QVariantHash &params);
+    void setHistory(const QList<ChatHistory> &history);
+    QList<ChatHistory> history() const;
+
+    // Starts a turn by listening, audio is passed to sendAudio().
+    bool start();
+    bool sendAudio(const QByteArray &audioData);
+    // The user stopped speaking, the final recognition starts the reply.
+    bool endSpeech();
+    // Starts a turn from text, skipping recognition.
+    bool respond(const QString &text);
+    // Aborts the turn, finished() reports RequestCancelled.
+    void stop();
+    bool isRunning() const;
+
+    Latency latency() const;
+    DTK_CORE_NAMESPACE::DError lastError() const;
+
+Q_SIGNALS:
+    void partialRecognized(const QString &text);
+    void recognized(const QString &text);
+    void replyOutput(const QString &content);
+    void audioOutput(const QByteArray &audioData);
+    void finished(int error);
+
+private:
+    QScopedPointer<DVoicePipelinePrivate> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DVOICEPIPELINE_H
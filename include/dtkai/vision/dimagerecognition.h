@@ -7,6 +7,8 @@
 
 
 #include "dtkai_global.h"
+#include "dtkaitypes.h"
+#include "dairequestoptions.h"
 #include <DError>
 
 #include <QObject>
@@ -33,21 +35,31 @@ public:
     
     // Synchronous recognition methods
     QString recognizeImage(const QString &imagePath, const QString &prompt = QString(), 
-                          const QVariantHash &params = {});
+                          const QVariantHash &params = {}, const DAIRequestOptions &options = {});
     QString recognizeImageData(const QByteArray &imageData, const QString &prompt = QString(),
-                              const QVariantHash &params = {});
+                              const QVariantHash &params = {}, const DAIRequestOptions &options = {});
     QString recognizeImageUrl(const QString &imageUrl, const QString &prompt = QString(),
-                             const QVariantHash &params = {});
+                             const QVariantHash &params = {}, const DAIRequestOptions &options = {});
+
+    // Asynchronous recognition methods, callback receives the content once the daemon replies.
+    // Return the request id, or 0 when the request could not be sent.
+    quint64 recognizeImageAsync(const QString &imagePath, const DAIReplyCallback<QString> &callback,
+                                const QString &prompt = QString(), const QVariantHash &params = {},
+                                const DAIRequestOptions &options = {});
+    quint64 recognizeImageDataAsync(const QByteArray &imageData, const DAIReplyCallback<QString> &callback,
+                                    const QString &prompt = QString(), const QVariantHash &params = {},
+                                    const DAIRequestOptions &options = {});
     
     // Information query methods
-    QStringList getSupportedImageFormats();
-    int getMaxImageSize();
+    QStringList getSupportedImageFormats(const DAIRequestOptions &options = {});
+    int getMaxImageSize(const DAIRequestOptions &options = {});
     
     // Error handling
     DTK_CORE_NAMESPACE::DError lastError() const;
     
     // Control methods
     void terminate();
+    void terminateRequest(quint64 requestId);
     
 private:
     QScopedPointer<DImageRecognitionPrivate> d;
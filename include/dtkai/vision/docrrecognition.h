@@ -6,6 +6,8 @@
 #define DOCRRECOGNITION_H
 
 #include "dtkai_global.h"
+#include "dtkaitypes.h"
+#include "dairequestoptions.h"
 #include <DError>
 #include <QObject>
 #include <QVariantHash>
@@ -23,34 +25,52 @@ public:
     ~DOCRRecognition();
     
     // Synchronous OCR methods
-    QString recognizeFile(const QString &imageFile, const QVariantHash &params = {});
-    QString recognizeImage(const QByteArray &imageData, const QVariantHash &params = {});
+    QString recognizeFile(const QString &imageFile, const QVariantHash &params = {}, const DAIRequestOptions &options = {});
+    QString recognizeImage(const QByteArray &imageData, const QVariantHash &params = {}, const DAIRequestOptions &options = {});
+
+    // Asynchronous OCR methods, callback receives the recognized text once the daemon replies.
+    // Return the request id, or 0 when the request could not be sent.
+    quint64 recognizeFileAsync(const QString &imageFile, const DAIReplyCallback<QString> &callback,
+                               const QVariantHash &params = {}, const DAIRequestOptions &options = {});
+    quint64 recognizeImageAsync(const QByteArray &imageData, const DAIReplyCallback<QString> &callback,
+                                const QVariantHash &params = {}, const DAIRequestOptions &options = {});
     
     /**
      * @brief Recognize text within a specific region of an image
      * @param imageFile Path to the image file to be analyzed. Must be an absolute path for security reasons.
      * @param region String definition of the region to analyze (e.g., "10,20,100,50" for x,y,width,height)
      * @param params Optional parameters to customize the OCR behavior (language, format options, etc.)
+     * @param options Priority and deadline of the request
      * @return Recognized text as a QString, or empty string if an error occurred
      */
-    QString recognizeRegionFromString(const QString &imageFile, const QString &region, const QVariantHash &params = {});
+    QString recognizeRegionFromString(const QString &imageFile, const QString &region, const QVariantHash &params = {},
+                                      const DAIRequestOptions &options = {});
     
     /**
      * @brief Recognize text within a specific rectangular region of an image
      * @param imageFile Path to the image file to be analyzed. Must be an absolute path for security reasons.
      * @param region QRect object defining the region to analyze (x, y, width, height)
      * @param params Optional parameters to customize the OCR behavior (language, format options, etc.)
+     * @param options Priority and deadline of the request
      * @return Recognized text as a QString, or empty string if an error occurred
      */
-    QString recognizeRegionFromRect(const QString &imageFile, const QRect &region, const QVariantHash &params = {});
+    QString recognizeRegionFromRect(const QString &imageFile, const QRect &region, const QVariantHash &params = {},
+                                    const DAIRequestOptions &options = {});
     
     // Information query methods
-    QStringList getSupportedLanguages();
-    QStringList getSupportedFormats();
-    QString getCapabilities();
+    QStringList getSupportedLanguages(const DAIRequestOptions &options = {});
+    QStringList getSupportedFormats(const DAIRequestOptions &options = {});
+    QString getCapabilities(const DAIRequestOptions &options = {});
     
     // Control methods  
     void terminate();
+    void terminateRequest(quint64 requestId);
+
+    // Identical blocking recognize calls running at the same time in different
+    // threads share one D-Bus call and its result. Disabled by default.
+    static void setRequestCoalescingEnabled(bool enabled);
+    static bool isRequestCoalescingEnabled();
+    static DAICoalescingStatistics coalescingStatistics();
     
     // Error handling
     DTK_CORE_NAMESPACE::DError lastError() const;
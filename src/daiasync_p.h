@@ -0,0 +1,61 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIASYNC_P_H
+#define DAIASYNC_P_H
+
+#include "dtkai_global.h"
+#include "daierror.h"
+#include "daicircuitbreaker_p.h"
+
+#include <DError>
+
+#include <QAtomicInteger>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QThread>
+
+DAI_BEGIN_NAMESPACE
+
+// Invoke func(const QDBusPendingCall &) in the thread of context once call finishes.
+// Nothing is invoked if context is destroyed first. The outcome is always reported
+// to the circuit breaker. Called from another thread (e.g. a scheduler admitting a
+// request issued from a thread pool) the watcher is created in the thread of context,
+// a watcher living in a thread without an event loop would never emit finished.
+template <typename Func>
+inline void watchPendingCall(const QDBusPendingCall &call, QObject *context, Func func)
+{
+    if (QThread::currentThread() != context->thread()) {
+        QMetaObject::invokeMethod(context, [call, context, func]() {
+            watchPendingCall(call, context, func);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    auto watcher = new QDBusPendingCallWatcher(call, context);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished, context, [watcher, func]() {
+        recordCallResult(*watcher);
+        func(*watcher);
+        watcher->deleteLater();
+    });
+}
+
+// Process-wide unique id of a request, 0 is never returned.
+inline quint64 nextRequestId()
+{
+    static QAtomicInteger<quint64> lastId;
+    return ++lastId;
+}
+
+inline DTK_CORE_NAMESPACE::DError pendingCallError(const QDBusPendingCall &call)
+{
+    if (call.isError())
+        return DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, call.error().message());
+
+    return DTK_CORE_NAMESPACE::DError(NoError, "");
+}
+
+DAI_END_NAMESPACE
+
+#endif // DAIASYNC_P_H
@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daicircuitbreaker.h"
+#include "daicircuitbreaker_p.h"
+#include "dsessionpool.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+
+Q_LOGGING_CATEGORY(dtkaiCircuitBreaker, "dtkai.circuitbreaker")
+
+DAI_BEGIN_NAMESPACE
+
+DAICircuitBreakerPrivate::DAICircuitBreakerPrivate(DAICircuitBreaker *parent)
+    : q(parent)
+{
+}
+
+bool DAICircuitBreakerPrivate::transition(DAICircuitBreaker::State to)
+{
+    if (state == to)
+        return false;
+
+    qCInfo(dtkaiCircuitBreaker) << "Circuit breaker" << state << "->" << to;
+    state = to;
+    failures = 0;
+    successes = 0;
+    probing = false;
+    since.start();
+    return true;
+}
+
+bool DAICircuitBreakerPrivate::isTransportFailure(const QDBusError &error)
+{
+    switch (error.type()) {
+    case QDBusError::NoReply:
+    case QDBusError::Timeout:
+    case QDBusError::TimedOut:
+    case QDBusError::ServiceUnknown:
+    case QDBusError::NoServer:
+    case QDBusError::NoNetwork:
+    case QDBusError::Disconnected:
+    case QDBusError::LimitsExceeded:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void recordCallResult(const QDBusError &error)
+{
+    if (DAICircuitBreakerPrivate::isTransportFailure(error))
+        DAICircuitBreaker::instance()->recordFailure();
+    else
+        DAICircuitBreaker::instance()->recordSuccess();
+}
+
+DAICircuitBreaker::DAICircuitBreaker(QObject *parent)
+    : QObject(parent)
+    , d(new DAICircuitBreakerPrivate(this))
+{
+    // A freshly started daemon deserves a fresh chance.
+    connect(DSessionPool::instance(), &DSessionPool::daemonStarted, this, &DAICircuitBreaker::reset);
+
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        if (thread() != app->thread())
+            moveToThread(app->thread());
+    }
+}
+
+DAICircuitBreaker::~DAICircuitBreaker()
+{
+
+}
+
+DAICircuitBreaker *DAICircuitBreaker::instance()
+{
+    // Intentionally never deleted, it is used until the very end of the process.
+    static DAICircuitBreaker *breaker = new DAICircuitBreaker;
+    return breaker;
+}
+
+void DAICircuitBreaker::setFailureThreshold(int count)
+{
+    QMutexLocker lk(&d->mtx);
+    d->failureThreshold = qMax(0, count);
+}
+
+int DAICircuitBreaker::failureThreshold() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->failureThreshold;
+}
+
+void DAICircuitBreaker::setOpenDuration(int msec)
+{
+    QMutexLocker lk(&d->mtx);
+    d->openDuration = qMax(0, msec);
+}
+
+int DAICircuitBreaker::openDuration() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->openDuration;
+}
+
+void DAICircuitBreaker::setSuccessThreshold(int count)
+{
+    QMutexLocker lk(&d->mtx);
+    d->successThreshold = qMax(1, count);
+}
+
+int DAICircuitBreaker::successThreshold() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->successThreshold;
+}
+
+DAICircuitBreaker::State DAICircuitBreaker::state() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->state;
+}
+
+bool DAICircuitBreaker::allowRequest()
+{
+    QMutexLocker lk(&d->mtx);
+    switch (d->state) {
+    case Closed:
+        return true;
+    case Open:
+        if (d->since.elapsed() < d->openDuration)
+            return false;
+
+        d->transition(HalfOpen);
+        d->probing = true;
+        d->since.start();
+        lk.unlock();
+        emit stateChanged(HalfOpen);
+        return true;
+    case HalfOpen:
+        // A probe that never reported back must not keep the breaker half-open forever.
+        if (d->probing && d->since.elapsed() < d->openDuration)
+            return false;
+
+        d->probing = true;
+        d->since.start();
+        return true;
+    }
+
+    return true;
+}
+
+void DAICircuitBreaker::recordSuccess()
+{
+    QMutexLocker lk(&d->mtx);
+    if (d->state == Closed) {
+        d->failures = 0;
+        return;
+    }
+
+    if (d->state == HalfOpen) {
+        d->probing = false;
+        if (++d->successes >= d->successThreshold && d->transition(Closed)) {
+            lk.unlock();
+            emit stateChanged(Closed);
+        }
+    }
+}
+
+void DAICircuitBreaker::recordFailure()
+{
+    QMutexLocker lk(&d->mtx);
+    if (d->failureThreshold == 0)
+        return;
+
+    if (d->state == HalfOpen || (d->state == Closed && ++d->failures >= d->failureThreshold)) {
+        if (d->transition(Open)) {
+            qCWarning(dtkaiCircuitBreaker) << "AI daemon is not answering, failing requests fast for"
+                                           << d->openDuration << "ms";
+            lk.unlock();
+            emit stateChanged(Open);
+        }
+    }
+}
+
+void DAICircuitBreaker::reset()
+{
+    QMutexLocker lk(&d->mtx);
+    const bool changed = d->transition(Closed);
+    d->failures = 0;
+    lk.unlock();
+
+    if (changed)
+        emit stateChanged(Closed);
+}
+
+DAI_END_NAMESPACE
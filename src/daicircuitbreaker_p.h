@@ -0,0 +1,52 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAICIRCUITBREAKER_P_H
+#define DAICIRCUITBREAKER_P_H
+
+#include "daicircuitbreaker.h"
+
+#include <QDBusError>
+#include <QDBusPendingCall>
+#include <QElapsedTimer>
+#include <QMutex>
+
+DAI_BEGIN_NAMESPACE
+
+class DAICircuitBreakerPrivate
+{
+public:
+    explicit DAICircuitBreakerPrivate(DAICircuitBreaker *q);
+
+    // Moves to state, returns whether it changed. Requires mtx.
+    bool transition(DAICircuitBreaker::State to);
+
+    // Errors meaning the daemon did not answer at all, anything else is a reply.
+    static bool isTransportFailure(const QDBusError &error);
+
+public:
+    mutable QMutex mtx;
+    DAICircuitBreaker::State state = DAICircuitBreaker::Closed;
+    int failureThreshold = 5;
+    int openDuration = 5 * 1000;
+    int successThreshold = 1;
+    int failures = 0;
+    int successes = 0;
+    bool probing = false;
+    QElapsedTimer since;    // entering Open, or start of the current probe
+
+    DAICircuitBreaker *q = nullptr;
+};
+
+// Reports the outcome of a finished D-Bus call to the shared breaker.
+void recordCallResult(const QDBusError &error);
+
+inline void recordCallResult(const QDBusPendingCall &call)
+{
+    recordCallResult(call.error());
+}
+
+DAI_END_NAMESPACE
+
+#endif // DAICIRCUITBREAKER_P_H
@@ -0,0 +1,210 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daiencodedparams.h"
+#include "daiencodedparams_p.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+DAI_BEGIN_NAMESPACE
+
+static void insertExtra(QVariantHash *hash, const QVariantHash &extra)
+{
+    for (auto it = extra.begin(); it != extra.end(); ++it)
+        hash->insert(it.key(), it.value());
+}
+
+QVariantHash DAIChatParams::toHash() const
+{
+    QVariantHash hash;
+    if (!model.isEmpty())
+        hash.insert(kParamModel, model);
+    if (temperature >= 0)
+        hash.insert(kParamTemperature, temperature);
+    if (maxTokens > 0)
+        hash.insert(kParamMaxTokens, maxTokens);
+    if (topP >= 0)
+        hash.insert(kParamTopP, topP);
+
+    insertExtra(&hash, extra);
+    return hash;
+}
+
+QVariantHash DAISpeechParams::toHash() const
+{
+    QVariantHash hash;
+    if (!model.isEmpty())
+        hash.insert(kParamModel, model);
+    if (!language.isEmpty())
+        hash.insert(kParamLanguage, language);
+    if (!format.isEmpty())
+        hash.insert(kParamFormat, format);
+    if (sampleRate > 0)
+        hash.insert(kParamSampleRate, sampleRate);
+
+    insertExtra(&hash, extra);
+    return hash;
+}
+
+QVariantHash DAISynthesisParams::toHash() const
+{
+    QVariantHash hash;
+    if (!model.isEmpty())
+        hash.insert(kParamModel, model);
+    if (!voice.isEmpty())
+        hash.insert(kParamVoice, voice);
+    if (!language.isEmpty())
+        hash.insert(kParamLanguage, language);
+    if (!format.isEmpty())
+        hash.insert(kParamFormat, format);
+    if (sampleRate > 0)
+        hash.insert(kParamSampleRate, sampleRate);
+    if (speed >= 0)
+        hash.insert(kParamSpeed, speed);
+    if (volume >= 0)
+        hash.insert(kParamVolume, volume);
+    if (pitch >= 0)
+        hash.insert(kParamPitch, pitch);
+
+    insertExtra(&hash, extra);
+    return hash;
+}
+
+DAIEncodedParamsData::DAIEncodedParamsData(const QVariantHash &params)
+    : params(params)
+    , json(DAIParamsCache::encode(params))
+{
+    DAIParamsCache::attach(this);
+}
+
+DAIEncodedParamsData::~DAIEncodedParamsData()
+{
+    DAIParamsCache::detach(this);
+}
+
+DAIParamsCache *DAIParamsCache::instance()
+{
+    // Intentionally never deleted, handles may be released during static destruction.
+    static DAIParamsCache *cache = new DAIParamsCache;
+    return cache;
+}
+
+QByteArray DAIParamsCache::serialize(const QVariantHash &params)
+{
+    return QJsonDocument(QJsonObject::fromVariantHash(params)).toJson(QJsonDocument::Compact);
+}
+
+QByteArray DAIParamsCache::encode(const QVariantHash &params)
+{
+    if (params.isEmpty())
+        return QByteArrayLiteral("{}");
+
+    DAIParamsCache *cache = instance();
+    QMutexLocker lk(&cache->mtx);
+    for (DAIEncodedParamsData *data : qAsConst(cache->handles)) {
+        if (data->params.isSharedWith(params))
+            return data->json;
+    }
+
+    for (int i = 0; i < cache->recent.size(); ++i) {
+        if (!cache->recent.at(i).params.isSharedWith(params))
+            continue;
+
+        if (i > 0)
+            cache->recent.move(i, 0);
+        return cache->recent.first().json;
+    }
+    lk.unlock();
+
+    // The copy kept here makes the next modification of the caller's hash detach,
+    // which is cheaper than serializing it on every request.
+    Entry entry { params, serialize(params) };
+
+    lk.relock();
+    cache->recent.prepend(entry);
+    if (cache->recent.size() > kRecentSize)
+        cache->recent.removeLast();
+    return entry.json;
+}
+
+QByteArray DAIParamsCache::members(const QByteArray &json)
+{
+    if (json.size() <= 2)
+        return QByteArray();
+
+    return json.mid(1, json.size() - 2);
+}
+
+void DAIParamsCache::attach(DAIEncodedParamsData *data)
+{
+    if (data->params.isEmpty())
+        return;
+
+    DAIParamsCache *cache = instance();
+    QMutexLocker lk(&cache->mtx);
+    cache->handles.append(data);
+}
+
+void DAIParamsCache::detach(DAIEncodedParamsData *data)
+{
+    if (data->params.isEmpty())
+        return;
+
+    DAIParamsCache *cache = instance();
+    QMutexLocker lk(&cache->mtx);
+    cache->handles.removeOne(data);
+}
+
+DAIEncodedParams::DAIEncodedParams()
+    : DAIEncodedParams(QVariantHash())
+{
+}
+
+DAIEncodedParams::DAIEncodedParams(const QVariantHash &params)
+    : d(new DAIEncodedParamsData(params))
+{
+}
+
+DAIEncodedParams::DAIEncodedParams(const DAIChatParams &params)
+    : DAIEncodedParams(params.toHash())
+{
+}
+
+DAIEncodedParams::DAIEncodedParams(const DAISpeechParams &params)
+    : DAIEncodedParams(params.toHash())
+{
+}
+
+DAIEncodedParams::DAIEncodedParams(const DAISynthesisParams &params)
+    : DAIEncodedParams(params.toHash())
+{
+}
+
+DAIEncodedParams::DAIEncodedParams(const DAIEncodedParams &other) = default;
+DAIEncodedParams &DAIEncodedParams::operator=(const DAIEncodedParams &other) = default;
+DAIEncodedParams::~DAIEncodedParams() = default;
+
+bool DAIEncodedParams::isEmpty() const
+{
+    return d->params.isEmpty();
+}
+
+QVariant DAIEncodedParams::value(const QString &key) const
+{
+    return d->params.value(key);
+}
+
+QVariantHash DAIEncodedParams::params() const
+{
+    return d->params;
+}
+
+QByteArray DAIEncodedParams::json() const
+{
+    return d->json;
+}
+
+DAI_END_NAMESPACE
@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIENCODEDPARAMS_P_H
+#define DAIENCODEDPARAMS_P_H
+
+#include "daiencodedparams.h"
+
+#include <QList>
+#include <QMutex>
+#include <QSharedData>
+
+DAI_BEGIN_NAMESPACE
+
+class DAIEncodedParamsData : public QSharedData
+{
+public:
+    explicit DAIEncodedParamsData(const QVariantHash &params);
+    ~DAIEncodedParamsData();
+
+    QVariantHash params;
+    QByteArray json;
+};
+
+// Process-wide cache of encoded parameters, entries are found by the identity
+// of the hash data, so a lookup costs a few pointer compares and a modified
+// copy never matches.
+class DAIParamsCache
+{
+public:
+    // Compact JSON object of params, cached when params shares its data with a
+    // live DAIEncodedParams or with one of the recently encoded hashes.
+    static QByteArray encode(const QVariantHash &params);
+    // Inner part of a JSON object, to be merged into another one.
+    static QByteArray members(const QByteArray &json);
+
+    static void attach(DAIEncodedParamsData *data);
+    static void detach(DAIEncodedParamsData *data);
+
+    static constexpr int kRecentSize = 16;
+
+private:
+    struct Entry
+    {
+        QVariantHash params;
+        QByteArray json;
+    };
+
+    static DAIParamsCache *instance();
+    static QByteArray serialize(const QVariantHash &params);
+
+    QMutex mtx;
+    QList<DAIEncodedParamsData *> handles;
+    QList<Entry> recent;    // most recent first
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIENCODEDPARAMS_P_H
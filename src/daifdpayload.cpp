@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daifdpayload_p.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(dtkaiFdPayload, "dtkai.fdpayload")
+
+DAI_BEGIN_NAMESPACE
+
+static QMutex capabilityMutex;
+static QHash<QString, bool> capabilities;
+
+bool DAIFdPayload::preferred(const QDBusAbstractInterface *ifs, const QString &method, qint64 size)
+{
+    if (size < kThreshold || !ifs)
+        return false;
+
+    if (!(ifs->connection().connectionCapabilities() & QDBusConnection::UnixFileDescriptorPassing))
+        return false;
+
+    return daemonSupports(ifs, method);
+}
+
+QDBusUnixFileDescriptor DAIFdPayload::fromData(const QByteArray &data)
+{
+    int fd = memfd_create("dtkai-payload", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        qCWarning(dtkaiFdPayload) << "memfd_create failed:" << strerror(errno);
+        return QDBusUnixFileDescriptor();
+    }
+
+    const char *buf = data.constData();
+    qint64 left = data.size();
+    while (left > 0) {
+        ssize_t written = write(fd, buf, static_cast<size_t>(left));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+
+            qCWarning(dtkaiFdPayload) << "Failed to fill memfd:" << strerror(errno);
+            close(fd);
+            return QDBusUnixFileDescriptor();
+        }
+        buf += written;
+        left -= written;
+    }
+
+    // The daemon maps the payload directly, make sure nobody can change it underneath.
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+        qCWarning(dtkaiFdPayload) << "Failed to seal memfd:" << strerror(errno);
+        close(fd);
+        return QDBusUnixFileDescriptor();
+    }
+
+    lseek(fd, 0, SEEK_SET);
+
+    QDBusUnixFileDescriptor ret;
+    ret.giveFileDescriptor(fd);
+    return ret;
+}
+
+void DAIFdPayload::resetCapabilities()
+{
+    QMutexLocker lk(&capabilityMutex);
+    capabilities.clear();
+}
+
+bool DAIFdPayload::daemonSupports(const QDBusAbstractInterface *ifs, const QString &method)
+{
+    const QString key = ifs->interface() + '.' + method;
+    {
+        QMutexLocker lk(&capabilityMutex);
+        auto it = capabilities.constFind(key);
+        if (it != capabilities.constEnd())
+            return it.value();
+    }
+
+    // Older daemons only export the ay variants, ask once and remember.
+    QDBusMessage msg = QDBusMessage::createMethodCall(ifs->service(), ifs->path(),
+                                                      "org.freedesktop.DBus.Introspectable", "Introspect");
+    QDBusMessage reply = ifs->connection().call(msg, QDBus::Block, 5000);
+    bool supported = false;
+    if (reply.type() == QDBusMessage::ReplyMessage && !reply.arguments().isEmpty()) {
+        const QString xml = reply.arguments().first().toString();
+        supported = xml.contains(QString("<method name=\"%1\"").arg(method));
+        qCDebug(dtkaiFdPayload) << key << (supported ? "accepts" : "does not accept") << "file descriptors";
+    } else {
+        // Remembered as well, a daemon that does not answer would block every request for the timeout.
+        qCDebug(dtkaiFdPayload) << "Failed to introspect" << key << reply.errorMessage();
+    }
+
+    QMutexLocker lk(&capabilityMutex);
+    capabilities.insert(key, supported);
+    return supported;
+}
+
+DAI_END_NAMESPACE
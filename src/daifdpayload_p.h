@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIFDPAYLOAD_P_H
+#define DAIFDPAYLOAD_P_H
+
+#include "dtkai_global.h"
+
+#include <QByteArray>
+#include <QDBusAbstractInterface>
+#include <QDBusUnixFileDescriptor>
+
+DAI_BEGIN_NAMESPACE
+
+// Passes large byte payloads to the daemon as a Unix file descriptor (D-Bus type h)
+// instead of an inline byte array (ay), which libdbus and the bus broker copy several times.
+class DAIFdPayload
+{
+public:
+    // Payloads below this size are cheaper to send inline.
+    static constexpr int kThreshold = 64 * 1024;
+
+    // Whether a payload of size bytes should go through method of ifs as a file descriptor.
+    // Requires fd passing on the connection and the method to be exported by the daemon.
+    static bool preferred(const QDBusAbstractInterface *ifs, const QString &method, qint64 size);
+
+    // Copies data into an anonymous memfd sealed against any further change.
+    // Returns an invalid descriptor on failure, the caller should fall back to ay.
+    static QDBusUnixFileDescriptor fromData(const QByteArray &data);
+
+    // Whether the daemon behind ifs exports method, looked up once by introspection.
+    // A failed lookup counts as unsupported until resetCapabilities().
+    static bool daemonSupports(const QDBusAbstractInterface *ifs, const QString &method);
+
+    // Forgets which daemon methods are known, called whenever the daemon stops or starts.
+    static void resetCapabilities();
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIFDPAYLOAD_P_H
@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daihedging_p.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+DAI_BEGIN_NAMESPACE
+
+// Latencies kept per model, and how many are needed before requests are hedged.
+static constexpr int kLatencyWindow = 64;
+static constexpr int kMinimumSamples = 8;
+
+struct LatencyWindow
+{
+    QVector<qint64> samples;
+    int next = 0;
+};
+
+static QMutex *latencyMutex()
+{
+    static QMutex mtx;
+    return &mtx;
+}
+
+static QHash<QString, LatencyWindow> *latencyWindows()
+{
+    static QHash<QString, LatencyWindow> windows;
+    return &windows;
+}
+
+static QString latencyKey(const QString &capability, const QString &model)
+{
+    return capability + QLatin1Char('/') + model;
+}
+
+bool DAIHedging::isEnabled(const DAIHedgingPolicy &policy, const QVariantHash &params)
+{
+    return !policy.secondaryModel.isEmpty() && model(params) != policy.secondaryModel;
+}
+
+QVariantHash DAIHedging::secondaryParams(const DAIHedgingPolicy &policy, const QVariantHash &params)
+{
+    QVariantHash ret = params;
+    ret.insert("model", policy.secondaryModel);
+    return ret;
+}
+
+QString DAIHedging::model(const QVariantHash &params)
+{
+    // Empty for the current model of the capability.
+    return params.value("model").toString();
+}
+
+int DAIHedging::delay(const QString &capability, const QString &model, const DAIHedgingPolicy &policy)
+{
+    QVector<qint64> samples;
+    {
+        QMutexLocker lk(latencyMutex());
+        samples = latencyWindows()->value(latencyKey(capability, model)).samples;
+    }
+
+    // Without a picture of the primary every request would be sent twice.
+    if (samples.size() < kMinimumSamples)
+        return -1;
+
+    std::sort(samples.begin(), samples.end());
+    const double p = qBound(0.0, policy.percentile, 100.0);
+    const int index = qBound(0, int(std::ceil(p / 100 * samples.size())) - 1, samples.size() - 1);
+    return int(qMax<qint64>(policy.minimumDelay, samples.at(index)));
+}
+
+void DAIHedging::recordLatency(const QString &capability, const QString &model, qint64 msec)
+{
+    QMutexLocker lk(latencyMutex());
+    LatencyWindow &window = (*latencyWindows())[latencyKey(capability, model)];
+    if (window.samples.size() < kLatencyWindow) {
+        window.samples.append(msec);
+        return;
+    }
+
+    window.samples[window.next] = msec;
+    window.next = (window.next + 1) % kLatencyWindow;
+}
+
+DAI_END_NAMESPACE
@@ -0,0 +1,52 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIHEDGING_P_H
+#define DAIHEDGING_P_H
+
+#include "dtkaitypes.h"
+
+#include <QVariantHash>
+
+DAI_BEGIN_NAMESPACE
+
+// Hedged requests: when the primary model has not answered within a percentile of its
+// recent latency, the same request goes to the secondary model and the first answer wins.
+class DAIHedging
+{
+public:
+    enum Leg {
+        Primary = 0,
+        Secondary = 1
+    };
+
+    // Whether a request with params is hedged, it is not when it already asks for the secondary model.
+    static bool isEnabled(const DAIHedgingPolicy &policy, const QVariantHash &params);
+    // Params of the duplicate, asking for the secondary model.
+    static QVariantHash secondaryParams(const DAIHedgingPolicy &policy, const QVariantHash &params);
+    static QString model(const QVariantHash &params);
+    // Time to give the primary model before the duplicate is sent, -1 while too few latencies are known.
+    static int delay(const QString &capability, const QString &model, const DAIHedgingPolicy &policy);
+    // Records the first-token or reply latency of a request to model. A request that lost
+    // records the time it ran, its latency is at least that.
+    static void recordLatency(const QString &capability, const QString &model, qint64 msec);
+};
+
+// Bookkeeping of a request running on both legs.
+struct DAIHedgeState
+{
+    int winner = -1;
+    bool failed[2] = { false, false };
+
+    // Marks leg as failed, returns whether the request fails as well.
+    bool fail(int leg)
+    {
+        failed[leg] = true;
+        return failed[DAIHedging::Primary] && failed[DAIHedging::Secondary];
+    }
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIHEDGING_P_H
@@ -0,0 +1,461 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daimetrics.h"
+#include "daimetrics_p.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cmath>
+
+Q_LOGGING_CATEGORY(dtkaiMetrics, "dtkai.metrics")
+
+DAI_BEGIN_NAMESPACE
+
+int DAIHistogram::bucketIndex(qint64 value)
+{
+    if (value < kSubBuckets)
+        return value < 0 ? 0 : int(value);
+
+    value = qMin(value, (qint64(1) << (kMaxBits + 1)) - 1);
+    const int msb = 63 - qCountLeadingZeroBits(quint64(value));
+    const int group = msb - kSubBucketBits;
+    const int sub = int(value >> group) - kSubBuckets;
+    return kSubBuckets + group * kSubBuckets + sub;
+}
+
+qint64 DAIHistogram::bucketValue(int index)
+{
+    if (index < kSubBuckets)
+        return index;
+
+    const int group = (index - kSubBuckets) / kSubBuckets;
+    const int sub = (index - kSubBuckets) % kSubBuckets;
+    const qint64 low = qint64(kSubBuckets + sub) << group;
+    return low + ((qint64(1) << group) >> 1);
+}
+
+void DAIHistogram::record(qint64 value)
+{
+    if (counts.isEmpty())
+        counts.resize(kBuckets);
+
+    value = qMax<qint64>(value, 0);
+    ++counts[bucketIndex(value)];
+    minimum = total ? qMin(minimum, value) : value;
+    maximum = total ? qMax(maximum, value) : value;
+    sum += value;
+    ++total;
+}
+
+qint64 DAIHistogram::percentile(double percentile) const
+{
+    if (!total)
+        return 0;
+
+    // The epsilon keeps e.g. 99.9% of 1000 values at rank 999 despite rounding.
+    const quint64 rank = qMax<quint64>(1, quint64(std::ceil(percentile * total / 100 - 1e-9)));
+    quint64 seen = 0;
+    for (int i = 0; i < counts.size(); ++i) {
+        seen += counts.at(i);
+        if (seen >= rank)
+            return qBound(minimum, bucketValue(i), maximum);
+    }
+    return maximum;
+}
+
+QAtomicInt DAIMetricsPrivate::enabled(1);
+
+DAIMetricsPrivate::DAIMetricsPrivate(DAIMetrics *parent)
+    : QObject()
+    , q(parent)
+{
+}
+
+void DAIMetricsPrivate::record(const QString &series, qint64 usec, int error, qint64 sent, qint64 received)
+{
+    if (!isEnabled())
+        return;
+
+    DAIMetricsPrivate *d = DAIMetrics::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    Entry &entry = d->entries[series];
+    ++entry.calls;
+    if (error != 0)
+        ++entry.errors[error];
+    entry.bytesSent += quint64(qMax<qint64>(sent, 0));
+    entry.bytesReceived += quint64(qMax<qint64>(received, 0));
+    entry.latency.record(usec);
+}
+
+void DAIMetricsPrivate::record(const QString &series, const QVector<qint64> &usecs)
+{
+    if (usecs.isEmpty() || !isEnabled())
+        return;
+
+    DAIMetricsPrivate *d = DAIMetrics::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    Entry &entry = d->entries[series];
+    entry.calls += quint64(usecs.size());
+    for (qint64 usec : usecs)
+        entry.latency.record(usec);
+}
+
+void DAIMetricsPrivate::begin(quint64 id, const QString &series, qint64 sent)
+{
+    if (!id || !isEnabled())
+        return;
+
+    DAIMetricsPrivate *d = DAIMetrics::instance()->d.data();
+    Pending request;
+    request.series = series;
+    request.sent.start();
+    request.bytesSent = sent;
+
+    QMutexLocker lk(&d->mtx);
+    d->pending.insert(id, request);
+}
+
+void DAIMetricsPrivate::mark(quint64 id, const char *stage)
+{
+    if (!isEnabled())
+        return;
+
+    DAIMetricsPrivate *d = DAIMetrics::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    auto it = d->pending.find(id);
+    if (it == d->pending.end())
+        return;
+
+    // Called for every token, stay cheap once the stage is recorded.
+    for (const char *marked : qAsConst(it->marked)) {
+        if (qstrcmp(marked, stage) == 0)
+            return;
+    }
+
+    it->marked.append(stage);
+    Entry &entry = d->entries[it->series + QLatin1Char('.') + QLatin1String(stage)];
+    ++entry.calls;
+    entry.latency.record(it->sent.nsecsElapsed() / 1000);
+}
+
+void DAIMetricsPrivate::addSent(quint64 id, qint64 bytes)
+{
+    if (!isEnabled())
+        return;
+
+    DAIMetricsPrivate *d = DAIMetrics::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    auto it = d->pending.find(id);
+    if (it != d->pending.end())
+        it->bytesSent += bytes;
+}
+
+void DAIMetricsPrivate::addReceived(quint64 id, qint64 bytes)
+{
+    if (!isEnabled())
+        return;
+
+    DAIMetricsPrivate *d = DAIMetrics::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    auto it = d->pending.find(id);
+    if (it != d->pending.end())
+        it->bytesReceived += bytes;
+}
+
+void DAIMetricsPrivate::end(quint64 id, int error, qint64 received)
+{
+    DAIMetricsPrivate *d = DAIMetrics::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    auto it = d->pending.find(id);
+    if (it == d->pending.end())
+        return;
+
+    const Pending request = it.value();
+    d->pending.erase(it);
+    lk.unlock();
+
+    record(request.series, request.sent.nsecsElapsed() / 1000, error, request.bytesSent, request.bytesReceived + received);
+}
+
+qint64 DAIMetricsPrivate::utf8Size(const QString &text)
+{
+    if (!isEnabled())
+        return 0;
+
+    qint64 size = 0;
+    const QChar *c = text.constData();
+    const QChar *end = c + text.size();
+    for (; c != end; ++c) {
+        const ushort u = c->unicode();
+        if (u < 0x80)
+            size += 1;
+        else if (u < 0x800 || c->isSurrogate())
+            size += 2;      // a surrogate pair takes 4 bytes
+        else
+            size += 3;
+    }
+    return size;
+}
+
+void DAIStreamTimer::output()
+{
+    if (!sent.isValid())
+        return;
+
+    const qint64 now = sent.nsecsElapsed() / 1000;
+    if (tokens++ == 0)
+        first = now;
+    else
+        gaps.append(now - last);
+    last = now;
+}
+
+DAIStreamStats DAIStreamTimer::stats() const
+{
+    DAIStreamStats stats;
+    if (!sent.isValid())
+        return stats;
+
+    stats.tokens = tokens;
+    stats.timeToFirstToken = first;
+    stats.duration = sent.nsecsElapsed() / 1000;
+    if (gaps.isEmpty())
+        return stats;
+
+    QVector<qint64> sorted = gaps;
+    std::sort(sorted.begin(), sorted.end());
+    // Nearest rank, a stream has few enough tokens to keep every gap.
+    auto percentile = [&sorted](double p) {
+        const int rank = qMax(1, int(std::ceil(p * sorted.size() / 100 - 1e-9)));
+        return sorted.at(qMin(rank, sorted.size()) - 1);
+    };
+    stats.gapMin = sorted.first();
+    stats.gapP50 = percentile(50);
+    stats.gapP90 = percentile(90);
+    stats.gapP99 = percentile(99);
+    stats.gapMax = sorted.last();
+    if (last > first)
+        stats.tokensPerSecond = gaps.size() * 1e6 / (last - first);
+    return stats;
+}
+
+void DAIStreamTimer::recordGaps(const QString &series) const
+{
+    if (gaps.isEmpty())
+        return;
+
+    DAIMetricsPrivate::record(series + QLatin1String(".interToken"), gaps);
+    DAIMetricsPrivate::record(series + QLatin1String(".timePerToken"), (last - first) / gaps.size());
+}
+
+DAIMetrics::Series DAIMetricsPrivate::series(const QString &name, const Entry &entry) const
+{
+    DAIMetrics::Series series;
+    series.name = name;
+    series.calls = entry.calls;
+    series.errors = entry.errors;
+    series.bytesSent = entry.bytesSent;
+    series.bytesReceived = entry.bytesReceived;
+    series.min = entry.latency.min();
+    series.max = entry.latency.max();
+    series.mean = entry.latency.mean();
+    series.p50 = entry.latency.percentile(50);
+    series.p90 = entry.latency.percentile(90);
+    series.p99 = entry.latency.percentile(99);
+    series.p999 = entry.latency.percentile(99.9);
+    return series;
+}
+
+void DAIMetricsPrivate::dump()
+{
+    QMutexLocker lk(&mtx);
+    const DAIMetrics::DumpFormat format = dumpFormat;
+    const QString path = dumpPath;
+    lk.unlock();
+
+    const QByteArray data = format == DAIMetrics::Json ? q->toJson() : q->toPrometheus();
+    if (!path.isEmpty()) {
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit())
+            qCWarning(dtkaiMetrics) << "Failed to write metrics to" << path << file.errorString();
+    }
+
+    emit q->dumped(data);
+}
+
+DAIMetrics::DAIMetrics(QObject *parent)
+    : QObject(parent)
+    , d(new DAIMetricsPrivate(this))
+{
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        if (thread() != app->thread())
+            moveToThread(app->thread());
+    }
+    d->moveToThread(thread());
+}
+
+DAIMetrics::~DAIMetrics()
+{
+
+}
+
+DAIMetrics *DAIMetrics::instance()
+{
+    // Intentionally never deleted, requests may record until the very end of the process.
+    static DAIMetrics *metrics = new DAIMetrics;
+    return metrics;
+}
+
+void DAIMetrics::setEnabled(bool enabled)
+{
+    DAIMetricsPrivate::enabled.storeRelease(enabled ? 1 : 0);
+}
+
+bool DAIMetrics::isEnabled() const
+{
+    return DAIMetricsPrivate::isEnabled();
+}
+
+QList<DAIMetrics::Series> DAIMetrics::snapshot() const
+{
+    QMutexLocker lk(&d->mtx);
+    QStringList names = d->entries.keys();
+    std::sort(names.begin(), names.end());
+
+    QList<Series> list;
+    for (const QString &name : names)
+        list.append(d->series(name, d->entries.value(name)));
+    return list;
+}
+
+DAIMetrics::Series DAIMetrics::series(const QString &name) const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->series(name, d->entries.value(name));
+}
+
+void DAIMetrics::reset()
+{
+    QMutexLocker lk(&d->mtx);
+    d->entries.clear();
+}
+
+// Escapes a Prometheus label value.
+static QByteArray labelValue(const QString &value)
+{
+    QByteArray escaped = value.toUtf8();
+    escaped.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return escaped;
+}
+
+QByteArray DAIMetrics::toPrometheus() const
+{
+    const QList<Series> list = snapshot();
+    QByteArray out;
+    out += "# HELP dtkai_request_duration_seconds Latency of dtkai requests and their stages.\n"
+           "# TYPE dtkai_request_duration_seconds summary\n";
+    for (const Series &series : list) {
+        const QByteArray name = "series=\"" + labelValue(series.name) + "\"";
+        const QPair<const char *, qint64> quantiles[] = {
+            { "0.5", series.p50 }, { "0.9", series.p90 }, { "0.99", series.p99 }, { "0.999", series.p999 }
+        };
+        for (const auto &quantile : quantiles) {
+            out += "dtkai_request_duration_seconds{" + name + ",quantile=\"" + quantile.first + "\"} "
+                   + QByteArray::number(quantile.second / 1e6, 'g', 9) + '\n';
+        }
+        out += "dtkai_request_duration_seconds_sum{" + name + "} "
+               + QByteArray::number(series.mean * series.calls / 1e6, 'g', 12) + '\n';
+        out += "dtkai_request_duration_seconds_count{" + name + "} " + QByteArray::number(series.calls) + '\n';
+    }
+
+    out += "# HELP dtkai_request_errors_total Failed dtkai requests by error code.\n"
+           "# TYPE dtkai_request_errors_total counter\n";
+    for (const Series &series : list) {
+        QList<int> codes = series.errors.keys();
+        std::sort(codes.begin(), codes.end());
+        for (int code : codes) {
+            out += "dtkai_request_errors_total{series=\"" + labelValue(series.name) + "\",code=\""
+                   + QByteArray::number(code) + "\"} " + QByteArray::number(series.errors.value(code)) + '\n';
+        }
+    }
+
+    const QPair<const char *, bool> directions[] = { { "sent", true }, { "received", false } };
+    out += "# HELP dtkai_bytes_total Payload bytes marshalled to and from the ai-daemon.\n"
+           "# TYPE dtkai_bytes_total counter\n";
+    for (const Series &series : list) {
+        for (const auto &direction : directions) {
+            const quint64 bytes = direction.second ? series.bytesSent : series.bytesReceived;
+            if (!bytes)
+                continue;
+            out += "dtkai_bytes_total{series=\"" + labelValue(series.name) + "\",direction=\"" + direction.first + "\"} "
+                   + QByteArray::number(bytes) + '\n';
+        }
+    }
+    return out;
+}
+
+QByteArray DAIMetrics::toJson() const
+{
+    QJsonArray array;
+    for (const Series &series : snapshot()) {
+        QJsonObject errors;
+        for (auto it = series.errors.constBegin(); it != series.errors.constEnd(); ++it)
+            errors.insert(QString::number(it.key()), double(it.value()));
+
+        QJsonObject obj;
+        obj.insert("name", series.name);
+        obj.insert("calls", double(series.calls));
+        obj.insert("errors", errors);
+        obj.insert("bytesSent", double(series.bytesSent));
+        obj.insert("bytesReceived", double(series.bytesReceived));
+        obj.insert("min", double(series.min));
+        obj.insert("max", double(series.max));
+        obj.insert("mean", series.mean);
+        obj.insert("p50", double(series.p50));
+        obj.insert("p90", double(series.p90));
+        obj.insert("p99", double(series.p99));
+        obj.insert("p999", double(series.p999));
+        array.append(obj);
+    }
+
+    QJsonObject root;
+    root.insert("unit", "us");
+    root.insert("series", array);
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+void DAIMetrics::setDump(int interval, DumpFormat format, const QString &filePath)
+{
+    {
+        QMutexLocker lk(&d->mtx);
+        d->dumpFormat = format;
+        d->dumpPath = filePath;
+    }
+
+    // The timer lives in the thread of the registry, other threads only ask it to change.
+    QMetaObject::invokeMethod(d.data(), [this, interval]() {
+        if (interval <= 0) {
+            delete d->dumpTimer;
+            d->dumpTimer = nullptr;
+            return;
+        }
+
+        if (!d->dumpTimer) {
+            d->dumpTimer = new QTimer(d.data());
+            connect(d->dumpTimer, &QTimer::timeout, d.data(), &DAIMetricsPrivate::dump);
+        }
+        d->dumpTimer->start(interval);
+    }, Qt::AutoConnection);
+}
+
+DAI_END_NAMESPACE
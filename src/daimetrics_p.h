@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIMETRICS_P_H
+#define DAIMETRICS_P_H
+
+#include "daimetrics.h"
+#include "daithreaderror_p.h"
+#include "dtkaitypes.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QTimer>
+#include <QVector>
+
+DAI_BEGIN_NAMESPACE
+
+// Log-linear histogram in the spirit of HdrHistogram. Values below kSubBuckets
+// are exact, above that every power of two is split into kSubBuckets linear
+// buckets, which keeps the relative error under 1/kSubBuckets.
+class DAIHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 6;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxBits = 40;     // about 12 days in microseconds, larger values are clamped
+    static constexpr int kBuckets = kSubBuckets * (kMaxBits - kSubBucketBits + 2);
+
+    void record(qint64 value);
+    // Value at percentile (0-100], 0 when nothing was recorded.
+    qint64 percentile(double percentile) const;
+
+    quint64 count() const { return total; }
+    qint64 min() const { return minimum; }
+    qint64 max() const { return maximum; }
+    double mean() const { return total ? double(sum) / total : 0; }
+
+    static int bucketIndex(qint64 value);
+    // Midpoint of the values that fall into bucket index.
+    static qint64 bucketValue(int index);
+
+private:
+    QVector<quint64> counts;
+    quint64 total = 0;
+    qint64 minimum = 0;
+    qint64 maximum = 0;
+    qint64 sum = 0;
+};
+
+class DAIMetricsPrivate : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry
+    {
+        quint64 calls = 0;
+        QHash<int, quint64> errors;
+        quint64 bytesSent = 0;
+        quint64 bytesReceived = 0;
+        DAIHistogram latency;
+    };
+
+    // An asynchronous request between begin() and end().
+    struct Pending
+    {
+        QString series;
+        QElapsedTimer sent;
+        qint64 bytesSent = 0;
+        qint64 bytesReceived = 0;
+        QList<const char *> marked;    // stages already recorded
+    };
+
+    explicit DAIMetricsPrivate(DAIMetrics *q);
+
+    static bool isEnabled() { return enabled.loadAcquire() != 0; }
+    // Records one finished call of series, error is 0 when it succeeded.
+    static void record(const QString &series, qint64 usec, int error = 0, qint64 sent = 0, qint64 received = 0);
+    // Records every value of usecs as a successful call of series.
+    static void record(const QString &series, const QVector<qint64> &usecs);
+    // Asynchronous request id of series was sent, end() records it.
+    static void begin(quint64 id, const QString &series, qint64 sent = 0);
+    // Records the time since begin() into series.stage, once per request.
+    static void mark(quint64 id, const char *stage);
+    static void addSent(quint64 id, qint64 bytes);
+    static void addReceived(quint64 id, qint64 bytes);
+    // Request id finished, unknown ids are ignored.
+    static void end(quint64 id, int error, qint64 received = 0);
+    // Bytes of text once marshalled as UTF-8, 0 while metrics are disabled.
+    static qint64 utf8Size(const QString &text);
+
+    DAIMetrics::Series series(const QString &name, const Entry &entry) const;
+    void dump();
+
+    static QAtomicInt enabled;
+
+    mutable QMutex mtx;
+    QHash<QString, Entry> entries;
+    QHash<quint64, Pending> pending;
+
+    QTimer *dumpTimer = nullptr;
+    DAIMetrics::DumpFormat dumpFormat = DAIMetrics::Prometheus;
+    QString dumpPath;
+
+    DAIMetrics *q = nullptr;
+};
+
+// Records a blocking call of series when it goes out of scope. With error set,
+// the call failed with what the client left in it for the calling thread.
+class DAICallMetric
+{
+public:
+    explicit DAICallMetric(const char *series, const DAIThreadError *error = nullptr)
+        : name(series)
+        , lastError(error)
+    {
+        if (DAIMetricsPrivate::isEnabled())
+            timer.start();
+    }
+
+    ~DAICallMetric()
+    {
+        if (!timer.isValid())
+            return;
+
+        const int code = lastError ? lastError->getErrorCode() : 0;
+        DAIMetricsPrivate::record(QString::fromLatin1(name), timer.nsecsElapsed() / 1000, code, sent, received);
+    }
+
+    void addSent(const QString &text) { sent += DAIMetricsPrivate::utf8Size(text); }
+    void addSent(qint64 bytes) { sent += bytes; }
+    void addReceived(const QString &text) { received += DAIMetricsPrivate::utf8Size(text); }
+    void addReceived(qint64 bytes) { received += bytes; }
+
+private:
+    Q_DISABLE_COPY(DAICallMetric)
+    const char *name = nullptr;
+    const DAIThreadError *lastError = nullptr;
+    QElapsedTimer timer;
+    qint64 sent = 0;
+    qint64 received = 0;
+};
+
+// Arrival times of the outputs of one stream, from sending the request to its end.
+class DAIStreamTimer
+{
+public:
+    void start() { sent.start(); }
+    bool isStarted() const { return sent.isValid(); }
+    // Msec since the request was sent.
+    qint64 elapsed() const { return sent.elapsed(); }
+
+    void output();
+    DAIStreamStats stats() const;
+    // Records the gaps into series.interToken and the time per token into series.timePerToken.
+    void recordGaps(const QString &series) const;
+
+private:
+    QElapsedTimer sent;
+    int tokens = 0;
+    qint64 first = -1;
+    qint64 last = -1;
+    QVector<qint64> gaps;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIMETRICS_P_H
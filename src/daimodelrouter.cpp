@@ -0,0 +1,218 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daimodelrouter.h"
+#include "daimodelrouter_p.h"
+#include "dmodelmanager.h"
+#include "dsessionpool.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+
+Q_LOGGING_CATEGORY(dtkaiRouter, "dtkai.router")
+
+DAI_BEGIN_NAMESPACE
+
+DAIModelRouterPrivate::DAIModelRouterPrivate(DAIModelRouter *parent)
+    : q(parent)
+{
+}
+
+void DAIModelRouterPrivate::record(const QString &capability, const QString &model, qint64 latency, bool success)
+{
+    // Nothing to learn about the current model of the daemon, it may change any time.
+    if (model.isEmpty())
+        return;
+
+    DAIModelRouter::instance()->recordOutcome(capability, model, latency, success);
+}
+
+DAIModelRouterPrivate::Candidates DAIModelRouterPrivate::candidates(const QString &capability)
+{
+    {
+        QMutexLocker lk(&mtx);
+        auto it = cache.constFind(capability);
+        if (it != cache.constEnd() && it->fetched.elapsed() < refreshInterval)
+            return *it;
+    }
+
+    // Asked outside the lock, two routes racing here both ask the daemon.
+    Candidates ret;
+    for (const ModelInfo &info : DModelManager::availableModels(capability)) {
+        if (info.isAvailable)
+            ret.models.append(info.modelName);
+    }
+    ret.current = DModelManager::currentModelForCapability(capability);
+    ret.fetched.start();
+
+    QMutexLocker lk(&mtx);
+    cache.insert(capability, ret);
+    return ret;
+}
+
+QString DAIModelRouterPrivate::pick(const QString &capability, const Candidates &candidates, const DAIModelSLO &slo) const
+{
+    auto fresh = [this, &capability](const QString &model) -> const Entry * {
+        auto it = scores.constFind(key(capability, model));
+        if (it == scores.constEnd() || it->updated.elapsed() >= staleAfter)
+            return nullptr;
+        return &*it;
+    };
+    auto meets = [&slo](const DAIModelRouter::Score &score) {
+        return (slo.latency <= 0 || score.latency <= slo.latency) && score.errorRate <= slo.maxErrorRate;
+    };
+
+    // Stay with the choice of the daemon while it does its job.
+    const Entry *current = candidates.models.contains(candidates.current) ? fresh(candidates.current) : nullptr;
+    if (current && meets(current->score))
+        return candidates.current;
+
+    QString fastest;
+    double fastestLatency = 0;
+    QString unmeasured;
+    QString leastBad;
+    DAIModelRouter::Score leastBadScore;
+    for (const QString &model : candidates.models) {
+        const Entry *entry = fresh(model);
+        if (!entry) {
+            if (unmeasured.isEmpty() || model == candidates.current)
+                unmeasured = model;
+            continue;
+        }
+
+        const DAIModelRouter::Score &score = entry->score;
+        if (meets(score) && (fastest.isEmpty() || score.latency < fastestLatency)) {
+            fastest = model;
+            fastestLatency = score.latency;
+        }
+        if (leastBad.isEmpty() || score.errorRate < leastBadScore.errorRate
+                || (qFuzzyCompare(score.errorRate + 1, leastBadScore.errorRate + 1) && score.latency < leastBadScore.latency)) {
+            leastBad = model;
+            leastBadScore = score;
+        }
+    }
+
+    if (!fastest.isEmpty())
+        return fastest;
+    // A model nobody measured lately may well be better, find out.
+    if (!unmeasured.isEmpty())
+        return unmeasured;
+    if (!leastBad.isEmpty())
+        return leastBad;
+
+    return candidates.current;
+}
+
+QString DAIModelRouterPrivate::key(const QString &capability, const QString &model)
+{
+    return capability + QLatin1Char('/') + model;
+}
+
+DAIModelRouter::DAIModelRouter(QObject *parent)
+    : QObject(parent)
+    , d(new DAIModelRouterPrivate(this))
+{
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        if (thread() != app->thread())
+            moveToThread(app->thread());
+    }
+
+    // A restarted daemon may come with other models.
+    connect(DSessionPool::instance(), &DSessionPool::daemonStarted, this, [this]() {
+        QMutexLocker lk(&d->mtx);
+        d->cache.clear();
+    });
+}
+
+DAIModelRouter::~DAIModelRouter()
+{
+
+}
+
+DAIModelRouter *DAIModelRouter::instance()
+{
+    // Intentionally never deleted, requests may report outcomes until the very end of the process.
+    static DAIModelRouter *router = new DAIModelRouter;
+    return router;
+}
+
+QString DAIModelRouter::route(const QString &capability, QVariantHash *params, const DAIModelSLO &slo)
+{
+    if (!params->value("model").toString().isEmpty())
+        return params->value("model").toString();
+
+    const QString model = selectModel(capability, slo);
+    if (!model.isEmpty())
+        params->insert("model", model);
+    return model;
+}
+
+QString DAIModelRouter::selectModel(const QString &capability, const DAIModelSLO &slo)
+{
+    const DAIModelRouterPrivate::Candidates candidates = d->candidates(capability);
+
+    QMutexLocker lk(&d->mtx);
+    const QString model = d->pick(capability, candidates, slo);
+    if (model != candidates.current)
+        qCDebug(dtkaiRouter) << "Routing" << capability << "to" << model << "instead of" << candidates.current;
+    return model;
+}
+
+void DAIModelRouter::recordOutcome(const QString &capability, const QString &model, qint64 latency, bool success)
+{
+    QMutexLocker lk(&d->mtx);
+    DAIModelRouterPrivate::Entry &entry = d->scores[DAIModelRouterPrivate::key(capability, model)];
+    const double error = success ? 0 : 1;
+    // Start over from a stale score, it says little about the model today.
+    if (entry.score.samples == 0 || entry.updated.elapsed() >= d->staleAfter) {
+        entry.score.latency = latency;
+        entry.score.errorRate = error;
+        entry.score.samples = 0;
+    } else {
+        entry.score.latency += d->alpha * (latency - entry.score.latency);
+        entry.score.errorRate += d->alpha * (error - entry.score.errorRate);
+    }
+    entry.score.samples++;
+    entry.updated.start();
+}
+
+DAIModelRouter::Score DAIModelRouter::score(const QString &capability, const QString &model) const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->scores.value(DAIModelRouterPrivate::key(capability, model)).score;
+}
+
+void DAIModelRouter::setSmoothing(double alpha)
+{
+    QMutexLocker lk(&d->mtx);
+    d->alpha = qBound(0.0, alpha, 1.0);
+}
+
+double DAIModelRouter::smoothing() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->alpha;
+}
+
+void DAIModelRouter::setStaleAfter(int msec)
+{
+    QMutexLocker lk(&d->mtx);
+    d->staleAfter = qMax(0, msec);
+}
+
+int DAIModelRouter::staleAfter() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->staleAfter;
+}
+
+void DAIModelRouter::reset()
+{
+    QMutexLocker lk(&d->mtx);
+    d->scores.clear();
+    d->cache.clear();
+}
+
+DAI_END_NAMESPACE
@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIMODELROUTER_P_H
+#define DAIMODELROUTER_P_H
+
+#include "daimodelrouter.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+
+DAI_BEGIN_NAMESPACE
+
+class DAIModelRouterPrivate
+{
+public:
+    struct Entry
+    {
+        DAIModelRouter::Score score;
+        QElapsedTimer updated;
+    };
+
+    // Available models of a capability and the current one, as last asked from DModelManager.
+    struct Candidates
+    {
+        QStringList models;
+        QString current;
+        QElapsedTimer fetched;
+    };
+
+    explicit DAIModelRouterPrivate(DAIModelRouter *q);
+
+    // Reports the outcome of a request to model, skipped when it named no model.
+    static void record(const QString &capability, const QString &model, qint64 latency, bool success);
+
+    Candidates candidates(const QString &capability);
+    // Picks among candidates, requires mtx.
+    QString pick(const QString &capability, const Candidates &candidates, const DAIModelSLO &slo) const;
+    static QString key(const QString &capability, const QString &model);
+
+public:
+    mutable QMutex mtx;
+    double alpha = 0.2;
+    int staleAfter = 60 * 1000;
+    int refreshInterval = 10 * 1000;
+    QHash<QString, Entry> scores;
+    QHash<QString, Candidates> cache;
+
+    DAIModelRouter *q = nullptr;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAIMODELROUTER_P_H
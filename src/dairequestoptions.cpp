@@ -0,0 +1,171 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "dairequestoptions.h"
+#include "dairequestoptions_p.h"
+#include "daierror.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include <climits>
+
+DAI_BEGIN_NAMESPACE
+
+DAICancellationNotifier *DAICancellationTokenPrivate::notifier()
+{
+    QMutexLocker lk(&mtx);
+    if (!notifierObject)
+        notifierObject.reset(new DAICancellationNotifier);
+    return notifierObject.data();
+}
+
+DAICancellationToken::DAICancellationToken()
+    : d(new DAICancellationTokenPrivate)
+{
+}
+
+DAICancellationToken::DAICancellationToken(const DAICancellationToken &other) = default;
+DAICancellationToken &DAICancellationToken::operator=(const DAICancellationToken &other) = default;
+DAICancellationToken::~DAICancellationToken() = default;
+
+void DAICancellationToken::cancel()
+{
+    if (!d->cancelled.testAndSetOrdered(0, 1))
+        return;
+
+    QMutexLocker lk(&d->mtx);
+    DAICancellationNotifier *notifier = d->notifierObject.data();
+    lk.unlock();
+
+    if (notifier)
+        emit notifier->cancelled();
+}
+
+bool DAICancellationToken::isCancelled() const
+{
+    return d->cancelled.loadAcquire() != 0;
+}
+
+QMetaObject::Connection DAICancellationToken::onCancelled(QObject *context, const std::function<void()> &func) const
+{
+    // cancel() may run between connecting and checking, func must still run only once.
+    QSharedPointer<QAtomicInt> once(new QAtomicInt(0));
+    auto invoke = [once, func]() {
+        if (once->testAndSetOrdered(0, 1))
+            func();
+    };
+
+    QMetaObject::Connection connection = QObject::connect(d->notifier(), &DAICancellationNotifier::cancelled, context, invoke);
+    if (isCancelled())
+        QMetaObject::invokeMethod(context, invoke, Qt::QueuedConnection);
+    return connection;
+}
+
+DAIRequestWatch::DAIRequestWatch(const DAIRequestOptions &options, const AbortFunc &func, QThread *thread)
+    : abort(func)
+    , deadline(options.deadline)
+{
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setTimerType(Qt::PreciseTimer);
+    connect(timer, &QTimer::timeout, this, [this]() {
+        if (deadline.hasExpired())
+            fire(deadlineExceededError());
+        else
+            arm();
+    });
+    options.cancellation.onCancelled(this, [this]() {
+        fire(requestCancelledError());
+    });
+
+    // Even without a deadline the watch belongs to the thread of the client, cancellation
+    // is delivered and release() deletes it there.
+    if (thread != QThread::currentThread()) {
+        moveToThread(thread);
+        if (!deadline.isForever()) {
+            QMetaObject::invokeMethod(timer, [this]() {
+                arm();
+            }, Qt::QueuedConnection);
+        }
+    } else if (!deadline.isForever()) {
+        arm();
+    }
+}
+
+void DAIRequestWatch::arm()
+{
+    // QTimer takes int msec, deadlines further out than about 24 days are reached in steps.
+    timer->start(static_cast<int>(qBound<qint64>(0, deadline.remainingTime(), INT_MAX)));
+}
+
+void DAIRequestWatch::fire(const DTK_CORE_NAMESPACE::DError &error)
+{
+    if (fired)
+        return;
+
+    fired = true;
+    timer->stop();
+    abort(error);
+}
+
+DAIRequestWatches::~DAIRequestWatches()
+{
+    qDeleteAll(watches);
+}
+
+void DAIRequestWatches::watch(quint64 id, const DAIRequestOptions &options, QObject *context, const DAIRequestWatch::AbortFunc &abort)
+{
+    // Any copy of the token may cancel later, even the one in the options of the caller,
+    // so every request is watched.
+    DAIRequestWatch *watch = new DAIRequestWatch(options, abort, context->thread());
+    QMutexLocker lk(&mtx);
+    delete watches.take(id);
+    watches.insert(id, watch);
+}
+
+void DAIRequestWatches::release(quint64 id)
+{
+    QMutexLocker lk(&mtx);
+    if (DAIRequestWatch *watch = watches.take(id))
+        watch->deleteLater();
+}
+
+int requestTimeout(const DAIRequestOptions &options, int fallback)
+{
+    if (options.deadline.isForever())
+        return fallback;
+
+    // 0 would disable the timeout of the call, an expired request still fails fast.
+    return static_cast<int>(qBound<qint64>(1, options.deadline.remainingTime(), fallback));
+}
+
+DTK_CORE_NAMESPACE::DError requestOptionsError(const DAIRequestOptions &options)
+{
+    if (options.cancellation.isCancelled())
+        return requestCancelledError();
+    if (options.deadline.hasExpired())
+        return deadlineExceededError();
+
+    return DTK_CORE_NAMESPACE::DError(NoError, "");
+}
+
+DTK_CORE_NAMESPACE::DError deadlineExceededError()
+{
+    return DTK_CORE_NAMESPACE::DError(AIErrorCode::RequestTimeout, "Request deadline exceeded");
+}
+
+DTK_CORE_NAMESPACE::DError requestCancelledError()
+{
+    return DTK_CORE_NAMESPACE::DError(AIErrorCode::RequestCancelled, "Request cancelled");
+}
+
+bool isRequestOptionsError(const DTK_CORE_NAMESPACE::DError &err)
+{
+    return err.getErrorCode() == AIErrorCode::RequestTimeout
+            || err.getErrorCode() == AIErrorCode::RequestCancelled
+            || err.getErrorCode() == AIErrorCode::RequestRejected;
+}
+
+DAI_END_NAMESPACE
@@ -0,0 +1,87 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIREQUESTOPTIONS_P_H
+#define DAIREQUESTOPTIONS_P_H
+
+#include "dairequestoptions.h"
+
+#include <DError>
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QSharedData>
+#include <QTimer>
+
+DAI_BEGIN_NAMESPACE
+
+class DAICancellationNotifier : public QObject
+{
+    Q_OBJECT
+Q_SIGNALS:
+    void cancelled();
+};
+
+class DAICancellationTokenPrivate : public QSharedData
+{
+public:
+    // Created on the first onCancelled(), most tokens are never watched.
+    DAICancellationNotifier *notifier();
+
+    QAtomicInt cancelled;
+    QMutex mtx;
+    QScopedPointer<DAICancellationNotifier> notifierObject;
+};
+
+// Aborts one request once its deadline expires or its token is cancelled, whichever comes first.
+class DAIRequestWatch : public QObject
+{
+    Q_OBJECT
+public:
+    using AbortFunc = std::function<void(const DTK_CORE_NAMESPACE::DError &error)>;
+    DAIRequestWatch(const DAIRequestOptions &options, const AbortFunc &func, QThread *thread);
+
+private:
+    void fire(const DTK_CORE_NAMESPACE::DError &error);
+    void arm();
+
+    QTimer *timer = nullptr;
+    AbortFunc abort;
+    QDeadlineTimer deadline;
+    bool fired = false;
+};
+
+// Watches of the outstanding requests of one client object, owned by its private.
+class DAIRequestWatches
+{
+public:
+    ~DAIRequestWatches();
+
+    // abort is invoked in the thread of context, at most once.
+    void watch(quint64 id, const DAIRequestOptions &options, QObject *context, const DAIRequestWatch::AbortFunc &abort);
+    // Called when the request finished, safe from within abort.
+    void release(quint64 id);
+
+private:
+    QMutex mtx;
+    QHash<quint64, DAIRequestWatch *> watches;
+};
+
+// Timeout of a D-Bus call made for options, never longer than fallback.
+int requestTimeout(const DAIRequestOptions &options, int fallback);
+
+// Error of options that expired or were cancelled before the request was sent, NoError otherwise.
+DTK_CORE_NAMESPACE::DError requestOptionsError(const DAIRequestOptions &options);
+DTK_CORE_NAMESPACE::DError deadlineExceededError();
+DTK_CORE_NAMESPACE::DError requestCancelledError();
+
+// Whether err comes from the options or the admission of one request rather than from the
+// call itself, such a result must not be handed to other requests.
+bool isRequestOptionsError(const DTK_CORE_NAMESPACE::DError &err);
+
+DAI_END_NAMESPACE
+
+#endif // DAIREQUESTOPTIONS_P_H
@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "dairetrypolicy.h"
+#include "dairetrypolicy_p.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+
+Q_LOGGING_CATEGORY(dtkaiRetry, "dtkai.retry")
+
+DAI_BEGIN_NAMESPACE
+
+// Retries kept in reserve, a burst of failures after a quiet period may use this many.
+static constexpr double kBudgetReserve = 10;
+
+DAIRetryPolicyPrivate::DAIRetryPolicyPrivate(DAIRetryPolicy *parent)
+    : budget(kBudgetReserve)
+    , q(parent)
+{
+}
+
+void DAIRetryPolicyPrivate::deposit()
+{
+    DAIRetryPolicyPrivate *d = DAIRetryPolicy::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    d->stats.calls++;
+    d->budget = qMin(kBudgetReserve, d->budget + d->budgetRatio);
+}
+
+bool DAIRetryPolicyPrivate::shouldRetry(const QDBusError &error, int attempt, const QDeadlineTimer &deadline, int *delay)
+{
+    // A reply, even an error one, means the daemon handled the call, asking again changes nothing.
+    if (!error.isValid() || !DAICircuitBreakerPrivate::isTransportFailure(error))
+        return false;
+
+    // A half-open breaker lets a single probe through, its failure is final.
+    if (DAICircuitBreaker::instance()->state() != DAICircuitBreaker::Closed)
+        return false;
+
+    DAIRetryPolicyPrivate *d = DAIRetryPolicy::instance()->d.data();
+    int wait = 0;
+    {
+        QMutexLocker lk(&d->mtx);
+        if (attempt >= d->maxAttempts)
+            return false;
+
+        // Full jitter, clients that failed together must not come back together.
+        const qint64 cap = qMin<qint64>(d->maximumDelay, qint64(d->baseDelay) << qMin(attempt - 1, 30));
+        wait = static_cast<int>(QRandomGenerator::global()->bounded(cap + 1));
+        if (!deadline.isForever() && deadline.remainingTime() <= wait)
+            return false;
+
+        if (d->budget < 1) {
+            d->stats.budgetExhausted++;
+            qCDebug(dtkaiRetry) << "Retry budget exhausted, giving up on" << error.name();
+            return false;
+        }
+        d->budget -= 1;
+        d->stats.retries++;
+    }
+
+    qCDebug(dtkaiRetry) << "Retrying after" << error.name() << "attempt" << attempt << "in" << wait << "ms";
+    *delay = wait;
+    return true;
+}
+
+DAIRetryPolicy::DAIRetryPolicy(QObject *parent)
+    : QObject(parent)
+    , d(new DAIRetryPolicyPrivate(this))
+{
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        if (thread() != app->thread())
+            moveToThread(app->thread());
+    }
+}
+
+DAIRetryPolicy::~DAIRetryPolicy()
+{
+
+}
+
+DAIRetryPolicy *DAIRetryPolicy::instance()
+{
+    // Intentionally never deleted, calls may retry until the very end of the process.
+    static DAIRetryPolicy *policy = new DAIRetryPolicy;
+    return policy;
+}
+
+void DAIRetryPolicy::setMaxAttempts(int count)
+{
+    QMutexLocker lk(&d->mtx);
+    d->maxAttempts = qMax(1, count);
+}
+
+int DAIRetryPolicy::maxAttempts() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->maxAttempts;
+}
+
+void DAIRetryPolicy::setBaseDelay(int msec)
+{
+    QMutexLocker lk(&d->mtx);
+    d->baseDelay = qMax(0, msec);
+}
+
+int DAIRetryPolicy::baseDelay() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->baseDelay;
+}
+
+void DAIRetryPolicy::setMaximumDelay(int msec)
+{
+    QMutexLocker lk(&d->mtx);
+    d->maximumDelay = qMax(0, msec);
+}
+
+int DAIRetryPolicy::maximumDelay() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->maximumDelay;
+}
+
+void DAIRetryPolicy::setRetryBudget(double ratio)
+{
+    QMutexLocker lk(&d->mtx);
+    d->budgetRatio = qMax(0.0, ratio);
+}
+
+double DAIRetryPolicy::retryBudget() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->budgetRatio;
+}
+
+DAIRetryPolicy::Statistics DAIRetryPolicy::statistics() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->stats;
+}
+
+DAI_END_NAMESPACE
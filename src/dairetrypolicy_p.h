@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAIRETRYPOLICY_P_H
+#define DAIRETRYPOLICY_P_H
+
+#include "dairetrypolicy.h"
+#include "daierror.h"
+#include "daicircuitbreaker_p.h"
+#include "dairequestoptions_p.h"
+
+#include <QDBusAbstractInterface>
+#include <QDBusError>
+#include <QDBusPendingCall>
+#include <QDeadlineTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+DAI_BEGIN_NAMESPACE
+
+class DAIRetryPolicyPrivate
+{
+public:
+    explicit DAIRetryPolicyPrivate(DAIRetryPolicy *q);
+
+    // Called once per call before its first attempt, earns retry budget.
+    static void deposit();
+    // Whether a call that failed on attempt should go again, delay receives the wait in msec.
+    static bool shouldRetry(const QDBusError &error, int attempt, const QDeadlineTimer &deadline, int *delay);
+
+public:
+    mutable QMutex mtx;
+    int maxAttempts = 3;
+    int baseDelay = 50;
+    int maximumDelay = 1000;
+    double budgetRatio = 0.2;
+    double budget = 0;
+    DAIRetryPolicy::Statistics stats;
+
+    DAIRetryPolicy *q = nullptr;
+};
+
+inline QDBusError replyError(QDBusPendingCall &call)
+{
+    call.waitForFinished();
+    return call.error();
+}
+
+// Issues call on proxy with the timeout of proxy cut to what is left of the deadline of options.
+// lock, when given, must be the lock every issue on proxy takes, the timeout is shared by them.
+template <typename Call>
+inline auto issueWithDeadline(const Call &call, const DAIRequestOptions &options, QDBusAbstractInterface *proxy, QMutex *lock) -> decltype(call())
+{
+    QMutexLocker lk(lock);
+    if (!proxy || options.deadline.isForever())
+        return call();
+
+    // -1 is the default timeout of D-Bus.
+    const int previous = proxy->timeout();
+    proxy->setTimeout(requestTimeout(options, previous < 0 ? 25000 : previous));
+    auto reply = call();
+    proxy->setTimeout(previous);
+    return reply;
+}
+
+// Runs call, a blocking D-Bus call on proxy that is safe to repeat, retrying it as DAIRetryPolicy
+// allows. No attempt waits past the deadline of options and none starts once the request expired
+// or was cancelled. Every attempt, the last included, is reported to the circuit breaker here
+// unless the deadline cut it short.
+template <typename Call>
+inline auto callWithRetry(Call call, const DAIRequestOptions &options = DAIRequestOptions(),
+                          QDBusAbstractInterface *proxy = nullptr, QMutex *lock = nullptr) -> decltype(call())
+{
+    DAIRetryPolicyPrivate::deposit();
+    for (int attempt = 1;; ++attempt) {
+        auto reply = issueWithDeadline(call, options, proxy, lock);
+        const QDBusError error = replyError(reply);
+        // An attempt cut short by the deadline says nothing about the daemon.
+        if (!error.isValid() || !options.deadline.hasExpired())
+            recordCallResult(error);
+        int delay = 0;
+        if (!DAIRetryPolicyPrivate::shouldRetry(error, attempt, options.deadline, &delay))
+            return reply;
+
+        QThread::msleep(static_cast<unsigned long>(delay));
+        if (requestOptionsError(options).getErrorCode() != NoError)
+            return reply;
+    }
+}
+
+DAI_END_NAMESPACE
+
+#endif // DAIRETRYPOLICY_P_H
@@ -0,0 +1,409 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daischeduler.h"
+#include "daischeduler_p.h"
+#include "daiasync_p.h"
+#include "dairequestoptions_p.h"
+#include "daierror.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtMath>
+
+#include <climits>
+#include <memory>
+
+Q_LOGGING_CATEGORY(dtkaiScheduler, "dtkai.scheduler")
+
+DAI_BEGIN_NAMESPACE
+
+namespace {
+// Starts an admitted request at most once, a request that never starts gives its slot back.
+struct DispatchGuard
+{
+    explicit DispatchGuard(quint64 id)
+        : id(id)
+    {
+    }
+
+    ~DispatchGuard()
+    {
+        if (!started)
+            DAISchedulerPrivate::finish(id);
+    }
+
+    quint64 id = 0;
+    bool started = false;
+};
+
+int priorityIndex(DAIRequestPriority priority)
+{
+    return qBound(0, static_cast<int>(priority), 2);
+}
+}
+
+DAISchedulerSlot::DAISchedulerSlot(const QString &capability, const DAIRequestOptions &options)
+    : id(DAISchedulerPrivate::acquire(capability, options, &err))
+{
+    // Cancelled or expired while the call waited for its turn.
+    if (id != 0)
+        err = requestOptionsError(options);
+}
+
+DAISchedulerSlot::~DAISchedulerSlot()
+{
+    DAISchedulerPrivate::finish(id);
+}
+
+DAISchedulerPrivate::DAISchedulerPrivate(DAIScheduler *parent)
+    : q(parent)
+{
+}
+
+void DAISchedulerPrivate::submit(quint64 id, const QString &capability, const DAIRequestOptions &options,
+                                 QObject *context, const std::function<void()> &start)
+{
+    DAISchedulerPrivate *d = DAIScheduler::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    Capability &cap = d->capabilities[capability];
+    if (d->isQueueEmpty(cap) && d->tryAdmit(cap)) {
+        d->running.insert(id, capability);
+        lk.unlock();
+        start();
+        return;
+    }
+
+    Pending *pending = new Pending;
+    pending->id = id;
+    pending->capability = capability;
+    pending->priority = priorityIndex(options.priority);
+    pending->queued.start();
+    pending->context = context;
+    pending->start = start;
+    cap.queue[pending->priority].append(pending);
+    d->pending.insert(id, pending);
+    qCDebug(dtkaiScheduler) << "Queued request" << id << "of" << capability;
+
+    QList<Pending *> started;
+    d->pump(capability, &started);
+    lk.unlock();
+    d->dispatch(started);
+}
+
+quint64 DAISchedulerPrivate::acquire(const QString &capability, const DAIRequestOptions &options,
+                                     DTK_CORE_NAMESPACE::DError *error)
+{
+    DAISchedulerPrivate *d = DAIScheduler::instance()->d.data();
+    // Async requests give their slots back from reply handlers on this thread, it must not wait for one.
+    const bool ownerThread = QThread::currentThread() == d->q->thread();
+    const quint64 id = nextRequestId();
+    QMutexLocker lk(&d->mtx);
+    {
+        Capability &cap = d->capabilities[capability];
+        if (d->isQueueEmpty(cap) && d->tryAdmit(cap)) {
+            d->running.insert(id, capability);
+            return id;
+        }
+    }
+
+    Pending *pending = new Pending;
+    pending->id = id;
+    pending->capability = capability;
+    pending->priority = priorityIndex(options.priority);
+    pending->queued.start();
+    d->capabilities[capability].queue[pending->priority].append(pending);
+    d->pending.insert(id, pending);
+
+    QList<Pending *> started;
+    d->pump(capability, &started);
+    while (!pending->admitted) {
+        if (!started.isEmpty()) {
+            lk.unlock();
+            d->dispatch(started);
+            started.clear();
+            lk.relock();
+            continue;
+        }
+
+        const Capability &cap = d->capabilities[capability];
+        const bool refused = ownerThread && cap.limit > 0 && cap.running >= cap.limit;
+        if (refused || options.deadline.hasExpired()) {
+            d->pending.remove(id);
+            d->dequeue(pending);
+            ++d->capabilities[capability].stats.expired;
+            delete pending;
+            if (error) {
+                *error = refused ? DTK_CORE_NAMESPACE::DError(AIErrorCode::RequestRejected,
+                                                              QString("Too many %1 requests running").arg(capability))
+                                 : deadlineExceededError();
+            }
+            if (refused)
+                qCWarning(dtkaiScheduler) << "Refused to block the thread of the scheduler for a slot of" << capability;
+            return 0;
+        }
+
+        // Tokens refill with time alone, nobody wakes us for them.
+        qint64 wait = options.deadline.remainingTime();
+        if (cap.rate > 0) {
+            const qint64 refill = qMax<qint64>(1, qCeil((1 - cap.tokens) / cap.rate * 1000));
+            wait = wait < 0 ? refill : qMin(wait, refill);
+        }
+        d->admitted.wait(&d->mtx, wait < 0 ? ULONG_MAX : static_cast<unsigned long>(wait));
+        d->pump(capability, &started);
+    }
+
+    d->pending.remove(id);
+    delete pending;
+    lk.unlock();
+    d->dispatch(started);
+    return id;
+}
+
+void DAISchedulerPrivate::finish(quint64 id)
+{
+    if (id == 0)
+        return;
+
+    DAISchedulerPrivate *d = DAIScheduler::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    if (Pending *pending = d->pending.value(id)) {
+        // A blocking request owns its entry until acquire() returns.
+        if (!pending->start)
+            return;
+
+        d->pending.remove(id);
+        d->dequeue(pending);
+        ++d->capabilities[pending->capability].stats.expired;
+        delete pending;
+        return;
+    }
+
+    auto it = d->running.find(id);
+    if (it == d->running.end())
+        return;
+
+    const QString capability = it.value();
+    d->running.erase(it);
+    --d->capabilities[capability].running;
+
+    QList<Pending *> started;
+    d->pump(capability, &started);
+    lk.unlock();
+    d->dispatch(started);
+}
+
+bool DAISchedulerPrivate::tryAdmit(Capability &cap)
+{
+    if (cap.limit > 0 && cap.running >= cap.limit)
+        return false;
+
+    if (cap.rate > 0) {
+        cap.tokens = qMin<double>(cap.burst, cap.tokens + cap.refilled.nsecsElapsed() / 1e9 * cap.rate);
+        cap.refilled.restart();
+        if (cap.tokens < 1)
+            return false;
+        cap.tokens -= 1;
+    }
+
+    ++cap.running;
+    ++cap.stats.dispatched;
+    return true;
+}
+
+bool DAISchedulerPrivate::isQueueEmpty(const Capability &cap) const
+{
+    for (const QList<Pending *> &queue : cap.queue) {
+        if (!queue.isEmpty())
+            return false;
+    }
+    return true;
+}
+
+void DAISchedulerPrivate::pump(const QString &capability, QList<Pending *> *started)
+{
+    Capability &cap = capabilities[capability];
+    bool woken = false;
+    bool blocked = false;
+    // Strictly by priority, a waiting interactive request is never overtaken by batch work.
+    for (QList<Pending *> &queue : cap.queue) {
+        while (!queue.isEmpty()) {
+            if (!tryAdmit(cap)) {
+                blocked = true;
+                break;
+            }
+
+            Pending *next = queue.takeFirst();
+            const qint64 waited = next->queued.elapsed();
+            cap.stats.totalWaitTime += waited;
+            cap.stats.maxWaitTime = qMax(cap.stats.maxWaitTime, waited);
+            next->admitted = true;
+            running.insert(next->id, capability);
+            if (next->start) {
+                pending.remove(next->id);
+                started->append(next);
+            } else {
+                woken = true;
+            }
+        }
+        if (blocked)
+            break;
+    }
+
+    if (woken)
+        admitted.wakeAll();
+
+    if (blocked && cap.rate > 0 && (cap.limit == 0 || cap.running < cap.limit))
+        scheduleRefill(qMax<qint64>(1, qCeil((1 - cap.tokens) / cap.rate * 1000)));
+}
+
+void DAISchedulerPrivate::pumpAll(QList<Pending *> *started)
+{
+    const QStringList names = capabilities.keys();
+    for (const QString &name : names)
+        pump(name, started);
+}
+
+void DAISchedulerPrivate::dispatch(const QList<Pending *> &started)
+{
+    for (Pending *pending : started) {
+        auto guard = std::make_shared<DispatchGuard>(pending->id);
+        const std::function<void()> start = pending->start;
+        QObject *context = pending->context.data();
+        delete pending;
+
+        // Dropping the guard without starting frees the slot again.
+        if (!context)
+            continue;
+
+        QMetaObject::invokeMethod(context, [guard, start]() {
+            guard->started = true;
+            start();
+        }, Qt::QueuedConnection);
+    }
+}
+
+void DAISchedulerPrivate::scheduleRefill(qint64 msec)
+{
+    QMetaObject::invokeMethod(q, [this, msec]() {
+        if (!refillTimer->isActive() || refillTimer->remainingTime() > msec)
+            refillTimer->start(static_cast<int>(msec));
+    }, Qt::QueuedConnection);
+}
+
+void DAISchedulerPrivate::dequeue(Pending *pending)
+{
+    for (QList<Pending *> &queue : capabilities[pending->capability].queue)
+        queue.removeOne(pending);
+}
+
+DAIScheduler::DAIScheduler(QObject *parent)
+    : QObject(parent)
+    , d(new DAISchedulerPrivate(this))
+{
+    d->refillTimer = new QTimer(this);
+    d->refillTimer->setSingleShot(true);
+    connect(d->refillTimer, &QTimer::timeout, this, [this]() {
+        QList<DAISchedulerPrivate::Pending *> started;
+        QMutexLocker lk(&d->mtx);
+        d->pumpAll(&started);
+        lk.unlock();
+        d->dispatch(started);
+    });
+
+    // The scheduler is shared by every thread, keep its timer on the main event loop.
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        if (thread() != app->thread())
+            moveToThread(app->thread());
+    }
+}
+
+DAIScheduler::~DAIScheduler()
+{
+
+}
+
+DAIScheduler *DAIScheduler::instance()
+{
+    // Intentionally never deleted, requests may finish until the very end of the process.
+    static DAIScheduler *scheduler = new DAIScheduler;
+    return scheduler;
+}
+
+void DAIScheduler::setConcurrencyLimit(const QString &capability, int limit)
+{
+    QList<DAISchedulerPrivate::Pending *> started;
+    QMutexLocker lk(&d->mtx);
+    d->capabilities[capability].limit = qMax(0, limit);
+    d->pump(capability, &started);
+    lk.unlock();
+    d->dispatch(started);
+}
+
+int DAIScheduler::concurrencyLimit(const QString &capability) const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->capabilities.value(capability).limit;
+}
+
+void DAIScheduler::setRateLimit(const QString &capability, double rate, int burst)
+{
+    QList<DAISchedulerPrivate::Pending *> started;
+    QMutexLocker lk(&d->mtx);
+    DAISchedulerPrivate::Capability &cap = d->capabilities[capability];
+    cap.rate = qMax(0.0, rate);
+    cap.burst = qMax(1, burst);
+    cap.tokens = cap.burst;
+    cap.refilled.start();
+    d->pump(capability, &started);
+    lk.unlock();
+    d->dispatch(started);
+}
+
+double DAIScheduler::rateLimit(const QString &capability) const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->capabilities.value(capability).rate;
+}
+
+int DAIScheduler::rateBurst(const QString &capability) const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->capabilities.value(capability).burst;
+}
+
+DAIScheduler::Statistics DAIScheduler::statistics(const QString &capability) const
+{
+    QMutexLocker lk(&d->mtx);
+    auto it = d->capabilities.constFind(capability);
+    if (it == d->capabilities.constEnd())
+        return Statistics();
+
+    Statistics stats = it.value().stats;
+    for (const QList<DAISchedulerPrivate::Pending *> &queue : it.value().queue)
+        stats.queued += queue.size();
+    stats.running = it.value().running;
+    return stats;
+}
+
+DAIScheduler::Statistics DAIScheduler::statistics() const
+{
+    QMutexLocker lk(&d->mtx);
+    Statistics total;
+    for (auto it = d->capabilities.constBegin(); it != d->capabilities.constEnd(); ++it) {
+        const DAISchedulerPrivate::Capability &cap = it.value();
+        for (const QList<DAISchedulerPrivate::Pending *> &queue : cap.queue)
+            total.queued += queue.size();
+        total.running += cap.running;
+        total.dispatched += cap.stats.dispatched;
+        total.expired += cap.stats.expired;
+        total.totalWaitTime += cap.stats.totalWaitTime;
+        total.maxWaitTime = qMax(total.maxWaitTime, cap.stats.maxWaitTime);
+    }
+    return total;
+}
+
+DAI_END_NAMESPACE
@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAISCHEDULER_P_H
+#define DAISCHEDULER_P_H
+
+#include "daischeduler.h"
+#include "dairequestoptions.h"
+
+#include <DError>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+#include <QTimer>
+#include <QWaitCondition>
+
+#include <functional>
+
+DAI_BEGIN_NAMESPACE
+
+class DAISchedulerPrivate
+{
+public:
+    explicit DAISchedulerPrivate(DAIScheduler *q);
+
+    // Admits request id of capability, start runs in the thread of context once it is.
+    // With room to spare start runs right away, before submit returns.
+    static void submit(quint64 id, const QString &capability, const DAIRequestOptions &options,
+                       QObject *context, const std::function<void()> &start);
+    // Blocks until a request of capability is admitted, returns 0 and sets error when the deadline
+    // expired first. On the thread of the scheduler it never waits for a concurrency slot and
+    // returns 0 right away instead, the requests holding the slots finish on that thread.
+    static quint64 acquire(const QString &capability, const DAIRequestOptions &options,
+                           DTK_CORE_NAMESPACE::DError *error = nullptr);
+    // Frees the slot of a finished request, or drops it from the queue. Unknown ids are ignored.
+    static void finish(quint64 id);
+
+public:
+    struct Pending
+    {
+        quint64 id = 0;
+        QString capability;
+        int priority = 0;
+        QElapsedTimer queued;
+        QPointer<QObject> context;
+        std::function<void()> start;    // empty for blocking requests
+        bool admitted = false;
+    };
+
+    struct Capability
+    {
+        int limit = 0;
+        double rate = 0;
+        int burst = 1;
+        double tokens = 0;
+        QElapsedTimer refilled;
+        int running = 0;
+        QList<Pending *> queue[3];
+        DAIScheduler::Statistics stats;
+    };
+
+    bool tryAdmit(Capability &cap);
+    bool isQueueEmpty(const Capability &cap) const;
+    // Admits queued requests of capability while there is room, mtx is held.
+    void pump(const QString &capability, QList<Pending *> *started);
+    void pumpAll(QList<Pending *> *started);
+    void dispatch(const QList<Pending *> &started);
+    void scheduleRefill(qint64 msec);
+    void dequeue(Pending *pending);
+
+    mutable QMutex mtx;
+    QWaitCondition admitted;
+    QHash<QString, Capability> capabilities;
+    QHash<quint64, QString> running;
+    QHash<quint64, Pending *> pending;
+    QTimer *refillTimer = nullptr;
+
+    DAIScheduler *q = nullptr;
+};
+
+// Holds a slot of capability for the lifetime of a blocking call.
+class DAISchedulerSlot
+{
+public:
+    DAISchedulerSlot(const QString &capability, const DAIRequestOptions &options);
+    ~DAISchedulerSlot();
+
+    bool isAdmitted() const { return id != 0; }
+    // Why the call must not go ahead, also set when it was admitted but options expired meanwhile.
+    const DTK_CORE_NAMESPACE::DError &error() const { return err; }
+
+private:
+    Q_DISABLE_COPY(DAISchedulerSlot)
+    quint64 id = 0;
+    DTK_CORE_NAMESPACE::DError err;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAISCHEDULER_P_H
@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAISINGLEFLIGHT_P_H
+#define DAISINGLEFLIGHT_P_H
+
+#include "dtkaitypes.h"
+
+#include <QCryptographicHash>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QWaitCondition>
+
+#include <functional>
+#include <memory>
+
+DAI_BEGIN_NAMESPACE
+
+// Coalesces identical blocking calls made at the same time from different threads.
+// The first caller of a key runs the call, later callers wait for it and get a copy
+// of its result. Nothing is cached once the call returned.
+class DAISingleFlight
+{
+public:
+    void setEnabled(bool on)
+    {
+        QMutexLocker lk(&mtx);
+        enabled = on;
+    }
+
+    bool isEnabled() const
+    {
+        QMutexLocker lk(&mtx);
+        return enabled;
+    }
+
+    DAICoalescingStatistics statistics() const
+    {
+        QMutexLocker lk(&mtx);
+        return stats;
+    }
+
+    // All calls of one key must return the same type. An empty key is never coalesced,
+    // callers pass one when building the key is not worth it. A waiting caller runs the
+    // call itself when shareable rejects the result, e.g. an error caused by the deadline
+    // or the cancellation of the first caller rather than by the call.
+    template <typename T>
+    T run(const QString &key, const std::function<T()> &call,
+          const std::function<bool(const T &)> &shareable = nullptr)
+    {
+        QMutexLocker lk(&mtx);
+        if (!enabled || key.isEmpty()) {
+            lk.unlock();
+            return call();
+        }
+
+        std::shared_ptr<Flight> flight = flights.value(key);
+        if (flight) {
+            ++stats.hits;
+            while (!flight->done)
+                cond.wait(&mtx);
+            std::shared_ptr<T> result = std::static_pointer_cast<T>(flight->result);
+            lk.unlock();
+            if (shareable && !shareable(*result))
+                return call();
+            return *result;
+        }
+
+        flight = std::make_shared<Flight>();
+        flights.insert(key, flight);
+        ++stats.calls;
+        lk.unlock();
+
+        std::shared_ptr<T> result = std::make_shared<T>(call());
+
+        lk.relock();
+        flight->result = result;
+        flight->done = true;
+        flights.remove(key);
+        cond.wakeAll();
+        return *result;
+    }
+
+    static QString key(const QString &method, const QStringList &args)
+    {
+        return (QStringList { method } + args).join(QChar(0x1f));
+    }
+
+    // Large payloads like images are keyed by their digest.
+    static QString digest(const QByteArray &data)
+    {
+        return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+    }
+
+private:
+    struct Flight
+    {
+        bool done = false;
+        std::shared_ptr<void> result;
+    };
+
+    mutable QMutex mtx;
+    QWaitCondition cond;
+    bool enabled = false;
+    DAICoalescingStatistics stats;
+    QHash<QString, std::shared_ptr<Flight>> flights;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAISINGLEFLIGHT_P_H
@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daithreaderror_p.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+DAI_BEGIN_NAMESPACE
+
+DAIThreadError::DAIThreadError(int code, const QString &message)
+    : d(new State)
+{
+    d->published = DTK_CORE_NAMESPACE::DError(code, message);
+}
+
+DAIThreadError::~DAIThreadError()
+{
+    // Threads outliving the object, like the main thread, would keep their handlers forever.
+    QMutexLocker lk(&d->mtx);
+    for (const Result &result : qAsConst(d->threads))
+        QObject::disconnect(result.finished);
+}
+
+DAIThreadError &DAIThreadError::operator=(const DTK_CORE_NAMESPACE::DError &error)
+{
+    QMutexLocker lk(&d->mtx);
+    setOwn(error);
+    return *this;
+}
+
+void DAIThreadError::publish(const DTK_CORE_NAMESPACE::DError &error)
+{
+    QMutexLocker lk(&d->mtx);
+    d->published = error;
+    // Handlers of the completion run in this thread and read it there.
+    setOwn(error);
+}
+
+void DAIThreadError::setOwn(const DTK_CORE_NAMESPACE::DError &error)
+{
+    const Qt::HANDLE id = QThread::currentThreadId();
+    auto it = d->threads.find(id);
+    if (it != d->threads.end()) {
+        it->error = error;
+        return;
+    }
+
+    // Forgotten when the thread ends, a later thread may get the same id. The handler
+    // holds the state, the object may be gone by then.
+    const QSharedPointer<State> state = d;
+    QThread *thread = QThread::currentThread();
+    const QMetaObject::Connection finished = QObject::connect(thread, &QThread::finished, thread, [state, id]() {
+        QMutexLocker lk(&state->mtx);
+        QObject::disconnect(state->threads.take(id).finished);
+    }, Qt::DirectConnection);
+    d->threads.insert(id, { error, finished });
+}
+
+DTK_CORE_NAMESPACE::DError DAIThreadError::value() const
+{
+    QMutexLocker lk(&d->mtx);
+    auto it = d->threads.constFind(QThread::currentThreadId());
+    if (it != d->threads.constEnd())
+        return it->error;
+
+    return d->published;
+}
+
+DAI_END_NAMESPACE
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAITHREADERROR_P_H
+#define DAITHREADERROR_P_H
+
+#include "dtkai_global.h"
+
+#include <DError>
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+
+DAI_BEGIN_NAMESPACE
+
+// lastError() of a client object that is called from several threads.
+// A thread sees the result of its own latest call, or of the latest request
+// that completed in it. Threads without a result of their own see the latest
+// completion of the object, wherever it happened.
+class DAIThreadError
+{
+public:
+    explicit DAIThreadError(int code = 0, const QString &message = QString());
+    ~DAIThreadError();
+
+    // Result of a call made by the current thread.
+    DAIThreadError &operator=(const DTK_CORE_NAMESPACE::DError &error);
+    // Result of a request that completed on its own, e.g. in a reply handler.
+    void publish(const DTK_CORE_NAMESPACE::DError &error);
+
+    DTK_CORE_NAMESPACE::DError value() const;
+    operator DTK_CORE_NAMESPACE::DError() const { return value(); }
+    int getErrorCode() const { return value().getErrorCode(); }
+    QString getErrorMessage() const { return value().getErrorMessage(); }
+
+private:
+    Q_DISABLE_COPY(DAIThreadError)
+
+    struct Result
+    {
+        DTK_CORE_NAMESPACE::DError error;
+        // To QThread::finished, which forgets the result.
+        QMetaObject::Connection finished;
+    };
+    // Shared with the handlers that forget the result of a finished thread.
+    struct State
+    {
+        QMutex mtx;
+        DTK_CORE_NAMESPACE::DError published;
+        QHash<Qt::HANDLE, Result> threads;
+    };
+    // Stores the result of the current thread, requires State::mtx.
+    void setOwn(const DTK_CORE_NAMESPACE::DError &error);
+
+    QSharedPointer<State> d;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAITHREADERROR_P_H
@@ -0,0 +1,247 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daitransport.h"
+#include "daitransport_p.h"
+#include "dsessionpool.h"
+#include "aidaemon_sessionmanager.h"
+
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+
+Q_LOGGING_CATEGORY(dtkaiTransport, "dtkai.transport")
+
+DAI_BEGIN_NAMESPACE
+
+DAITransportPrivate::DAITransportPrivate(DAITransport *parent)
+    : q(parent)
+{
+}
+
+void DAITransportPrivate::adopt(QObject *proxy)
+{
+    DAITransportPrivate *d = DAITransport::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    if (!d->ioThreadEnabled)
+        return;
+
+    proxy->moveToThread(d->ioThread());
+}
+
+bool DAITransportPrivate::isIoThread()
+{
+    DAITransportPrivate *d = DAITransport::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    return d->thread && d->thread == QThread::currentThread();
+}
+
+Qt::ConnectionType DAITransportPrivate::signalConnection(const QObject *proxy)
+{
+    // The handlers lock what they touch, running them on the I/O thread keeps
+    // the thread of the client object out of the delivery path.
+    if (proxy->thread() != QThread::currentThread())
+        return Qt::DirectConnection;
+
+    return Qt::AutoConnection;
+}
+
+QDBusConnection DAITransportPrivate::sessionConnection()
+{
+    DAITransportPrivate *d = DAITransport::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    if (d->mode == DAITransport::PeerToPeer && !d->peerFailed) {
+        QDBusConnection con = d->peerConnection();
+        if (con.isConnected())
+            return con;
+    }
+
+    return QDBusConnection::sessionBus();
+}
+
+QString DAITransportPrivate::serviceName(const QDBusConnection &con)
+{
+    if (con.name().startsWith("dtkai-peer-"))
+        return QString();
+
+    return OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName();
+}
+
+QDBusConnection DAITransportPrivate::threadConnection(QString *name)
+{
+    name->clear();
+    QCoreApplication *app = QCoreApplication::instance();
+    if (!app || QThread::currentThread() == app->thread())
+        return QDBusConnection::sessionBus();
+
+    DAITransportPrivate *d = DAITransport::instance()->d.data();
+    QMutexLocker lk(&d->mtx);
+    if (!d->perThreadConnections)
+        return QDBusConnection::sessionBus();
+
+    const QString connectionName = QString("dtkai-thread-%1").arg(++d->threadConnectionCount);
+    lk.unlock();
+
+    QDBusConnection con = QDBusConnection::connectToBus(QDBusConnection::SessionBus, connectionName);
+    if (!con.isConnected()) {
+        qCWarning(dtkaiTransport) << "Failed to open a session bus connection for thread"
+                                  << QThread::currentThread() << con.lastError().message();
+        QDBusConnection::disconnectFromBus(connectionName);
+        return QDBusConnection::sessionBus();
+    }
+
+    *name = connectionName;
+    return con;
+}
+
+void DAITransportPrivate::closeThreadConnection(const QString &name)
+{
+    if (!name.isEmpty())
+        QDBusConnection::disconnectFromBus(name);
+}
+
+QDBusConnection DAITransportPrivate::peerConnection()
+{
+    if (!peerName.isEmpty()) {
+        QDBusConnection con(peerName);
+        if (con.isConnected())
+            return con;
+
+        // The daemon dropped us without leaving the bus, ask it for a new one.
+        QDBusConnection::disconnectFromPeer(peerName);
+        peerName.clear();
+    }
+
+    OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
+                                                            "/org/deepin/ai/daemon/SessionManager", QDBusConnection::sessionBus());
+    sessionManager.setTimeout(3000);
+    QDBusPendingReply<QString> reply = sessionManager.GetPeerAddress();
+    reply.waitForFinished();
+    if (reply.isError() || reply.value().isEmpty()) {
+        // Older daemons have no peer address, stay on the bus until the daemon restarts.
+        qCInfo(dtkaiTransport) << "No peer address from ai-daemon, using the session bus:" << reply.error().message();
+        peerFailed = true;
+        return QDBusConnection(QString());
+    }
+
+    const QString name = QString("dtkai-peer-%1").arg(++peerCount);
+    QDBusConnection con = QDBusConnection::connectToPeer(reply.value(), name);
+    if (!con.isConnected()) {
+        qCWarning(dtkaiTransport) << "Failed to connect to ai-daemon peer" << reply.value() << con.lastError().message();
+        QDBusConnection::disconnectFromPeer(name);
+        peerFailed = true;
+        return con;
+    }
+
+    qCInfo(dtkaiTransport) << "Connected to ai-daemon peer" << reply.value();
+    peerName = name;
+    return con;
+}
+
+void DAITransportPrivate::resetPeer()
+{
+    QMutexLocker lk(&mtx);
+    peerFailed = false;
+    if (peerName.isEmpty())
+        return;
+
+    QDBusConnection::disconnectFromPeer(peerName);
+    peerName.clear();
+}
+
+QThread *DAITransportPrivate::ioThread()
+{
+    if (thread)
+        return thread;
+
+    thread = new QThread;
+    thread->setObjectName("dtkai-io");
+    thread->start();
+    qCInfo(dtkaiTransport) << "Started D-Bus I/O thread";
+
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        QThread *io = thread;
+        QObject::connect(app, &QCoreApplication::aboutToQuit, [io]() {
+            io->quit();
+            io->wait();
+        });
+    }
+    return thread;
+}
+
+DAITransport::DAITransport(QObject *parent)
+    : QObject(parent)
+    , d(new DAITransportPrivate(this))
+{
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        if (thread() != app->thread())
+            moveToThread(app->thread());
+    }
+
+    // A restarted daemon listens on a new address, sessions of the old one are gone anyway.
+    connect(DSessionPool::instance(), &DSessionPool::daemonStopped, this, [this]() {
+        d->resetPeer();
+    });
+    connect(DSessionPool::instance(), &DSessionPool::daemonStarted, this, [this]() {
+        d->resetPeer();
+    });
+}
+
+DAITransport::~DAITransport()
+{
+
+}
+
+DAITransport *DAITransport::instance()
+{
+    // Intentionally never deleted, proxies may live on its thread until the very end of the process.
+    static DAITransport *transport = new DAITransport;
+    return transport;
+}
+
+void DAITransport::setIOThreadEnabled(bool enabled)
+{
+    QMutexLocker lk(&d->mtx);
+    d->ioThreadEnabled = enabled;
+}
+
+bool DAITransport::isIOThreadEnabled() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->ioThreadEnabled;
+}
+
+void DAITransport::setConnectionMode(ConnectionMode mode)
+{
+    {
+        QMutexLocker lk(&d->mtx);
+        if (d->mode == mode)
+            return;
+        d->mode = mode;
+    }
+
+    // Proxies opened before keep their connection, only drop ours when leaving peer mode.
+    if (mode == SessionBus)
+        d->resetPeer();
+}
+
+DAITransport::ConnectionMode DAITransport::connectionMode() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->mode;
+}
+
+void DAITransport::setPerThreadConnectionsEnabled(bool enabled)
+{
+    QMutexLocker lk(&d->mtx);
+    d->perThreadConnections = enabled;
+}
+
+bool DAITransport::isPerThreadConnectionsEnabled() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->perThreadConnections;
+}
+
+DAI_END_NAMESPACE
@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAITRANSPORT_P_H
+#define DAITRANSPORT_P_H
+
+#include "daitransport.h"
+
+#include <QDBusConnection>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QThread>
+
+DAI_BEGIN_NAMESPACE
+
+class DAITransportPrivate
+{
+public:
+    explicit DAITransportPrivate(DAITransport *q);
+
+    // Moves a freshly created proxy to the I/O thread when it is enabled.
+    static void adopt(QObject *proxy);
+    // Whether the calling thread is the shared I/O thread, blocking there stalls every proxy on it.
+    static bool isIoThread();
+    // Connection type for proxy signals, handlers run on the thread of the proxy.
+    static Qt::ConnectionType signalConnection(const QObject *proxy);
+    // Connection to open session proxies on, the peer connection in PeerToPeer mode.
+    static QDBusConnection sessionConnection();
+    // Service name for proxies on con, peers have no bus names.
+    static QString serviceName(const QDBusConnection &con);
+    // Session bus connection of the calling thread when per-thread connections are enabled,
+    // the shared one otherwise. A non-empty name must be passed to closeThreadConnection().
+    static QDBusConnection threadConnection(QString *name);
+    static void closeThreadConnection(const QString &name);
+
+    QThread *ioThread();
+    QDBusConnection peerConnection();
+    void resetPeer();
+
+public:
+    mutable QMutex mtx;
+    bool ioThreadEnabled = false;
+    QThread *thread = nullptr;
+
+    DAITransport::ConnectionMode mode = DAITransport::SessionBus;
+    QString peerName;
+    bool peerFailed = false;
+    int peerCount = 0;
+
+    bool perThreadConnections = false;
+    int threadConnectionCount = 0;
+
+    DAITransport *q = nullptr;
+};
+
+// QScopedPointer cleanup for proxies, they are deleted in their own thread.
+struct DAIProxyDeleter
+{
+    // The proxy of a client session. Calls copy it under the lock of the client and issue
+    // on the copy, the client may replace it meanwhile and the last copy deletes it.
+    template <typename Interface>
+    static QSharedPointer<Interface> shared(Interface *proxy)
+    {
+        return QSharedPointer<Interface>(proxy, &DAIProxyDeleter::cleanup);
+    }
+
+    static inline void cleanup(QObject *proxy)
+    {
+        if (!proxy)
+            return;
+
+        if (proxy->thread() == QThread::currentThread()) {
+            delete proxy;
+        } else {
+            // Nothing may reach the owner of the proxy once it let go of it.
+            QObject::disconnect(proxy, nullptr, nullptr, nullptr);
+            proxy->deleteLater();
+        }
+    }
+};
+
+// Lifetime of an object handling proxy signals. With the I/O thread the handlers run
+// there, one may still be running while the object is destroyed on its own thread and
+// disconnecting does not wait for it. Handlers hold a copy of the guard and run under it.
+class DAIHandlerGuard
+{
+public:
+    DAIHandlerGuard() : lock(QReadWriteLock::Recursive) {}
+
+    // Waits for running handlers, none is entered afterwards. Must not be called from a handler.
+    void close()
+    {
+        QWriteLocker lk(&lock);
+        closed = true;
+    }
+
+    template <typename Func>
+    void run(Func func)
+    {
+        QReadLocker lk(&lock);
+        if (!closed)
+            func();
+    }
+
+    // Handler invoking slot of receiver as long as guard is open.
+    template <typename Receiver, typename... Args>
+    static auto wrap(const QSharedPointer<DAIHandlerGuard> &guard, Receiver *receiver, void (Receiver::*slot)(Args...))
+    {
+        return [guard, receiver, slot](Args... args) {
+            guard->run([&]() {
+                (receiver->*slot)(args...);
+            });
+        };
+    }
+
+private:
+    QReadWriteLock lock;
+    bool closed = false;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAITRANSPORT_P_H
@@ -2,8 +2,13 @@
 //
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
-#include "dmodelmanager.h"
+#include "dmodelmanager_p.h"
 #include "aidaemon_modelinfo.h" // D-Bus generated proxy header
+#include "daicircuitbreaker_p.h"
+#include "dairetrypolicy_p.h"
+#include "daischeduler_p.h"
+#include "daisingleflight_p.h"
+#include "daitransport_p.h"
 
 #include <QDBusConnection>
 #include <QDBusReply>
@@ -11,96 +16,135 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QLoggingCategory>
+#include <QThreadStorage>
 
 Q_LOGGING_CATEGORY(dtkaiModelManager, "dtkai.modelmanager")
 
 DAI_USE_NAMESPACE
 
 namespace {
-    // Helper function to get D-Bus interface
-    OrgDeepinAiDaemonModelInfoInterface* getModelInfoInterface() {
-        static OrgDeepinAiDaemonModelInfoInterface* interface = nullptr;
-        if (!interface) {
-            interface = new OrgDeepinAiDaemonModelInfoInterface(
-                "org.deepin.ai.daemon.ModelInfo",
-                "/org/deepin/ai/daemon/ModelInfo",
-                QDBusConnection::sessionBus()
-            );
-        }
-        return interface;
+    // Identical model queries issued at the same time share one D-Bus call.
+    DAISingleFlight *modelInfoFlight() {
+        static DAISingleFlight flight;
+        return &flight;
     }
 
-    // Helper function to convert single JSON object to ModelInfo
-    ModelInfo parseModelFromJson(const QString &jsonStr) {
-        ModelInfo info;
+    // Key of a query that may be coalesced, queries of different priority are not. A query with
+    // a deadline runs on its own, a caller running out of time must not empty the result of others.
+    QString flightKey(const QString &method, const QStringList &args, const DAIRequestOptions &options)
+    {
+        if (!options.deadline.isForever())
+            return QString();
 
-        QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
-        if (!doc.isObject()) {
-            qCWarning(dtkaiModelManager) << "Invalid JSON response for single model";
-            return info;
-        }
+        return DAISingleFlight::key(method, QStringList(args) << QString::number(int(options.priority)));
+    }
 
-        QJsonObject modelObj = doc.object();
-        if (modelObj.isEmpty()) {
-            return info; // Empty model info for not found
+    // Proxy of one thread, on the connection of that thread when it has its own.
+    struct ModelInfoProxy
+    {
+        ~ModelInfoProxy()
+        {
+            interface.reset();
+            DAITransportPrivate::closeThreadConnection(connectionName);
         }
 
-        info.modelName = modelObj["name"].toString();
-        info.provider = modelObj["provider"].toString();
-        info.description = modelObj["description"].toString();
-        info.capability = modelObj["capability"].toString();
-        info.isAvailable = modelObj["isAvailable"].toBool();
-
-        // Parse deploy type
-        QString deployTypeStr = modelObj["deployType"].toString();
-        if (deployTypeStr == "Local") {
-            info.deployType = DeployType::Local;
-        } else if (deployTypeStr == "Cloud") {
-            info.deployType = DeployType::Cloud;
-        } else {
-            info.deployType = DeployType::Custom;
-        }
+        QString connectionName;
+        QScopedPointer<OrgDeepinAiDaemonModelInfoInterface> interface;
+    };
 
-        // Parse parameters
-        QJsonObject paramsObj = modelObj["parameters"].toObject();
-        for (auto it = paramsObj.begin(); it != paramsObj.end(); ++it) {
-            info.parameters[it.key()] = it.value().toVariant();
+    // Helper function to get D-Bus interface
+    OrgDeepinAiDaemonModelInfoInterface* getModelInfoInterface() {
+        // Treat the daemon as unavailable while the circuit breaker is open
+        if (!DAICircuitBreaker::instance()->allowRequest())
+            return nullptr;
+
+        // Each thread gets a proxy of its own that lives and dies with it, so
+        // worker threads never share, or outlive, the proxy of another thread.
+        static QThreadStorage<ModelInfoProxy *> proxies;
+        if (!proxies.hasLocalData()) {
+            ModelInfoProxy *proxy = new ModelInfoProxy;
+            QDBusConnection con = DAITransportPrivate::threadConnection(&proxy->connectionName);
+            proxy->interface.reset(new OrgDeepinAiDaemonModelInfoInterface(
+                "org.deepin.ai.daemon.ModelInfo",
+                "/org/deepin/ai/daemon/ModelInfo",
+                con
+            ));
+            proxies.setLocalData(proxy);
         }
+        return proxies.localData()->interface.data();
+    }
+}
 
+ModelInfo DModelManagerPrivate::parseModelFromJson(const QString &jsonStr)
+{
+    ModelInfo info;
+
+    QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
+    if (!doc.isObject()) {
+        qCWarning(dtkaiModelManager) << "Invalid JSON response for single model";
         return info;
     }
 
-    // Helper function to convert JSON string to ModelInfo list
-    QList<ModelInfo> parseModelsFromJson(const QString &jsonStr) {
-        QList<ModelInfo> models;
+    QJsonObject modelObj = doc.object();
+    if (modelObj.isEmpty()) {
+        return info; // Empty model info for not found
+    }
 
-        QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
-        if (!doc.isObject()) {
-            qCWarning(dtkaiModelManager) << "Invalid JSON response from daemon";
-            return models;
-        }
+    info.modelName = modelObj["name"].toString();
+    info.provider = modelObj["provider"].toString();
+    info.description = modelObj["description"].toString();
+    info.capability = modelObj["capability"].toString();
+    info.isAvailable = modelObj["isAvailable"].toBool();
+
+    // Parse deploy type
+    QString deployTypeStr = modelObj["deployType"].toString();
+    if (deployTypeStr == "Local") {
+        info.deployType = DeployType::Local;
+    } else if (deployTypeStr == "Cloud") {
+        info.deployType = DeployType::Cloud;
+    } else {
+        info.deployType = DeployType::Custom;
+    }
 
-        QJsonObject root = doc.object();
-        QJsonArray modelsArray = root["models"].toArray();
-
-        for (const QJsonValue value : modelsArray) {
-            QJsonObject modelObj = value.toObject();
-            
-            // Convert single model object to JSON string and parse using existing function
-            QJsonDocument modelDoc(modelObj);
-            QString modelJsonStr = modelDoc.toJson(QJsonDocument::Compact);
-            ModelInfo info = parseModelFromJson(modelJsonStr);
-            
-            if (!info.modelName.isEmpty()) {
-                models.append(info);
-            }
-        }
+    // Parse parameters
+    QJsonObject paramsObj = modelObj["parameters"].toObject();
+    for (auto it = paramsObj.begin(); it != paramsObj.end(); ++it) {
+        info.parameters[it.key()] = it.value().toVariant();
+    }
 
+    return info;
+}
+
+QList<ModelInfo> DModelManagerPrivate::parseModelsFromJson(const QString &jsonStr)
+{
+    QList<ModelInfo> models;
+
+    QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
+    if (!doc.isObject()) {
+        qCWarning(dtkaiModelManager) << "Invalid JSON response from daemon";
         return models;
     }
+
+    QJsonObject root = doc.object();
+    QJsonArray modelsArray = root["models"].toArray();
+
+    for (const QJsonValue value : modelsArray) {
+        QJsonObject modelObj = value.toObject();
+        
+        // Convert single model object to JSON string and parse using existing function
+        QJsonDocument modelDoc(modelObj);
+        QString modelJsonStr = modelDoc.toJson(QJsonDocument::Compact);
+        ModelInfo info = parseModelFromJson(modelJsonStr);
+        
+        if (!info.modelName.isEmpty()) {
+            models.append(info);
+        }
+    }
+
+    return models;
 }
 
-QStringList DModelManager::supportedCapabilities()
+QStringList DModelManager::supportedCapabilities(const DAIRequestOptions &options)
 {
     auto interface = getModelInfoInterface();
     if (!interface || !interface->isValid()) {
@@ -108,7 +152,12 @@ QStringList DModelManager::supportedCapabilities()
         return {};
     }
 
-    QDBusReply<QString> reply = interface->GetSupportedCapabilities();
+    // Admitted like every other request to the daemon, a refused query reports nothing.
+    DAISchedulerSlot slot("ModelInfo", options);
+    if (!slot.isAdmitted())
+        return {};
+
+    QDBusReply<QString> reply = callWithRetry([&]() { return interface->GetSupportedCapabilities(); }, options, interface);
     if (!reply.isValid()) {
         qCWarning(dtkaiModelManager) << "Failed to get supported capabilities:" << reply.error().message();
         return {};
@@ -131,78 +180,96 @@ QStringList DModelManager::supportedCapabilities()
     return capabilities;
 }
 
-bool DModelManager::isCapabilityAvailable(const QString &capability)
+bool DModelManager::isCapabilityAvailable(const QString &capability, const DAIRequestOptions &options)
 {
     // Check if any models support this capability
-    auto models = availableModels(capability);
+    auto models = availableModels(capability, options);
     return !models.isEmpty();
 }
 
-QList<ModelInfo> DModelManager::availableModels(const QString &capability)
+QList<ModelInfo> DModelManager::availableModels(const QString &capability, const DAIRequestOptions &options)
 {
-    auto interface = getModelInfoInterface();
-    if (!interface || !interface->isValid()) {
-        qCWarning(dtkaiModelManager) << "ModelInfo D-Bus interface not available";
-        return QList<ModelInfo>();
-    }
+    return modelInfoFlight()->run<QList<ModelInfo>>(flightKey("GetModelsForCapability", { capability }, options), [&]() {
+        auto interface = getModelInfoInterface();
+        if (!interface || !interface->isValid()) {
+            qCWarning(dtkaiModelManager) << "ModelInfo D-Bus interface not available";
+            return QList<ModelInfo>();
+        }
 
-    QDBusReply<QString> reply = interface->GetModelsForCapability(capability);
-    if (!reply.isValid()) {
-        qCWarning(dtkaiModelManager) << "Failed to get models for capability" << capability
-                                    << ":" << reply.error().message();
-        return QList<ModelInfo>();
-    }
+        DAISchedulerSlot slot("ModelInfo", options);
+        if (!slot.isAdmitted())
+            return QList<ModelInfo>();
 
-    QList<ModelInfo> models = parseModelsFromJson(reply.value());
-    qCDebug(dtkaiModelManager) << "Found" << models.size() << "models for capability" << capability;
-    return models;
+        QDBusReply<QString> reply = callWithRetry([&]() { return interface->GetModelsForCapability(capability); }, options, interface);
+        if (!reply.isValid()) {
+            qCWarning(dtkaiModelManager) << "Failed to get models for capability" << capability
+                                        << ":" << reply.error().message();
+            return QList<ModelInfo>();
+        }
+
+        QList<ModelInfo> models = DModelManagerPrivate::parseModelsFromJson(reply.value());
+        qCDebug(dtkaiModelManager) << "Found" << models.size() << "models for capability" << capability;
+        return models;
+    });
 }
 
-QList<ModelInfo> DModelManager::availableModels()
+QList<ModelInfo> DModelManager::availableModels(const DAIRequestOptions &options)
 {
-    auto interface = getModelInfoInterface();
-    if (!interface || !interface->isValid()) {
-        qCWarning(dtkaiModelManager) << "ModelInfo D-Bus interface not available";
-        return QList<ModelInfo>();
-    }
+    return modelInfoFlight()->run<QList<ModelInfo>>(flightKey("GetAllModels", {}, options), [&]() {
+        auto interface = getModelInfoInterface();
+        if (!interface || !interface->isValid()) {
+            qCWarning(dtkaiModelManager) << "ModelInfo D-Bus interface not available";
+            return QList<ModelInfo>();
+        }
 
-    QDBusReply<QString> reply = interface->GetAllModels();
-    if (!reply.isValid()) {
-        qCWarning(dtkaiModelManager) << "Failed to get all models:" << reply.error().message();
-        return QList<ModelInfo>();
-    }
+        DAISchedulerSlot slot("ModelInfo", options);
+        if (!slot.isAdmitted())
+            return QList<ModelInfo>();
 
-    QList<ModelInfo> models = parseModelsFromJson(reply.value());
-    qCDebug(dtkaiModelManager) << "Found" << models.size() << "total models";
-    return models;
+        QDBusReply<QString> reply = callWithRetry([&]() { return interface->GetAllModels(); }, options, interface);
+        if (!reply.isValid()) {
+            qCWarning(dtkaiModelManager) << "Failed to get all models:" << reply.error().message();
+            return QList<ModelInfo>();
+        }
+
+        QList<ModelInfo> models = DModelManagerPrivate::parseModelsFromJson(reply.value());
+        qCDebug(dtkaiModelManager) << "Found" << models.size() << "total models";
+        return models;
+    });
 }
 
-ModelInfo DModelManager::modelInfo(const QString &modelName)
+ModelInfo DModelManager::modelInfo(const QString &modelName, const DAIRequestOptions &options)
 {
-    auto interface = getModelInfoInterface();
-    if (!interface || !interface->isValid()) {
-        qCWarning(dtkaiModelManager) << "ModelInfo D-Bus interface not available";
-        return ModelInfo();
-    }
+    return modelInfoFlight()->run<ModelInfo>(flightKey("GetModelInfo", { modelName }, options), [&]() {
+        auto interface = getModelInfoInterface();
+        if (!interface || !interface->isValid()) {
+            qCWarning(dtkaiModelManager) << "ModelInfo D-Bus interface not available";
+            return ModelInfo();
+        }
 
-    QDBusReply<QString> reply = interface->GetModelInfo(modelName);
-    if (!reply.isValid()) {
-        qCWarning(dtkaiModelManager) << "Failed to get model info for" << modelName
-                                    << ":" << reply.error().message();
-        return ModelInfo();
-    }
+        DAISchedulerSlot slot("ModelInfo", options);
+        if (!slot.isAdmitted())
+            return ModelInfo();
 
-    ModelInfo info = parseModelFromJson(reply.value());
-    if (info.modelName.isEmpty()) {
-        qCWarning(dtkaiModelManager) << "Model not found:" << modelName;
-    } else {
-        qCDebug(dtkaiModelManager) << "Found model info for" << modelName;
-    }
+        QDBusReply<QString> reply = callWithRetry([&]() { return interface->GetModelInfo(modelName); }, options, interface);
+        if (!reply.isValid()) {
+            qCWarning(dtkaiModelManager) << "Failed to get model info for" << modelName
+                                        << ":" << reply.error().message();
+            return ModelInfo();
+        }
 
-    return info;
+        ModelInfo info = DModelManagerPrivate::parseModelFromJson(reply.value());
+        if (info.modelName.isEmpty()) {
+            qCWarning(dtkaiModelManager) << "Model not found:" << modelName;
+        } else {
+            qCDebug(dtkaiModelManager) << "Found model info for" << modelName;
+        }
+
+        return info;
+    });
 }
 
-QString DModelManager::currentModelForCapability(const QString &capability)
+QString DModelManager::currentModelForCapability(const QString &capability, const DAIRequestOptions &options)
 {
     auto interface = getModelInfoInterface();
     if (!interface || !interface->isValid()) {
@@ -210,7 +277,11 @@ QString DModelManager::currentModelForCapability(const QString &capability)
         return QString();
     }
 
-    QDBusReply<QString> reply = interface->GetCurrentModelForCapability(capability);
+    DAISchedulerSlot slot("ModelInfo", options);
+    if (!slot.isAdmitted())
+        return QString();
+
+    QDBusReply<QString> reply = callWithRetry([&]() { return interface->GetCurrentModelForCapability(capability); }, options, interface);
     if (!reply.isValid()) {
         qCWarning(dtkaiModelManager) << "Failed to get current model for capability" << capability
                                     << ":" << reply.error().message();
@@ -220,7 +291,7 @@ QString DModelManager::currentModelForCapability(const QString &capability)
     return reply.value();
 }
 
-QStringList DModelManager::getProviderList()
+QStringList DModelManager::getProviderList(const DAIRequestOptions &options)
 {
     auto interface = getModelInfoInterface();
     if (!interface || !interface->isValid()) {
@@ -228,7 +299,11 @@ QStringList DModelManager::getProviderList()
         return QStringList();
     }
 
-    QDBusReply<QStringList> reply = interface->GetProviderList();
+    DAISchedulerSlot slot("ModelInfo", options);
+    if (!slot.isAdmitted())
+        return QStringList();
+
+    QDBusReply<QStringList> reply = callWithRetry([&]() { return interface->GetProviderList(); }, options, interface);
     if (!reply.isValid()) {
         qCWarning(dtkaiModelManager) << "Failed to get provider list:" 
                                     << reply.error().message();
@@ -238,7 +313,7 @@ QStringList DModelManager::getProviderList()
     return reply.value();
 }
 
-QList<ModelInfo> DModelManager::getModelsForProvider(const QString &provider)
+QList<ModelInfo> DModelManager::getModelsForProvider(const QString &provider, const DAIRequestOptions &options)
 {
     auto interface = getModelInfoInterface();
     if (!interface || !interface->isValid()) {
@@ -246,14 +321,33 @@ QList<ModelInfo> DModelManager::getModelsForProvider(const QString &provider)
         return QList<ModelInfo>();
     }
 
-    QDBusReply<QString> reply = interface->GetModelsForProvider(provider);
+    DAISchedulerSlot slot("ModelInfo", options);
+    if (!slot.isAdmitted())
+        return QList<ModelInfo>();
+
+    QDBusReply<QString> reply = callWithRetry([&]() { return interface->GetModelsForProvider(provider); }, options, interface);
     if (!reply.isValid()) {
         qCWarning(dtkaiModelManager) << "Failed to get models for provider" << provider
                                     << ":" << reply.error().message();
         return QList<ModelInfo>();
     }
 
-    QList<ModelInfo> models = parseModelsFromJson(reply.value());
+    QList<ModelInfo> models = DModelManagerPrivate::parseModelsFromJson(reply.value());
     qCDebug(dtkaiModelManager) << "Found" << models.size() << "models for provider" << provider;
     return models;
 }
+
+void DModelManager::setRequestCoalescingEnabled(bool enabled)
+{
+    modelInfoFlight()->setEnabled(enabled);
+}
+
+bool DModelManager::isRequestCoalescingEnabled()
+{
+    return modelInfoFlight()->isEnabled();
+}
+
+DAICoalescingStatistics DModelManager::coalescingStatistics()
+{
+    return modelInfoFlight()->statistics();
+}
@@ -0,0 +1,22 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DMODELMANAGER_P_H
+#define DMODELMANAGER_P_H
+
+#include "dmodelmanager.h"
+
+DAI_BEGIN_NAMESPACE
+
+class DModelManagerPrivate
+{
+public:
+    // Replies of the ModelInfo service, a model object and an object with a "models" array.
+    static ModelInfo parseModelFromJson(const QString &jsonStr);
+    static QList<ModelInfo> parseModelsFromJson(const QString &jsonStr);
+};
+
+DAI_END_NAMESPACE
+
+#endif // DMODELMANAGER_P_H
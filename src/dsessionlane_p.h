@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DSESSIONLANE_P_H
+#define DSESSIONLANE_P_H
+
+#include "dsessionpool.h"
+#include "aidaemon_sessionmanager.h"
+#include "daitransport_p.h"
+
+#include <QScopedPointer>
+
+DAI_BEGIN_NAMESPACE
+
+// A daemon session leased from DSessionPool for a single in-flight request.
+// Used where the daemon cannot tell concurrent requests of one session apart,
+// e.g. the untagged StreamOutput signal of the chat session.
+template <typename Interface>
+class DSessionLane
+{
+public:
+    explicit DSessionLane(const QString &type)
+        : type(type)
+    {
+    }
+
+    ~DSessionLane()
+    {
+        close();
+    }
+
+    bool open(int timeout)
+    {
+        sessionId = DSessionPool::instance()->acquire(type);
+        if (sessionId.isEmpty())
+            return false;
+
+        const QString sessionPath = QString("/org/deepin/ai/daemon/Session/%1").arg(sessionId);
+        QDBusConnection con = DAITransportPrivate::sessionConnection();
+        ifs.reset(new Interface(DAITransportPrivate::serviceName(con), sessionPath, con));
+        DAITransportPrivate::adopt(ifs.data());
+        ifs->setTimeout(timeout);
+        return true;
+    }
+
+    void close()
+    {
+        if (sessionId.isEmpty())
+            return;
+
+        ifs.reset(nullptr);
+        DSessionPool::instance()->release(type, sessionId);
+        sessionId.clear();
+    }
+
+    // Like close(), safe from within a signal of the proxy, which is deleted once control returns to its event loop.
+    void closeLater()
+    {
+        if (Interface *proxy = ifs.take()) {
+            QObject::disconnect(proxy, nullptr, nullptr, nullptr);
+            proxy->deleteLater();
+        }
+        close();
+    }
+
+public:
+    QString type;
+    QString sessionId;
+    QScopedPointer<Interface, DAIProxyDeleter> ifs;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DSESSIONLANE_P_H
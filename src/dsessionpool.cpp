@@ -0,0 +1,388 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "dsessionpool.h"
+#include "dsessionpool_p.h"
+#include "aidaemon_sessionmanager.h"
+#include "daiasync_p.h"
+#include "daifdpayload_p.h"
+#include "daimetrics_p.h"
+
+#include <QCoreApplication>
+#include <QDBusConnectionInterface>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+
+Q_LOGGING_CATEGORY(dtkaiSessionPool, "dtkai.sessionpool")
+
+DAI_USE_NAMESPACE
+
+DSessionPoolPrivate::DSessionPoolPrivate(DSessionPool *parent)
+    : q(parent)
+{
+    clock.start();
+}
+
+QString DSessionPoolPrivate::createSession(const QString &type)
+{
+    OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
+                                                            "/org/deepin/ai/daemon/SessionManager", QDBusConnection::sessionBus());
+    QElapsedTimer sent;
+    sent.start();
+    QDBusPendingReply<QString> reply = sessionManager.CreateSession(type);
+    reply.waitForFinished();
+    recordCallResult(reply);
+    DAIMetricsPrivate::record("DSessionPool.createSession." + type, sent.nsecsElapsed() / 1000,
+                              pendingCallError(reply).getErrorCode());
+    if (reply.isError()) {
+        qCWarning(dtkaiSessionPool) << "Failed to create" << type << "session:" << reply.error().message();
+        return QString();
+    }
+
+    return reply.value();
+}
+
+void DSessionPoolPrivate::destroySessions(const QStringList &sessionIds, bool wait)
+{
+    if (sessionIds.isEmpty())
+        return;
+
+    OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
+                                                            "/org/deepin/ai/daemon/SessionManager", QDBusConnection::sessionBus());
+    QList<QDBusPendingCall> calls;
+    for (const QString &id : sessionIds)
+        calls.append(sessionManager.DestroySession(id));
+
+    // DestroySession has no result, only wait when the process is about to go away.
+    if (wait) {
+        for (QDBusPendingCall &call : calls)
+            call.waitForFinished();
+    }
+}
+
+void DSessionPoolPrivate::restartTimer()
+{
+    const int interval = idleTimeout;
+    QMetaObject::invokeMethod(evictTimer, [this, interval]() {
+        if (interval > 0)
+            evictTimer->start(interval);
+        else
+            evictTimer->stop();
+    }, Qt::QueuedConnection);
+}
+
+void DSessionPoolPrivate::serviceUnregistered()
+{
+    {
+        QMutexLocker lk(&mtx);
+        ++generation;
+        daemonAvailable = false;
+        // The daemon took every session with it, remember how many each type needs again.
+        for (auto it = buckets.begin(); it != buckets.end(); ++it) {
+            Bucket &bucket = it.value();
+            const int inUse = bucket.idle.size() + bucket.leased.size();
+            bucket.warm = qMin(maximumSize, qMax(minimumSize, inUse));
+            bucket.idle.clear();
+            bucket.leased.clear();
+        }
+    }
+
+    qCInfo(dtkaiSessionPool) << "AI daemon stopped, all sessions dropped";
+    DAIFdPayload::resetCapabilities();
+    emit q->daemonStopped();
+}
+
+void DSessionPoolPrivate::serviceRegistered()
+{
+    QHash<QString, int> missing;
+    quint64 current = 0;
+    {
+        QMutexLocker lk(&mtx);
+        daemonAvailable = true;
+        current = generation;
+        for (auto it = buckets.begin(); it != buckets.end(); ++it) {
+            if (it.value().warm > 0)
+                missing.insert(it.key(), it.value().warm);
+            it.value().warm = 0;
+        }
+    }
+
+    // Lookups that failed while the daemon was away or starting are asked again.
+    DAIFdPayload::resetCapabilities();
+    qCInfo(dtkaiSessionPool) << "AI daemon started, recreating sessions for" << missing.keys();
+    for (auto it = missing.constBegin(); it != missing.constEnd(); ++it) {
+        for (int i = 0; i < it.value(); ++i)
+            createSessionAsync(it.key(), current);
+    }
+
+    emit q->daemonStarted();
+}
+
+void DSessionPoolPrivate::createSessionAsync(const QString &type, quint64 forGeneration)
+{
+    OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
+                                                            "/org/deepin/ai/daemon/SessionManager", QDBusConnection::sessionBus());
+    QElapsedTimer sent;
+    sent.start();
+    watchPendingCall(sessionManager.CreateSession(type), q, [this, type, forGeneration, sent](const QDBusPendingCall &call) {
+        QDBusPendingReply<QString> reply = call;
+        DAIMetricsPrivate::record("DSessionPool.createSession." + type, sent.nsecsElapsed() / 1000,
+                                  pendingCallError(reply).getErrorCode());
+        if (reply.isError()) {
+            qCWarning(dtkaiSessionPool) << "Failed to recreate" << type << "session:" << reply.error().message();
+            return;
+        }
+
+        {
+            QMutexLocker lk(&mtx);
+            Bucket &bucket = buckets[type];
+            if (!closed && generation == forGeneration && bucket.idle.size() < maximumSize) {
+                bucket.idle.append(IdleSession{reply.value(), clock.elapsed()});
+                return;
+            }
+        }
+
+        destroySessions({reply.value()});
+    });
+}
+
+DSessionPool::DSessionPool(QObject *parent)
+    : QObject(parent)
+    , d(new DSessionPoolPrivate(this))
+{
+    d->evictTimer = new QTimer(this);
+    connect(d->evictTimer, &QTimer::timeout, this, &DSessionPool::evictIdle);
+
+    const QString service = OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName();
+    d->watcher = new QDBusServiceWatcher(service, QDBusConnection::sessionBus(),
+                                         QDBusServiceWatcher::WatchForRegistration | QDBusServiceWatcher::WatchForUnregistration,
+                                         this);
+    connect(d->watcher, &QDBusServiceWatcher::serviceUnregistered, this, [this]() {
+        d->serviceUnregistered();
+    });
+    connect(d->watcher, &QDBusServiceWatcher::serviceRegistered, this, [this]() {
+        d->serviceRegistered();
+    });
+    if (QDBusConnectionInterface *bus = QDBusConnection::sessionBus().interface())
+        d->daemonAvailable = bus->isServiceRegistered(service);
+
+    // The pool is shared by every thread, keep its timer on the main event loop.
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        if (thread() != app->thread())
+            moveToThread(app->thread());
+        connect(app, &QCoreApplication::aboutToQuit, this, &DSessionPool::clear);
+    }
+
+    d->restartTimer();
+}
+
+DSessionPool::~DSessionPool()
+{
+
+}
+
+DSessionPool *DSessionPool::instance()
+{
+    // Intentionally never deleted, sessions are returned to the daemon on aboutToQuit.
+    static DSessionPool *pool = new DSessionPool;
+    return pool;
+}
+
+void DSessionPool::setMinimumSize(int count)
+{
+    QMutexLocker lk(&d->mtx);
+    d->minimumSize = qMax(0, count);
+}
+
+int DSessionPool::minimumSize() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->minimumSize;
+}
+
+void DSessionPool::setMaximumSize(int count)
+{
+    QMutexLocker lk(&d->mtx);
+    d->maximumSize = qMax(0, count);
+}
+
+int DSessionPool::maximumSize() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->maximumSize;
+}
+
+void DSessionPool::setIdleTimeout(int msec)
+{
+    QMutexLocker lk(&d->mtx);
+    d->idleTimeout = qMax(0, msec);
+    d->restartTimer();
+}
+
+int DSessionPool::idleTimeout() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->idleTimeout;
+}
+
+QString DSessionPool::acquire(const QString &type)
+{
+    {
+        QMutexLocker lk(&d->mtx);
+        DSessionPoolPrivate::Bucket &bucket = d->buckets[type];
+        if (!bucket.idle.isEmpty()) {
+            // Most recently released first, the oldest ones are left for eviction.
+            const QString sessionId = bucket.idle.takeLast().sessionId;
+            bucket.leased.insert(sessionId);
+            ++bucket.stats.hits;
+            return sessionId;
+        }
+        ++bucket.stats.misses;
+    }
+
+    const QString sessionId = DSessionPoolPrivate::createSession(type);
+    if (sessionId.isEmpty())
+        return sessionId;
+
+    QMutexLocker lk(&d->mtx);
+    d->buckets[type].leased.insert(sessionId);
+    return sessionId;
+}
+
+void DSessionPool::release(const QString &type, const QString &sessionId)
+{
+    if (sessionId.isEmpty())
+        return;
+
+    {
+        QMutexLocker lk(&d->mtx);
+        DSessionPoolPrivate::Bucket &bucket = d->buckets[type];
+        // Unknown or from before a daemon restart, nothing to give back.
+        if (!bucket.leased.remove(sessionId))
+            return;
+
+        if (!d->closed && bucket.idle.size() < d->maximumSize) {
+            bucket.idle.append(DSessionPoolPrivate::IdleSession{sessionId, d->clock.elapsed()});
+            return;
+        }
+        ++bucket.stats.evictions;
+    }
+
+    DSessionPoolPrivate::destroySessions({sessionId});
+}
+
+void DSessionPool::discard(const QString &type, const QString &sessionId)
+{
+    if (sessionId.isEmpty())
+        return;
+
+    {
+        QMutexLocker lk(&d->mtx);
+        if (!d->buckets[type].leased.remove(sessionId))
+            return;
+    }
+
+    DSessionPoolPrivate::destroySessions({sessionId});
+}
+
+void DSessionPool::warmUp(const QString &type)
+{
+    int missing = 0;
+    {
+        QMutexLocker lk(&d->mtx);
+        if (d->closed)
+            return;
+        missing = d->minimumSize - d->buckets[type].idle.size();
+    }
+
+    for (; missing > 0; --missing) {
+        const QString sessionId = DSessionPoolPrivate::createSession(type);
+        if (sessionId.isEmpty())
+            break;
+
+        QMutexLocker lk(&d->mtx);
+        d->buckets[type].idle.append(DSessionPoolPrivate::IdleSession{sessionId, d->clock.elapsed()});
+    }
+}
+
+void DSessionPool::evictIdle()
+{
+    QStringList expired;
+    {
+        QMutexLocker lk(&d->mtx);
+        if (d->idleTimeout <= 0)
+            return;
+
+        const qint64 now = d->clock.elapsed();
+        for (auto it = d->buckets.begin(); it != d->buckets.end(); ++it) {
+            DSessionPoolPrivate::Bucket &bucket = it.value();
+            while (bucket.idle.size() > d->minimumSize
+                   && now - bucket.idle.first().idleSince >= d->idleTimeout) {
+                expired.append(bucket.idle.takeFirst().sessionId);
+                ++bucket.stats.evictions;
+            }
+        }
+    }
+
+    if (!expired.isEmpty())
+        qCDebug(dtkaiSessionPool) << "Evicting" << expired.size() << "idle sessions";
+
+    DSessionPoolPrivate::destroySessions(expired);
+}
+
+void DSessionPool::clear()
+{
+    QStringList sessions;
+    {
+        QMutexLocker lk(&d->mtx);
+        // Runs on aboutToQuit, sessions still leased are destroyed as soon as they come back.
+        d->closed = true;
+        for (auto it = d->buckets.begin(); it != d->buckets.end(); ++it) {
+            for (const DSessionPoolPrivate::IdleSession &session : it.value().idle)
+                sessions.append(session.sessionId);
+            it.value().idle.clear();
+        }
+    }
+
+    DSessionPoolPrivate::destroySessions(sessions, true);
+}
+
+DSessionPool::Statistics DSessionPool::statistics(const QString &type) const
+{
+    QMutexLocker lk(&d->mtx);
+    auto it = d->buckets.constFind(type);
+    if (it == d->buckets.constEnd())
+        return Statistics();
+
+    Statistics stats = it.value().stats;
+    stats.idle = it.value().idle.size();
+    stats.leased = it.value().leased.size();
+    return stats;
+}
+
+DSessionPool::Statistics DSessionPool::statistics() const
+{
+    QMutexLocker lk(&d->mtx);
+    Statistics total;
+    for (auto it = d->buckets.constBegin(); it != d->buckets.constEnd(); ++it) {
+        total.hits += it.value().stats.hits;
+        total.misses += it.value().stats.misses;
+        total.evictions += it.value().stats.evictions;
+        total.idle += it.value().idle.size();
+        total.leased += it.value().leased.size();
+    }
+    return total;
+}
+
+quint64 DSessionPool::generation() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->generation;
+}
+
+bool DSessionPool::isDaemonAvailable() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->daemonAvailable;
+}
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DSESSIONPOOL_P_H
+#define DSESSIONPOOL_P_H
+
+#include "dsessionpool.h"
+
+#include <QDBusServiceWatcher>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QTimer>
+
+DAI_BEGIN_NAMESPACE
+
+class DSessionPoolPrivate
+{
+public:
+    struct IdleSession {
+        QString sessionId;
+        qint64 idleSince = 0;
+    };
+
+    struct Bucket {
+        QList<IdleSession> idle;    // oldest first
+        QSet<QString> leased;
+        int warm = 0;               // sessions to recreate once the daemon is back
+        DSessionPool::Statistics stats;
+    };
+
+    explicit DSessionPoolPrivate(DSessionPool *q);
+
+    static QString createSession(const QString &type);
+    static void destroySessions(const QStringList &sessionIds, bool wait = false);
+    void restartTimer();
+    void serviceUnregistered();
+    void serviceRegistered();
+    void createSessionAsync(const QString &type, quint64 forGeneration);
+
+public:
+    mutable QMutex mtx;
+    QHash<QString, Bucket> buckets;
+    QElapsedTimer clock;
+    QTimer *evictTimer = nullptr;
+    QDBusServiceWatcher *watcher = nullptr;
+    quint64 generation = 0;
+    bool daemonAvailable = true;
+    bool closed = false;        // set by clear(), released sessions are destroyed from then on
+    int minimumSize = 0;
+    int maximumSize = 4;
+    int idleTimeout = 60 * 1000;
+
+    DSessionPool *q = nullptr;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DSESSIONPOOL_P_H
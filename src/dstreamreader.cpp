@@ -0,0 +1,298 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "dstreamreader.h"
+#include "dstreamreader_p.h"
+#include "nlp/dchatcompletions.h"
+#include "speech/dtexttospeech.h"
+
+#include <QDeadlineTimer>
+#include <QLoggingCategory>
+#include <QMutexLocker>
+#include <QThread>
+
+Q_LOGGING_CATEGORY(dtkaiStreamReader, "dtkai.streamreader")
+
+DAI_BEGIN_NAMESPACE
+
+DStreamReaderPrivate::DStreamReaderPrivate(DStreamReader *parent)
+    : q(parent)
+{
+}
+
+void DStreamReaderPrivate::append(const QByteArray &data)
+{
+    if (data.isEmpty())
+        return;
+
+    QMutexLocker lk(&mtx);
+    if (closed)
+        return;
+
+    QByteArray chunk = data;
+    if (size + data.size() > capacity) {
+        DStreamReader::OverflowPolicy effective = policy;
+        // Waiting in the thread of the reader would keep the consumer from ever reading,
+        // waiting in the shared I/O thread would stall every other proxy and stream.
+        if (effective == DStreamReader::Block
+                && (QThread::currentThread() == q->thread() || DAITransportPrivate::isIoThread()))
+            effective = DStreamReader::DropOldest;
+
+        if (effective == DStreamReader::Block) {
+            while (size > lowWatermark && !closed)
+                cond.wait(&mtx);
+            if (closed)
+                return;
+        } else if (effective == DStreamReader::DropNewest) {
+            dropped += data.size();
+            return;
+        } else {
+            // A chunk larger than the whole buffer keeps its newest bytes only.
+            if (chunk.size() > capacity) {
+                dropped += chunk.size() - capacity;
+                chunk = chunk.right(int(capacity));
+            }
+            while (!chunks.isEmpty() && size + chunk.size() > capacity) {
+                dropped += chunks.head().size();
+                size -= chunks.dequeue().size();
+            }
+        }
+    }
+
+    chunks.enqueue(chunk);
+    size += chunk.size();
+    cond.wakeAll();
+
+    // One notification on its way is enough, the consumer reads everything there is.
+    if (notifying)
+        return;
+    notifying = true;
+    lk.unlock();
+
+    QMetaObject::invokeMethod(q, [this]() {
+        {
+            QMutexLocker lk(&mtx);
+            notifying = false;
+            if (chunks.isEmpty())
+                return;
+        }
+        emit q->readyRead();
+    }, Qt::QueuedConnection);
+}
+
+void DStreamReaderPrivate::finish(int err)
+{
+    {
+        QMutexLocker lk(&mtx);
+        if (ended)
+            return;
+        ended = true;
+        error = err;
+        cond.wakeAll();
+    }
+
+    QMetaObject::invokeMethod(q, [this, err]() {
+        emit q->finished(err);
+    }, Qt::QueuedConnection);
+}
+
+QByteArray DStreamReaderPrivate::take(qint64 bytes)
+{
+    QByteArray ret;
+    while (!chunks.isEmpty() && (bytes < 0 || ret.size() < bytes)) {
+        QByteArray &head = chunks.head();
+        if (bytes >= 0 && ret.size() + head.size() > bytes) {
+            const int part = int(bytes - ret.size());
+            ret.append(head.left(part));
+            head.remove(0, part);
+            size -= part;
+            break;
+        }
+
+        ret.append(head);
+        size -= head.size();
+        chunks.dequeue();
+    }
+
+    if (size <= lowWatermark)
+        cond.wakeAll();
+    return ret;
+}
+
+int DStreamReaderPrivate::incompleteTail(const QByteArray &data)
+{
+    // Walk back over continuation bytes to the lead byte of the last sequence.
+    for (int i = 1; i <= qMin(3, data.size()); ++i) {
+        const uchar c = uchar(data.at(data.size() - i));
+        if ((c & 0xC0) == 0x80)
+            continue;
+
+        const int length = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+        return length > i ? i : 0;
+    }
+    return 0;
+}
+
+DStreamReader::DStreamReader(QObject *parent)
+    : QObject(parent)
+    , d(new DStreamReaderPrivate(this))
+{
+
+}
+
+DStreamReader::~DStreamReader()
+{
+    // Release a delivering thread waiting for room, then wait for every delivery under
+    // way to leave. Disconnecting alone does not wait for a handler running in another thread.
+    {
+        QMutexLocker lk(&d->mtx);
+        d->closed = true;
+        d->cond.wakeAll();
+    }
+    d->handlers->close();
+
+    for (const QMetaObject::Connection &connection : qAsConst(d->connections))
+        disconnect(connection);
+}
+
+bool DStreamReader::attach(DChatCompletions *chat, quint64 requestId)
+{
+    QMutexLocker lk(&d->mtx);
+    if (d->attached || !chat || requestId == 0)
+        return false;
+    d->attached = true;
+    lk.unlock();
+
+    const QSharedPointer<DAIHandlerGuard> guard = d->handlers;
+    // Direct, the data goes into the buffer in the thread that delivers it.
+    d->connections << connect(chat, &DChatCompletions::requestStreamOutput, this, [this, guard, requestId](quint64 id, const QString &content) {
+        if (id == requestId)
+            guard->run([&]() { d->append(content.toUtf8()); });
+    }, Qt::DirectConnection);
+    d->connections << connect(chat, &DChatCompletions::requestStreamFinished, this, [this, guard, requestId](quint64 id, int err) {
+        if (id == requestId)
+            guard->run([&]() { d->finish(err); });
+    }, Qt::DirectConnection);
+    return true;
+}
+
+bool DStreamReader::attach(DTextToSpeech *tts, quint64 requestId)
+{
+    QMutexLocker lk(&d->mtx);
+    if (d->attached || !tts || requestId == 0)
+        return false;
+    d->attached = true;
+    lk.unlock();
+
+    const QSharedPointer<DAIHandlerGuard> guard = d->handlers;
+    d->connections << connect(tts, &DTextToSpeech::requestSynthesisResult, this, [this, guard, requestId](quint64 id, const QByteArray &audioData) {
+        if (id == requestId)
+            guard->run([&]() { d->append(audioData); });
+    }, Qt::DirectConnection);
+    d->connections << connect(tts, &DTextToSpeech::requestSynthesisCompleted, this, [this, guard, requestId](quint64 id) {
+        if (id == requestId)
+            guard->run([&]() { d->finish(0); });
+    }, Qt::DirectConnection);
+    d->connections << connect(tts, &DTextToSpeech::requestSynthesisError, this, [this, guard, requestId](quint64 id, int errorCode) {
+        if (id == requestId)
+            guard->run([&]() { d->finish(errorCode); });
+    }, Qt::DirectConnection);
+    return true;
+}
+
+void DStreamReader::setCapacity(qint64 bytes)
+{
+    QMutexLocker lk(&d->mtx);
+    d->capacity = qMax<qint64>(1, bytes);
+    d->lowWatermark = qMin(d->lowWatermark, d->capacity);
+    d->cond.wakeAll();
+}
+
+qint64 DStreamReader::capacity() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->capacity;
+}
+
+void DStreamReader::setLowWatermark(qint64 bytes)
+{
+    QMutexLocker lk(&d->mtx);
+    d->lowWatermark = qBound<qint64>(0, bytes, d->capacity);
+    d->cond.wakeAll();
+}
+
+qint64 DStreamReader::lowWatermark() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->lowWatermark;
+}
+
+void DStreamReader::setOverflowPolicy(OverflowPolicy policy)
+{
+    QMutexLocker lk(&d->mtx);
+    d->policy = policy;
+    d->cond.wakeAll();
+}
+
+DStreamReader::OverflowPolicy DStreamReader::overflowPolicy() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->policy;
+}
+
+qint64 DStreamReader::bytesAvailable() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->size;
+}
+
+QByteArray DStreamReader::read(qint64 maxSize)
+{
+    QMutexLocker lk(&d->mtx);
+    return d->take(maxSize);
+}
+
+QString DStreamReader::readText()
+{
+    QMutexLocker lk(&d->mtx);
+    QByteArray data = d->take(-1);
+    const int tail = DStreamReaderPrivate::incompleteTail(data);
+    if (tail > 0 && !d->ended) {
+        d->chunks.prepend(data.right(tail));
+        d->size += tail;
+        data.chop(tail);
+    }
+    return QString::fromUtf8(data);
+}
+
+bool DStreamReader::waitForData(int msecs)
+{
+    const QDeadlineTimer deadline = msecs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(msecs);
+    QMutexLocker lk(&d->mtx);
+    while (d->chunks.isEmpty() && !d->ended) {
+        if (!d->cond.wait(&d->mtx, deadline))
+            break;
+    }
+    return !d->chunks.isEmpty();
+}
+
+bool DStreamReader::atEnd() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->ended && d->chunks.isEmpty();
+}
+
+int DStreamReader::error() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->error;
+}
+
+quint64 DStreamReader::droppedBytes() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->dropped;
+}
+
+DAI_END_NAMESPACE
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DSTREAMREADER_P_H
+#define DSTREAMREADER_P_H
+
+#include "dstreamreader.h"
+#include "daitransport_p.h"
+
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+
+DAI_BEGIN_NAMESPACE
+
+class DStreamReaderPrivate
+{
+public:
+    explicit DStreamReaderPrivate(DStreamReader *q);
+
+    // Called in the delivering thread.
+    void append(const QByteArray &data);
+    void finish(int err);
+    // Removes up to bytes from the front of the buffer, requires mtx.
+    QByteArray take(qint64 bytes);
+    // Length of a UTF-8 sequence cut off at the end of data.
+    static int incompleteTail(const QByteArray &data);
+
+public:
+    mutable QMutex mtx;
+    QWaitCondition cond;
+    QQueue<QByteArray> chunks;
+    qint64 size = 0;
+    qint64 capacity = 1024 * 1024;
+    qint64 lowWatermark = 256 * 1024;
+    DStreamReader::OverflowPolicy policy = DStreamReader::DropOldest;
+    quint64 dropped = 0;
+    bool attached = false;
+    bool ended = false;
+    bool closed = false;
+    bool notifying = false;
+    // The attached handlers run under it, the reader waits for a delivery under way when destroyed.
+    QSharedPointer<DAIHandlerGuard> handlers { new DAIHandlerGuard };
+    QList<QMetaObject::Connection> connections;
+    int error = 0;
+
+    DStreamReader *q = nullptr;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DSTREAMREADER_P_H
@@ -5,10 +5,19 @@
 #include "nlp/dchatcompletions.h"
 #include "nlp/dchatcompletions_p.h"
 #include "aidaemon_sessionmanager.h"
+#include "dsessionpool.h"
+#include "daiasync_p.h"
+#include "dairequestoptions_p.h"
+#include "daischeduler_p.h"
+#include "daimodelrouter_p.h"
+#include "daiencodedparams_p.h"
+#include "daimetrics_p.h"
 #include "daierror.h"
 
 #include <QMutexLocker>
 #include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
 
 DCORE_USE_NAMESPACE
 DAI_USE_NAMESPACE
@@ -21,39 +30,74 @@ DChatCompletionsPrivate::DChatCompletionsPrivate(DChatCompletions *parent)
     , error(NoError, "")
     , q(parent)
 {
-
+    qRegisterMetaType<DAIStreamStats>();
+    connect(DSessionPool::instance(), &DSessionPool::daemonStopped, this, &DChatCompletionsPrivate::onDaemonStopped);
 }
 
 DChatCompletionsPrivate::~DChatCompletionsPrivate()
 {
+    // Proxy signals on the I/O thread may be in a handler right now.
+    handlers->close();
+
+    // Requests still in flight hold their scheduler slots.
+    for (quint64 id : streams.keys() + calls.keys())
+        DAISchedulerPrivate::finish(id);
+    DAISchedulerPrivate::finish(streamSlot);
+
+    for (StreamRequest *request : qAsConst(streams)) {
+        request->lane.ifs->terminate();
+        if (request->hedge)
+            request->hedge->ifs->terminate();
+        delete request;
+    }
+    streams.clear();
+
+    for (HedgedCall *hedge : qAsConst(hedges)) {
+        hedge->lane.ifs->terminate();
+        delete hedge;
+    }
+    hedges.clear();
+
     if (!chatIfs.isNull() && !sessionId.isEmpty()) {
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", QDBusConnection::sessionBus());
-        if (sessionManager.isValid())
-            sessionManager.DestroySession(sessionId);
+        // Leave the session clean for the next lease.
+        if (!isIdle())
+            chatIfs->terminate();
 
         chatIfs.reset(nullptr);
+        DSessionPool::instance()->release("Chat", sessionId);
     }
 }
 
 bool DChatCompletionsPrivate::ensureServer()
 {
-    if (chatIfs.isNull() || !chatIfs->isValid()) {
-        QDBusConnection con = QDBusConnection::sessionBus();
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", con);
-        if (!sessionManager.isValid())
-            return false;
+    // Fail at once instead of waiting for a D-Bus timeout while the daemon is known to be down.
+    if (!DAICircuitBreaker::instance()->allowRequest())
+        return false;
+
+    // A session from before a daemon restart is gone even if the proxy looks fine.
+    const quint64 generation = DSessionPool::instance()->generation();
+    if (chatIfs.isNull() || !chatIfs->isValid() || sessionGeneration != generation) {
+        if (!sessionId.isEmpty()) {
+            chatIfs.reset(nullptr);
+            DSessionPool::instance()->discard("Chat", sessionId);
+            sessionId.clear();
+        }
 
-        sessionId = sessionManager.CreateSession("Chat");
+        sessionId = DSessionPool::instance()->acquire("Chat");
         if (sessionId.isEmpty())
             return false;
+        sessionGeneration = generation;
 
         QString sessionPath = QString("/org/deepin/ai/daemon/Session/%1").arg(sessionId);
-        chatIfs.reset(new OrgDeepinAiDaemonSessionChatInterface(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(), sessionPath, con));
+        QDBusConnection con = DAITransportPrivate::sessionConnection();
+        chatIfs = DAIProxyDeleter::shared(new OrgDeepinAiDaemonSessionChatInterface(DAITransportPrivate::serviceName(con), sessionPath, con));
+        DAITransportPrivate::adopt(chatIfs.data());
         chatIfs->setTimeout(REQ_TIMEOUT);
-        q->connect(chatIfs.data(), &OrgDeepinAiDaemonSessionChatInterface::StreamOutput, q, &DChatCompletions::streamOutput);
-        q->connect(chatIfs.data(), &OrgDeepinAiDaemonSessionChatInterface::StreamFinished, this, &DChatCompletionsPrivate::finished);
+        const Qt::ConnectionType type = DAITransportPrivate::signalConnection(chatIfs.data());
+        connect(chatIfs.data(), &OrgDeepinAiDaemonSessionChatInterface::StreamOutput, this,
+                DAIHandlerGuard::wrap(handlers, this, &DChatCompletionsPrivate::onStreamOutput), type);
+        connect(chatIfs.data(), &OrgDeepinAiDaemonSessionChatInterface::StreamFinished, this,
+                DAIHandlerGuard::wrap(handlers, this, &DChatCompletionsPrivate::finished), type);
     }
 
     return chatIfs->isValid();
@@ -61,38 +105,372 @@ bool DChatCompletionsPrivate::ensureServer()
 
 QString DChatCompletionsPrivate::packageParams(const QList<ChatHistory> &history, const QVariantHash &params)
 {
-    QVariantHash root;
+    // Messages in params replace the history.
+    if (params.contains("messages"))
+        return QString::fromUtf8(DAIParamsCache::encode(params));
 
-    // Add chat history to messages
-    QVariantList msgs;
-    for (const ChatHistory &chat : history) {
-        QVariantHash obj;
-        obj.insert("role", chat.role);
-        obj.insert("content", chat.content);
-        msgs.append(obj);
+    QByteArray json("{\"messages\":[");
+    {
+        QMutexLocker lk(&encodeMtx);
+        int same = 0;
+        const int common = qMin(history.size(), encodedHistory.size());
+        while (same < common && history.at(same).role == encodedHistory.at(same).role
+               && history.at(same).content == encodedHistory.at(same).content)
+            ++same;
+
+        encodedMessages.erase(encodedMessages.begin() + same, encodedMessages.end());
+        for (int i = same; i < history.size(); ++i)
+            encodedMessages.append(encodeMessage(history.at(i)));
+        encodedHistory = history;
+        json += encodedMessages.join(',');
     }
-    root.insert("messages", msgs);
-    
+    json += ']';
+
     // Merge user-provided parameters (including model, temperature, etc.)
-    for (auto it = params.begin(); it != params.end(); ++it) {
-        root.insert(it.key(), it.value());
+    const QByteArray members = DAIParamsCache::members(DAIParamsCache::encode(params));
+    if (!members.isEmpty()) {
+        json += ',';
+        json += members;
     }
+    json += '}';
+    return QString::fromUtf8(json);
+}
 
-    QString ret = QString::fromUtf8(QJsonDocument::fromVariant(root).toJson(QJsonDocument::Compact));
-    return ret;
+QByteArray DChatCompletionsPrivate::encodeMessage(const ChatHistory &chat)
+{
+    QJsonObject obj;
+    obj.insert("role", chat.role);
+    obj.insert("content", chat.content);
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+QString DChatCompletionsPrivate::parseChatResult(const QString &result, DError *error)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(result.toUtf8());
+    auto var = doc.object().toVariantHash();
+    if (var.contains("error")) {
+        *error = DError(var.value("error").toInt(), var.value("errorMessage").toString());
+        return result;
+    }
+
+    *error = DError(NoError, "");
+    return var.value("content").toString();
+}
+
+QString DChatCompletionsPrivate::chatReply(const QDBusPendingCall &reply, DError *error)
+{
+    *error = pendingCallError(reply);
+    if (error->getErrorCode() != NoError)
+        return QString();
+
+    QString result = parseChatResult(QDBusPendingReply<QString>(reply).value(), error);
+    if (error->getErrorCode() != NoError)
+        result.clear();
+    return result;
+}
+
+void DChatCompletionsPrivate::finishCall(quint64 id, const QString &result, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    // Already handled by terminateRequest().
+    if (!calls.contains(id))
+        return;
+
+    DAIReplyCallback<QString> callback = calls.take(id);
+    error.publish(err);
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err.getErrorCode(), DAIMetricsPrivate::utf8Size(result));
+    if (callback)
+        callback(result, err);
+}
+
+void DChatCompletionsPrivate::finishStream(quint64 id, int err, const QString &message)
+{
+    QMutexLocker lk(&mtx);
+    QScopedPointer<StreamRequest> request(streams.take(id));
+    if (!request)
+        return;
+
+    error.publish(DError(err, message));
+    const DAIStreamStats stats = request->timing.stats();
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err);
+    if (err == NoError)
+        request->timing.recordGaps(QStringLiteral("DChatCompletions.startChatStream"));
+    // May be called from a signal of a lane interface, only the proxies outlive this call.
+    request->lane.closeLater();
+    if (request->hedge)
+        request->hedge->closeLater();
+
+    emit q->requestStreamStats(id, stats);
+    emit q->requestStreamFinished(id, err);
+}
+
+void DChatCompletionsPrivate::finishLeg(quint64 id, int leg, const QString &model, qint64 latency,
+                                        const QString &result, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    // Already handled by terminateRequest() or the other leg.
+    if (!calls.contains(id))
+        return;
+
+    DAIModelRouterPrivate::record("Chat", model, latency, err.getErrorCode() == NoError);
+    // The one place a request samples the latency of its primary model, a primary that
+    // answers after the secondary won returned above and was sampled when it lost.
+    if (leg == DAIHedging::Primary && err.getErrorCode() == NoError)
+        DAIHedging::recordLatency("Chat", model, latency);
+
+    HedgedCall *hedge = hedges.value(id);
+    if (hedge && err.getErrorCode() != NoError && !hedge->state.fail(leg))
+        return;
+
+    hedges.remove(id);
+    lk.unlock();
+
+    finishCall(id, result, err);
+    if (!hedge)
+        return;
+
+    if (leg == DAIHedging::Primary) {
+        hedge->lane.ifs->terminate();
+    } else {
+        DAIHedging::recordLatency("Chat", hedge->model, hedge->sent.elapsed());
+        // The primary session is shared, only stop the daemon when nothing else runs on it.
+        lk.relock();
+        if (isIdle() && chatIfs)
+            chatIfs->terminate();
+        lk.unlock();
+    }
+    delete hedge;
+}
+
+void DChatCompletionsPrivate::startHedgedCall(quint64 id, const QString &prompt, const QString &packed,
+                                              const QString &model, const QString &secondaryModel, const QElapsedTimer &sent)
+{
+    {
+        QMutexLocker lk(&mtx);
+        // Answered or aborted before the duplicate was due.
+        if (!calls.contains(id))
+            return;
+    }
+
+    QScopedPointer<HedgedCall> hedge(new HedgedCall);
+    if (!hedge->lane.open(CHAT_TIMEOUT))
+        return;
+
+    hedge->model = model;
+    hedge->sent = sent;
+    OrgDeepinAiDaemonSessionChatInterface *ifs = hedge->lane.ifs.data();
+    {
+        QMutexLocker lk(&mtx);
+        if (!calls.contains(id))
+            return;
+        hedges.insert(id, hedge.take());
+    }
+
+    QElapsedTimer hedgeSent;
+    hedgeSent.start();
+    watchPendingCall(ifs->chat(prompt, packed), this, [this, id, secondaryModel, hedgeSent](const QDBusPendingCall &reply) {
+        DError err;
+        const QString result = chatReply(reply, &err);
+        finishLeg(id, DAIHedging::Secondary, secondaryModel, hedgeSent.elapsed(), result, err);
+    });
+}
+
+void DChatCompletionsPrivate::connectStream(quint64 id, int leg, OrgDeepinAiDaemonSessionChatInterface *ifs)
+{
+    const Qt::ConnectionType type = DAITransportPrivate::signalConnection(ifs);
+    const QSharedPointer<DAIHandlerGuard> guard = handlers;
+    connect(ifs, &OrgDeepinAiDaemonSessionChatInterface::StreamOutput, this, [this, guard, id, leg](const QString &content) {
+        guard->run([&]() {
+            streamLegOutput(id, leg, content);
+        });
+    }, type);
+    connect(ifs, &OrgDeepinAiDaemonSessionChatInterface::StreamFinished, this, [this, guard, id, leg](int err, const QString &content) {
+        guard->run([&]() {
+            streamLegFinished(id, leg, err, err == 0 ? QString() : content);
+        });
+    }, type);
+}
+
+void DChatCompletionsPrivate::streamLegOutput(quint64 id, int leg, const QString &content)
+{
+    QMutexLocker lk(&mtx);
+    StreamRequest *request = streams.value(id);
+    // Output already queued when the request was aborted is dropped, so is the output of the losing leg.
+    if (!request)
+        return;
+
+    if (request->state.winner < 0) {
+        request->state.winner = leg;
+        // Latency of the first token, or the time the primary ran until it lost.
+        DAIHedging::recordLatency("Chat", request->model, request->timing.elapsed());
+        if (leg == DAIHedging::Secondary)
+            request->lane.ifs->terminate();
+        else if (request->hedge)
+            request->hedge->ifs->terminate();
+    } else if (request->state.winner != leg) {
+        return;
+    }
+    request->timing.output();
+    lk.unlock();
+
+    DAIMetricsPrivate::mark(id, "firstToken");
+    DAIMetricsPrivate::addReceived(id, DAIMetricsPrivate::utf8Size(content));
+    emit q->requestStreamOutput(id, content);
+}
+
+void DChatCompletionsPrivate::streamLegFinished(quint64 id, int leg, int err, const QString &message)
+{
+    QMutexLocker lk(&mtx);
+    StreamRequest *request = streams.value(id);
+    if (!request)
+        return;
+
+    if (request->state.winner < 0 && request->hedge) {
+        // The other leg may still answer.
+        if (err != 0 && !request->state.fail(leg))
+            return;
+
+        if (err == 0) {
+            request->state.winner = leg;
+            ChatLane *loser = leg == DAIHedging::Primary ? request->hedge.data() : &request->lane;
+            loser->ifs->terminate();
+        }
+    } else if (request->state.winner >= 0 && request->state.winner != leg) {
+        return;
+    }
+    lk.unlock();
+
+    finishStream(id, err, message);
+}
+
+void DChatCompletionsPrivate::startHedgedStream(quint64 id, const QString &prompt, const QString &packed)
+{
+    {
+        QMutexLocker lk(&mtx);
+        StreamRequest *request = streams.value(id);
+        // Finished, aborted or already streaming before the duplicate was due.
+        if (!request || request->state.winner >= 0)
+            return;
+    }
+
+    QScopedPointer<ChatLane> lane(new ChatLane("Chat"));
+    if (!lane->open(REQ_TIMEOUT))
+        return;
+
+    OrgDeepinAiDaemonSessionChatInterface *ifs = lane->ifs.data();
+    {
+        QMutexLocker lk(&mtx);
+        StreamRequest *request = streams.value(id);
+        if (!request || request->state.winner >= 0)
+            return;
+        request->hedge.reset(lane.take());
+    }
+
+    connectStream(id, DAIHedging::Secondary, ifs);
+    watchPendingCall(ifs->streamChat(prompt, packed), this, [this, id](const QDBusPendingCall &reply) {
+        if (reply.isError())
+            streamLegFinished(id, DAIHedging::Secondary, AIErrorCode::APIServerNotAvailable, reply.error().message());
+    });
+}
+
+void DChatCompletionsPrivate::abortRequest(quint64 id, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    if (StreamRequest *request = streams.value(id)) {
+        request->lane.ifs->terminate();
+        if (request->hedge)
+            request->hedge->ifs->terminate();
+        lk.unlock();
+        finishStream(id, err.getErrorCode(), err.getErrorMessage());
+        return;
+    }
+
+    if (!calls.contains(id))
+        return;
+
+    // The primary session is shared, only stop the daemon when nothing else runs on it.
+    DAIReplyCallback<QString> callback = calls.take(id);
+    HedgedCall *hedge = hedges.take(id);
+    const bool idle = isIdle();
+    const QSharedPointer<OrgDeepinAiDaemonSessionChatInterface> ifs = chatIfs;
+    error.publish(err);
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err.getErrorCode());
+    if (idle && ifs)
+        ifs->terminate();
+    if (hedge) {
+        hedge->lane.ifs->terminate();
+        delete hedge;
+    }
+
+    if (callback)
+        callback(QString(), err);
 }
 
 void DChatCompletionsPrivate::finished(int err, const QString &content)
 {
     QMutexLocker lk(&mtx);
+    const bool streaming = running;
     running = false;
-    error.setErrorCode(err);
-    error.setErrorMessage(err == 0 ? QString() : content);
+    DAISchedulerPrivate::finish(streamSlot);
+    streamSlot = 0;
+    error.publish(DError(err, err == 0 ? QString() : content));
+    const DAIStreamTimer timing = streamTiming;
+    streamTiming = DAIStreamTimer();
     lk.unlock();
 
+    // Only a chatStream() has timing, StreamFinished may arrive without one.
+    if (streaming && timing.isStarted()) {
+        const DAIStreamStats stats = timing.stats();
+        const QString series = QStringLiteral("DChatCompletions.chatStream");
+        DAIMetricsPrivate::record(series, stats.duration, err);
+        if (stats.timeToFirstToken >= 0)
+            DAIMetricsPrivate::record(series + QLatin1String(".firstToken"), stats.timeToFirstToken);
+        if (err == NoError)
+            timing.recordGaps(series);
+        emit q->streamStats(stats);
+    }
+
     emit q->streamFinished(err);
 }
 
+void DChatCompletionsPrivate::onStreamOutput(const QString &content)
+{
+    {
+        QMutexLocker lk(&mtx);
+        if (running)
+            streamTiming.output();
+    }
+
+    emit q->streamOutput(content);
+}
+
+void DChatCompletionsPrivate::onDaemonStopped()
+{
+    QMutexLocker lk(&mtx);
+    const bool streaming = running;
+    const QList<quint64> ids = streams.keys();
+    lk.unlock();
+
+    // No StreamFinished will ever arrive for these.
+    const QString message("AI daemon stopped");
+    if (streaming)
+        finished(AIErrorCode::APIServerNotAvailable, message);
+    for (quint64 id : ids)
+        finishStream(id, AIErrorCode::APIServerNotAvailable, message);
+}
+
 DChatCompletions::DChatCompletions(QObject *parent)
     : QObject(parent)
     , d(new DChatCompletionsPrivate(this))
@@ -107,26 +485,118 @@ DChatCompletions::~DChatCompletions()
 
 bool DChatCompletions::chatStream(const QString &prompt, const QList<ChatHistory> &history, const QVariantHash &params)
 {
+    const QString packed = d->packageParams(history, params);
+    {
+        QMutexLocker lk(&d->mtx);
+        if (d->running)
+            return false;
+    }
+
+    // Admitted like every other request, the slot is held until the stream finishes.
+    DError refused;
+    const quint64 slot = DAISchedulerPrivate::acquire("Chat", DAIRequestOptions(), &refused);
     QMutexLocker lk(&d->mtx);
-    if (d->running)
+    if (!slot) {
+        d->error = refused;
+        return false;
+    }
+
+    if (d->running) {
+        DAISchedulerPrivate::finish(slot);
         return false;
+    }
 
     if (!d->ensureServer()) {
+        DAISchedulerPrivate::finish(slot);
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return false;
     }
 
     d->running = true;
-    lk.unlock();
-
-    d->chatIfs->streamChat(prompt, d->packageParams(history, params));
+    d->streamSlot = slot;
+    d->streamTiming = DAIStreamTimer();
+    d->streamTiming.start();
+    d->chatIfs->streamChat(prompt, packed);
     return true;
 }
 
-QString DChatCompletions::chat(const QString &prompt, const QList<ChatHistory> &history, const QVariantHash &params)
+quint64 DChatCompletions::startChatStream(const QString &prompt, const QList<ChatHistory> &history, const QVariantHash &params,
+                                          const DAIRequestOptions &options)
+{
+    const DError expired = requestOptionsError(options);
+    if (expired.getErrorCode() != NoError) {
+        QMutexLocker lk(&d->mtx);
+        d->error = expired;
+        return 0;
+    }
+
+    QScopedPointer<DChatCompletionsPrivate::StreamRequest> request(new DChatCompletionsPrivate::StreamRequest);
+    if (!request->lane.open(requestTimeout(options, REQ_TIMEOUT))) {
+        QMutexLocker lk(&d->mtx);
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
+        return 0;
+    }
+
+    const quint64 id = nextRequestId();
+    OrgDeepinAiDaemonSessionChatInterface *ifs = request->lane.ifs.data();
+    request->model = DAIHedging::model(params);
+    d->connectStream(id, DAIHedging::Primary, ifs);
+
+    DAIHedgingPolicy policy;
+    {
+        QMutexLocker lk(&d->mtx);
+        d->streams.insert(id, request.take());
+        policy = d->hedging;
+    }
+
+    const QString packed = d->packageParams(history, params);
+    const QString hedgePacked = DAIHedging::isEnabled(policy, params)
+            ? d->packageParams(history, DAIHedging::secondaryParams(policy, params)) : QString();
+    DAIMetricsPrivate::begin(id, "DChatCompletions.startChatStream", DAIMetricsPrivate::utf8Size(prompt) + DAIMetricsPrivate::utf8Size(packed));
+    d->watches.watch(id, options, d.data(), [this, id](const DError &err) {
+        d->abortRequest(id, err);
+    });
+    DAISchedulerPrivate::submit(id, "Chat", options, d.data(), [this, id, ifs, prompt, packed, hedgePacked, policy]() {
+        QString model;
+        {
+            QMutexLocker lk(&d->mtx);
+            DChatCompletionsPrivate::StreamRequest *request = d->streams.value(id);
+            // Aborted while it was queued, the lane may be gone.
+            if (!request)
+                return;
+
+            request->timing.start();
+            model = request->model;
+        }
+
+        watchPendingCall(ifs->streamChat(prompt, packed), d.data(), [this, id](const QDBusPendingCall &reply) {
+            if (reply.isError())
+                d->streamLegFinished(id, DAIHedging::Primary, AIErrorCode::APIServerNotAvailable, reply.error().message());
+        });
+
+        const int delay = hedgePacked.isEmpty() ? -1 : DAIHedging::delay("Chat", model, policy);
+        if (delay >= 0) {
+            QTimer::singleShot(delay, d.data(), [this, id, prompt, hedgePacked]() {
+                d->startHedgedStream(id, prompt, hedgePacked);
+            });
+        }
+    });
+    return id;
+}
+
+QString DChatCompletions::chat(const QString &prompt, const QList<ChatHistory> &history, const QVariantHash &params,
+                              const DAIRequestOptions &options)
 {
+    DAICallMetric metric("DChatCompletions.chat", &d->error);
+    const QString packed = d->packageParams(history, params);
+    metric.addSent(prompt);
+    metric.addSent(packed);
+
+    // Waits for admission first, a deadline that expired in the queue is reported below.
+    DAISchedulerSlot slot("Chat", options);
     QMutexLocker lk(&d->mtx);
-    if (d->running)
+    d->error = slot.error();
+    if (d->error.getErrorCode() != NoError)
         return "";
 
     if (!d->ensureServer()) {
@@ -134,37 +604,140 @@ QString DChatCompletions::chat(const QString &prompt, const QList<ChatHistory> &
         return "";
     }
 
-    d->running = true;
+    // Concurrent calls are told apart by their reply serial, only the issue is serialized.
+    d->chatIfs->setTimeout(requestTimeout(options, CHAT_TIMEOUT));
+    QElapsedTimer sent;
+    sent.start();
+    QDBusPendingReply<QString> reply = d->chatIfs->chat(prompt, packed);
+    d->chatIfs->setTimeout(REQ_TIMEOUT);
+    ++d->blocking;
     lk.unlock();
 
-    d->chatIfs->setTimeout(CHAT_TIMEOUT);
-    QString ret = d->chatIfs->chat(prompt, d->packageParams(history, params));
-    d->chatIfs->setTimeout(REQ_TIMEOUT);
-    {
-        QJsonDocument doc = QJsonDocument::fromJson(ret.toUtf8());
-        auto var = doc.object().toVariantHash();
-        if (var.contains("error")) {
-            d->error = DError(var.value("error").toInt(), var.value("errorMessage").toString());
-        } else {
-            ret = var.value("content").toString();
-            d->error = DError(NoError, "");
-        }
+    reply.waitForFinished();
+    lk.relock();
+    --d->blocking;
+    if (reply.isError() && options.deadline.hasExpired()) {
+        // The caller gave up, which says nothing about the daemon. Other calls on the
+        // session must not be stopped with it.
+        d->error = deadlineExceededError();
+        if (d->isIdle() && d->chatIfs)
+            d->chatIfs->terminate();
+        return "";
+    }
+    lk.unlock();
+
+    recordCallResult(reply);
+    DError err(NoError, "");
+    QString ret;
+    if (reply.isError()) {
+        err = pendingCallError(reply);
+    } else {
+        metric.addReceived(reply.value());
+        ret = DChatCompletionsPrivate::parseChatResult(reply.value(), &err);
     }
+    DAIModelRouterPrivate::record("Chat", DAIHedging::model(params), sent.elapsed(),
+                                  !reply.isError() && err.getErrorCode() == NoError);
 
     lk.relock();
-    d->running = false;
+    d->error = err;
     return ret;
 }
 
+quint64 DChatCompletions::chatAsync(const QString &prompt, const DAIReplyCallback<QString> &callback,
+                                    const QList<ChatHistory> &history, const QVariantHash &params,
+                                    const DAIRequestOptions &options)
+{
+    QMutexLocker lk(&d->mtx);
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return 0;
+
+    if (!d->ensureServer()) {
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
+        return 0;
+    }
+
+    const quint64 id = nextRequestId();
+    d->calls.insert(id, callback);
+    const DAIHedgingPolicy policy = d->hedging;
+    lk.unlock();
+
+    const QString packed = d->packageParams(history, params);
+    const QString model = DAIHedging::model(params);
+    const QString hedgePacked = DAIHedging::isEnabled(policy, params)
+            ? d->packageParams(history, DAIHedging::secondaryParams(policy, params)) : QString();
+    DAIMetricsPrivate::begin(id, "DChatCompletions.chatAsync", DAIMetricsPrivate::utf8Size(prompt) + DAIMetricsPrivate::utf8Size(packed));
+
+    // The deadline is enforced by the watch, a late reply is dropped by finishCall().
+    d->watches.watch(id, options, d.data(), [this, id](const DError &err) {
+        d->abortRequest(id, err);
+    });
+    DAISchedulerPrivate::submit(id, "Chat", options, d.data(), [this, id, prompt, packed, model, hedgePacked, policy]() {
+        QMutexLocker lk(&d->mtx);
+        // Aborted while it was queued.
+        if (!d->calls.contains(id))
+            return;
+
+        if (!d->ensureServer()) {
+            lk.unlock();
+            d->finishCall(id, QString(), DError(AIErrorCode::APIServerNotAvailable, ""));
+            return;
+        }
+
+        d->chatIfs->setTimeout(CHAT_TIMEOUT);
+        QDBusPendingCall call = d->chatIfs->chat(prompt, packed);
+        d->chatIfs->setTimeout(REQ_TIMEOUT);
+        lk.unlock();
+
+        QElapsedTimer sent;
+        sent.start();
+        watchPendingCall(call, d.data(), [this, id, model, sent](const QDBusPendingCall &reply) {
+            DError err;
+            const QString result = DChatCompletionsPrivate::chatReply(reply, &err);
+            d->finishLeg(id, DAIHedging::Primary, model, sent.elapsed(), result, err);
+        });
+
+        const int delay = hedgePacked.isEmpty() ? -1 : DAIHedging::delay("Chat", model, policy);
+        if (delay >= 0) {
+            QTimer::singleShot(delay, d.data(), [this, id, prompt, hedgePacked, model, policy, sent]() {
+                d->startHedgedCall(id, prompt, hedgePacked, model, policy.secondaryModel, sent);
+            });
+        }
+    });
+    return id;
+}
+
+void DChatCompletions::setHedgingPolicy(const DAIHedgingPolicy &policy)
+{
+    QMutexLocker lk(&d->mtx);
+    d->hedging = policy;
+}
+
+DAIHedgingPolicy DChatCompletions::hedgingPolicy() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->hedging;
+}
+
 void DChatCompletions::terminate()
 {
+    QMutexLocker lk(&d->mtx);
     if (d->chatIfs)
         d->chatIfs->terminate();
+
+    const QList<quint64> ids = d->streams.keys();
+    lk.unlock();
+
+    for (quint64 id : ids)
+        terminateRequest(id);
+}
+
+void DChatCompletions::terminateRequest(quint64 requestId)
+{
+    d->abortRequest(requestId, DError(AIErrorCode::RequestCancelled, "Request terminated"));
 }
 
 DError DChatCompletions::lastError() const
 {
     return d->error;
 }
-
-
@@ -7,6 +7,15 @@
 
 #include "nlp/dchatcompletions.h"
 #include "aidaemon_apisession_chat.h"
+#include "daitransport_p.h"
+#include "dsessionlane_p.h"
+#include "dairequestoptions_p.h"
+#include "daithreaderror_p.h"
+#include "daihedging_p.h"
+#include "daimetrics_p.h"
+
+#include <QElapsedTimer>
+#include <QHash>
 
 DAI_BEGIN_NAMESPACE
 
@@ -14,18 +23,80 @@ class DChatCompletionsPrivate : public QObject
 {
     Q_OBJECT
 public:
+    using ChatLane = DSessionLane<OrgDeepinAiDaemonSessionChatInterface>;
+
+    // StreamOutput carries no request id, so every tagged stream owns a leased session.
+    struct StreamRequest
+    {
+        StreamRequest() : lane("Chat") {}
+        ChatLane lane;
+        // Duplicate on the secondary model, the leg with the first output wins.
+        QScopedPointer<ChatLane> hedge;
+        DAIHedgeState state;
+        QString model;
+        DAIStreamTimer timing;
+    };
+
+    // Duplicate of a chatAsync() request on the secondary model.
+    struct HedgedCall
+    {
+        HedgedCall() : lane("Chat") {}
+        ChatLane lane;
+        DAIHedgeState state;
+        QString model;
+        QElapsedTimer sent;
+    };
+
     explicit DChatCompletionsPrivate(DChatCompletions *q);
     ~DChatCompletionsPrivate();
     bool ensureServer();
-    static QString packageParams(const QList<ChatHistory> &history, const QVariantHash &params);
+    QString packageParams(const QList<ChatHistory> &history, const QVariantHash &params);
+    static QByteArray encodeMessage(const ChatHistory &chat);
+    static QString parseChatResult(const QString &result, DTK_CORE_NAMESPACE::DError *error);
+    static QString chatReply(const QDBusPendingCall &reply, DTK_CORE_NAMESPACE::DError *error);
+    void finishCall(quint64 id, const QString &result, const DTK_CORE_NAMESPACE::DError &err);
+    void finishStream(quint64 id, int err, const QString &message);
+    // Reply of one leg of a chatAsync() request, finishes it unless the other leg may still answer.
+    void finishLeg(quint64 id, int leg, const QString &model, qint64 latency,
+                   const QString &result, const DTK_CORE_NAMESPACE::DError &err);
+    void startHedgedCall(quint64 id, const QString &prompt, const QString &packed,
+                         const QString &model, const QString &secondaryModel, const QElapsedTimer &sent);
+    void connectStream(quint64 id, int leg, OrgDeepinAiDaemonSessionChatInterface *ifs);
+    void streamLegOutput(quint64 id, int leg, const QString &content);
+    void streamLegFinished(quint64 id, int leg, int err, const QString &message);
+    void startHedgedStream(quint64 id, const QString &prompt, const QString &packed);
+    // Stops a request in the daemon and finishes it with err.
+    void abortRequest(quint64 id, const DTK_CORE_NAMESPACE::DError &err);
+    // Nothing else runs on chatIfs, terminating it cancels nobody, requires mtx.
+    bool isIdle() const { return calls.isEmpty() && !running && blocking == 0; }
 public Q_SLOTS:
     void finished(int error, const QString &content);
+    void onStreamOutput(const QString &content);
+    void onDaemonStopped();
 public:
-    QMutex mtx;
+    mutable QMutex mtx;
+    QSharedPointer<DAIHandlerGuard> handlers { new DAIHandlerGuard };
     bool running = false;
-    DTK_CORE_NAMESPACE::DError error;
-    QScopedPointer<OrgDeepinAiDaemonSessionChatInterface> chatIfs;
+    // Scheduler slot of the chatStream() running on chatIfs.
+    quint64 streamSlot = 0;
+    // Blocking chat() calls waiting for their reply on chatIfs.
+    int blocking = 0;
+    DAIThreadError error;
+    QSharedPointer<OrgDeepinAiDaemonSessionChatInterface> chatIfs;
     QString sessionId;
+    quint64 sessionGeneration = 0;
+    QHash<quint64, DAIReplyCallback<QString>> calls;
+    QHash<quint64, StreamRequest *> streams;
+    QHash<quint64, HedgedCall *> hedges;
+    DAIHedgingPolicy hedging;
+    DAIRequestWatches watches;
+    // Timing of the chatStream() running on chatIfs.
+    DAIStreamTimer streamTiming;
+
+    // Messages of the last history sent, conversations mostly grow at the end.
+    QMutex encodeMtx;
+    QList<ChatHistory> encodedHistory;
+    QByteArrayList encodedMessages;
 public:
     DChatCompletions *q = nullptr;
 };
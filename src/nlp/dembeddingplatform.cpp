@@ -5,10 +5,14 @@
 #include "nlp/dembeddingplatform.h"
 #include "dembeddingplatform_p.h"
 #include "daierror.h"
+#include "daicircuitbreaker_p.h"
+#include "daiasync_p.h"
+#include "daischeduler_p.h"
+#include "dairetrypolicy_p.h"
 
 #include <DError>
 
-#include <QDBusInterface>
+#include <QCoreApplication>
 #include <QDBusPendingReply>
 #include <QDBusConnection>
 #include <QJsonObject>
@@ -19,68 +23,67 @@ DAI_BEGIN_NAMESPACE
 
 DEmbeddingPlatformPrivate::DEmbeddingPlatformPrivate(DEmbeddingPlatform *qq)
     : DObjectPrivate(qq)
+    , error(NoError, "")
 {
-    error = DTK_CORE_NAMESPACE::DError(NoError, "");
 }
 
-DEmbeddingPlatform::DEmbeddingPlatform(QObject *parent)
-    : QObject(parent)
-    , DObject(*new DEmbeddingPlatformPrivate(this))
+bool DEmbeddingPlatformPrivate::allowRequest()
 {
+    if (DAICircuitBreaker::instance()->allowRequest())
+        return true;
+
+    error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "AI daemon is not available, circuit breaker is open");
+    return false;
 }
 
-DEmbeddingPlatform::~DEmbeddingPlatform() = default;
+DAISingleFlight *DEmbeddingPlatformPrivate::coalescing()
+{
+    static DAISingleFlight flight;
+    return &flight;
+}
 
-QString DEmbeddingPlatform::embeddingModels()
+OrgDeepinAiDaemonEmbeddingPlatformInterface *DEmbeddingPlatformPrivate::platformInterface(const QDBusConnection &con)
 {
-    D_D(DEmbeddingPlatform);
-    QDBusInterface interface("org.deepin.ai.daemon",
-                             "/org/deepin/ai/daemon/EmbeddingPlatform",
-                             "org.deepin.ai.daemon.EmbeddingPlatform",
-                             QDBusConnection::sessionBus());
-    QDBusPendingReply<QString> reply = interface.asyncCall("embeddingModels");
-    reply.waitForFinished();
-    if (reply.isError()) {
-        qWarning() << "DBus error:" << reply.error().message();
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
-        return QString();
+    // A generated proxy skips the introspection QDBusInterface does on construction,
+    // keep one per connection for the whole process.
+    static QMutex mutex;
+    static QHash<QString, OrgDeepinAiDaemonEmbeddingPlatformInterface *> interfaces;
+
+    QMutexLocker lk(&mutex);
+    OrgDeepinAiDaemonEmbeddingPlatformInterface *ifs = interfaces.value(con.name());
+    if (!ifs) {
+        ifs = new OrgDeepinAiDaemonEmbeddingPlatformInterface("org.deepin.ai.daemon",
+                                                              "/org/deepin/ai/daemon/EmbeddingPlatform", con);
+        if (QCoreApplication *app = QCoreApplication::instance())
+            ifs->moveToThread(app->thread());
+        interfaces.insert(con.name(), ifs);
     }
-    d->error = DTK_CORE_NAMESPACE::DError(NoError, "");
-    return reply.value();
+    return ifs;
 }
 
-QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatform::uploadDocuments(const QString &appId, const QStringList &files, const QString &extensionParams)
+QMutex *DEmbeddingPlatformPrivate::issueLock()
+{
+    static QMutex lock;
+    return &lock;
+}
+
+QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatformPrivate::parseUploadResults(const QString &response, DTK_CORE_NAMESPACE::DError *error)
 {
-    D_D(DEmbeddingPlatform);
-    QDBusInterface interface("org.deepin.ai.daemon",
-                             "/org/deepin/ai/daemon/EmbeddingPlatform",
-                             "org.deepin.ai.daemon.EmbeddingPlatform",
-                             QDBusConnection::sessionBus());
-    QDBusPendingReply<QString> reply = interface.asyncCall("uploadDocuments", appId, files, extensionParams);
-    reply.waitForFinished();
-    if (reply.isError()) {
-        qWarning() << "DBus error:" << reply.error().message();
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
-        return QList<DocumentInfo>();
-    }
-    
-    // Parse JSON response
-    QString response = reply.value();
     QJsonDocument doc = QJsonDocument::fromJson(response.toUtf8());
     if (!doc.isObject()) {
         qWarning() << "Invalid JSON response:" << response;
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Invalid JSON response");
-        return QList<DocumentInfo>();
+        *error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Invalid JSON response");
+        return QList<DEmbeddingPlatform::DocumentInfo>();
     }
     
     QJsonObject obj = doc.object();
-    QList<DocumentInfo> infos;
+    QList<DEmbeddingPlatform::DocumentInfo> infos;
     
     // Check if results field exists and is an array
     if (!obj.contains("results") || !obj["results"].isArray()) {
         qWarning() << "Missing or invalid results field in response:" << response;
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Missing or invalid results field in response");
-        return QList<DocumentInfo>();
+        *error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Missing or invalid results field in response");
+        return QList<DEmbeddingPlatform::DocumentInfo>();
     }
     
     QJsonArray resultsArray = obj["results"].toArray();
@@ -92,7 +95,7 @@ QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatform::uploadDocuments(cons
         }
         
         QJsonObject itemObj = value.toObject();
-        DocumentInfo info;
+        DEmbeddingPlatform::DocumentInfo info;
         
         // Extract fields according to the provided JSON format
         if (itemObj.contains("documentID") && itemObj["documentID"].isString()) {
@@ -109,69 +112,27 @@ QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatform::uploadDocuments(cons
         infos.append(info);
     }
     
-    d->error = DTK_CORE_NAMESPACE::DError(NoError, "");
+    *error = DTK_CORE_NAMESPACE::DError(NoError, "");
     return infos;
 }
 
-bool DEmbeddingPlatform::deleteDocuments(const QString &appId, const QStringList &documentIds)
-{
-    D_D(DEmbeddingPlatform);
-    QDBusInterface interface("org.deepin.ai.daemon",
-                             "/org/deepin/ai/daemon/EmbeddingPlatform",
-                             "org.deepin.ai.daemon.EmbeddingPlatform",
-                             QDBusConnection::sessionBus());
-    QDBusPendingReply<QString> reply = interface.asyncCall("deleteDocuments", appId, documentIds);
-    reply.waitForFinished();
-    if (reply.isError()) {
-        qWarning() << "DBus error:" << reply.error().message();
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
-        return false;
-    }
-
-    QString response = reply.value();
-    QJsonDocument doc = QJsonDocument::fromJson(response.toUtf8());
-    if (!doc.isObject()) {
-        qWarning() << "Invalid JSON response:" << response;
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Invalid JSON response");
-        return false;
-    }
-
-    d->error = DTK_CORE_NAMESPACE::DError(NoError, "");
-    return true;
-}
-
-QList<DEmbeddingPlatform::SearchResult> DEmbeddingPlatform::search(const QString &appId, const QString &query, const QString &extensionParams)
+QList<DEmbeddingPlatform::SearchResult> DEmbeddingPlatformPrivate::parseSearchResults(const QString &response, DTK_CORE_NAMESPACE::DError *error)
 {
-    D_D(DEmbeddingPlatform);
-    QDBusInterface interface("org.deepin.ai.daemon",
-                             "/org/deepin/ai/daemon/EmbeddingPlatform",
-                             "org.deepin.ai.daemon.EmbeddingPlatform",
-                             QDBusConnection::sessionBus());
-    QDBusPendingReply<QString> reply = interface.asyncCall("search", appId, query, extensionParams);
-    reply.waitForFinished();
-    if (reply.isError()) {
-        qWarning() << "DBus error:" << reply.error().message();
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
-        return QList<SearchResult>();
-    }
-    
-    // Parse JSON response
-    QString response = reply.value();
     QJsonDocument doc = QJsonDocument::fromJson(response.toUtf8());
     if (!doc.isObject()) {
         qWarning() << "Invalid JSON response:" << response;
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Invalid JSON response");
-        return QList<SearchResult>();
+        *error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Invalid JSON response");
+        return QList<DEmbeddingPlatform::SearchResult>();
     }
     
     QJsonObject obj = doc.object();
-    QList<SearchResult> results;
+    QList<DEmbeddingPlatform::SearchResult> results;
     
     // Check if results field exists and is an array
     if (!obj.contains("results") || !obj["results"].isArray()) {
         qWarning() << "Missing or invalid results field in response:" << response;
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Missing or invalid results field in response");
-        return QList<SearchResult>();
+        *error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Missing or invalid results field in response");
+        return QList<DEmbeddingPlatform::SearchResult>();
     }
     
     QJsonArray resultsArray = obj["results"].toArray();
@@ -183,7 +144,7 @@ QList<DEmbeddingPlatform::SearchResult> DEmbeddingPlatform::search(const QString
         }
         
         QJsonObject itemObj = value.toObject();
-        SearchResult result;
+        DEmbeddingPlatform::SearchResult result;
         
         // Extract fields
         if (itemObj.contains("id") && itemObj["id"].isString()) {
@@ -227,60 +188,27 @@ QList<DEmbeddingPlatform::SearchResult> DEmbeddingPlatform::search(const QString
         results.append(result);
     }
     
-    d->error = DTK_CORE_NAMESPACE::DError(NoError, "");
+    *error = DTK_CORE_NAMESPACE::DError(NoError, "");
     return results;
 }
 
-bool DEmbeddingPlatform::cancelTask(const QString &taskId)
-{
-    D_D(DEmbeddingPlatform);
-    QDBusInterface interface("org.deepin.ai.daemon",
-                             "/org/deepin/ai/daemon/EmbeddingPlatform",
-                             "org.deepin.ai.daemon.EmbeddingPlatform",
-                             QDBusConnection::sessionBus());
-    QDBusPendingReply<bool> reply = interface.asyncCall("cancelTask", taskId);
-    reply.waitForFinished();
-    if (reply.isError()) {
-        qWarning() << "DBus error:" << reply.error().message();
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
-        return false;
-    }
-    d->error = DTK_CORE_NAMESPACE::DError(NoError, "");
-    return reply.value();
-}
-
-QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatform::documentsInfo(const QString &appId, const QStringList &documentIds)
+QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatformPrivate::parseDocumentsInfo(const QString &response, DTK_CORE_NAMESPACE::DError *error)
 {
-    D_D(DEmbeddingPlatform);
-    QDBusInterface interface("org.deepin.ai.daemon",
-                             "/org/deepin/ai/daemon/EmbeddingPlatform",
-                             "org.deepin.ai.daemon.EmbeddingPlatform",
-                             QDBusConnection::sessionBus());
-    QDBusPendingReply<QString> reply = interface.asyncCall("documentsInfo", appId, documentIds);
-    reply.waitForFinished();
-    if (reply.isError()) {
-        qWarning() << "DBus error:" << reply.error().message();
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
-        return QList<DocumentInfo>();
-    }
-    
-    // Parse JSON response
-    QString response = reply.value();
     QJsonDocument doc = QJsonDocument::fromJson(response.toUtf8());
     if (!doc.isObject()) {
         qWarning() << "Invalid JSON response:" << response;
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Invalid JSON response");
-        return QList<DocumentInfo>();
+        *error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Invalid JSON response");
+        return QList<DEmbeddingPlatform::DocumentInfo>();
     }
     
     QJsonObject obj = doc.object();
-    QList<DocumentInfo> infos;
+    QList<DEmbeddingPlatform::DocumentInfo> infos;
     
     // Check if results field exists and is an array
     if (!obj.contains("results") || !obj["results"].isArray()) {
         qWarning() << "Missing or invalid results field in response:" << response;
-        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Missing or invalid results field in response");
-        return QList<DocumentInfo>();
+        *error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Missing or invalid results field in response");
+        return QList<DEmbeddingPlatform::DocumentInfo>();
     }
     
     QJsonArray resultsArray = obj["results"].toArray();
@@ -292,7 +220,7 @@ QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatform::documentsInfo(const
         }
         
         QJsonObject itemObj = value.toObject();
-        DocumentInfo info;
+        DEmbeddingPlatform::DocumentInfo info;
         
         // Extract fields
         if (itemObj.contains("id") && itemObj["id"].isString()) {
@@ -318,19 +246,300 @@ QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatform::documentsInfo(const
         infos.append(info);
     }
     
+    *error = DTK_CORE_NAMESPACE::DError(NoError, "");
+    return infos;
+}
+
+quint64 DEmbeddingPlatformPrivate::watchReply(const char *series, const std::function<QDBusPendingCall()> &send,
+                                              const Finish &finish, const DAIRequestOptions &options)
+{
+    D_Q(DEmbeddingPlatform);
+    const quint64 id = nextRequestId();
+    {
+        QMutexLocker lk(&mtx);
+        calls.insert(id, finish);
+    }
+    DAIMetricsPrivate::begin(id, QString::fromLatin1(series));
+
+    watches.watch(id, options, q, [this, id](const DTK_CORE_NAMESPACE::DError &err) {
+        abortRequest(id, err);
+    });
+
+    DAISchedulerPrivate::submit(id, "Embedding", options, q, [this, q, id, send]() {
+        {
+            QMutexLocker lk(&mtx);
+            // Aborted while it was queued.
+            if (!calls.contains(id))
+                return;
+        }
+
+        QMutexLocker lk(issueLock());
+        const QDBusPendingCall call = send();
+        lk.unlock();
+
+        watchPendingCall(call, q, [this, id](const QDBusPendingCall &reply) {
+            QMutexLocker lk(&mtx);
+            // Already handled by terminateRequest().
+            if (!calls.contains(id))
+                return;
+
+            Finish finish = calls.take(id);
+            lk.unlock();
+
+            watches.release(id);
+            DAISchedulerPrivate::finish(id);
+            if (reply.isError()) {
+                qWarning() << "DBus error:" << reply.error().message();
+                DAIMetricsPrivate::end(id, pendingCallError(reply).getErrorCode());
+                finish(QString(), pendingCallError(reply));
+            } else {
+                const QString response = QDBusPendingReply<QString>(reply).value();
+                DAIMetricsPrivate::end(id, NoError, DAIMetricsPrivate::utf8Size(response));
+                finish(response, pendingCallError(reply));
+            }
+        });
+    });
+    return id;
+}
+
+void DEmbeddingPlatformPrivate::abortRequest(quint64 id, const DTK_CORE_NAMESPACE::DError &err)
+{
+    QMutexLocker lk(&mtx);
+    if (!calls.contains(id))
+        return;
+
+    Finish finish = calls.take(id);
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err.getErrorCode());
+    finish(QString(), err);
+}
+
+DEmbeddingPlatform::DEmbeddingPlatform(QObject *parent)
+    : QObject(parent)
+    , DObject(*new DEmbeddingPlatformPrivate(this))
+{
+}
+
+DEmbeddingPlatform::~DEmbeddingPlatform() = default;
+
+QString DEmbeddingPlatform::embeddingModels()
+{
+    D_D(DEmbeddingPlatform);
+    if (!d->allowRequest())
+        return QString();
+
+    DAICallMetric metric("DEmbeddingPlatform.embeddingModels", &d->error);
+    QDBusPendingReply<QString> reply = callWithRetry([]() { return DEmbeddingPlatformPrivate::platformInterface()->embeddingModels(); },
+                                                     DAIRequestOptions(), DEmbeddingPlatformPrivate::platformInterface(),
+                                                     DEmbeddingPlatformPrivate::issueLock());
+    metric.addReceived(reply.value());
+    if (reply.isError()) {
+        qWarning() << "DBus error:" << reply.error().message();
+        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
+        return QString();
+    }
+    d->error = DTK_CORE_NAMESPACE::DError(NoError, "");
+    return reply.value();
+}
+
+QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatform::uploadDocuments(const QString &appId, const QStringList &files, const QString &extensionParams,
+                                                                            const DAIRequestOptions &options)
+{
+    D_D(DEmbeddingPlatform);
+    if (!d->allowRequest())
+        return QList<DocumentInfo>();
+
+    DAICallMetric metric("DEmbeddingPlatform.uploadDocuments", &d->error);
+    DAISchedulerSlot slot("Embedding", options);
+    if (slot.error().getErrorCode() != NoError) {
+        d->error = slot.error();
+        return QList<DocumentInfo>();
+    }
+
+    QDBusPendingReply<QString> reply = issueWithDeadline([&]() {
+        return DEmbeddingPlatformPrivate::platformInterface()->uploadDocuments(appId, files, extensionParams);
+    }, options, DEmbeddingPlatformPrivate::platformInterface(), DEmbeddingPlatformPrivate::issueLock());
+    reply.waitForFinished();
+    // The caller gave up, which says nothing about the daemon.
+    if (reply.isError() && options.deadline.hasExpired()) {
+        d->error = deadlineExceededError();
+        return QList<DocumentInfo>();
+    }
+    recordCallResult(reply);
+    metric.addReceived(reply.value());
+    if (reply.isError()) {
+        qWarning() << "DBus error:" << reply.error().message();
+        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
+        return QList<DocumentInfo>();
+    }
+    
+    DTK_CORE_NAMESPACE::DError error(NoError, "");
+    QList<DocumentInfo> infos = DEmbeddingPlatformPrivate::parseUploadResults(reply.value(), &error);
+    d->error = error;
+    return infos;
+}
+
+bool DEmbeddingPlatform::deleteDocuments(const QString &appId, const QStringList &documentIds,
+                                         const DAIRequestOptions &options)
+{
+    D_D(DEmbeddingPlatform);
+    if (!d->allowRequest())
+        return false;
+
+    DAICallMetric metric("DEmbeddingPlatform.deleteDocuments", &d->error);
+    DAISchedulerSlot slot("Embedding", options);
+    if (slot.error().getErrorCode() != NoError) {
+        d->error = slot.error();
+        return false;
+    }
+
+    QDBusPendingReply<QString> reply = issueWithDeadline([&]() {
+        return DEmbeddingPlatformPrivate::platformInterface()->deleteDocuments(appId, documentIds);
+    }, options, DEmbeddingPlatformPrivate::platformInterface(), DEmbeddingPlatformPrivate::issueLock());
+    reply.waitForFinished();
+    // The caller gave up, which says nothing about the daemon.
+    if (reply.isError() && options.deadline.hasExpired()) {
+        d->error = deadlineExceededError();
+        return false;
+    }
+    recordCallResult(reply);
+    metric.addReceived(reply.value());
+    if (reply.isError()) {
+        qWarning() << "DBus error:" << reply.error().message();
+        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
+        return false;
+    }
+
+    QString response = reply.value();
+    QJsonDocument doc = QJsonDocument::fromJson(response.toUtf8());
+    if (!doc.isObject()) {
+        qWarning() << "Invalid JSON response:" << response;
+        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, "Invalid JSON response");
+        return false;
+    }
+
+    d->error = DTK_CORE_NAMESPACE::DError(NoError, "");
+    return true;
+}
+
+QList<DEmbeddingPlatform::SearchResult> DEmbeddingPlatform::search(const QString &appId, const QString &query, const QString &extensionParams,
+                                                                   const DAIRequestOptions &options)
+{
+    D_D(DEmbeddingPlatform);
+    if (!d->allowRequest())
+        return QList<SearchResult>();
+
+    DAICallMetric metric("DEmbeddingPlatform.search", &d->error);
+    using SearchReply = QPair<QList<SearchResult>, DTK_CORE_NAMESPACE::DError>;
+    const QString key = DAISingleFlight::key("search", { appId, query, extensionParams });
+    SearchReply result = DEmbeddingPlatformPrivate::coalescing()->run<SearchReply>(key, [&]() {
+        DAISchedulerSlot slot("Embedding", options);
+        if (slot.error().getErrorCode() != NoError)
+            return SearchReply({}, slot.error());
+
+        QDBusPendingReply<QString> reply = callWithRetry([&]() {
+            return DEmbeddingPlatformPrivate::platformInterface()->search(appId, query, extensionParams);
+        }, options, DEmbeddingPlatformPrivate::platformInterface(), DEmbeddingPlatformPrivate::issueLock());
+        // Reported as such so that coalesced callers with a later deadline run the search themselves.
+        if (reply.isError() && options.deadline.hasExpired())
+            return SearchReply({}, deadlineExceededError());
+
+        metric.addReceived(reply.value());
+        if (reply.isError()) {
+            qWarning() << "DBus error:" << reply.error().message();
+            return SearchReply({}, DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message()));
+        }
+
+        DTK_CORE_NAMESPACE::DError err;
+        QList<SearchResult> results = DEmbeddingPlatformPrivate::parseSearchResults(reply.value(), &err);
+        return SearchReply(results, err);
+    }, [](const SearchReply &shared) {
+        return !isRequestOptionsError(shared.second);
+    });
+
+    d->error = result.second;
+    return result.first;
+}
+
+bool DEmbeddingPlatform::cancelTask(const QString &taskId)
+{
+    D_D(DEmbeddingPlatform);
+    if (!d->allowRequest())
+        return false;
+
+    DAICallMetric metric("DEmbeddingPlatform.cancelTask", &d->error);
+    QMutexLocker lk(DEmbeddingPlatformPrivate::issueLock());
+    QDBusPendingReply<bool> reply = DEmbeddingPlatformPrivate::platformInterface()->cancelTask(taskId);
+    lk.unlock();
+    reply.waitForFinished();
+    recordCallResult(reply);
+    if (reply.isError()) {
+        qWarning() << "DBus error:" << reply.error().message();
+        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
+        return false;
+    }
     d->error = DTK_CORE_NAMESPACE::DError(NoError, "");
+    return reply.value();
+}
+
+QList<DEmbeddingPlatform::DocumentInfo> DEmbeddingPlatform::documentsInfo(const QString &appId, const QStringList &documentIds,
+                                                                          const DAIRequestOptions &options)
+{
+    D_D(DEmbeddingPlatform);
+    if (!d->allowRequest())
+        return QList<DocumentInfo>();
+
+    DAICallMetric metric("DEmbeddingPlatform.documentsInfo", &d->error);
+    DAISchedulerSlot slot("Embedding", options);
+    if (slot.error().getErrorCode() != NoError) {
+        d->error = slot.error();
+        return QList<DocumentInfo>();
+    }
+
+    QDBusPendingReply<QString> reply = callWithRetry([&]() {
+        return DEmbeddingPlatformPrivate::platformInterface()->documentsInfo(appId, documentIds);
+    }, options, DEmbeddingPlatformPrivate::platformInterface(), DEmbeddingPlatformPrivate::issueLock());
+    metric.addReceived(reply.value());
+    if (reply.isError()) {
+        qWarning() << "DBus error:" << reply.error().message();
+        d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
+        return QList<DocumentInfo>();
+    }
+    
+    DTK_CORE_NAMESPACE::DError error(NoError, "");
+    const QList<DocumentInfo> infos = DEmbeddingPlatformPrivate::parseDocumentsInfo(reply.value(), &error);
+    d->error = error;
     return infos;
 }
 
-bool DEmbeddingPlatform::buildIndex(const QString &appId, const QString &docId, const QString &extensionParams)
+bool DEmbeddingPlatform::buildIndex(const QString &appId, const QString &docId, const QString &extensionParams,
+                                    const DAIRequestOptions &options)
 {
     D_D(DEmbeddingPlatform);
-    QDBusInterface interface("org.deepin.ai.daemon",
-                             "/org/deepin/ai/daemon/EmbeddingPlatform",
-                             "org.deepin.ai.daemon.EmbeddingPlatform",
-                             QDBusConnection::sessionBus());
-    QDBusPendingReply<QString> reply = interface.asyncCall("buildIndex", appId, docId, extensionParams);
+    if (!d->allowRequest())
+        return false;
+
+    DAICallMetric metric("DEmbeddingPlatform.buildIndex", &d->error);
+    DAISchedulerSlot slot("Embedding", options);
+    if (slot.error().getErrorCode() != NoError) {
+        d->error = slot.error();
+        return false;
+    }
+
+    QDBusPendingReply<QString> reply = issueWithDeadline([&]() {
+        return DEmbeddingPlatformPrivate::platformInterface()->buildIndex(appId, docId, extensionParams);
+    }, options, DEmbeddingPlatformPrivate::platformInterface(), DEmbeddingPlatformPrivate::issueLock());
     reply.waitForFinished();
+    // The caller gave up, which says nothing about the daemon.
+    if (reply.isError() && options.deadline.hasExpired()) {
+        d->error = deadlineExceededError();
+        return false;
+    }
+    recordCallResult(reply);
+    metric.addReceived(reply.value());
     if (reply.isError()) {
         qWarning() << "DBus error:" << reply.error().message();
         d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
@@ -349,15 +558,31 @@ bool DEmbeddingPlatform::buildIndex(const QString &appId, const QString &docId,
     return true;
 }
 
-bool DEmbeddingPlatform::destroyIndex(const QString &appId, bool allIndex, const QString &extensionParams)
+bool DEmbeddingPlatform::destroyIndex(const QString &appId, bool allIndex, const QString &extensionParams,
+                                      const DAIRequestOptions &options)
 {
     D_D(DEmbeddingPlatform);
-    QDBusInterface interface("org.deepin.ai.daemon",
-                             "/org/deepin/ai/daemon/EmbeddingPlatform",
-                             "org.deepin.ai.daemon.EmbeddingPlatform",
-                             QDBusConnection::sessionBus());
-    QDBusPendingReply<QString> reply = interface.asyncCall("destroyIndex", appId, allIndex, extensionParams);
+    if (!d->allowRequest())
+        return false;
+
+    DAICallMetric metric("DEmbeddingPlatform.destroyIndex", &d->error);
+    DAISchedulerSlot slot("Embedding", options);
+    if (slot.error().getErrorCode() != NoError) {
+        d->error = slot.error();
+        return false;
+    }
+
+    QDBusPendingReply<QString> reply = issueWithDeadline([&]() {
+        return DEmbeddingPlatformPrivate::platformInterface()->destroyIndex(appId, allIndex, extensionParams);
+    }, options, DEmbeddingPlatformPrivate::platformInterface(), DEmbeddingPlatformPrivate::issueLock());
     reply.waitForFinished();
+    // The caller gave up, which says nothing about the daemon.
+    if (reply.isError() && options.deadline.hasExpired()) {
+        d->error = deadlineExceededError();
+        return false;
+    }
+    recordCallResult(reply);
+    metric.addReceived(reply.value());
     if (reply.isError()) {
         qWarning() << "DBus error:" << reply.error().message();
         d->error = DTK_CORE_NAMESPACE::DError(AIErrorCode::APIServerNotAvailable, reply.error().message());
@@ -384,6 +609,71 @@ bool DEmbeddingPlatform::destroyIndex(const QString &appId, bool allIndex, const
     return obj["success"].toBool();
 }
 
+quint64 DEmbeddingPlatform::uploadDocumentsAsync(const QString &appId, const QStringList &files,
+                                                 const DAIReplyCallback<QList<DocumentInfo>> &callback,
+                                                 const QString &extensionParams, const DAIRequestOptions &options)
+{
+    D_D(DEmbeddingPlatform);
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError || !d->allowRequest())
+        return 0;
+
+    return d->watchReply("DEmbeddingPlatform.uploadDocumentsAsync", [appId, files, extensionParams]() {
+        return DEmbeddingPlatformPrivate::platformInterface()->uploadDocuments(appId, files, extensionParams);
+    }, [d, callback](const QString &response, const DTK_CORE_NAMESPACE::DError &err) {
+        QList<DocumentInfo> infos;
+        DTK_CORE_NAMESPACE::DError error = err;
+        if (err.getErrorCode() == NoError)
+            infos = DEmbeddingPlatformPrivate::parseUploadResults(response, &error);
+        d->error.publish(error);
+        if (callback)
+            callback(infos, error);
+    }, options);
+}
+
+quint64 DEmbeddingPlatform::searchAsync(const QString &appId, const QString &query,
+                                        const DAIReplyCallback<QList<SearchResult>> &callback,
+                                        const QString &extensionParams, const DAIRequestOptions &options)
+{
+    D_D(DEmbeddingPlatform);
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError || !d->allowRequest())
+        return 0;
+
+    return d->watchReply("DEmbeddingPlatform.searchAsync", [appId, query, extensionParams]() {
+        return DEmbeddingPlatformPrivate::platformInterface()->search(appId, query, extensionParams);
+    }, [d, callback](const QString &response, const DTK_CORE_NAMESPACE::DError &err) {
+        QList<SearchResult> results;
+        DTK_CORE_NAMESPACE::DError error = err;
+        if (err.getErrorCode() == NoError)
+            results = DEmbeddingPlatformPrivate::parseSearchResults(response, &error);
+        d->error.publish(error);
+        if (callback)
+            callback(results, error);
+    }, options);
+}
+
+void DEmbeddingPlatform::terminateRequest(quint64 requestId)
+{
+    D_D(DEmbeddingPlatform);
+    d->abortRequest(requestId, DTK_CORE_NAMESPACE::DError(AIErrorCode::RequestCancelled, "Request terminated"));
+}
+
+void DEmbeddingPlatform::setRequestCoalescingEnabled(bool enabled)
+{
+    DEmbeddingPlatformPrivate::coalescing()->setEnabled(enabled);
+}
+
+bool DEmbeddingPlatform::isRequestCoalescingEnabled()
+{
+    return DEmbeddingPlatformPrivate::coalescing()->isEnabled();
+}
+
+DAICoalescingStatistics DEmbeddingPlatform::coalescingStatistics()
+{
+    return DEmbeddingPlatformPrivate::coalescing()->statistics();
+}
+
 DTK_CORE_NAMESPACE::DError DEmbeddingPlatform::lastError() const
 {
     D_DC(DEmbeddingPlatform);
@@ -6,8 +6,19 @@
 #define DEMBEDDINGPLATFORM_P_H
 
 #include "nlp/dembeddingplatform.h"
+#include "aidaemon_embeddingplatform.h"
+#include "dairequestoptions_p.h"
+#include "daithreaderror_p.h"
+#include "daisingleflight_p.h"
+#include "daimetrics_p.h"
+
 #include <DObjectPrivate>
 
+#include <QHash>
+#include <QMutex>
+
+#include <functional>
+
 DAI_BEGIN_NAMESPACE
 
 class DEmbeddingPlatformPrivate : public Dtk::Core::DObjectPrivate
@@ -15,11 +26,32 @@ class DEmbeddingPlatformPrivate : public Dtk::Core::DObjectPrivate
     Q_DECLARE_PUBLIC(DEmbeddingPlatform)
 
 public:
+    // Finishes an asynchronous request with the raw reply of the daemon.
+    using Finish = std::function<void(const QString &response, const DTK_CORE_NAMESPACE::DError &error)>;
+
     explicit DEmbeddingPlatformPrivate(DEmbeddingPlatform *qq);
+    // Sets error and returns false while the circuit breaker is open.
+    bool allowRequest();
+    // Identical blocking searches of all platform objects share one call.
+    static DAISingleFlight *coalescing();
+    // Generated proxy shared by every platform object on con, created once.
+    static OrgDeepinAiDaemonEmbeddingPlatformInterface *platformInterface(const QDBusConnection &con = QDBusConnection::sessionBus());
+    // Taken by every issue on the shared proxy, blocking calls cut its timeout to their deadline for their own issue.
+    static QMutex *issueLock();
+    static QList<DEmbeddingPlatform::DocumentInfo> parseUploadResults(const QString &response, DTK_CORE_NAMESPACE::DError *error);
+    static QList<DEmbeddingPlatform::SearchResult> parseSearchResults(const QString &response, DTK_CORE_NAMESPACE::DError *error);
+    static QList<DEmbeddingPlatform::DocumentInfo> parseDocumentsInfo(const QString &response, DTK_CORE_NAMESPACE::DError *error);
+    // Sends the call once DAIScheduler admits the request, the request records into series.
+    quint64 watchReply(const char *series, const std::function<QDBusPendingCall()> &send, const Finish &finish,
+                       const DAIRequestOptions &options);
+    void abortRequest(quint64 id, const DTK_CORE_NAMESPACE::DError &err);
     
-    DTK_CORE_NAMESPACE::DError error;
+    DAIThreadError error;
+    QMutex mtx;
+    QHash<quint64, Finish> calls;
+    DAIRequestWatches watches;
 };
 
 DAI_END_NAMESPACE
 
-#endif // DEMBEDDINGPLATFORM_P_H
\ No newline at end of file
+#endif // DEMBEDDINGPLATFORM_P_H
@@ -5,10 +5,18 @@
 #include "nlp/dfunctioncalling.h"
 #include "nlp/dfunctioncalling_p.h"
 #include "aidaemon_sessionmanager.h"
+#include "dsessionpool.h"
+#include "daiasync_p.h"
+#include "dairequestoptions_p.h"
+#include "daischeduler_p.h"
+#include "daimodelrouter_p.h"
+#include "daiencodedparams_p.h"
+#include "daimetrics_p.h"
 #include "daierror.h"
 
 #include <QMutexLocker>
 #include <QJsonDocument>
+#include <QTimer>
 
 DCORE_USE_NAMESPACE
 DAI_USE_NAMESPACE
@@ -25,31 +33,49 @@ DFunctionCallingPrivate::DFunctionCallingPrivate(DFunctionCalling *parent)
 
 DFunctionCallingPrivate::~DFunctionCallingPrivate()
 {
+    // Requests still in flight hold their scheduler slots.
+    for (quint64 id : calls.keys())
+        DAISchedulerPrivate::finish(id);
+
+    for (HedgedCall *hedge : qAsConst(hedges)) {
+        hedge->lane.ifs->Terminate();
+        delete hedge;
+    }
+    hedges.clear();
+
     if (!funcIfs.isNull() && !sessionId.isEmpty()) {
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", QDBusConnection::sessionBus());
-        if (sessionManager.isValid())
-            sessionManager.DestroySession(sessionId);
+        // Leave the session clean for the next lease.
+        if (!isIdle())
+            funcIfs->Terminate();
 
         funcIfs.reset(nullptr);
+        DSessionPool::instance()->release("FunctionCalling", sessionId);
     }
 }
 
 bool DFunctionCallingPrivate::ensureServer()
 {
-    if (funcIfs.isNull() || !funcIfs->isValid()) {
-        QDBusConnection con = QDBusConnection::sessionBus();
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", con);
-        if (!sessionManager.isValid())
-            return false;
+    if (!DAICircuitBreaker::instance()->allowRequest())
+        return false;
+
+    // A session from before a daemon restart is gone even if the proxy looks fine.
+    const quint64 generation = DSessionPool::instance()->generation();
+    if (funcIfs.isNull() || !funcIfs->isValid() || sessionGeneration != generation) {
+        if (!sessionId.isEmpty()) {
+            funcIfs.reset(nullptr);
+            DSessionPool::instance()->discard("FunctionCalling", sessionId);
+            sessionId.clear();
+        }
 
-        sessionId = sessionManager.CreateSession("FunctionCalling");
+        sessionId = DSessionPool::instance()->acquire("FunctionCalling");
         if (sessionId.isEmpty())
             return false;
+        sessionGeneration = generation;
 
         QString sessionPath = QString("/org/deepin/ai/daemon/Session/%1").arg(sessionId);
-        funcIfs.reset(new OrgDeepinAiDaemonSessionFunctionCallingInterface(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(), sessionPath, con));
+        QDBusConnection con = DAITransportPrivate::sessionConnection();
+        funcIfs = DAIProxyDeleter::shared(new OrgDeepinAiDaemonSessionFunctionCallingInterface(DAITransportPrivate::serviceName(con), sessionPath, con));
+        DAITransportPrivate::adopt(funcIfs.data());
         funcIfs->setTimeout(REQ_TIMEOUT);
     }
 
@@ -61,8 +87,149 @@ QString DFunctionCallingPrivate::packageParams(const QVariantHash &params)
     if (params.isEmpty())
         return "";
 
-    return QString::fromUtf8(QJsonDocument(QJsonObject::fromVariantHash(params))
-                             .toJson(QJsonDocument::Compact));
+    return QString::fromUtf8(DAIParamsCache::encode(params));
+}
+
+QString DFunctionCallingPrivate::parseFunctionResult(const QString &result, DError *error)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(result.toUtf8());
+    auto var = doc.object().toVariantHash();
+    if (var.contains("error")) {
+        *error = DError(var.value("error").toInt(), var.value("errorMessage").toString());
+        return result;
+    }
+
+    auto jObj = QJsonObject::fromVariantHash(var.value("function").value<QVariantHash>());
+    *error = DError(NoError, "");
+    return QString::fromUtf8(QJsonDocument(jObj).toJson(QJsonDocument::Compact));
+}
+
+QString DFunctionCallingPrivate::parseReply(const QDBusPendingCall &reply, DError *error)
+{
+    *error = pendingCallError(reply);
+    if (error->getErrorCode() != NoError)
+        return QString();
+
+    QString result = parseFunctionResult(QDBusPendingReply<QString>(reply).value(), error);
+    if (error->getErrorCode() != NoError)
+        result.clear();
+    return result;
+}
+
+void DFunctionCallingPrivate::finishCall(quint64 id, const QString &result, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    // Already handled by terminateRequest().
+    if (!calls.contains(id))
+        return;
+
+    DAIReplyCallback<QString> callback = calls.take(id);
+    error.publish(err);
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err.getErrorCode(), DAIMetricsPrivate::utf8Size(result));
+    if (callback)
+        callback(result, err);
+}
+
+void DFunctionCallingPrivate::finishLeg(quint64 id, int leg, const QString &model, qint64 latency,
+                                        const QString &result, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    // Already handled by terminateRequest() or the other leg.
+    if (!calls.contains(id))
+        return;
+
+    DAIModelRouterPrivate::record("FunctionCalling", model, latency, err.getErrorCode() == NoError);
+    // Sampled only here: a late primary returned above, the secondary winning samples it below.
+    if (leg == DAIHedging::Primary && err.getErrorCode() == NoError)
+        DAIHedging::recordLatency("FunctionCalling", model, latency);
+
+    HedgedCall *hedge = hedges.value(id);
+    if (hedge && err.getErrorCode() != NoError && !hedge->state.fail(leg))
+        return;
+
+    hedges.remove(id);
+    lk.unlock();
+
+    finishCall(id, result, err);
+    if (!hedge)
+        return;
+
+    if (leg == DAIHedging::Primary) {
+        hedge->lane.ifs->Terminate();
+    } else {
+        DAIHedging::recordLatency("FunctionCalling", hedge->model, hedge->sent.elapsed());
+        // The session is shared, only stop the daemon when nothing else runs on it.
+        lk.relock();
+        if (isIdle() && funcIfs)
+            funcIfs->Terminate();
+        lk.unlock();
+    }
+    delete hedge;
+}
+
+void DFunctionCallingPrivate::startHedgedCall(quint64 id, const QString &prompt, const QString &functions, const QString &packed,
+                                              const QString &model, const QString &secondaryModel, const QElapsedTimer &sent)
+{
+    {
+        QMutexLocker lk(&mtx);
+        // Answered or aborted before the duplicate was due.
+        if (!calls.contains(id))
+            return;
+    }
+
+    QScopedPointer<HedgedCall> hedge(new HedgedCall);
+    if (!hedge->lane.open(CHAT_TIMEOUT))
+        return;
+
+    hedge->model = model;
+    hedge->sent = sent;
+    OrgDeepinAiDaemonSessionFunctionCallingInterface *ifs = hedge->lane.ifs.data();
+    {
+        QMutexLocker lk(&mtx);
+        if (!calls.contains(id))
+            return;
+        hedges.insert(id, hedge.take());
+    }
+
+    QElapsedTimer hedgeSent;
+    hedgeSent.start();
+    watchPendingCall(ifs->Parse(prompt, functions, packed), this, [this, id, secondaryModel, hedgeSent](const QDBusPendingCall &reply) {
+        DError err;
+        const QString result = parseReply(reply, &err);
+        finishLeg(id, DAIHedging::Secondary, secondaryModel, hedgeSent.elapsed(), result, err);
+    });
+}
+
+void DFunctionCallingPrivate::abortRequest(quint64 id, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    if (!calls.contains(id))
+        return;
+
+    // The session is shared, only stop the daemon when nothing else runs on it.
+    DAIReplyCallback<QString> callback = calls.take(id);
+    HedgedCall *hedge = hedges.take(id);
+    const bool idle = isIdle();
+    const QSharedPointer<OrgDeepinAiDaemonSessionFunctionCallingInterface> ifs = funcIfs;
+    error.publish(err);
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err.getErrorCode());
+    if (idle && ifs)
+        ifs->Terminate();
+    if (hedge) {
+        hedge->lane.ifs->Terminate();
+        delete hedge;
+    }
+
+    if (callback)
+        callback(QString(), err);
 }
 
 DFunctionCalling::DFunctionCalling(QObject *parent)
@@ -77,13 +244,22 @@ DFunctionCalling::~DFunctionCalling()
 
 }
 
-QString DFunctionCalling::parse(const QString &prompt, const QString &functions, const QVariantHash &params)
+QString DFunctionCalling::parse(const QString &prompt, const QString &functions, const QVariantHash &params,
+                               const DAIRequestOptions &options)
 {
     if (prompt.isEmpty() || functions.isEmpty())
         return "";
 
+    DAICallMetric metric("DFunctionCalling.parse", &d->error);
+    const QString packed = d->packageParams(params);
+    metric.addSent(prompt);
+    metric.addSent(functions);
+    metric.addSent(packed);
+
+    DAISchedulerSlot slot("FunctionCalling", options);
     QMutexLocker lk(&d->mtx);
-    if (d->running)
+    d->error = slot.error();
+    if (d->error.getErrorCode() != NoError)
         return "";
 
     if (!d->ensureServer()) {
@@ -91,36 +267,138 @@ QString DFunctionCalling::parse(const QString &prompt, const QString &functions,
         return "";
     }
 
-    d->running = true;
+    // Concurrent calls are told apart by their reply serial, only the issue is serialized.
+    d->funcIfs->setTimeout(requestTimeout(options, CHAT_TIMEOUT));
+    QElapsedTimer sent;
+    sent.start();
+    QDBusPendingReply<QString> reply = d->funcIfs->Parse(prompt, functions, packed);
+    d->funcIfs->setTimeout(REQ_TIMEOUT);
+    ++d->blocking;
     lk.unlock();
 
-    d->funcIfs->setTimeout(CHAT_TIMEOUT);
-    QString ret = d->funcIfs->Parse(prompt, functions, d->packageParams(params));
-    d->funcIfs->setTimeout(REQ_TIMEOUT);
-    {
-        QJsonDocument doc = QJsonDocument::fromJson(ret.toUtf8());
-        auto var = doc.object().toVariantHash();
-        if (var.contains("error")) {
-            d->error = DError(var.value("error").toInt(), var.value("errorMessage").toString());
-        } else {
-            auto jObj = QJsonObject::fromVariantHash(var.value("function").value<QVariantHash>());
-            QJsonDocument doc(jObj);
-            ret = QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
-            d->error = DError(NoError, "");
-        }
+    reply.waitForFinished();
+    lk.relock();
+    --d->blocking;
+    if (reply.isError() && options.deadline.hasExpired()) {
+        // The caller gave up, which says nothing about the daemon, nor about the other calls.
+        d->error = deadlineExceededError();
+        if (d->isIdle() && d->funcIfs)
+            d->funcIfs->Terminate();
+        return "";
     }
+    lk.unlock();
+
+    recordCallResult(reply);
+    DError err(NoError, "");
+    QString ret;
+    if (reply.isError()) {
+        err = pendingCallError(reply);
+    } else {
+        metric.addReceived(reply.value());
+        ret = DFunctionCallingPrivate::parseFunctionResult(reply.value(), &err);
+    }
+    DAIModelRouterPrivate::record("FunctionCalling", DAIHedging::model(params), sent.elapsed(),
+                                  !reply.isError() && err.getErrorCode() == NoError);
 
     lk.relock();
-    d->running = false;
+    d->error = err;
     return ret;
 }
 
+quint64 DFunctionCalling::parseAsync(const QString &prompt, const QString &functions, const DAIReplyCallback<QString> &callback,
+                                     const QVariantHash &params, const DAIRequestOptions &options)
+{
+    QMutexLocker lk(&d->mtx);
+    if (prompt.isEmpty() || functions.isEmpty()) {
+        d->error = DError(AIErrorCode::InvalidParameter, "Empty prompt or functions");
+        return 0;
+    }
+
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return 0;
+
+    if (!d->ensureServer()) {
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
+        return 0;
+    }
+
+    const quint64 id = nextRequestId();
+    d->calls.insert(id, callback);
+    const DAIHedgingPolicy policy = d->hedging;
+    lk.unlock();
+
+    const QString packed = d->packageParams(params);
+    const QString model = DAIHedging::model(params);
+    const QString hedgePacked = DAIHedging::isEnabled(policy, params)
+            ? d->packageParams(DAIHedging::secondaryParams(policy, params)) : QString();
+    DAIMetricsPrivate::begin(id, "DFunctionCalling.parseAsync", DAIMetricsPrivate::utf8Size(prompt)
+                             + DAIMetricsPrivate::utf8Size(functions) + DAIMetricsPrivate::utf8Size(packed));
+
+    // The deadline is enforced by the watch, a late reply is dropped by finishCall().
+    d->watches.watch(id, options, d.data(), [this, id](const DError &err) {
+        d->abortRequest(id, err);
+    });
+    DAISchedulerPrivate::submit(id, "FunctionCalling", options, d.data(),
+                                [this, id, prompt, functions, packed, model, hedgePacked, policy]() {
+        QMutexLocker lk(&d->mtx);
+        // Aborted while it was queued.
+        if (!d->calls.contains(id))
+            return;
+
+        if (!d->ensureServer()) {
+            lk.unlock();
+            d->finishCall(id, QString(), DError(AIErrorCode::APIServerNotAvailable, ""));
+            return;
+        }
+
+        d->funcIfs->setTimeout(CHAT_TIMEOUT);
+        QDBusPendingCall call = d->funcIfs->Parse(prompt, functions, packed);
+        d->funcIfs->setTimeout(REQ_TIMEOUT);
+        lk.unlock();
+
+        QElapsedTimer sent;
+        sent.start();
+        watchPendingCall(call, d.data(), [this, id, model, sent](const QDBusPendingCall &reply) {
+            DError err;
+            const QString result = DFunctionCallingPrivate::parseReply(reply, &err);
+            d->finishLeg(id, DAIHedging::Primary, model, sent.elapsed(), result, err);
+        });
+
+        const int delay = hedgePacked.isEmpty() ? -1 : DAIHedging::delay("FunctionCalling", model, policy);
+        if (delay >= 0) {
+            QTimer::singleShot(delay, d.data(), [this, id, prompt, functions, hedgePacked, model, policy, sent]() {
+                d->startHedgedCall(id, prompt, functions, hedgePacked, model, policy.secondaryModel, sent);
+            });
+        }
+    });
+    return id;
+}
+
+void DFunctionCalling::setHedgingPolicy(const DAIHedgingPolicy &policy)
+{
+    QMutexLocker lk(&d->mtx);
+    d->hedging = policy;
+}
+
+DAIHedgingPolicy DFunctionCalling::hedgingPolicy() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->hedging;
+}
+
 void DFunctionCalling::terminate()
 {
+    QMutexLocker lk(&d->mtx);
     if (d->funcIfs)
         d->funcIfs->Terminate();
 }
 
+void DFunctionCalling::terminateRequest(quint64 requestId)
+{
+    d->abortRequest(requestId, DError(AIErrorCode::RequestCancelled, "Request terminated"));
+}
+
 DError DFunctionCalling::lastError() const
 {
     return d->error;
@@ -7,6 +7,14 @@
 
 #include "nlp/dfunctioncalling.h"
 #include "aidaemon_apisession_functioncalling.h"
+#include "daitransport_p.h"
+#include "dsessionlane_p.h"
+#include "dairequestoptions_p.h"
+#include "daithreaderror_p.h"
+#include "daihedging_p.h"
+
+#include <QElapsedTimer>
+#include <QHash>
 
 DAI_BEGIN_NAMESPACE
 
@@ -14,16 +22,44 @@ class DFunctionCallingPrivate : public QObject
 {
     Q_OBJECT
 public:
+    // Duplicate of a parseAsync() request on the secondary model.
+    struct HedgedCall
+    {
+        HedgedCall() : lane("FunctionCalling") {}
+        DSessionLane<OrgDeepinAiDaemonSessionFunctionCallingInterface> lane;
+        DAIHedgeState state;
+        QString model;
+        QElapsedTimer sent;
+    };
+
     explicit DFunctionCallingPrivate(DFunctionCalling *q);
     ~DFunctionCallingPrivate();
     bool ensureServer();
     static QString packageParams(const QVariantHash &params);
+    static QString parseFunctionResult(const QString &result, DTK_CORE_NAMESPACE::DError *error);
+    static QString parseReply(const QDBusPendingCall &reply, DTK_CORE_NAMESPACE::DError *error);
+    void finishCall(quint64 id, const QString &result, const DTK_CORE_NAMESPACE::DError &err);
+    // Reply of one leg of a parseAsync() request, finishes it unless the other leg may still answer.
+    void finishLeg(quint64 id, int leg, const QString &model, qint64 latency,
+                   const QString &result, const DTK_CORE_NAMESPACE::DError &err);
+    void startHedgedCall(quint64 id, const QString &prompt, const QString &functions, const QString &packed,
+                         const QString &model, const QString &secondaryModel, const QElapsedTimer &sent);
+    // Stops a request in the daemon and finishes it with err.
+    void abortRequest(quint64 id, const DTK_CORE_NAMESPACE::DError &err);
+    // Nothing else runs on funcIfs, terminating it cancels nobody, requires mtx.
+    bool isIdle() const { return calls.isEmpty() && blocking == 0; }
 public:
     QMutex mtx;
-    bool running = false;
-    DTK_CORE_NAMESPACE::DError error;
-    QScopedPointer<OrgDeepinAiDaemonSessionFunctionCallingInterface> funcIfs;
+    // Blocking parse() calls waiting for their reply on funcIfs.
+    int blocking = 0;
+    DAIThreadError error;
+    QSharedPointer<OrgDeepinAiDaemonSessionFunctionCallingInterface> funcIfs;
     QString sessionId;
+    quint64 sessionGeneration = 0;
+    QHash<quint64, DAIReplyCallback<QString>> calls;
+    QHash<quint64, HedgedCall *> hedges;
+    DAIHedgingPolicy hedging;
+    DAIRequestWatches watches;
 public:
     DFunctionCalling *q = nullptr;
 };
@@ -0,0 +1,193 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "daudioring_p.h"
+
+#include <QLoggingCategory>
+
+#include <new>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(dtkaiAudioRing, "dtkai.audioring")
+
+DAI_BEGIN_NAMESPACE
+
+static_assert(std::atomic<quint64>::is_always_lock_free, "ring counters must be lock-free to be shared across processes");
+
+static constexpr size_t kDataOffset = 192;
+static_assert(sizeof(DAudioRing::Header) <= kDataOffset, "ring header overlaps the data area");
+
+DAudioRing::~DAudioRing()
+{
+    unmap();
+}
+
+bool DAudioRing::create(quint32 capacity)
+{
+    unmap();
+    if (capacity == 0)
+        return false;
+
+    int memFd = memfd_create("dtkai-audio-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memFd < 0) {
+        qCWarning(dtkaiAudioRing) << "memfd_create failed:" << strerror(errno);
+        return false;
+    }
+
+    const size_t size = kDataOffset + capacity;
+    void *addr = MAP_FAILED;
+    if (ftruncate(memFd, static_cast<off_t>(size)) == 0
+            && fcntl(memFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == 0)
+        addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+
+    int bellFd = addr != MAP_FAILED ? eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) : -1;
+    if (bellFd < 0) {
+        qCWarning(dtkaiAudioRing) << "Failed to set up audio ring:" << strerror(errno);
+        if (addr != MAP_FAILED)
+            munmap(addr, size);
+        ::close(memFd);
+        return false;
+    }
+
+    mappedSize = size;
+    header = new (addr) Header;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->capacity = capacity;
+    header->closed.store(0, std::memory_order_release);
+    data = static_cast<char *>(addr) + kDataOffset;
+
+    memory.giveFileDescriptor(memFd);
+    doorbell.giveFileDescriptor(bellFd);
+    return true;
+}
+
+bool DAudioRing::attach(const QDBusUnixFileDescriptor &memoryFd, const QDBusUnixFileDescriptor &doorbellFd)
+{
+    unmap();
+    if (!memoryFd.isValid() || !doorbellFd.isValid())
+        return false;
+
+    struct stat st;
+    if (fstat(memoryFd.fileDescriptor(), &st) != 0 || static_cast<size_t>(st.st_size) <= kDataOffset)
+        return false;
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd.fileDescriptor(), 0);
+    if (addr == MAP_FAILED)
+        return false;
+
+    Header *mapped = static_cast<Header *>(addr);
+    if (kDataOffset + mapped->capacity != size) {
+        qCWarning(dtkaiAudioRing) << "Audio ring size does not match its header";
+        munmap(addr, size);
+        return false;
+    }
+
+    header = mapped;
+    data = static_cast<char *>(addr) + kDataOffset;
+    mappedSize = size;
+    memory = memoryFd;
+    doorbell = doorbellFd;
+    return true;
+}
+
+bool DAudioRing::write(const QByteArray &bytes)
+{
+    if (!header || header->closed.load(std::memory_order_relaxed))
+        return false;
+
+    const quint64 head = header->head.load(std::memory_order_relaxed);
+    const quint64 tail = header->tail.load(std::memory_order_acquire);
+    const quint64 cap = header->capacity;
+    if (static_cast<quint64>(bytes.size()) > cap - (head - tail))
+        return false;
+
+    const quint64 offset = head % cap;
+    const quint64 first = qMin<quint64>(bytes.size(), cap - offset);
+    memcpy(data + offset, bytes.constData(), first);
+    memcpy(data, bytes.constData() + first, bytes.size() - first);
+
+    header->head.store(head + bytes.size(), std::memory_order_release);
+    ring();
+    return true;
+}
+
+QByteArray DAudioRing::read(qint64 maxSize)
+{
+    if (!header || maxSize <= 0)
+        return QByteArray();
+
+    const quint64 tail = header->tail.load(std::memory_order_relaxed);
+    const quint64 head = header->head.load(std::memory_order_acquire);
+    const quint64 cap = header->capacity;
+    const quint64 size = qMin<quint64>(head - tail, maxSize);
+    if (size == 0)
+        return QByteArray();
+
+    QByteArray bytes(static_cast<int>(size), Qt::Uninitialized);
+    const quint64 offset = tail % cap;
+    const quint64 first = qMin(size, cap - offset);
+    memcpy(bytes.data(), data + offset, first);
+    memcpy(bytes.data() + first, data, size - first);
+
+    header->tail.store(tail + size, std::memory_order_release);
+    return bytes;
+}
+
+void DAudioRing::close()
+{
+    if (!header)
+        return;
+
+    header->closed.store(1, std::memory_order_release);
+    ring();
+}
+
+bool DAudioRing::isClosed() const
+{
+    return header && header->closed.load(std::memory_order_acquire);
+}
+
+quint32 DAudioRing::capacity() const
+{
+    return header ? header->capacity : 0;
+}
+
+quint64 DAudioRing::bytesAvailable() const
+{
+    if (!header)
+        return 0;
+
+    return header->head.load(std::memory_order_acquire) - header->tail.load(std::memory_order_acquire);
+}
+
+void DAudioRing::ring()
+{
+    const quint64 one = 1;
+    // EAGAIN only means the counter is saturated, the consumer is woken up anyway.
+    if (::write(doorbell.fileDescriptor(), &one, sizeof(one)) < 0 && errno != EAGAIN)
+        qCWarning(dtkaiAudioRing) << "Failed to ring audio doorbell:" << strerror(errno);
+}
+
+void DAudioRing::unmap()
+{
+    if (header)
+        munmap(header, mappedSize);
+
+    header = nullptr;
+    data = nullptr;
+    mappedSize = 0;
+    memory = QDBusUnixFileDescriptor();
+    doorbell = QDBusUnixFileDescriptor();
+}
+
+DAI_END_NAMESPACE
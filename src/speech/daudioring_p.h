@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DAUDIORING_P_H
+#define DAUDIORING_P_H
+
+#include "dtkai_global.h"
+
+#include <QByteArray>
+#include <QDBusUnixFileDescriptor>
+
+#include <atomic>
+
+DAI_BEGIN_NAMESPACE
+
+// Lock-free single-producer/single-consumer byte ring in a memfd shared with the daemon.
+// The producer rings an eventfd doorbell after every write, so only control messages
+// and results travel over D-Bus while a stream is running.
+//
+// Memory layout, all integers in host byte order:
+//   offset   0: u64 head      total bytes written, advanced by the producer only
+//   offset  64: u64 tail      total bytes read, advanced by the consumer only
+//   offset 128: u32 capacity  size of the data area
+//   offset 132: u32 closed    set to 1 once the producer has written everything
+//   offset 192: data[capacity]
+class DAudioRing
+{
+public:
+    struct Header
+    {
+        alignas(64) std::atomic<quint64> head;
+        alignas(64) std::atomic<quint64> tail;
+        alignas(64) quint32 capacity;
+        std::atomic<quint32> closed;
+    };
+
+    DAudioRing() = default;
+    ~DAudioRing();
+
+    // Producer side, creates a new ring holding up to capacity bytes.
+    bool create(quint32 capacity);
+    // Consumer side, maps a ring created by another process.
+    bool attach(const QDBusUnixFileDescriptor &memoryFd, const QDBusUnixFileDescriptor &doorbellFd);
+
+    // Writes all of data or nothing, false when there is not enough room.
+    bool write(const QByteArray &bytes);
+    // Reads at most maxSize bytes, never blocks.
+    QByteArray read(qint64 maxSize);
+    // Marks the end of the stream and wakes the consumer.
+    void close();
+
+    bool isValid() const { return header != nullptr; }
+    bool isClosed() const;
+    quint32 capacity() const;
+    quint64 bytesAvailable() const;
+
+    QDBusUnixFileDescriptor memoryDescriptor() const { return memory; }
+    QDBusUnixFileDescriptor doorbellDescriptor() const { return doorbell; }
+
+private:
+    Q_DISABLE_COPY(DAudioRing)
+    void ring();
+    void unmap();
+
+    Header *header = nullptr;
+    char *data = nullptr;
+    size_t mappedSize = 0;
+    QDBusUnixFileDescriptor memory;
+    QDBusUnixFileDescriptor doorbell;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DAUDIORING_P_H
@@ -5,7 +5,16 @@
 #include "speech/dspeechtotext.h"
 #include "speech/dspeechtotext_p.h"
 #include "aidaemon_sessionmanager.h"
+#include "dsessionpool.h"
+#include "daiasync_p.h"
+#include "dairequestoptions_p.h"
+#include "daischeduler_p.h"
+#include "dairetrypolicy_p.h"
+#include "daiencodedparams_p.h"
+#include "daimetrics_p.h"
+#include "daifdpayload_p.h"
 #include "daierror.h"
+#include "daudioring_p.h"
 
 #include <QMutexLocker>
 #include <QJsonDocument>
@@ -16,52 +25,76 @@ DAI_USE_NAMESPACE
 #define RECOGNITION_TIMEOUT 30 * 1000  // 30 seconds 
 #define REQ_TIMEOUT  10 * 1000
 
+// Room for about 30 seconds of 16kHz 16-bit mono audio per stream.
+static constexpr quint32 kRingCapacity = 1024 * 1024;
+
 DSpeechToTextPrivate::DSpeechToTextPrivate(DSpeechToText *parent)
     : QObject()
     , error(NoError, "")
     , q(parent)
 {
-
+    connect(DSessionPool::instance(), &DSessionPool::daemonStopped, this, &DSpeechToTextPrivate::onDaemonStopped);
 }
 
 DSpeechToTextPrivate::~DSpeechToTextPrivate()
 {
+    // Proxy signals on the I/O thread may be in a handler right now.
+    handlers->close();
+
+    // Requests still in flight hold their scheduler slots.
+    for (quint64 id : calls.keys() + streams.keys())
+        DAISchedulerPrivate::finish(id);
+    DAISchedulerPrivate::finish(streamSlot);
+
+    for (DAudioRing *ring : qAsConst(rings))
+        ring->close();
+    qDeleteAll(rings);
+
     if (!speechIfs.isNull() && !sessionId.isEmpty()) {
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", QDBusConnection::sessionBus());
-        if (sessionManager.isValid())
-            sessionManager.DestroySession(sessionId);
+        // Leave the session clean for the next lease.
+        if (!isIdle())
+            speechIfs->terminate();
 
         speechIfs.reset(nullptr);
+        DSessionPool::instance()->release("SpeechToText", sessionId);
     }
 }
 
 bool DSpeechToTextPrivate::ensureServer()
 {
-    if (speechIfs.isNull() || !speechIfs->isValid()) {
-        QDBusConnection con = QDBusConnection::sessionBus();
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", con);
-        if (!sessionManager.isValid())
-            return false;
+    if (!DAICircuitBreaker::instance()->allowRequest())
+        return false;
+
+    // A session from before a daemon restart is gone even if the proxy looks fine.
+    const quint64 generation = DSessionPool::instance()->generation();
+    if (speechIfs.isNull() || !speechIfs->isValid() || sessionGeneration != generation) {
+        if (!sessionId.isEmpty()) {
+            speechIfs.reset(nullptr);
+            DSessionPool::instance()->discard("SpeechToText", sessionId);
+            sessionId.clear();
+        }
 
-        sessionId = sessionManager.CreateSession("SpeechToText");
+        sessionId = DSessionPool::instance()->acquire("SpeechToText");
         if (sessionId.isEmpty())
             return false;
+        sessionGeneration = generation;
 
         QString sessionPath = QString("/org/deepin/ai/daemon/Session/%1").arg(sessionId);
-        speechIfs.reset(new OrgDeepinAiDaemonSessionSpeechToTextInterface(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(), sessionPath, con));
+        QDBusConnection con = DAITransportPrivate::sessionConnection();
+        speechIfs = DAIProxyDeleter::shared(new OrgDeepinAiDaemonSessionSpeechToTextInterface(DAITransportPrivate::serviceName(con), sessionPath, con));
+        DAITransportPrivate::adopt(speechIfs.data());
         speechIfs->setTimeout(REQ_TIMEOUT);
         
         // Connect signals
-        q->connect(speechIfs.data(), &OrgDeepinAiDaemonSessionSpeechToTextInterface::RecognitionResult, 
-                   this, &DSpeechToTextPrivate::onRecognitionResult);
-        q->connect(speechIfs.data(), &OrgDeepinAiDaemonSessionSpeechToTextInterface::RecognitionPartialResult, 
-                   this, &DSpeechToTextPrivate::onRecognitionPartialResult);
-        q->connect(speechIfs.data(), &OrgDeepinAiDaemonSessionSpeechToTextInterface::RecognitionError, 
-                   this, &DSpeechToTextPrivate::onRecognitionError);
-        q->connect(speechIfs.data(), &OrgDeepinAiDaemonSessionSpeechToTextInterface::RecognitionCompleted, 
-                   this, &DSpeechToTextPrivate::onRecognitionCompleted);
+        const Qt::ConnectionType type = DAITransportPrivate::signalConnection(speechIfs.data());
+        connect(speechIfs.data(), &OrgDeepinAiDaemonSessionSpeechToTextInterface::RecognitionResult,
+                this, DAIHandlerGuard::wrap(handlers, this, &DSpeechToTextPrivate::onRecognitionResult), type);
+        connect(speechIfs.data(), &OrgDeepinAiDaemonSessionSpeechToTextInterface::RecognitionPartialResult,
+                this, DAIHandlerGuard::wrap(handlers, this, &DSpeechToTextPrivate::onRecognitionPartialResult), type);
+        connect(speechIfs.data(), &OrgDeepinAiDaemonSessionSpeechToTextInterface::RecognitionError,
+                this, DAIHandlerGuard::wrap(handlers, this, &DSpeechToTextPrivate::onRecognitionError), type);
+        connect(speechIfs.data(), &OrgDeepinAiDaemonSessionSpeechToTextInterface::RecognitionCompleted,
+                this, DAIHandlerGuard::wrap(handlers, this, &DSpeechToTextPrivate::onRecognitionCompleted), type);
     }
 
     return speechIfs->isValid();
@@ -69,15 +102,7 @@ bool DSpeechToTextPrivate::ensureServer()
 
 QString DSpeechToTextPrivate::packageParams(const QVariantHash &params)
 {
-    QVariantHash root;
-    
-    // Merge user-provided parameters
-    for (auto it = params.begin(); it != params.end(); ++it) {
-        root.insert(it.key(), it.value());
-    }
-
-    QString ret = QString::fromUtf8(QJsonDocument::fromVariant(root).toJson(QJsonDocument::Compact));
-    return ret;
+    return QString::fromUtf8(DAIParamsCache::encode(params));
 }
 
 QString DSpeechToTextPrivate::parseRecognitionResult(const QString &jsonResult, DError *error)
@@ -102,46 +127,195 @@ QString DSpeechToTextPrivate::parseRecognitionResult(const QString &jsonResult,
     return resultText;
 }
 
+bool DSpeechToTextPrivate::isCurrentStream(const QString &streamSessionId) const
+{
+    // Stream signals may arrive on the I/O thread.
+    QMutexLocker lk(&mtx);
+    return !streamSessionId.isEmpty() && streamSessionId == currentStreamSessionId;
+}
+
+quint64 DSpeechToTextPrivate::streamRequest(const QString &streamSessionId)
+{
+    QMutexLocker lk(&mtx);
+    return streams.key(streamSessionId, 0);
+}
+
+QDBusPendingReply<QString> DSpeechToTextPrivate::startStream(const QVariantHash &params, QScopedPointer<DAudioRing> &ring)
+{
+    if (transport == DSpeechToText::SharedMemoryTransport
+            && (speechIfs->connection().connectionCapabilities() & QDBusConnection::UnixFileDescriptorPassing)
+            && DAIFdPayload::daemonSupports(speechIfs.data(), "startStreamRecognitionShm")) {
+        ring.reset(new DAudioRing);
+        if (ring->create(kRingCapacity))
+            return speechIfs->startStreamRecognitionShm(packageParams(params), ring->memoryDescriptor(),
+                                                        ring->doorbellDescriptor());
+        ring.reset(nullptr);
+    }
+
+    return speechIfs->startStreamRecognition(packageParams(params));
+}
+
+bool DSpeechToTextPrivate::sendAudio(const QString &streamSessionId, const QByteArray &audioData)
+{
+    // Sent on a copy of the proxy, ensureServer() may replace it in another thread.
+    QSharedPointer<OrgDeepinAiDaemonSessionSpeechToTextInterface> ifs;
+    {
+        QMutexLocker lk(&mtx);
+        if (DAudioRing *ring = rings.value(streamSessionId))
+            return ring->write(audioData);
+        ifs = speechIfs;
+    }
+    if (!ifs)
+        return false;
+
+    QDBusPendingReply<bool> reply;
+    QDBusUnixFileDescriptor audioFd;
+    if (DAIFdPayload::preferred(ifs.data(), "sendAudioDataFd", audioData.size()))
+        audioFd = DAIFdPayload::fromData(audioData);
+
+    if (audioFd.isValid())
+        reply = ifs->sendAudioDataFd(streamSessionId, audioFd);
+    else
+        reply = ifs->sendAudioData(streamSessionId, audioData);
+
+    return reply.value();
+}
+
+void DSpeechToTextPrivate::releaseRing(const QString &streamSessionId)
+{
+    // The daemon keeps its own mapping, ours is only needed while writing.
+    if (DAudioRing *ring = rings.take(streamSessionId)) {
+        ring->close();
+        delete ring;
+    }
+}
+
+void DSpeechToTextPrivate::abortRequest(quint64 id, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    if (streams.contains(id)) {
+        // Streams have no terminate of their own, ending one discards its pending audio.
+        const QString streamSessionId = streams.take(id);
+        releaseRing(streamSessionId);
+        error.publish(err);
+        if (speechIfs)
+            speechIfs->endStreamRecognition(streamSessionId);
+        lk.unlock();
+
+        watches.release(id);
+        DAIMetricsPrivate::end(id, err.getErrorCode());
+        emit q->requestRecognitionError(id, err.getErrorCode(), err.getErrorMessage());
+        return;
+    }
+
+    if (!calls.contains(id))
+        return;
+
+    // The session is shared, only stop the daemon when nothing else runs on it.
+    DAIReplyCallback<QString> callback = calls.take(id);
+    const bool idle = isIdle();
+    const QSharedPointer<OrgDeepinAiDaemonSessionSpeechToTextInterface> ifs = speechIfs;
+    error.publish(err);
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err.getErrorCode());
+    if (idle && ifs)
+        ifs->terminate();
+
+    if (callback)
+        callback(QString(), err);
+}
+
 void DSpeechToTextPrivate::onRecognitionResult(const QString &streamSessionId, const QString &text)
 {
-    if (streamSessionId == currentStreamSessionId) {
+    if (isCurrentStream(streamSessionId)) {
         emit q->recognitionResult(text);
+    } else if (quint64 id = streamRequest(streamSessionId)) {
+        DAIMetricsPrivate::mark(id, "firstResult");
+        DAIMetricsPrivate::addReceived(id, DAIMetricsPrivate::utf8Size(text));
+        emit q->requestRecognitionResult(id, text);
     }
 }
 
+void DSpeechToTextPrivate::endCurrentStream()
+{
+    running = false;
+    DAISchedulerPrivate::finish(streamSlot);
+    streamSlot = 0;
+}
+
 void DSpeechToTextPrivate::onRecognitionPartialResult(const QString &streamSessionId, const QString &partialText)
 {
-    if (streamSessionId == currentStreamSessionId) {
+    if (isCurrentStream(streamSessionId)) {
         emit q->recognitionPartialResult(partialText);
+    } else if (quint64 id = streamRequest(streamSessionId)) {
+        DAIMetricsPrivate::mark(id, "firstResult");
+        DAIMetricsPrivate::addReceived(id, DAIMetricsPrivate::utf8Size(partialText));
+        emit q->requestRecognitionPartialResult(id, partialText);
     }
 }
 
 void DSpeechToTextPrivate::onRecognitionError(const QString &streamSessionId, int errorCode, const QString &errorMessage)
 {
-    if (streamSessionId == currentStreamSessionId) {
+    if (isCurrentStream(streamSessionId)) {
         QMutexLocker lk(&mtx);
-        running = false;
-        error.setErrorCode(errorCode);
-        error.setErrorMessage(errorMessage);
+        endCurrentStream();
+        releaseRing(streamSessionId);
+        error.publish(DError(errorCode, errorMessage));
         lk.unlock();
         
         emit q->recognitionError(errorCode, errorMessage);
+    } else if (quint64 id = streamRequest(streamSessionId)) {
+        QMutexLocker lk(&mtx);
+        streams.remove(id);
+        releaseRing(streamSessionId);
+        error.publish(DError(errorCode, errorMessage));
+        lk.unlock();
+
+        watches.release(id);
+        DAIMetricsPrivate::end(id, errorCode);
+        emit q->requestRecognitionError(id, errorCode, errorMessage);
     }
 }
 
 void DSpeechToTextPrivate::onRecognitionCompleted(const QString &streamSessionId, const QString &finalText)
 {
-    if (streamSessionId == currentStreamSessionId) {
+    if (isCurrentStream(streamSessionId)) {
         QMutexLocker lk(&mtx);
-        running = false;
-        error.setErrorCode(0);
-        error.setErrorMessage("");
+        endCurrentStream();
+        releaseRing(streamSessionId);
+        error.publish(DError(NoError, ""));
         lk.unlock();
         
         emit q->recognitionCompleted(finalText);
+    } else if (quint64 id = streamRequest(streamSessionId)) {
+        QMutexLocker lk(&mtx);
+        streams.remove(id);
+        releaseRing(streamSessionId);
+        error.publish(DError(NoError, ""));
+        lk.unlock();
+
+        watches.release(id);
+        DAIMetricsPrivate::end(id, NoError, DAIMetricsPrivate::utf8Size(finalText));
+        emit q->requestRecognitionCompleted(id, finalText);
     }
 }
 
+void DSpeechToTextPrivate::onDaemonStopped()
+{
+    QMutexLocker lk(&mtx);
+    QStringList active = streams.values();
+    if (running)
+        active.append(currentStreamSessionId);
+    lk.unlock();
+
+    // No RecognitionCompleted will ever arrive for these.
+    for (const QString &streamSessionId : active)
+        onRecognitionError(streamSessionId, AIErrorCode::APIServerNotAvailable, "AI daemon stopped");
+}
+
 DSpeechToText::DSpeechToText(QObject *parent)
     : QObject(parent)
     , d(new DSpeechToTextPrivate(this))
@@ -154,10 +328,17 @@ DSpeechToText::~DSpeechToText()
 
 }
 
-QString DSpeechToText::recognizeFile(const QString &audioFile, const QVariantHash &params)
+QString DSpeechToText::recognizeFile(const QString &audioFile, const QVariantHash &params, const DAIRequestOptions &options)
 {
+    DAICallMetric metric("DSpeechToText.recognizeFile", &d->error);
+    const QString packed = d->packageParams(params);
+    metric.addSent(audioFile);
+    metric.addSent(packed);
+
+    DAISchedulerSlot slot("SpeechToText", options);
     QMutexLocker lk(&d->mtx);
-    if (d->running)
+    d->error = slot.error();
+    if (d->error.getErrorCode() != NoError)
         return "";
 
     if (!d->ensureServer()) {
@@ -165,88 +346,329 @@ QString DSpeechToText::recognizeFile(const QString &audioFile, const QVariantHas
         return "";
     }
 
-    d->running = true;
+    // Concurrent calls are told apart by their reply serial, only the issue is serialized.
+    d->speechIfs->setTimeout(requestTimeout(options, RECOGNITION_TIMEOUT));
+    QDBusPendingReply<QString> reply = d->speechIfs->recognizeFile(audioFile, packed);
+    d->speechIfs->setTimeout(REQ_TIMEOUT);
+    ++d->blocking;
     lk.unlock();
 
-    d->speechIfs->setTimeout(RECOGNITION_TIMEOUT);
-    QString ret = d->speechIfs->recognizeFile(audioFile, d->packageParams(params));
-    d->speechIfs->setTimeout(REQ_TIMEOUT);
+    reply.waitForFinished();
+    lk.relock();
+    --d->blocking;
+    if (reply.isError() && options.deadline.hasExpired()) {
+        // The caller gave up, which says nothing about the daemon, nor about the other calls.
+        d->error = deadlineExceededError();
+        if (d->isIdle() && d->speechIfs)
+            d->speechIfs->terminate();
+        return "";
+    }
+    lk.unlock();
 
-    ret = DSpeechToTextPrivate::parseRecognitionResult(ret, &d->error);
+    recordCallResult(reply);
+    DError err(NoError, "");
+    QString ret;
+    if (reply.isError()) {
+        err = pendingCallError(reply);
+    } else {
+        metric.addReceived(reply.value());
+        ret = DSpeechToTextPrivate::parseRecognitionResult(reply.value(), &err);
+    }
 
     lk.relock();
-    d->running = false;
+    d->error = err;
     return ret;
 }
 
+quint64 DSpeechToText::recognizeFileAsync(const QString &audioFile, const DAIReplyCallback<QString> &callback,
+                                          const QVariantHash &params, const DAIRequestOptions &options)
+{
+    QMutexLocker lk(&d->mtx);
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return 0;
+
+    if (!d->ensureServer()) {
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
+        return 0;
+    }
+
+    const quint64 id = nextRequestId();
+    d->calls.insert(id, callback);
+    lk.unlock();
+
+    const QString packed = d->packageParams(params);
+    DAIMetricsPrivate::begin(id, "DSpeechToText.recognizeFileAsync",
+                             DAIMetricsPrivate::utf8Size(audioFile) + DAIMetricsPrivate::utf8Size(packed));
+
+    // The deadline is enforced by the watch, a late reply is dropped below.
+    d->watches.watch(id, options, d.data(), [this, id](const DError &err) {
+        d->abortRequest(id, err);
+    });
+
+    DAISchedulerPrivate::submit(id, "SpeechToText", options, d.data(), [this, id, audioFile, packed]() {
+        QMutexLocker lk(&d->mtx);
+        // Aborted while it was queued.
+        if (!d->calls.contains(id))
+            return;
+
+        if (!d->ensureServer()) {
+            lk.unlock();
+            d->abortRequest(id, DError(AIErrorCode::APIServerNotAvailable, ""));
+            return;
+        }
+
+        d->speechIfs->setTimeout(RECOGNITION_TIMEOUT);
+        QDBusPendingCall call = d->speechIfs->recognizeFile(audioFile, packed);
+        d->speechIfs->setTimeout(REQ_TIMEOUT);
+        lk.unlock();
+
+        watchPendingCall(call, d.data(), [this, id](const QDBusPendingCall &reply) {
+            DError err = pendingCallError(reply);
+            QString result;
+            if (err.getErrorCode() == NoError)
+                result = DSpeechToTextPrivate::parseRecognitionResult(QDBusPendingReply<QString>(reply).value(), &err);
+
+            QMutexLocker lk(&d->mtx);
+            // Already handled by terminateRequest().
+            if (!d->calls.contains(id))
+                return;
+
+            DAIReplyCallback<QString> callback = d->calls.take(id);
+            d->error.publish(err);
+            lk.unlock();
+
+            d->watches.release(id);
+            DAISchedulerPrivate::finish(id);
+            DAIMetricsPrivate::end(id, err.getErrorCode(), DAIMetricsPrivate::utf8Size(result));
+            if (callback)
+                callback(result, err);
+        });
+    });
+    return id;
+}
+
 bool DSpeechToText::startStreamRecognition(const QVariantHash &params)
 {
+    {
+        QMutexLocker lk(&d->mtx);
+        if (d->running)
+            return false;
+    }
+
+    // Admitted like every other request, the slot is held until the stream ends.
+    DError refused;
+    const quint64 slot = DAISchedulerPrivate::acquire("SpeechToText", DAIRequestOptions(), &refused);
     QMutexLocker lk(&d->mtx);
-    if (d->running)
+    if (!slot) {
+        d->error = refused;
+        return false;
+    }
+
+    if (d->running) {
+        DAISchedulerPrivate::finish(slot);
         return false;
+    }
 
     if (!d->ensureServer()) {
+        DAISchedulerPrivate::finish(slot);
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return false;
     }
 
     d->running = true;
+    d->streamSlot = slot;
+    QScopedPointer<DAudioRing> ring;
+    QDBusPendingReply<QString> reply = d->startStream(params, ring);
     lk.unlock();
 
-    QString streamSessionId = d->speechIfs->startStreamRecognition(d->packageParams(params));
+    QString streamSessionId = reply.value();
     if (streamSessionId.isEmpty()) {
         lk.relock();
-        d->running = false;
+        d->endCurrentStream();
         d->error = DError(AIErrorCode::APIServerNotAvailable, "Failed to start stream recognition");
         return false;
     }
     
+    lk.relock();
+    if (ring)
+        d->rings.insert(streamSessionId, ring.take());
     d->currentStreamSessionId = streamSessionId;
     return true;
 }
 
 bool DSpeechToText::sendAudioData(const QByteArray &audioData)
 {
+    QMutexLocker lk(&d->mtx);
     if (!d->speechIfs || d->currentStreamSessionId.isEmpty())
         return false;
-        
-    return d->speechIfs->sendAudioData(d->currentStreamSessionId, audioData);
+
+    const QString streamSessionId = d->currentStreamSessionId;
+    lk.unlock();
+
+    return d->sendAudio(streamSessionId, audioData);
 }
 
 QString DSpeechToText::endStreamRecognition()
 {
+    QMutexLocker lk(&d->mtx);
     if (!d->speechIfs || d->currentStreamSessionId.isEmpty())
         return "";
-        
-    QString result = d->speechIfs->endStreamRecognition(d->currentStreamSessionId);
+
+    // Taken under the lock, only one of several threads ending the stream gets its result.
+    const QString streamSessionId = d->currentStreamSessionId;
     d->currentStreamSessionId.clear();
-    
-    result = DSpeechToTextPrivate::parseRecognitionResult(result, &d->error);
-    
+    d->releaseRing(streamSessionId);
+    QDBusPendingReply<QString> reply = d->speechIfs->endStreamRecognition(streamSessionId);
+    lk.unlock();
+
+    reply.waitForFinished();
+    DError err(NoError, "");
+    QString result = DSpeechToTextPrivate::parseRecognitionResult(reply.value(), &err);
+
+    lk.relock();
+    d->endCurrentStream();
+    d->error = err;
+    return result;
+}
+
+quint64 DSpeechToText::startRecognitionStream(const QVariantHash &params, const DAIRequestOptions &options)
+{
     QMutexLocker lk(&d->mtx);
-    d->running = false;
-    
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return 0;
+
+    if (!d->ensureServer()) {
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
+        return 0;
+    }
+
+    // Allocated up front, the time to the first result includes opening the stream.
+    const quint64 id = nextRequestId();
+    DAIMetricsPrivate::begin(id, "DSpeechToText.startRecognitionStream");
+    QScopedPointer<DAudioRing> ring;
+    d->speechIfs->setTimeout(requestTimeout(options, REQ_TIMEOUT));
+    QDBusPendingReply<QString> reply = d->startStream(params, ring);
+    d->speechIfs->setTimeout(REQ_TIMEOUT);
+    lk.unlock();
+
+    reply.waitForFinished();
+    if (reply.isError() && options.deadline.hasExpired()) {
+        const DError err = deadlineExceededError();
+        DAIMetricsPrivate::end(id, err.getErrorCode());
+        lk.relock();
+        d->error = err;
+        return 0;
+    }
+
+    recordCallResult(reply);
+    const QString streamSessionId = reply.value();
+
+    lk.relock();
+    if (streamSessionId.isEmpty()) {
+        DAIMetricsPrivate::end(id, AIErrorCode::APIServerNotAvailable);
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "Failed to start stream recognition");
+        return 0;
+    }
+
+    d->streams.insert(id, streamSessionId);
+    if (ring)
+        d->rings.insert(streamSessionId, ring.take());
+    lk.unlock();
+
+    d->watches.watch(id, options, d.data(), [this, id](const DError &err) {
+        d->abortRequest(id, err);
+    });
+    return id;
+}
+
+bool DSpeechToText::sendStreamAudio(quint64 requestId, const QByteArray &audioData)
+{
+    QMutexLocker lk(&d->mtx);
+    const QString streamSessionId = d->streams.value(requestId);
+    if (!d->speechIfs || streamSessionId.isEmpty())
+        return false;
+
+    lk.unlock();
+
+    DAIMetricsPrivate::addSent(requestId, audioData.size());
+    return d->sendAudio(streamSessionId, audioData);
+}
+
+QString DSpeechToText::endRecognitionStream(quint64 requestId)
+{
+    QMutexLocker lk(&d->mtx);
+    const QString streamSessionId = d->streams.take(requestId);
+    if (!d->speechIfs || streamSessionId.isEmpty())
+        return "";
+
+    d->watches.release(requestId);
+    d->releaseRing(streamSessionId);
+    QDBusPendingReply<QString> reply = d->speechIfs->endStreamRecognition(streamSessionId);
+    lk.unlock();
+
+    reply.waitForFinished();
+    recordCallResult(reply);
+    DError err(NoError, "");
+    QString result = DSpeechToTextPrivate::parseRecognitionResult(reply.value(), &err);
+    DAIMetricsPrivate::end(requestId, err.getErrorCode(), DAIMetricsPrivate::utf8Size(result));
+
+    lk.relock();
+    d->error = err;
     return result;
 }
 
 void DSpeechToText::terminate()
 {
+    QMutexLocker lk(&d->mtx);
     if (d->speechIfs)
         d->speechIfs->terminate();
-        
-    QMutexLocker lk(&d->mtx);
-    d->running = false;
+
+    d->endCurrentStream();
+    d->releaseRing(d->currentStreamSessionId);
     d->currentStreamSessionId.clear();
+    const QList<quint64> ids = d->streams.keys();
+    lk.unlock();
+
+    for (quint64 id : ids)
+        terminateRequest(id);
+}
+
+void DSpeechToText::terminateRequest(quint64 requestId)
+{
+    d->abortRequest(requestId, DError(AIErrorCode::RequestCancelled, "Request terminated"));
 }
 
-QStringList DSpeechToText::getSupportedFormats()
+void DSpeechToText::setStreamTransport(StreamTransport transport)
 {
+    QMutexLocker lk(&d->mtx);
+    d->transport = transport;
+}
+
+DSpeechToText::StreamTransport DSpeechToText::streamTransport() const
+{
+    QMutexLocker lk(&d->mtx);
+    return d->transport;
+}
+
+QStringList DSpeechToText::getSupportedFormats(const DAIRequestOptions &options)
+{
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return QStringList();
+
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return QStringList();
     }
-    
-    return d->speechIfs->getSupportedFormats();
+
+    // The copy keeps the proxy alive should another thread replace the session meanwhile.
+    const QSharedPointer<OrgDeepinAiDaemonSessionSpeechToTextInterface> ifs = d->speechIfs;
+    lk.unlock();
+
+    return callWithRetry([&ifs]() { return ifs->getSupportedFormats(); }, options, ifs.data(), &d->mtx);
 }
 
 DError DSpeechToText::lastError() const
@@ -7,11 +7,17 @@
 
 #include "speech/dspeechtotext.h"
 #include "aidaemon_apisession_speechtotext.h"
+#include "daitransport_p.h"
+#include "dairequestoptions_p.h"
+#include "daithreaderror_p.h"
 
+#include <QHash>
 #include <QJsonDocument>
 
 DAI_BEGIN_NAMESPACE
 
+class DAudioRing;
+
 class DSpeechToTextPrivate : public QObject
 {
     Q_OBJECT
@@ -23,20 +29,45 @@ public:
     
     // JSON response parsing function
     static QString parseRecognitionResult(const QString &jsonResult, DTK_CORE_NAMESPACE::DError *error = nullptr);
+    bool isCurrentStream(const QString &streamSessionId) const;
+    quint64 streamRequest(const QString &streamSessionId);
+    QDBusPendingReply<QString> startStream(const QVariantHash &params, QScopedPointer<DAudioRing> &ring);
+    bool sendAudio(const QString &streamSessionId, const QByteArray &audioData);
+    void releaseRing(const QString &streamSessionId);
+    // Stops a request in the daemon and finishes it with err.
+    void abortRequest(quint64 id, const DTK_CORE_NAMESPACE::DError &err);
+    // The startStreamRecognition() stream ended, frees its scheduler slot, requires mtx.
+    void endCurrentStream();
+    // Nothing else runs on speechIfs, terminating it cancels nobody, requires mtx.
+    bool isIdle() const { return calls.isEmpty() && streams.isEmpty() && !running && blocking == 0; }
     
 public Q_SLOTS:
     void onRecognitionResult(const QString &streamSessionId, const QString &text);
     void onRecognitionPartialResult(const QString &streamSessionId, const QString &partialText);
     void onRecognitionError(const QString &streamSessionId, int errorCode, const QString &errorMessage);
     void onRecognitionCompleted(const QString &streamSessionId, const QString &finalText);
+    void onDaemonStopped();
     
 public:
-    QMutex mtx;
+    mutable QMutex mtx;
+    QSharedPointer<DAIHandlerGuard> handlers { new DAIHandlerGuard };
     bool running = false;
-    DTK_CORE_NAMESPACE::DError error;
-    QScopedPointer<OrgDeepinAiDaemonSessionSpeechToTextInterface> speechIfs;
+    // Scheduler slot of the startStreamRecognition() stream.
+    quint64 streamSlot = 0;
+    // Blocking recognizeFile() calls waiting for their reply on speechIfs.
+    int blocking = 0;
+    DAIThreadError error;
+    QSharedPointer<OrgDeepinAiDaemonSessionSpeechToTextInterface> speechIfs;
     QString sessionId;
+    quint64 sessionGeneration = 0;
     QString currentStreamSessionId;
+    QHash<quint64, DAIReplyCallback<QString>> calls;
+    // Request id to stream session id, the daemon tags every stream signal with the latter.
+    QHash<quint64, QString> streams;
+    // Shared-memory rings by stream session id, only for streams using SharedMemoryTransport.
+    QHash<QString, DAudioRing *> rings;
+    DSpeechToText::StreamTransport transport = DSpeechToText::DBusTransport;
+    DAIRequestWatches watches;
     
 public:
     DSpeechToText *q = nullptr;
@@ -5,6 +5,13 @@
 #include "speech/dtexttospeech.h"
 #include "speech/dtexttospeech_p.h"
 #include "aidaemon_sessionmanager.h"
+#include "dsessionpool.h"
+#include "daiasync_p.h"
+#include "dairequestoptions_p.h"
+#include "dairetrypolicy_p.h"
+#include "daischeduler_p.h"
+#include "daiencodedparams_p.h"
+#include "daimetrics_p.h"
 #include "daierror.h"
 
 #include <QMutexLocker>
@@ -21,45 +28,62 @@ DTextToSpeechPrivate::DTextToSpeechPrivate(DTextToSpeech *parent)
     , error(NoError, "")
     , q(parent)
 {
-
+    connect(DSessionPool::instance(), &DSessionPool::daemonStopped, this, &DTextToSpeechPrivate::onDaemonStopped);
 }
 
 DTextToSpeechPrivate::~DTextToSpeechPrivate()
 {
+    // Proxy signals on the I/O thread may be in a handler right now.
+    handlers->close();
+
+    // Streams still open hold their scheduler slots.
+    for (quint64 id : streams.keys())
+        DAISchedulerPrivate::finish(id);
+    DAISchedulerPrivate::finish(currentStreamSlot);
+
     if (!ttsIfs.isNull() && !sessionId.isEmpty()) {
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", QDBusConnection::sessionBus());
-        if (sessionManager.isValid())
-            sessionManager.DestroySession(sessionId);
+        // Leave the session clean for the next lease.
+        if (running || !streams.isEmpty())
+            ttsIfs->terminate();
 
         ttsIfs.reset(nullptr);
+        DSessionPool::instance()->release("TextToSpeech", sessionId);
     }
 }
 
 bool DTextToSpeechPrivate::ensureServer()
 {
-    if (ttsIfs.isNull() || !ttsIfs->isValid()) {
-        QDBusConnection con = QDBusConnection::sessionBus();
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", con);
-        if (!sessionManager.isValid())
-            return false;
+    if (!DAICircuitBreaker::instance()->allowRequest())
+        return false;
+
+    // A session from before a daemon restart is gone even if the proxy looks fine.
+    const quint64 generation = DSessionPool::instance()->generation();
+    if (ttsIfs.isNull() || !ttsIfs->isValid() || sessionGeneration != generation) {
+        if (!sessionId.isEmpty()) {
+            ttsIfs.reset(nullptr);
+            DSessionPool::instance()->discard("TextToSpeech", sessionId);
+            sessionId.clear();
+        }
 
-        sessionId = sessionManager.CreateSession("TextToSpeech");
+        sessionId = DSessionPool::instance()->acquire("TextToSpeech");
         if (sessionId.isEmpty())
             return false;
+        sessionGeneration = generation;
 
         QString sessionPath = QString("/org/deepin/ai/daemon/Session/%1").arg(sessionId);
-        ttsIfs.reset(new OrgDeepinAiDaemonSessionTextToSpeechInterface(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(), sessionPath, con));
+        QDBusConnection con = DAITransportPrivate::sessionConnection();
+        ttsIfs = DAIProxyDeleter::shared(new OrgDeepinAiDaemonSessionTextToSpeechInterface(DAITransportPrivate::serviceName(con), sessionPath, con));
+        DAITransportPrivate::adopt(ttsIfs.data());
         ttsIfs->setTimeout(REQ_TIMEOUT);
         
         // Connect signals
-        q->connect(ttsIfs.data(), &OrgDeepinAiDaemonSessionTextToSpeechInterface::SynthesisResult, 
-                   this, &DTextToSpeechPrivate::onSynthesisResult);
-        q->connect(ttsIfs.data(), &OrgDeepinAiDaemonSessionTextToSpeechInterface::SynthesisError, 
-                   this, &DTextToSpeechPrivate::onSynthesisError);
-        q->connect(ttsIfs.data(), &OrgDeepinAiDaemonSessionTextToSpeechInterface::SynthesisCompleted, 
-                   this, &DTextToSpeechPrivate::onSynthesisCompleted);
+        const Qt::ConnectionType type = DAITransportPrivate::signalConnection(ttsIfs.data());
+        connect(ttsIfs.data(), &OrgDeepinAiDaemonSessionTextToSpeechInterface::SynthesisResult,
+                this, DAIHandlerGuard::wrap(handlers, this, &DTextToSpeechPrivate::onSynthesisResult), type);
+        connect(ttsIfs.data(), &OrgDeepinAiDaemonSessionTextToSpeechInterface::SynthesisError,
+                this, DAIHandlerGuard::wrap(handlers, this, &DTextToSpeechPrivate::onSynthesisError), type);
+        connect(ttsIfs.data(), &OrgDeepinAiDaemonSessionTextToSpeechInterface::SynthesisCompleted,
+                this, DAIHandlerGuard::wrap(handlers, this, &DTextToSpeechPrivate::onSynthesisCompleted), type);
     }
 
     return ttsIfs->isValid();
@@ -67,50 +91,130 @@ bool DTextToSpeechPrivate::ensureServer()
 
 QString DTextToSpeechPrivate::packageParams(const QVariantHash &params)
 {
-    QVariantHash root;
-    
-    // Merge user-provided parameters
-    for (auto it = params.begin(); it != params.end(); ++it) {
-        root.insert(it.key(), it.value());
+    return QString::fromUtf8(DAIParamsCache::encode(params));
+}
+
+QByteArray DTextToSpeechPrivate::parseSynthesisResult(const QString &result, DError *error)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(result.toUtf8());
+    auto var = doc.object().toVariantHash();
+    int errorCode = var.value("error_code", 0).toInt();
+    if (errorCode != 0) {
+        *error = DError(errorCode, var.value("error_message").toString());
+        return QByteArray();
     }
 
-    QString ret = QString::fromUtf8(QJsonDocument::fromVariant(root).toJson(QJsonDocument::Compact));
-    return ret;
+    *error = DError(NoError, "");
+    return QByteArray::fromBase64(var.value("audio_data").toString().toUtf8());
+}
+
+bool DTextToSpeechPrivate::isCurrentStream(const QString &streamSessionId) const
+{
+    // Stream signals may arrive on the I/O thread.
+    QMutexLocker lk(&mtx);
+    return !streamSessionId.isEmpty() && streamSessionId == currentStreamSessionId;
+}
+
+quint64 DTextToSpeechPrivate::streamRequest(const QString &streamSessionId)
+{
+    QMutexLocker lk(&mtx);
+    return streams.key(streamSessionId, 0);
+}
+
+void DTextToSpeechPrivate::abortRequest(quint64 id, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    if (!streams.contains(id))
+        return;
+
+    // Streams have no terminate of their own, ending one discards the rest of its audio.
+    const QString streamSessionId = streams.take(id);
+    error.publish(err);
+    if (ttsIfs)
+        ttsIfs->endStreamSynthesis(streamSessionId);
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err.getErrorCode());
+    emit q->requestSynthesisError(id, err.getErrorCode(), err.getErrorMessage());
+}
+
+void DTextToSpeechPrivate::endCurrentStream()
+{
+    running = false;
+    DAISchedulerPrivate::finish(currentStreamSlot);
+    currentStreamSlot = 0;
 }
 
 void DTextToSpeechPrivate::onSynthesisResult(const QString &streamSessionId, const QByteArray &audioData)
 {
-    if (streamSessionId == currentStreamSessionId) {
+    if (isCurrentStream(streamSessionId)) {
         emit q->synthesisResult(audioData);
+    } else if (quint64 id = streamRequest(streamSessionId)) {
+        DAIMetricsPrivate::mark(id, "firstAudio");
+        DAIMetricsPrivate::addReceived(id, audioData.size());
+        emit q->requestSynthesisResult(id, audioData);
     }
 }
 
 void DTextToSpeechPrivate::onSynthesisError(const QString &streamSessionId, int errorCode, const QString &errorMessage)
 {
-    if (streamSessionId == currentStreamSessionId) {
+    if (isCurrentStream(streamSessionId)) {
         QMutexLocker lk(&mtx);
-        running = false;
-        error.setErrorCode(errorCode);
-        error.setErrorMessage(errorMessage);
+        endCurrentStream();
+        error.publish(DError(errorCode, errorMessage));
         lk.unlock();
         
         emit q->synthesisError(errorCode, errorMessage);
+    } else if (quint64 id = streamRequest(streamSessionId)) {
+        QMutexLocker lk(&mtx);
+        streams.remove(id);
+        error.publish(DError(errorCode, errorMessage));
+        lk.unlock();
+
+        watches.release(id);
+        DAISchedulerPrivate::finish(id);
+        DAIMetricsPrivate::end(id, errorCode);
+        emit q->requestSynthesisError(id, errorCode, errorMessage);
     }
 }
 
 void DTextToSpeechPrivate::onSynthesisCompleted(const QString &streamSessionId, const QByteArray &finalAudio)
 {
-    if (streamSessionId == currentStreamSessionId) {
+    if (isCurrentStream(streamSessionId)) {
         QMutexLocker lk(&mtx);
-        running = false;
-        error.setErrorCode(0);
-        error.setErrorMessage("");
+        endCurrentStream();
+        error.publish(DError(NoError, ""));
         lk.unlock();
         
         emit q->synthesisCompleted(finalAudio);
+    } else if (quint64 id = streamRequest(streamSessionId)) {
+        QMutexLocker lk(&mtx);
+        streams.remove(id);
+        error.publish(DError(NoError, ""));
+        lk.unlock();
+
+        watches.release(id);
+        DAISchedulerPrivate::finish(id);
+        DAIMetricsPrivate::end(id, NoError, finalAudio.size());
+        emit q->requestSynthesisCompleted(id, finalAudio);
     }
 }
 
+void DTextToSpeechPrivate::onDaemonStopped()
+{
+    QMutexLocker lk(&mtx);
+    QStringList active = streams.values();
+    if (running)
+        active.append(currentStreamSessionId);
+    lk.unlock();
+
+    // No SynthesisCompleted will ever arrive for these.
+    for (const QString &streamSessionId : active)
+        onSynthesisError(streamSessionId, AIErrorCode::APIServerNotAvailable, "AI daemon stopped");
+}
+
 DTextToSpeech::DTextToSpeech(QObject *parent)
     : QObject(parent)
     , d(new DTextToSpeechPrivate(this))
@@ -125,73 +229,189 @@ DTextToSpeech::~DTextToSpeech()
 
 bool DTextToSpeech::startStreamSynthesis(const QString &text, const QVariantHash &params)
 {
+    // The stream holds a slot of the scheduler until it ends.
+    DError admission;
+    const quint64 slot = DAISchedulerPrivate::acquire("TextToSpeech", DAIRequestOptions(), &admission);
     QMutexLocker lk(&d->mtx);
-    if (d->running)
+    if (!slot) {
+        d->error = admission;
+        return false;
+    }
+
+    if (d->running) {
+        DAISchedulerPrivate::finish(slot);
         return false;
+    }
 
     if (!d->ensureServer()) {
+        DAISchedulerPrivate::finish(slot);
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return false;
     }
 
     d->running = true;
+    d->currentStreamSlot = slot;
+    // The copy keeps the proxy alive should another thread replace the session meanwhile.
+    const QSharedPointer<OrgDeepinAiDaemonSessionTextToSpeechInterface> ifs = d->ttsIfs;
     lk.unlock();
 
-    QString streamSessionId = d->ttsIfs->startStreamSynthesis(text, d->packageParams(params));
+    QString streamSessionId = ifs->startStreamSynthesis(text, d->packageParams(params));
     if (streamSessionId.isEmpty()) {
         lk.relock();
-        d->running = false;
+        d->endCurrentStream();
         d->error = DError(AIErrorCode::APIServerNotAvailable, "Failed to start stream synthesis");
         return false;
     }
-    
+
+    lk.relock();
     d->currentStreamSessionId = streamSessionId;
     return true;
 }
 
 QByteArray DTextToSpeech::endStreamSynthesis()
 {
+    QMutexLocker lk(&d->mtx);
     if (!d->ttsIfs || d->currentStreamSessionId.isEmpty())
         return QByteArray();
-        
-    QString result = d->ttsIfs->endStreamSynthesis(d->currentStreamSessionId);
+
+    // Taken under the lock, only one of several threads ending the stream gets its audio.
+    const QString streamSessionId = d->currentStreamSessionId;
     d->currentStreamSessionId.clear();
-    
+    QDBusPendingReply<QString> reply = d->ttsIfs->endStreamSynthesis(streamSessionId);
+    lk.unlock();
+
+    reply.waitForFinished();
+    // Parse result to get audio data, a failed parse leaves the previous error untouched
+    DError err(NoError, "");
+    QByteArray audioData = DTextToSpeechPrivate::parseSynthesisResult(reply.value(), &err);
+
+    lk.relock();
+    d->endCurrentStream();
+    if (err.getErrorCode() != NoError)
+        d->error = err;
+    return audioData;
+}
+
+quint64 DTextToSpeech::startSynthesisStream(const QString &text, const QVariantHash &params, const DAIRequestOptions &options)
+{
+    // The stream holds its slot of the scheduler until it ends, the slot id is the request id.
+    // Allocated up front, the time to the first audio includes opening the stream.
+    DError admission;
+    const quint64 id = DAISchedulerPrivate::acquire("TextToSpeech", options, &admission);
     QMutexLocker lk(&d->mtx);
-    d->running = false;
-    
-    // Parse result to get audio data
-    QByteArray audioData;
-    QJsonDocument doc = QJsonDocument::fromJson(result.toUtf8());
-    auto var = doc.object().toVariantHash();
-    int errorCode = var.value("error_code", 0).toInt();
-    if (errorCode == 0) {
-        audioData = QByteArray::fromBase64(var.value("audio_data").toString().toUtf8());
-    } else {
-        d->error = DError(errorCode, var.value("error_message").toString());
+    d->error = id ? requestOptionsError(options) : admission;
+    if (d->error.getErrorCode() != NoError) {
+        DAISchedulerPrivate::finish(id);
+        return 0;
+    }
+
+    if (!d->ensureServer()) {
+        DAISchedulerPrivate::finish(id);
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
+        return 0;
     }
-    
+
+    const QString packed = d->packageParams(params);
+    DAIMetricsPrivate::begin(id, "DTextToSpeech.startSynthesisStream",
+                             DAIMetricsPrivate::utf8Size(text) + DAIMetricsPrivate::utf8Size(packed));
+    d->ttsIfs->setTimeout(requestTimeout(options, REQ_TIMEOUT));
+    QDBusPendingReply<QString> reply = d->ttsIfs->startStreamSynthesis(text, packed);
+    d->ttsIfs->setTimeout(REQ_TIMEOUT);
+    lk.unlock();
+
+    reply.waitForFinished();
+    if (reply.isError() && options.deadline.hasExpired()) {
+        const DError err = deadlineExceededError();
+        DAISchedulerPrivate::finish(id);
+        DAIMetricsPrivate::end(id, err.getErrorCode());
+        lk.relock();
+        d->error = err;
+        return 0;
+    }
+
+    recordCallResult(reply);
+    const QString streamSessionId = reply.value();
+
+    lk.relock();
+    if (streamSessionId.isEmpty()) {
+        DAISchedulerPrivate::finish(id);
+        DAIMetricsPrivate::end(id, AIErrorCode::APIServerNotAvailable);
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "Failed to start stream synthesis");
+        return 0;
+    }
+
+    d->streams.insert(id, streamSessionId);
+    lk.unlock();
+
+    d->watches.watch(id, options, d.data(), [this, id](const DError &err) {
+        d->abortRequest(id, err);
+    });
+    return id;
+}
+
+QByteArray DTextToSpeech::endSynthesisStream(quint64 requestId)
+{
+    QMutexLocker lk(&d->mtx);
+    const QString streamSessionId = d->streams.take(requestId);
+    if (!d->ttsIfs || streamSessionId.isEmpty())
+        return QByteArray();
+
+    d->watches.release(requestId);
+    DAISchedulerPrivate::finish(requestId);
+    QDBusPendingReply<QString> reply = d->ttsIfs->endStreamSynthesis(streamSessionId);
+    lk.unlock();
+
+    reply.waitForFinished();
+    recordCallResult(reply);
+    DError err(NoError, "");
+    QByteArray audioData;
+    if (reply.isError())
+        err = pendingCallError(reply);
+    else
+        audioData = DTextToSpeechPrivate::parseSynthesisResult(reply.value(), &err);
+    DAIMetricsPrivate::end(requestId, err.getErrorCode(), audioData.size());
+
+    lk.relock();
+    d->error = err;
     return audioData;
 }
 
 void DTextToSpeech::terminate()
 {
+    QMutexLocker lk(&d->mtx);
     if (d->ttsIfs)
         d->ttsIfs->terminate();
-        
-    QMutexLocker lk(&d->mtx);
-    d->running = false;
+
+    d->endCurrentStream();
     d->currentStreamSessionId.clear();
+    const QList<quint64> ids = d->streams.keys();
+    lk.unlock();
+
+    for (quint64 id : ids)
+        terminateRequest(id);
+}
+
+void DTextToSpeech::terminateRequest(quint64 requestId)
+{
+    d->abortRequest(requestId, DError(AIErrorCode::RequestCancelled, "Request terminated"));
 }
 
-QStringList DTextToSpeech::getSupportedVoices()
+QStringList DTextToSpeech::getSupportedVoices(const DAIRequestOptions &options)
 {
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return QStringList();
+
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return QStringList();
     }
-    
-    return d->ttsIfs->getSupportedVoices();
+
+    const QSharedPointer<OrgDeepinAiDaemonSessionTextToSpeechInterface> ifs = d->ttsIfs;
+    lk.unlock();
+
+    return callWithRetry([&ifs]() { return ifs->getSupportedVoices(); }, options, ifs.data(), &d->mtx);
 }
 
 DError DTextToSpeech::lastError() const
@@ -7,6 +7,11 @@
 
 #include "speech/dtexttospeech.h"
 #include "aidaemon_apisession_texttospeech.h"
+#include "daitransport_p.h"
+#include "dairequestoptions_p.h"
+#include "daithreaderror_p.h"
+
+#include <QHash>
 
 DAI_BEGIN_NAMESPACE
 
@@ -18,19 +23,33 @@ public:
     ~DTextToSpeechPrivate();
     bool ensureServer();
     static QString packageParams(const QVariantHash &params);
+    static QByteArray parseSynthesisResult(const QString &result, DTK_CORE_NAMESPACE::DError *error);
+    bool isCurrentStream(const QString &streamSessionId) const;
+    quint64 streamRequest(const QString &streamSessionId);
+    // Stops a request in the daemon and finishes it with err.
+    void abortRequest(quint64 id, const DTK_CORE_NAMESPACE::DError &err);
+    // Marks the startStreamSynthesis() stream as over and gives its scheduler slot back, mtx is held.
+    void endCurrentStream();
     
 public Q_SLOTS:
     void onSynthesisResult(const QString &streamSessionId, const QByteArray &audioData);
     void onSynthesisError(const QString &streamSessionId, int errorCode, const QString &errorMessage);
     void onSynthesisCompleted(const QString &streamSessionId, const QByteArray &finalAudio);
+    void onDaemonStopped();
     
 public:
-    QMutex mtx;
+    mutable QMutex mtx;
+    QSharedPointer<DAIHandlerGuard> handlers { new DAIHandlerGuard };
     bool running = false;
-    DTK_CORE_NAMESPACE::DError error;
-    QScopedPointer<OrgDeepinAiDaemonSessionTextToSpeechInterface> ttsIfs;
+    DAIThreadError error;
+    QSharedPointer<OrgDeepinAiDaemonSessionTextToSpeechInterface> ttsIfs;
     QString sessionId;
+    quint64 sessionGeneration = 0;
     QString currentStreamSessionId;
+    quint64 currentStreamSlot = 0;
+    // Request id to stream session id, the daemon tags every stream signal with the latter.
+    QHash<quint64, QString> streams;
+    DAIRequestWatches watches;
     
 public:
     DTextToSpeech *q = nullptr;
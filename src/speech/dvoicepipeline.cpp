@@ -0,0 +1,409 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "speech/dvoicepipeline.h"
+#include "speech/dvoicepipeline_p.h"
+#include "speech/dspeechtotext.h"
+#include "speech/dtexttospeech.h"
+#include "nlp/dchatcompletions.h"
+#include "daierror.h"
+
+#include <algorithm>
+
+DCORE_USE_NAMESPACE
+DAI_USE_NAMESPACE
+
+// A reply running this long without a sentence end is cut at its last pause.
+static constexpr int kMaxSegment = 80;
+
+DVoicePipelinePrivate::DVoicePipelinePrivate(DVoicePipeline *parent)
+    : QObject()
+    , stt(new DSpeechToText(this))
+    , chat(new DChatCompletions(this))
+    , tts(new DTextToSpeech(this))
+    , error(NoError, "")
+    , q(parent)
+{
+    connect(stt, &DSpeechToText::requestRecognitionPartialResult, this, &DVoicePipelinePrivate::onRecognitionPartialResult);
+    connect(stt, &DSpeechToText::requestRecognitionCompleted, this, &DVoicePipelinePrivate::onRecognitionCompleted);
+    connect(stt, &DSpeechToText::requestRecognitionError, this, &DVoicePipelinePrivate::onRecognitionError);
+    connect(chat, &DChatCompletions::requestStreamOutput, this, &DVoicePipelinePrivate::onStreamOutput);
+    connect(chat, &DChatCompletions::requestStreamFinished, this, &DVoicePipelinePrivate::onStreamFinished);
+    connect(tts, &DTextToSpeech::requestSynthesisResult, this, &DVoicePipelinePrivate::onSynthesisResult);
+    connect(tts, &DTextToSpeech::requestSynthesisCompleted, this, &DVoicePipelinePrivate::onSynthesisCompleted);
+    connect(tts, &DTextToSpeech::requestSynthesisError, this, &DVoicePipelinePrivate::onSynthesisError);
+}
+
+QStringList DVoicePipelinePrivate::takeSentences(QString *buffer)
+{
+    static const QString ends = QStringLiteral("。！？；!?;\n");
+    static const QString pauses = QStringLiteral("，、：,:");
+
+    QStringList ret;
+    int start = 0;
+    for (int i = 0; i < buffer->size(); ++i) {
+        const QChar c = buffer->at(i);
+        // A period ends a sentence only before a space, not in 3.14 or a file name.
+        const bool end = ends.contains(c) || (c == '.' && i + 1 < buffer->size() && buffer->at(i + 1).isSpace());
+        if (!end)
+            continue;
+
+        const QString sentence = buffer->mid(start, i + 1 - start).trimmed();
+        if (!sentence.isEmpty())
+            ret.append(sentence);
+        start = i + 1;
+    }
+    buffer->remove(0, start);
+
+    if (buffer->size() >= kMaxSegment) {
+        for (int i = buffer->size() - 1; i > 0; --i) {
+            if (pauses.contains(buffer->at(i))) {
+                ret.append(buffer->left(i + 1).trimmed());
+                buffer->remove(0, i + 1);
+                break;
+            }
+        }
+    }
+    return ret;
+}
+
+void DVoicePipelinePrivate::beginTurn()
+{
+    running = true;
+    error = DError(NoError, "");
+    latency = DVoicePipeline::Latency();
+    speechEnded.invalidate();
+    recognized.invalidate();
+    recognitionId = 0;
+    chatId = 0;
+    chatDone = false;
+    prompt.clear();
+    reply.clear();
+    buffer.clear();
+    segments.clear();
+}
+
+void DVoicePipelinePrivate::startChat(const QString &text)
+{
+    latency.recognition = speechEnded.elapsed();
+    recognized.start();
+    prompt = text;
+
+    chatId = chat->startChatStream(text, history, chatParams);
+    if (chatId == 0) {
+        const DError err = chat->lastError();
+        finishTurn(err.getErrorCode() != NoError ? err.getErrorCode() : int(AIErrorCode::APIServerNotAvailable), err.getErrorMessage());
+    }
+}
+
+void DVoicePipelinePrivate::synthesize(const QString &sentence)
+{
+    if (!running)
+        return;
+
+    if (latency.firstSentence < 0)
+        latency.firstSentence = recognized.elapsed();
+
+    Segment segment;
+    segment.id = tts->startSynthesisStream(sentence, synthesisParams);
+    if (segment.id == 0) {
+        const DError err = tts->lastError();
+        finishTurn(err.getErrorCode() != NoError ? err.getErrorCode() : int(AIErrorCode::APIServerNotAvailable), err.getErrorMessage());
+        return;
+    }
+    segments.append(segment);
+}
+
+void DVoicePipelinePrivate::emitAudio(const QByteArray &audioData)
+{
+    if (latency.firstAudio < 0)
+        latency.firstAudio = speechEnded.elapsed();
+
+    emit q->audioOutput(audioData);
+}
+
+void DVoicePipelinePrivate::finishTurn(int err, const QString &message)
+{
+    if (!running)
+        return;
+
+    // Terminating a stage may report back synchronously, that must not end the turn twice.
+    running = false;
+    if (err != NoError)
+        terminateStages();
+
+    error = DError(err, message);
+    recognitionId = 0;
+    chatId = 0;
+    segments.clear();
+    emit q->finished(err);
+}
+
+void DVoicePipelinePrivate::tryFinish()
+{
+    if (!running || !chatDone || !segments.isEmpty())
+        return;
+
+    latency.total = speechEnded.elapsed();
+    history.append({ kChatRoleUser, prompt });
+    history.append({ kChatRoleAssistant, reply });
+    finishTurn(NoError, "");
+}
+
+void DVoicePipelinePrivate::terminateStages()
+{
+    if (recognitionId)
+        stt->terminateRequest(recognitionId);
+    if (chatId && !chatDone)
+        chat->terminateRequest(chatId);
+    for (const Segment &segment : qAsConst(segments)) {
+        if (!segment.done)
+            tts->terminateRequest(segment.id);
+    }
+}
+
+void DVoicePipelinePrivate::onRecognitionPartialResult(quint64 id, const QString &text)
+{
+    if (running && id == recognitionId)
+        emit q->partialRecognized(text);
+}
+
+void DVoicePipelinePrivate::onRecognitionCompleted(quint64 id, const QString &text)
+{
+    if (!running || id != recognitionId)
+        return;
+
+    // The daemon detected the end of speech itself.
+    recognitionId = 0;
+    speechEnded.start();
+    emit q->recognized(text);
+    if (text.trimmed().isEmpty()) {
+        finishTurn(NoError, "");
+        return;
+    }
+    startChat(text);
+}
+
+void DVoicePipelinePrivate::onRecognitionError(quint64 id, int errorCode, const QString &errorMessage)
+{
+    if (!running || id != recognitionId)
+        return;
+
+    recognitionId = 0;
+    finishTurn(errorCode, errorMessage);
+}
+
+void DVoicePipelinePrivate::onStreamOutput(quint64 id, const QString &content)
+{
+    if (!running || id != chatId)
+        return;
+
+    if (latency.firstToken < 0)
+        latency.firstToken = recognized.elapsed();
+
+    reply += content;
+    emit q->replyOutput(content);
+
+    buffer += content;
+    for (const QString &sentence : takeSentences(&buffer))
+        synthesize(sentence);
+}
+
+void DVoicePipelinePrivate::onStreamFinished(quint64 id, int err)
+{
+    if (!running || id != chatId)
+        return;
+
+    chatDone = true;
+    if (err != NoError) {
+        finishTurn(err, chat->lastError().getErrorMessage());
+        return;
+    }
+
+    latency.chat = recognized.elapsed();
+    const QString rest = buffer.trimmed();
+    buffer.clear();
+    if (!rest.isEmpty())
+        synthesize(rest);
+    tryFinish();
+}
+
+void DVoicePipelinePrivate::onSynthesisResult(quint64 id, const QByteArray &audioData)
+{
+    for (int i = 0; running && i < segments.size(); ++i) {
+        if (segments.at(i).id != id)
+            continue;
+
+        if (i == 0)
+            emitAudio(audioData);
+        else
+            segments[i].pending.append(audioData);
+        return;
+    }
+}
+
+void DVoicePipelinePrivate::onSynthesisCompleted(quint64 id, const QByteArray &finalAudio)
+{
+    Q_UNUSED(finalAudio)
+    auto it = std::find_if(segments.begin(), segments.end(), [id](const Segment &segment) {
+        return segment.id == id;
+    });
+    if (!running || it == segments.end())
+        return;
+
+    it->done = true;
+    // The next sentence in line speaks now, with what it synthesized while waiting.
+    while (!segments.isEmpty() && segments.first().done) {
+        segments.removeFirst();
+        if (!segments.isEmpty() && !segments.first().pending.isEmpty()) {
+            emitAudio(segments.first().pending);
+            segments.first().pending.clear();
+        }
+    }
+    tryFinish();
+}
+
+void DVoicePipelinePrivate::onSynthesisError(quint64 id, int errorCode, const QString &errorMessage)
+{
+    for (const Segment &segment : qAsConst(segments)) {
+        if (segment.id == id) {
+            finishTurn(errorCode, errorMessage);
+            return;
+        }
+    }
+}
+
+DVoicePipeline::DVoicePipeline(QObject *parent)
+    : QObject(parent)
+    , d(new DVoicePipelinePrivate(this))
+{
+
+}
+
+DVoicePipeline::~DVoicePipeline()
+{
+    if (d->running) {
+        d->running = false;
+        d->terminateStages();
+    }
+}
+
+DSpeechToText *DVoicePipeline::speechToText() const
+{
+    return d->stt;
+}
+
+DChatCompletions *DVoicePipeline::chatCompletions() const
+{
+    return d->chat;
+}
+
+DTextToSpeech *DVoicePipeline::textToSpeech() const
+{
+    return d->tts;
+}
+
+void DVoicePipeline::setRecognitionParams(const QVariantHash &params)
+{
+    d->recognitionParams = params;
+}
+
+void DVoicePipeline::setChatParams(const QVariantHash &params)
+{
+    d->chatParams = DAIEncodedParams(params);
+}
+
+void DVoicePipeline::setSynthesisParams(const QVariantHash &params)
+{
+    d->synthesisParams = DAIEncodedParams(params);
+}
+
+void DVoicePipeline::setHistory(const QList<ChatHistory> &history)
+{
+    d->history = history;
+}
+
+QList<ChatHistory> DVoicePipeline::history() const
+{
+    return d->history;
+}
+
+bool DVoicePipeline::start()
+{
+    if (d->running)
+        return false;
+
+    d->beginTurn();
+    d->recognitionId = d->stt->startRecognitionStream(d->recognitionParams);
+    if (d->recognitionId == 0) {
+        d->running = false;
+        d->error = d->stt->lastError();
+        return false;
+    }
+    return true;
+}
+
+bool DVoicePipeline::sendAudio(const QByteArray &audioData)
+{
+    if (!d->running || d->recognitionId == 0)
+        return false;
+
+    return d->stt->sendStreamAudio(d->recognitionId, audioData);
+}
+
+bool DVoicePipeline::endSpeech()
+{
+    if (!d->running || d->recognitionId == 0)
+        return false;
+
+    d->speechEnded.start();
+    const quint64 id = d->recognitionId;
+    d->recognitionId = 0;
+    const QString text = d->stt->endRecognitionStream(id);
+    const DError err = d->stt->lastError();
+    if (err.getErrorCode() != NoError) {
+        d->finishTurn(err.getErrorCode(), err.getErrorMessage());
+        return false;
+    }
+
+    emit recognized(text);
+    if (text.trimmed().isEmpty()) {
+        d->finishTurn(NoError, "");
+        return true;
+    }
+
+    d->startChat(text);
+    return d->running;
+}
+
+bool DVoicePipeline::respond(const QString &text)
+{
+    if (d->running || text.trimmed().isEmpty())
+        return false;
+
+    d->beginTurn();
+    d->speechEnded.start();
+    d->startChat(text);
+    return d->running;
+}
+
+void DVoicePipeline::stop()
+{
+    d->finishTurn(AIErrorCode::RequestCancelled, "Pipeline stopped");
+}
+
+bool DVoicePipeline::isRunning() const
+{
+    return d->running;
+}
+
+DVoicePipeline::Latency DVoicePipeline::latency() const
+{
+    return d->latency;
+}
+
+DError DVoicePipeline::lastError() const
+{
+    return d->error;
+}
@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef DVOICEPIPELINE_P_H
+#define DVOICEPIPELINE_P_H
+
+#include "speech/dvoicepipeline.h"
+#include "daiencodedparams.h"
+
+#include <QElapsedTimer>
+#include <QList>
+
+DAI_BEGIN_NAMESPACE
+
+class DVoicePipelinePrivate : public QObject
+{
+    Q_OBJECT
+public:
+    // A sentence of the reply in synthesis, audio of a sentence that is not
+    // the first in line waits until those before it are done.
+    struct Segment
+    {
+        quint64 id = 0;
+        QByteArray pending;
+        bool done = false;
+    };
+
+    explicit DVoicePipelinePrivate(DVoicePipeline *q);
+
+    // Cuts the complete sentences off the front of buffer.
+    static QStringList takeSentences(QString *buffer);
+
+    void beginTurn();
+    void startChat(const QString &text);
+    void synthesize(const QString &sentence);
+    void emitAudio(const QByteArray &audioData);
+    void finishTurn(int err, const QString &message);
+    // Ends the turn once the reply is complete and all of it was spoken.
+    void tryFinish();
+    // Stops whatever still runs in the daemon.
+    void terminateStages();
+
+public Q_SLOTS:
+    void onRecognitionPartialResult(quint64 id, const QString &text);
+    void onRecognitionCompleted(quint64 id, const QString &text);
+    void onRecognitionError(quint64 id, int errorCode, const QString &errorMessage);
+    void onStreamOutput(quint64 id, const QString &content);
+    void onStreamFinished(quint64 id, int err);
+    void onSynthesisResult(quint64 id, const QByteArray &audioData);
+    void onSynthesisCompleted(quint64 id, const QByteArray &finalAudio);
+    void onSynthesisError(quint64 id, int errorCode, const QString &errorMessage);
+
+public:
+    DSpeechToText *stt = nullptr;
+    DChatCompletions *chat = nullptr;
+    DTextToSpeech *tts = nullptr;
+
+    QVariantHash recognitionParams;
+    // Sent with every turn and every sentence, encoded once.
+    DAIEncodedParams chatParams;
+    DAIEncodedParams synthesisParams;
+    QList<ChatHistory> history;
+
+    bool running = false;
+    DTK_CORE_NAMESPACE::DError error;
+    DVoicePipeline::Latency latency;
+    // Started at the end of speech, and at the final recognition.
+    QElapsedTimer speechEnded;
+    QElapsedTimer recognized;
+
+    quint64 recognitionId = 0;
+    quint64 chatId = 0;
+    bool chatDone = false;
+    QString prompt;
+    QString reply;
+    QString buffer;
+    QList<Segment> segments;
+
+    DVoicePipeline *q = nullptr;
+};
+
+DAI_END_NAMESPACE
+
+#endif // DVOICEPIPELINE_P_H
@@ -5,6 +5,13 @@
 #include "vision/dimagerecognition.h"
 #include "dimagerecognition_p.h"
 #include "aidaemon_sessionmanager.h"
+#include "dsessionpool.h"
+#include "daiasync_p.h"
+#include "dairequestoptions_p.h"
+#include "daischeduler_p.h"
+#include "dairetrypolicy_p.h"
+#include "daiencodedparams_p.h"
+#include "daifdpayload_p.h"
 #include "daierror.h"
 
 #include <QDBusConnection>
@@ -27,26 +34,43 @@ DImageRecognitionPrivate::DImageRecognitionPrivate(DImageRecognition *parent)
 
 DImageRecognitionPrivate::~DImageRecognitionPrivate()
 {
+    // Requests still in flight hold their scheduler slots.
+    for (quint64 id : calls.keys())
+        DAISchedulerPrivate::finish(id);
+
     if (imageIfs && !sessionId.isEmpty()) {
-        imageIfs->terminate();
+        // Leave the session clean for the next lease.
+        if (!calls.isEmpty())
+            imageIfs->terminate();
+
+        imageIfs.reset(nullptr);
+        DSessionPool::instance()->release("ImageRecognition", sessionId);
     }
 }
 
 bool DImageRecognitionPrivate::ensureServer()
 {
-    if (imageIfs.isNull() || !imageIfs->isValid()) {
-        QDBusConnection con = QDBusConnection::sessionBus();
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", con);
-        if (!sessionManager.isValid())
-            return false;
+    if (!DAICircuitBreaker::instance()->allowRequest())
+        return false;
 
-        sessionId = sessionManager.CreateSession("ImageRecognition");
+    // A session from before a daemon restart is gone even if the proxy looks fine.
+    const quint64 generation = DSessionPool::instance()->generation();
+    if (imageIfs.isNull() || !imageIfs->isValid() || sessionGeneration != generation) {
+        if (!sessionId.isEmpty()) {
+            imageIfs.reset(nullptr);
+            DSessionPool::instance()->discard("ImageRecognition", sessionId);
+            sessionId.clear();
+        }
+
+        sessionId = DSessionPool::instance()->acquire("ImageRecognition");
         if (sessionId.isEmpty())
             return false;
+        sessionGeneration = generation;
 
         QString sessionPath = QString("/org/deepin/ai/daemon/Session/%1").arg(sessionId);
-        imageIfs.reset(new OrgDeepinAiDaemonSessionImageRecognitionInterface(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(), sessionPath, con));
+        QDBusConnection con = DAITransportPrivate::sessionConnection();
+        imageIfs = DAIProxyDeleter::shared(new OrgDeepinAiDaemonSessionImageRecognitionInterface(DAITransportPrivate::serviceName(con), sessionPath, con));
+        DAITransportPrivate::adopt(imageIfs.data());
         imageIfs->setTimeout(REQ_TIMEOUT);
     }
 
@@ -55,18 +79,144 @@ bool DImageRecognitionPrivate::ensureServer()
 
 QString DImageRecognitionPrivate::packageParams(const QVariantHash &params)
 {
-    QVariantHash root;
-    
-    // Merge user-provided parameters
-    for (auto it = params.begin(); it != params.end(); ++it) {
-        root.insert(it.key(), it.value());
+    return QString::fromUtf8(DAIParamsCache::encode(params));
+}
+
+QString DImageRecognitionPrivate::parseResult(const QString &result, DError *error)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(result.toUtf8(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        *error = DError(AIErrorCode::ResponseParseError, parseError.errorString());
+        return QString();
     }
 
-    QString ret = QString::fromUtf8(QJsonDocument::fromVariant(root).toJson(QJsonDocument::Compact));
+    QJsonObject obj = doc.object();
+    if (obj.contains("error") && obj["error"].toBool()) {
+        *error = DError(obj["error_code"].toInt(), obj["error_message"].toString());
+        return QString();
+    }
+
+    *error = DError(NoError, "");
+    return obj["content"].toString();
+}
+
+QDBusPendingReply<QString> DImageRecognitionPrivate::sendImageData(const QByteArray &imageData, const QString &prompt,
+                                                                  const QVariantHash &params)
+{
+    if (DAIFdPayload::preferred(imageIfs.data(), "recognizeImageDataFd", imageData.size())) {
+        QDBusUnixFileDescriptor imageFd = DAIFdPayload::fromData(imageData);
+        if (imageFd.isValid())
+            return imageIfs->recognizeImageDataFd(imageFd, prompt, packageParams(params));
+    }
+
+    return imageIfs->recognizeImageData(imageData, prompt, packageParams(params));
+}
+
+QString DImageRecognitionPrivate::waitResult(QDBusPendingReply<QString> reply, DAICallMetric &metric,
+                                            const DAIRequestOptions &options)
+{
+    reply.waitForFinished();
+    // The caller gave up, which says nothing about the daemon.
+    if (reply.isError() && options.deadline.hasExpired()) {
+        QMutexLocker lk(&mtx);
+        error = deadlineExceededError();
+        return QString();
+    }
+
+    recordCallResult(reply);
+    DError err(NoError, "");
+    QString ret;
+    if (reply.isError()) {
+        err = pendingCallError(reply);
+    } else {
+        metric.addReceived(reply.value());
+        ret = parseResult(reply.value(), &err);
+    }
+
+    QMutexLocker lk(&mtx);
+    error = err;
     return ret;
 }
 
+quint64 DImageRecognitionPrivate::watchResult(const char *series, qint64 sent, const std::function<QDBusPendingCall()> &send,
+                                              const DAIReplyCallback<QString> &callback, const DAIRequestOptions &options)
+{
+    const quint64 id = nextRequestId();
+    {
+        QMutexLocker lk(&mtx);
+        calls.insert(id, callback);
+    }
+    DAIMetricsPrivate::begin(id, QString::fromLatin1(series), sent);
+
+    // The deadline is enforced by the watch, a late reply is dropped below.
+    watches.watch(id, options, this, [this, id](const DError &err) {
+        abortRequest(id, err);
+    });
+
+    DAISchedulerPrivate::submit(id, "ImageRecognition", options, this, [this, id, send]() {
+        QMutexLocker lk(&mtx);
+        // Aborted while it was queued.
+        if (!calls.contains(id))
+            return;
+
+        // The daemon may have restarted while the request was queued.
+        if (!ensureServer()) {
+            lk.unlock();
+            abortRequest(id, DError(AIErrorCode::APIServerNotAvailable, ""));
+            return;
+        }
+
+        QDBusPendingCall call = send();
+        lk.unlock();
+
+        watchPendingCall(call, this, [this, id](const QDBusPendingCall &reply) {
+            DError err = pendingCallError(reply);
+            QString result;
+            if (err.getErrorCode() == NoError)
+                result = parseResult(QDBusPendingReply<QString>(reply).value(), &err);
+
+            QMutexLocker lk(&mtx);
+            // Already handled by terminateRequest().
+            if (!calls.contains(id))
+                return;
+
+            DAIReplyCallback<QString> callback = calls.take(id);
+            error.publish(err);
+            lk.unlock();
+
+            watches.release(id);
+            DAISchedulerPrivate::finish(id);
+            DAIMetricsPrivate::end(id, err.getErrorCode(), DAIMetricsPrivate::utf8Size(result));
+            if (callback)
+                callback(result, err);
+        });
+    });
+    return id;
+}
+
+void DImageRecognitionPrivate::abortRequest(quint64 id, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    if (!calls.contains(id))
+        return;
+
+    // The session is shared, only stop the daemon when nothing else runs on it.
+    DAIReplyCallback<QString> callback = calls.take(id);
+    const bool idle = calls.isEmpty();
+    const QSharedPointer<OrgDeepinAiDaemonSessionImageRecognitionInterface> ifs = imageIfs;
+    error.publish(err);
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err.getErrorCode());
+    if (idle && ifs)
+        ifs->terminate();
 
+    if (callback)
+        callback(QString(), err);
+}
 
 DImageRecognition::DImageRecognition(QObject *parent)
     : QObject(parent)
@@ -78,13 +228,9 @@ DImageRecognition::~DImageRecognition()
 {
 }
 
-QString DImageRecognition::recognizeImage(const QString &imagePath, const QString &prompt, const QVariantHash &params)
+QString DImageRecognition::recognizeImage(const QString &imagePath, const QString &prompt, const QVariantHash &params,
+                                          const DAIRequestOptions &options)
 {
-    if (!d->ensureServer()) {
-        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
-        return QString();
-    }
-    
     if (imagePath.isEmpty()) {
         d->error = DError(AIErrorCode::InvalidParameter, "Empty image path");
         return QString();
@@ -102,141 +248,211 @@ QString DImageRecognition::recognizeImage(const QString &imagePath, const QStrin
         return QString();
     }
     
-    QMutexLocker lk(&d->mtx);
-    d->running = true;
-    d->error = DError(NoError, "");
-    
-    QString ret = d->imageIfs->recognizeImage(imagePath, prompt, d->packageParams(params));
-    
-    // Parse result
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(ret.toUtf8(), &error);
-    if (error.error != QJsonParseError::NoError) {
-        d->error = DError(AIErrorCode::ResponseParseError, error.errorString());
-        d->running = false;
-        return QString();
-    }
-    
-    QJsonObject obj = doc.object();
-    if (obj.contains("error") && obj["error"].toBool()) {
-        int errorCode = obj["error_code"].toInt();
-        QString errorMessage = obj["error_message"].toString();
-        d->error = DError(errorCode, errorMessage);
-        d->running = false;
+    DAICallMetric metric("DImageRecognition.recognizeImage", &d->error);
+    const QString packed = d->packageParams(params);
+    metric.addSent(imagePath);
+    metric.addSent(prompt);
+    metric.addSent(packed);
+
+    DAISchedulerSlot slot("ImageRecognition", options);
+    if (slot.error().getErrorCode() != NoError) {
+        d->error = slot.error();
         return QString();
     }
-    
-    d->running = false;
-    return obj["content"].toString();
-}
 
-QString DImageRecognition::recognizeImageData(const QByteArray &imageData, const QString &prompt, const QVariantHash &params)
-{
+    // Only the issue is serialized, concurrent calls are told apart by their reply serial.
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return QString();
     }
-    
+
+    d->imageIfs->setTimeout(requestTimeout(options, REQ_TIMEOUT));
+    QDBusPendingReply<QString> reply = d->imageIfs->recognizeImage(imagePath, prompt, packed);
+    d->imageIfs->setTimeout(REQ_TIMEOUT);
+    lk.unlock();
+
+    return d->waitResult(reply, metric, options);
+}
+
+QString DImageRecognition::recognizeImageData(const QByteArray &imageData, const QString &prompt, const QVariantHash &params,
+                                              const DAIRequestOptions &options)
+{
     if (imageData.isEmpty()) {
         d->error = DError(AIErrorCode::InvalidParameter, "Empty image data");
         return QString();
     }
     
-    QMutexLocker lk(&d->mtx);
-    d->running = true;
-    d->error = DError(NoError, "");
-    
-    QString ret = d->imageIfs->recognizeImageData(imageData, prompt, d->packageParams(params));
-    
-    // Parse result
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(ret.toUtf8(), &error);
-    if (error.error != QJsonParseError::NoError) {
-        d->error = DError(AIErrorCode::ResponseParseError, error.errorString());
-        d->running = false;
-        return QString();
-    }
-    
-    QJsonObject obj = doc.object();
-    if (obj.contains("error") && obj["error"].toBool()) {
-        int errorCode = obj["error_code"].toInt();
-        QString errorMessage = obj["error_message"].toString();
-        d->error = DError(errorCode, errorMessage);
-        d->running = false;
+    DAICallMetric metric("DImageRecognition.recognizeImageData", &d->error);
+    metric.addSent(imageData.size());
+    metric.addSent(prompt);
+
+    DAISchedulerSlot slot("ImageRecognition", options);
+    if (slot.error().getErrorCode() != NoError) {
+        d->error = slot.error();
         return QString();
     }
-    
-    d->running = false;
-    return obj["content"].toString();
-}
 
-QString DImageRecognition::recognizeImageUrl(const QString &imageUrl, const QString &prompt, const QVariantHash &params)
-{
+    // Only the issue is serialized, concurrent calls are told apart by their reply serial.
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return QString();
     }
-    
+
+    d->imageIfs->setTimeout(requestTimeout(options, REQ_TIMEOUT));
+    QDBusPendingReply<QString> reply = d->sendImageData(imageData, prompt, params);
+    d->imageIfs->setTimeout(REQ_TIMEOUT);
+    lk.unlock();
+
+    return d->waitResult(reply, metric, options);
+}
+
+QString DImageRecognition::recognizeImageUrl(const QString &imageUrl, const QString &prompt, const QVariantHash &params,
+                                             const DAIRequestOptions &options)
+{
     if (imageUrl.isEmpty()) {
         d->error = DError(AIErrorCode::InvalidParameter, "Empty image URL");
         return QString();
     }
     
-    QMutexLocker lk(&d->mtx);
-    d->running = true;
-    d->error = DError(NoError, "");
-    
-    QString ret = d->imageIfs->recognizeImageUrl(imageUrl, prompt, d->packageParams(params));
-    
-    // Parse result
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(ret.toUtf8(), &error);
-    if (error.error != QJsonParseError::NoError) {
-        d->error = DError(AIErrorCode::ResponseParseError, error.errorString());
-        d->running = false;
+    DAICallMetric metric("DImageRecognition.recognizeImageUrl", &d->error);
+    const QString packed = d->packageParams(params);
+    metric.addSent(imageUrl);
+    metric.addSent(prompt);
+    metric.addSent(packed);
+
+    DAISchedulerSlot slot("ImageRecognition", options);
+    if (slot.error().getErrorCode() != NoError) {
+        d->error = slot.error();
         return QString();
     }
-    
-    QJsonObject obj = doc.object();
-    if (obj.contains("error") && obj["error"].toBool()) {
-        int errorCode = obj["error_code"].toInt();
-        QString errorMessage = obj["error_message"].toString();
-        d->error = DError(errorCode, errorMessage);
-        d->running = false;
+
+    // Only the issue is serialized, concurrent calls are told apart by their reply serial.
+    QMutexLocker lk(&d->mtx);
+    if (!d->ensureServer()) {
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return QString();
     }
-    
-    d->running = false;
-    return obj["content"].toString();
+
+    d->imageIfs->setTimeout(requestTimeout(options, REQ_TIMEOUT));
+    QDBusPendingReply<QString> reply = d->imageIfs->recognizeImageUrl(imageUrl, prompt, packed);
+    d->imageIfs->setTimeout(REQ_TIMEOUT);
+    lk.unlock();
+
+    return d->waitResult(reply, metric, options);
+}
+
+quint64 DImageRecognition::recognizeImageAsync(const QString &imagePath, const DAIReplyCallback<QString> &callback,
+                                               const QString &prompt, const QVariantHash &params, const DAIRequestOptions &options)
+{
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return 0;
+
+    QMutexLocker lk(&d->mtx);
+    if (!d->ensureServer()) {
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
+        return 0;
+    }
+    lk.unlock();
+
+    if (imagePath.isEmpty()) {
+        d->error = DError(AIErrorCode::InvalidParameter, "Empty image path");
+        return 0;
+    }
+
+    QFileInfo fileInfo(imagePath);
+    if (!fileInfo.isAbsolute()) {
+        d->error = DError(AIErrorCode::InvalidParameter, "Relative path not allowed for security reasons");
+        return 0;
+    }
+
+    if (!fileInfo.exists()) {
+        d->error = DError(AIErrorCode::InvalidParameter, "Image file does not exist");
+        return 0;
+    }
+
+    const QString packed = d->packageParams(params);
+    const qint64 sent = DAIMetricsPrivate::utf8Size(imagePath) + DAIMetricsPrivate::utf8Size(prompt)
+            + DAIMetricsPrivate::utf8Size(packed);
+    return d->watchResult("DImageRecognition.recognizeImageAsync", sent, [this, imagePath, prompt, packed]() {
+        return d->imageIfs->recognizeImage(imagePath, prompt, packed);
+    }, callback, options);
 }
 
-QStringList DImageRecognition::getSupportedImageFormats()
+quint64 DImageRecognition::recognizeImageDataAsync(const QByteArray &imageData, const DAIReplyCallback<QString> &callback,
+                                                   const QString &prompt, const QVariantHash &params, const DAIRequestOptions &options)
 {
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return 0;
+
+    QMutexLocker lk(&d->mtx);
+    if (!d->ensureServer()) {
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
+        return 0;
+    }
+    lk.unlock();
+
+    if (imageData.isEmpty()) {
+        d->error = DError(AIErrorCode::InvalidParameter, "Empty image data");
+        return 0;
+    }
+
+    const qint64 sent = imageData.size() + DAIMetricsPrivate::utf8Size(prompt);
+    return d->watchResult("DImageRecognition.recognizeImageDataAsync", sent, [this, imageData, prompt, params]() {
+        return d->sendImageData(imageData, prompt, params);
+    }, callback, options);
+}
+
+QStringList DImageRecognition::getSupportedImageFormats(const DAIRequestOptions &options)
+{
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return QStringList();
+
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return QStringList();
     }
-    
-    return d->imageIfs->getSupportedImageFormats();
+
+    // The copy keeps the proxy alive should another thread replace the session meanwhile.
+    const QSharedPointer<OrgDeepinAiDaemonSessionImageRecognitionInterface> ifs = d->imageIfs;
+    lk.unlock();
+
+    return callWithRetry([&ifs]() { return ifs->getSupportedImageFormats(); }, options, ifs.data(), &d->mtx);
 }
 
-int DImageRecognition::getMaxImageSize()
+int DImageRecognition::getMaxImageSize(const DAIRequestOptions &options)
 {
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return 0;
+
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return 0;
     }
-    
-    return d->imageIfs->getMaxImageSize();
+
+    const QSharedPointer<OrgDeepinAiDaemonSessionImageRecognitionInterface> ifs = d->imageIfs;
+    lk.unlock();
+
+    return callWithRetry([&ifs]() { return ifs->getMaxImageSize(); }, options, ifs.data(), &d->mtx);
 }
 
 void DImageRecognition::terminate()
 {
+    QMutexLocker lk(&d->mtx);
     if (d->imageIfs)
         d->imageIfs->terminate();
-        
-    QMutexLocker lk(&d->mtx);
-    d->running = false;
+}
+
+void DImageRecognition::terminateRequest(quint64 requestId)
+{
+    d->abortRequest(requestId, DError(AIErrorCode::RequestCancelled, "Request terminated"));
 }
 
 DError DImageRecognition::lastError() const
@@ -7,6 +7,12 @@
 
 #include "vision/dimagerecognition.h"
 #include "aidaemon_apisession_imagerecognition.h"
+#include "daitransport_p.h"
+#include "dairequestoptions_p.h"
+#include "daithreaderror_p.h"
+#include "daimetrics_p.h"
+
+#include <QHash>
 
 DAI_BEGIN_NAMESPACE
 
@@ -18,15 +24,23 @@ public:
     ~DImageRecognitionPrivate();
     bool ensureServer();
     static QString packageParams(const QVariantHash &params);
-    
+    static QString parseResult(const QString &result, DTK_CORE_NAMESPACE::DError *error);
+    QDBusPendingReply<QString> sendImageData(const QByteArray &imageData, const QString &prompt, const QVariantHash &params);
+    QString waitResult(QDBusPendingReply<QString> reply, DAICallMetric &metric, const DAIRequestOptions &options);
+    // Sends the call once DAIScheduler admits the request, the request records into series.
+    quint64 watchResult(const char *series, qint64 sent, const std::function<QDBusPendingCall()> &send,
+                        const DAIReplyCallback<QString> &callback, const DAIRequestOptions &options);
+    // Stops a request in the daemon and finishes it with err.
+    void abortRequest(quint64 id, const DTK_CORE_NAMESPACE::DError &err);
 
-    
 public:
     QMutex mtx;
-    bool running = false;
-    DTK_CORE_NAMESPACE::DError error;
-    QScopedPointer<OrgDeepinAiDaemonSessionImageRecognitionInterface> imageIfs;
+    DAIThreadError error;
+    QSharedPointer<OrgDeepinAiDaemonSessionImageRecognitionInterface> imageIfs;
     QString sessionId;
+    quint64 sessionGeneration = 0;
+    QHash<quint64, DAIReplyCallback<QString>> calls;
+    DAIRequestWatches watches;
     
 public:
     DImageRecognition *q = nullptr;
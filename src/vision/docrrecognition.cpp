@@ -5,6 +5,13 @@
 #include "vision/docrrecognition.h"
 #include "docrrecognition_p.h"
 #include "aidaemon_sessionmanager.h"
+#include "dsessionpool.h"
+#include "daiasync_p.h"
+#include "dairequestoptions_p.h"
+#include "daischeduler_p.h"
+#include "dairetrypolicy_p.h"
+#include "daiencodedparams_p.h"
+#include "daifdpayload_p.h"
 #include "daierror.h"
 
 #include <QDBusConnection>
@@ -26,26 +33,43 @@ DOCRRecognitionPrivate::DOCRRecognitionPrivate(DOCRRecognition *parent)
 
 DOCRRecognitionPrivate::~DOCRRecognitionPrivate()
 {
+    // Requests still in flight hold their scheduler slots.
+    for (quint64 id : calls.keys())
+        DAISchedulerPrivate::finish(id);
+
     if (ocrIfs && !sessionId.isEmpty()) {
-        ocrIfs->terminate();
+        // Leave the session clean for the next lease.
+        if (!calls.isEmpty())
+            ocrIfs->terminate();
+
+        ocrIfs.reset(nullptr);
+        DSessionPool::instance()->release("OCR", sessionId);
     }
 }
 
 bool DOCRRecognitionPrivate::ensureServer()
 {
-    if (ocrIfs.isNull() || !ocrIfs->isValid()) {
-        QDBusConnection con = QDBusConnection::sessionBus();
-        OrgDeepinAiDaemonSessionManagerInterface sessionManager(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(),
-                                                                "/org/deepin/ai/daemon/SessionManager", con);
-        if (!sessionManager.isValid())
-            return false;
+    if (!DAICircuitBreaker::instance()->allowRequest())
+        return false;
 
-        sessionId = sessionManager.CreateSession("OCR");
+    // A session from before a daemon restart is gone even if the proxy looks fine.
+    const quint64 generation = DSessionPool::instance()->generation();
+    if (ocrIfs.isNull() || !ocrIfs->isValid() || sessionGeneration != generation) {
+        if (!sessionId.isEmpty()) {
+            ocrIfs.reset(nullptr);
+            DSessionPool::instance()->discard("OCR", sessionId);
+            sessionId.clear();
+        }
+
+        sessionId = DSessionPool::instance()->acquire("OCR");
         if (sessionId.isEmpty())
             return false;
+        sessionGeneration = generation;
 
         QString sessionPath = QString("/org/deepin/ai/daemon/Session/%1").arg(sessionId);
-        ocrIfs.reset(new OrgDeepinAiDaemonSessionOCRInterface(OrgDeepinAiDaemonSessionManagerInterface::staticInterfaceName(), sessionPath, con));
+        QDBusConnection con = DAITransportPrivate::sessionConnection();
+        ocrIfs = DAIProxyDeleter::shared(new OrgDeepinAiDaemonSessionOCRInterface(DAITransportPrivate::serviceName(con), sessionPath, con));
+        DAITransportPrivate::adopt(ocrIfs.data());
         ocrIfs->setTimeout(REQ_TIMEOUT);
     }
 
@@ -54,15 +78,166 @@ bool DOCRRecognitionPrivate::ensureServer()
 
 QString DOCRRecognitionPrivate::packageParams(const QVariantHash &params)
 {
-    QVariantHash root;
-    
-    // Merge user-provided parameters
-    for (auto it = params.begin(); it != params.end(); ++it) {
-        root.insert(it.key(), it.value());
+    return QString::fromUtf8(DAIParamsCache::encode(params));
+}
+
+QString DOCRRecognitionPrivate::parseResult(const QString &result, DError *error)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(result.toUtf8(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        *error = DError(AIErrorCode::ResponseParseError, parseError.errorString());
+        return QString();
+    }
+
+    QJsonObject obj = doc.object();
+    if (obj.contains("error") && obj["error"].toBool()) {
+        *error = DError(obj["error_code"].toInt(), obj["error_message"].toString());
+        return QString();
+    }
+
+    *error = DError(NoError, "");
+    return obj["text"].toString();
+}
+
+QDBusPendingReply<QString> DOCRRecognitionPrivate::sendImage(const QByteArray &imageData, const QVariantHash &params)
+{
+    if (DAIFdPayload::preferred(ocrIfs.data(), "recognizeImageFd", imageData.size())) {
+        QDBusUnixFileDescriptor imageFd = DAIFdPayload::fromData(imageData);
+        if (imageFd.isValid())
+            return ocrIfs->recognizeImageFd(imageFd, packageParams(params));
+    }
+
+    return ocrIfs->recognizeImage(imageData, packageParams(params));
+}
+
+DAISingleFlight *DOCRRecognitionPrivate::coalescing()
+{
+    static DAISingleFlight flight;
+    return &flight;
+}
+
+QString DOCRRecognitionPrivate::waitResult(const char *series, qint64 sent, const QString &key,
+                                          const std::function<QDBusPendingReply<QString>()> &send,
+                                          const DAIRequestOptions &options)
+{
+    DAICallMetric metric(series, &error);
+    using Result = QPair<QString, DError>;
+    Result result = coalescing()->run<Result>(key, [this, &send, &metric, &options, sent]() {
+        DAISchedulerSlot slot("OCR", options);
+        if (slot.error().getErrorCode() != NoError)
+            return Result(QString(), slot.error());
+
+        // Only the issue is serialized, concurrent calls are told apart by their reply serial.
+        QMutexLocker lk(&mtx);
+        if (!ensureServer())
+            return Result(QString(), DError(AIErrorCode::APIServerNotAvailable, ""));
+
+        ocrIfs->setTimeout(requestTimeout(options, REQ_TIMEOUT));
+        QDBusPendingReply<QString> reply = send();
+        ocrIfs->setTimeout(REQ_TIMEOUT);
+        lk.unlock();
+
+        reply.waitForFinished();
+        metric.addSent(sent);
+        // The caller gave up, which says nothing about the daemon.
+        if (reply.isError() && options.deadline.hasExpired())
+            return Result(QString(), deadlineExceededError());
+
+        recordCallResult(reply);
+        if (reply.isError())
+            return Result(QString(), pendingCallError(reply));
+
+        metric.addReceived(reply.value());
+        DError err(NoError, "");
+        QString ret = parseResult(reply.value(), &err);
+        return Result(ret, err);
+    }, [](const Result &shared) {
+        return !isRequestOptionsError(shared.second);
+    });
+
+    QMutexLocker lk(&mtx);
+    error = result.second;
+    return result.first;
+}
+
+quint64 DOCRRecognitionPrivate::watchResult(const char *series, qint64 sent, const std::function<QDBusPendingCall()> &send,
+                                            const DAIReplyCallback<QString> &callback, const DAIRequestOptions &options)
+{
+    const quint64 id = nextRequestId();
+    {
+        QMutexLocker lk(&mtx);
+        calls.insert(id, callback);
     }
+    DAIMetricsPrivate::begin(id, QString::fromLatin1(series), sent);
+
+    // The deadline is enforced by the watch, a late reply is dropped below.
+    watches.watch(id, options, this, [this, id](const DError &err) {
+        abortRequest(id, err);
+    });
+
+    DAISchedulerPrivate::submit(id, "OCR", options, this, [this, id, send]() {
+        QMutexLocker lk(&mtx);
+        // Aborted while it was queued.
+        if (!calls.contains(id))
+            return;
+
+        // The daemon may have restarted while the request was queued.
+        if (!ensureServer()) {
+            lk.unlock();
+            abortRequest(id, DError(AIErrorCode::APIServerNotAvailable, ""));
+            return;
+        }
+
+        QDBusPendingCall call = send();
+        lk.unlock();
 
-    QString ret = QString::fromUtf8(QJsonDocument::fromVariant(root).toJson(QJsonDocument::Compact));
-    return ret;
+        watchPendingCall(call, this, [this, id](const QDBusPendingCall &reply) {
+            DError err = pendingCallError(reply);
+            QString result;
+            if (err.getErrorCode() == NoError)
+                result = parseResult(QDBusPendingReply<QString>(reply).value(), &err);
+
+            QMutexLocker lk(&mtx);
+            // Already handled by terminateRequest().
+            if (!calls.contains(id))
+                return;
+
+            DAIReplyCallback<QString> callback = calls.take(id);
+            error.publish(err);
+            lk.unlock();
+
+            watches.release(id);
+            DAISchedulerPrivate::finish(id);
+            DAIMetricsPrivate::end(id, err.getErrorCode(), DAIMetricsPrivate::utf8Size(result));
+            if (callback)
+                callback(result, err);
+        });
+    });
+    return id;
+}
+
+void DOCRRecognitionPrivate::abortRequest(quint64 id, const DError &err)
+{
+    QMutexLocker lk(&mtx);
+    if (!calls.contains(id))
+        return;
+
+    // The session is shared, only stop the daemon when nothing else runs on it.
+    DAIReplyCallback<QString> callback = calls.take(id);
+    const bool idle = calls.isEmpty();
+    const QSharedPointer<OrgDeepinAiDaemonSessionOCRInterface> ifs = ocrIfs;
+    error.publish(err);
+    lk.unlock();
+
+    watches.release(id);
+    DAISchedulerPrivate::finish(id);
+    DAIMetricsPrivate::end(id, err.getErrorCode());
+    if (idle && ifs)
+        ifs->terminate();
+
+    if (callback)
+        callback(QString(), err);
 }
 
 // Note: Removed async signal handlers since using synchronous interface
@@ -77,93 +252,91 @@ DOCRRecognition::~DOCRRecognition()
 {
 }
 
-QString DOCRRecognition::recognizeFile(const QString &imageFile, const QVariantHash &params)
+QString DOCRRecognition::recognizeFile(const QString &imageFile, const QVariantHash &params,
+                                       const DAIRequestOptions &options)
 {
-    if (!d->ensureServer()) {
-        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
-        return QString();
-    }
-    
     if (imageFile.isEmpty()) {
         d->error = DError(AIErrorCode::InvalidParameter, "Empty image file path");
         return QString();
     }
     
-    QMutexLocker lk(&d->mtx);
-    d->running = true;
-    d->error = DError(NoError, "");
-    
-    QString ret = d->ocrIfs->recognizeFile(imageFile, d->packageParams(params));
-    
-    // Parse result
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(ret.toUtf8(), &error);
-    if (error.error != QJsonParseError::NoError) {
-        d->error = DError(AIErrorCode::ResponseParseError, error.errorString());
-        d->running = false;
-        return QString();
-    }
-    
-    QJsonObject obj = doc.object();
-    if (obj.contains("error") && obj["error"].toBool()) {
-        int errorCode = obj["error_code"].toInt();
-        QString errorMessage = obj["error_message"].toString();
-        d->error = DError(errorCode, errorMessage);
-        d->running = false;
-        return QString();
-    }
-    
-    d->running = false;
-    return obj["text"].toString();
+    const QString packed = d->packageParams(params);
+    const qint64 sent = DAIMetricsPrivate::utf8Size(imageFile) + DAIMetricsPrivate::utf8Size(packed);
+    return d->waitResult("DOCRRecognition.recognizeFile", sent, DAISingleFlight::key("recognizeFile", { imageFile, packed }), [&]() {
+        return d->ocrIfs->recognizeFile(imageFile, packed);
+    }, options);
 }
 
-QString DOCRRecognition::recognizeImage(const QByteArray &imageData, const QVariantHash &params)
+QString DOCRRecognition::recognizeImage(const QByteArray &imageData, const QVariantHash &params,
+                                        const DAIRequestOptions &options)
 {
-    if (!d->ensureServer()) {
-        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
-        return QString();
-    }
-    
     if (imageData.isEmpty()) {
         d->error = DError(AIErrorCode::InvalidParameter, "Empty image data");
         return QString();
     }
     
+    // Hashing the image is only worth it when the call may be coalesced.
+    QString key;
+    if (d->coalescing()->isEnabled())
+        key = DAISingleFlight::key("recognizeImage", { DAISingleFlight::digest(imageData), d->packageParams(params) });
+    return d->waitResult("DOCRRecognition.recognizeImage", imageData.size(), key, [&]() {
+        return d->sendImage(imageData, params);
+    }, options);
+}
+
+quint64 DOCRRecognition::recognizeFileAsync(const QString &imageFile, const DAIReplyCallback<QString> &callback,
+                                            const QVariantHash &params, const DAIRequestOptions &options)
+{
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return 0;
+
     QMutexLocker lk(&d->mtx);
-    d->running = true;
-    d->error = DError(NoError, "");
-    
-    QString ret = d->ocrIfs->recognizeImage(imageData, d->packageParams(params));
-    
-    // Parse result
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(ret.toUtf8(), &error);
-    if (error.error != QJsonParseError::NoError) {
-        d->error = DError(AIErrorCode::ResponseParseError, error.errorString());
-        d->running = false;
-        return QString();
+    if (!d->ensureServer()) {
+        d->error = DError(AIErrorCode::APIServerNotAvailable, "");
+        return 0;
     }
-    
-    QJsonObject obj = doc.object();
-    if (obj.contains("error") && obj["error"].toBool()) {
-        int errorCode = obj["error_code"].toInt();
-        QString errorMessage = obj["error_message"].toString();
-        d->error = DError(errorCode, errorMessage);
-        d->running = false;
-        return QString();
+    lk.unlock();
+
+    if (imageFile.isEmpty()) {
+        d->error = DError(AIErrorCode::InvalidParameter, "Empty image file path");
+        return 0;
     }
-    
-    d->running = false;
-    return obj["text"].toString();
+
+    const QString packed = d->packageParams(params);
+    const qint64 sent = DAIMetricsPrivate::utf8Size(imageFile) + DAIMetricsPrivate::utf8Size(packed);
+    return d->watchResult("DOCRRecognition.recognizeFileAsync", sent, [this, imageFile, packed]() {
+        return d->ocrIfs->recognizeFile(imageFile, packed);
+    }, callback, options);
 }
 
-QString DOCRRecognition::recognizeRegionFromString(const QString &imageFile, const QString &region, const QVariantHash &params)
+quint64 DOCRRecognition::recognizeImageAsync(const QByteArray &imageData, const DAIReplyCallback<QString> &callback,
+                                             const QVariantHash &params, const DAIRequestOptions &options)
 {
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return 0;
+
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
-        return QString();
+        return 0;
     }
-    
+    lk.unlock();
+
+    if (imageData.isEmpty()) {
+        d->error = DError(AIErrorCode::InvalidParameter, "Empty image data");
+        return 0;
+    }
+
+    return d->watchResult("DOCRRecognition.recognizeImageAsync", imageData.size(), [this, imageData, params]() {
+        return d->sendImage(imageData, params);
+    }, callback, options);
+}
+
+QString DOCRRecognition::recognizeRegionFromString(const QString &imageFile, const QString &region, const QVariantHash &params,
+                                                   const DAIRequestOptions &options)
+{
     if (imageFile.isEmpty()) {
         d->error = DError(AIErrorCode::InvalidParameter, "Empty image file path");
         return QString();
@@ -174,35 +347,16 @@ QString DOCRRecognition::recognizeRegionFromString(const QString &imageFile, con
         return QString();
     }
     
-    QMutexLocker lk(&d->mtx);
-    d->running = true;
-    d->error = DError(NoError, "");
-    
-    QString ret = d->ocrIfs->recognizeRegion(imageFile, region, d->packageParams(params));
-    
-    // Parse result
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(ret.toUtf8(), &error);
-    if (error.error != QJsonParseError::NoError) {
-        d->error = DError(AIErrorCode::ResponseParseError, error.errorString());
-        d->running = false;
-        return QString();
-    }
-    
-    QJsonObject obj = doc.object();
-    if (obj.contains("error") && obj["error"].toBool()) {
-        int errorCode = obj["error_code"].toInt();
-        QString errorMessage = obj["error_message"].toString();
-        d->error = DError(errorCode, errorMessage);
-        d->running = false;
-        return QString();
-    }
-    
-    d->running = false;
-    return obj["text"].toString();
+    const QString packed = d->packageParams(params);
+    const qint64 sent = DAIMetricsPrivate::utf8Size(imageFile) + DAIMetricsPrivate::utf8Size(region)
+            + DAIMetricsPrivate::utf8Size(packed);
+    return d->waitResult("DOCRRecognition.recognizeRegion", sent, DAISingleFlight::key("recognizeRegion", { imageFile, region, packed }), [&]() {
+        return d->ocrIfs->recognizeRegion(imageFile, region, packed);
+    }, options);
 }
 
-QString DOCRRecognition::recognizeRegionFromRect(const QString &imageFile, const QRect &region, const QVariantHash &params)
+QString DOCRRecognition::recognizeRegionFromRect(const QString &imageFile, const QRect &region, const QVariantHash &params,
+                                                 const DAIRequestOptions &options)
 {
     // Convert QRect to string format: "x,y,width,height"
     QString regionStr = QString("%1,%2,%3,%4")
@@ -211,48 +365,91 @@ QString DOCRRecognition::recognizeRegionFromRect(const QString &imageFile, const
                         .arg(region.width())
                         .arg(region.height());
     
-    return recognizeRegionFromString(imageFile, regionStr, params);
+    return recognizeRegionFromString(imageFile, regionStr, params, options);
 }
 
-QStringList DOCRRecognition::getSupportedLanguages()
+QStringList DOCRRecognition::getSupportedLanguages(const DAIRequestOptions &options)
 {
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return QStringList();
+
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return QStringList();
     }
-    
-    return d->ocrIfs->getSupportedLanguages();
+
+    // The copy keeps the proxy alive should another thread replace the session meanwhile.
+    const QSharedPointer<OrgDeepinAiDaemonSessionOCRInterface> ifs = d->ocrIfs;
+    lk.unlock();
+
+    return callWithRetry([&ifs]() { return ifs->getSupportedLanguages(); }, options, ifs.data(), &d->mtx);
 }
 
-QStringList DOCRRecognition::getSupportedFormats()
+QStringList DOCRRecognition::getSupportedFormats(const DAIRequestOptions &options)
 {
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return QStringList();
+
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return QStringList();
     }
-    
-    return d->ocrIfs->getSupportedFormats();
+
+    const QSharedPointer<OrgDeepinAiDaemonSessionOCRInterface> ifs = d->ocrIfs;
+    lk.unlock();
+
+    return callWithRetry([&ifs]() { return ifs->getSupportedFormats(); }, options, ifs.data(), &d->mtx);
 }
 
-QString DOCRRecognition::getCapabilities()
+QString DOCRRecognition::getCapabilities(const DAIRequestOptions &options)
 {
+    d->error = requestOptionsError(options);
+    if (d->error.getErrorCode() != NoError)
+        return QString();
+
+    QMutexLocker lk(&d->mtx);
     if (!d->ensureServer()) {
         d->error = DError(AIErrorCode::APIServerNotAvailable, "");
         return QString();
     }
-    
-    return d->ocrIfs->getCapabilities();
+
+    const QSharedPointer<OrgDeepinAiDaemonSessionOCRInterface> ifs = d->ocrIfs;
+    lk.unlock();
+
+    return callWithRetry([&ifs]() { return ifs->getCapabilities(); }, options, ifs.data(), &d->mtx);
 }
 
 // Note: cancel method removed - not applicable for synchronous interface
 
 void DOCRRecognition::terminate()
 {
+    QMutexLocker lk(&d->mtx);
     if (d->ocrIfs)
         d->ocrIfs->terminate();
-        
-    QMutexLocker lk(&d->mtx);
-    d->running = false;
+}
+
+void DOCRRecognition::terminateRequest(quint64 requestId)
+{
+    d->abortRequest(requestId, DError(AIErrorCode::RequestCancelled, "Request terminated"));
+}
+
+void DOCRRecognition::setRequestCoalescingEnabled(bool enabled)
+{
+    DOCRRecognitionPrivate::coalescing()->setEnabled(enabled);
+}
+
+bool DOCRRecognition::isRequestCoalescingEnabled()
+{
+    return DOCRRecognitionPrivate::coalescing()->isEnabled();
+}
+
+DAICoalescingStatistics DOCRRecognition::coalescingStatistics()
+{
+    return DOCRRecognitionPrivate::coalescing()->statistics();
 }
 
 DError DOCRRecognition::lastError() const
@@ -7,8 +7,14 @@
 
 #include "vision/docrrecognition.h"
 #include "aidaemon_apisession_ocr.h"
+#include "daitransport_p.h"
+#include "dairequestoptions_p.h"
+#include "daithreaderror_p.h"
+#include "daisingleflight_p.h"
+#include "daimetrics_p.h"
 
 #include <QObject>
+#include <QHash>
 #include <QMutex>
 #include <QScopedPointer>
 
@@ -25,17 +31,34 @@ public:
     
     bool ensureServer();
     QString packageParams(const QVariantHash &params);
+    static QString parseResult(const QString &result, DTK_CORE_NAMESPACE::DError *error);
+    QDBusPendingReply<QString> sendImage(const QByteArray &imageData, const QVariantHash &params);
+    // Identical blocking calls of all OCR objects share one reply.
+    static DAISingleFlight *coalescing();
+    // Sends the call, or joins an identical one in flight, and waits for its result.
+    // Every caller records into series, only the one sending marshals its sent bytes.
+    // The options of the caller that sends apply to the admission of the shared call.
+    QString waitResult(const char *series, qint64 sent, const QString &key,
+                       const std::function<QDBusPendingReply<QString>()> &send,
+                       const DAIRequestOptions &options);
+    // Sends the call once DAIScheduler admits the request, the request records into series.
+    quint64 watchResult(const char *series, qint64 sent, const std::function<QDBusPendingCall()> &send,
+                        const DAIReplyCallback<QString> &callback, const DAIRequestOptions &options);
+    // Stops a request in the daemon and finishes it with err.
+    void abortRequest(quint64 id, const DTK_CORE_NAMESPACE::DError &err);
     
 // Note: No async signals needed for synchronous interface
     
 public:
     DOCRRecognition *q = nullptr;
     QString sessionId;
-    QScopedPointer<OrgDeepinAiDaemonSessionOCRInterface> ocrIfs;
+    quint64 sessionGeneration = 0;
+    QSharedPointer<OrgDeepinAiDaemonSessionOCRInterface> ocrIfs;
     
     mutable QMutex mtx;
-    bool running = false;
-    DTK_CORE_NAMESPACE::DError error;
+    DAIThreadError error;
+    QHash<quint64, DAIReplyCallback<QString>> calls;
+    DAIRequestWatches watches;
 };
 
 DAI_END_NAMESPACE
@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mock_test_base.h"
+
+#include "dtkai/dmodelmanager.h"
+#include "dtkai/dsessionpool.h"
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for the session pool and model manager against the mock daemon
+ */
+class TestMockCore : public MockTestBase
+{
+};
+
+/**
+ * @brief Test that leased sessions are created once and reused
+ */
+TEST_F(TestMockCore, sessionPool)
+{
+    DSessionPool *pool = DSessionPool::instance();
+    EXPECT_TRUE(pool->isDaemonAvailable());
+
+    const QString first = pool->acquire("OCR");
+    ASSERT_FALSE(first.isEmpty());
+    pool->release("OCR", first);
+    const QString second = pool->acquire("OCR");
+    EXPECT_EQ(second, first) << "A released session should be leased again";
+    pool->release("OCR", second);
+    EXPECT_LE(calls("SessionManager.CreateSession"), 1) << "Sessions left idle by earlier tests may be reused";
+}
+
+/**
+ * @brief Test that the whole model catalog is read
+ */
+TEST_F(TestMockCore, modelCatalog)
+{
+    setConfig(R"({"ModelInfo": {"models": 200}})");
+    EXPECT_EQ(DModelManager::availableModels().size(), 200);
+
+    const QList<ModelInfo> chat = DModelManager::availableModels("Chat");
+    ASSERT_FALSE(chat.isEmpty());
+    for (const ModelInfo &model : chat)
+        EXPECT_EQ(model.capability, QString("Chat"));
+    EXPECT_EQ(DModelManager::currentModelForCapability("Chat"), chat.first().modelName);
+}
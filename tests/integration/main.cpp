@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <QCoreApplication>
+#include <QDBusInterface>
+#include <QDebug>
+#include <gtest/gtest.h>
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("DTKAI Integration Tests");
+    app.setApplicationVersion("1.0.0");
+
+    // Never run against a real daemon, the tests change its configuration.
+    QDBusInterface control("org.deepin.ai.daemon.SessionManager", "/org/deepin/ai/daemon/Mock",
+                           "org.deepin.ai.daemon.Mock");
+    if (!control.isValid()) {
+        qCritical() << "dtkai-mock-daemon is not running, use tests/mockdaemon/dtkai-mock-session.sh";
+        return 1;
+    }
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
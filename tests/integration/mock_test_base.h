@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef MOCK_TEST_BASE_H
+#define MOCK_TEST_BASE_H
+
+#include "test_base.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusReply>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+/**
+ * @brief Base of the tests running against dtkai-mock-daemon
+ *
+ * Every test starts from the configuration given on the daemon's command
+ * line and with empty statistics.
+ */
+class MockTestBase : public TestBase
+{
+public:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        control("Reset");
+    }
+
+    void TearDown() override
+    {
+        control("Reset");
+        TestBase::TearDown();
+    }
+
+protected:
+    static QDBusMessage control(const QString &method, const QVariantList &args = {})
+    {
+        QDBusMessage msg = QDBusMessage::createMethodCall("org.deepin.ai.daemon.SessionManager", "/org/deepin/ai/daemon/Mock",
+                                                          "org.deepin.ai.daemon.Mock", method);
+        msg.setArguments(args);
+        return QDBusConnection::sessionBus().call(msg);
+    }
+
+    /**
+     * @brief Merges json into the daemon configuration, e.g. {"Chat": {"tokens": 10}}
+     */
+    void setConfig(const QString &json)
+    {
+        QDBusReply<bool> reply = control("SetConfig", { json });
+        ASSERT_TRUE(reply.isValid() && reply.value()) << reply.error().message().toStdString();
+    }
+
+    QJsonObject statistics()
+    {
+        QDBusReply<QString> reply = control("Statistics");
+        return QJsonDocument::fromJson(reply.value().toUtf8()).object();
+    }
+
+    /**
+     * @brief Calls of method the daemon handled, e.g. "Chat.streamChat"
+     */
+    int calls(const QString &method)
+    {
+        return statistics().value("calls").toObject().value(method).toObject().value("calls").toInt();
+    }
+};
+
+#endif // MOCK_TEST_BASE_H
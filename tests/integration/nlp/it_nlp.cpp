@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mock_test_base.h"
+
+#include "dtkai/nlp/dchatcompletions.h"
+#include "dtkai/nlp/dembeddingplatform.h"
+#include "dtkai/nlp/dfunctioncalling.h"
+#include "dtkai/DAIError"
+
+#include <QSignalSpy>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for the NLP clients against the mock daemon
+ */
+class TestMockNlp : public MockTestBase
+{
+};
+
+/**
+ * @brief Test that chat goes through the daemon and reports its injected errors
+ */
+TEST_F(TestMockNlp, chat)
+{
+    setConfig(R"({"Chat": {"replySize": 100}})");
+    DChatCompletions chat;
+    EXPECT_EQ(chat.chat("Hello").size(), 100);
+    EXPECT_EQ(chat.lastError().getErrorCode(), NoError);
+    EXPECT_EQ(calls("Chat.chat"), 1);
+
+    setConfig(R"({"Chat": {"errorRate": 1, "errorCode": 7}})");
+    EXPECT_TRUE(chat.chat("Hello").isEmpty());
+    EXPECT_EQ(chat.lastError().getErrorCode(), 7) << "Errors in the reply should reach the caller";
+}
+
+/**
+ * @brief Test that a chat stream delivers every token and its timing
+ */
+TEST_F(TestMockNlp, chatStream)
+{
+    setConfig(R"({"Chat": {"latency": 20, "tokens": 10, "tokensPerSecond": 200}})");
+    DChatCompletions chat;
+    QSignalSpy output(&chat, &DChatCompletions::requestStreamOutput);
+    QSignalSpy stats(&chat, &DChatCompletions::requestStreamStats);
+    QSignalSpy finished(&chat, &DChatCompletions::requestStreamFinished);
+
+    const quint64 id = chat.startChatStream("Hello");
+    ASSERT_NE(id, 0u);
+    ASSERT_TRUE(finished.wait(5000)) << "The stream should finish";
+    EXPECT_EQ(finished.first().at(1).toInt(), NoError);
+    EXPECT_EQ(output.size(), 10);
+
+    ASSERT_EQ(stats.size(), 1);
+    const DAIStreamStats streamStats = stats.first().at(1).value<DAIStreamStats>();
+    EXPECT_EQ(streamStats.tokens, 10);
+    EXPECT_GE(streamStats.timeToFirstToken, 20000) << "The first token comes after the configured latency";
+    EXPECT_GT(streamStats.tokensPerSecond, 0.0);
+}
+
+/**
+ * @brief Test that function calling picks the offered function
+ */
+TEST_F(TestMockNlp, functionCalling)
+{
+    DFunctionCalling calling;
+    const QString functions(R"([{"name": "get_weather", "description": "Weather of a city", "parameters": {}}])");
+    const QJsonObject function = QJsonDocument::fromJson(calling.parse("Weather in Wuhan?", functions).toUtf8()).object();
+    EXPECT_EQ(calling.lastError().getErrorCode(), NoError);
+    EXPECT_EQ(function.value("name").toString(), QString("get_weather"));
+}
+
+/**
+ * @brief Test that embedding searches return the configured number of hits
+ */
+TEST_F(TestMockNlp, embeddingSearch)
+{
+    setConfig(R"({"EmbeddingPlatform": {"hits": 50, "replySize": 40}})");
+    DEmbeddingPlatform platform;
+    const QList<DEmbeddingPlatform::DocumentInfo> documents = platform.uploadDocuments("it-dtkai", { "/tmp/a.txt", "/tmp/b.txt" });
+    ASSERT_EQ(documents.size(), 2);
+    EXPECT_EQ(platform.documentsInfo("it-dtkai").size(), 2);
+
+    const QList<DEmbeddingPlatform::SearchResult> results = platform.search("it-dtkai", "query");
+    ASSERT_EQ(results.size(), 50);
+    EXPECT_EQ(results.first().model, QString("mock-embedding"));
+    EXPECT_EQ(results.first().chunk.content.size(), 40);
+
+    EXPECT_TRUE(platform.destroyIndex("it-dtkai", true));
+    EXPECT_TRUE(platform.documentsInfo("it-dtkai").isEmpty());
+}
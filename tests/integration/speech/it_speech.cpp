@@ -0,0 +1,87 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mock_test_base.h"
+
+#include "dtkai/speech/dspeechtotext.h"
+#include "dtkai/speech/dtexttospeech.h"
+#include "dtkai/DAIError"
+
+#include <QSignalSpy>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for the speech clients against the mock daemon
+ */
+class TestMockSpeech : public MockTestBase
+{
+protected:
+    // Streams 5 chunks of 100 ms audio and returns the final text.
+    QString recognize(DSpeechToText *speech, QSignalSpy *partial)
+    {
+        const quint64 id = speech->startRecognitionStream();
+        if (id == 0)
+            return QString();
+
+        for (int i = 0; i < 5; ++i) {
+            EXPECT_TRUE(speech->sendStreamAudio(id, QByteArray(3200, '\0')));
+            QTest::qWait(10);
+        }
+        EXPECT_TRUE(QTest::qWaitFor([partial]() { return !partial->isEmpty(); }, 2000))
+            << "Partial results should arrive while audio is sent";
+        return speech->endRecognitionStream(id);
+    }
+};
+
+/**
+ * @brief Test a recognition stream over D-Bus calls
+ */
+TEST_F(TestMockSpeech, recognitionStream)
+{
+    DSpeechToText speech;
+    speech.setStreamTransport(DSpeechToText::DBusTransport);
+    QSignalSpy partial(&speech, &DSpeechToText::requestRecognitionPartialResult);
+
+    EXPECT_FALSE(recognize(&speech, &partial).isEmpty());
+    EXPECT_EQ(speech.lastError().getErrorCode(), NoError);
+    EXPECT_GE(statistics().value("bytesReceived").toInt(), 5 * 3200);
+}
+
+/**
+ * @brief Test a recognition stream through the shared-memory ring
+ */
+TEST_F(TestMockSpeech, recognitionStreamShm)
+{
+    DSpeechToText speech;
+    speech.setStreamTransport(DSpeechToText::SharedMemoryTransport);
+    QSignalSpy partial(&speech, &DSpeechToText::requestRecognitionPartialResult);
+
+    EXPECT_FALSE(recognize(&speech, &partial).isEmpty());
+    EXPECT_EQ(calls("SpeechToText.startStreamRecognitionShm"), 1) << "The mock daemon supports the ring";
+    EXPECT_EQ(calls("SpeechToText.startStreamRecognition"), 0);
+    EXPECT_GE(statistics().value("bytesReceived").toInt(), 5 * 3200) << "Audio should arrive through the ring";
+}
+
+/**
+ * @brief Test that a synthesis stream delivers every audio chunk
+ */
+TEST_F(TestMockSpeech, synthesisStream)
+{
+    setConfig(R"({"TextToSpeech": {"tokens": 5, "chunkSize": 640}})");
+    DTextToSpeech speech;
+    QSignalSpy audio(&speech, &DTextToSpeech::requestSynthesisResult);
+    QSignalSpy completed(&speech, &DTextToSpeech::requestSynthesisCompleted);
+
+    ASSERT_NE(speech.startSynthesisStream("Hello"), 0u);
+    ASSERT_TRUE(completed.wait(5000)) << "The stream should complete";
+    ASSERT_EQ(audio.size(), 5);
+    EXPECT_EQ(audio.first().at(1).toByteArray().size(), 640);
+
+    setConfig(R"({"TextToSpeech": {"errorRate": 1, "errorCode": 9}})");
+    QSignalSpy error(&speech, &DTextToSpeech::requestSynthesisError);
+    ASSERT_NE(speech.startSynthesisStream("Hello"), 0u);
+    ASSERT_TRUE(error.wait(5000));
+    EXPECT_EQ(error.first().at(1).toInt(), 9);
+}
@@ -0,0 +1,48 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mock_test_base.h"
+
+#include "dtkai/vision/dimagerecognition.h"
+#include "dtkai/vision/docrrecognition.h"
+#include "dtkai/DAIError"
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for the vision clients against the mock daemon
+ */
+class TestMockVision : public MockTestBase
+{
+};
+
+/**
+ * @brief Test OCR of image data, small and large enough to be passed as a memfd
+ */
+TEST_F(TestMockVision, ocr)
+{
+    setConfig(R"({"OCR": {"replySize": 64}})");
+    DOCRRecognition ocr;
+    EXPECT_EQ(ocr.recognizeImage(QByteArray(1024, 'x')).size(), 64);
+    EXPECT_EQ(ocr.lastError().getErrorCode(), NoError);
+
+    const QByteArray large(4 * 1024 * 1024, 'x');
+    EXPECT_EQ(ocr.recognizeImage(large).size(), 64);
+    EXPECT_GE(statistics().value("bytesReceived").toDouble(), double(large.size()));
+}
+
+/**
+ * @brief Test image recognition and its injected errors
+ */
+TEST_F(TestMockVision, imageRecognition)
+{
+    setConfig(R"({"ImageRecognition": {"replySize": 32}})");
+    DImageRecognition image;
+    EXPECT_EQ(image.recognizeImageData(QByteArray(2048, 'x'), "What is this?").size(), 32);
+    EXPECT_EQ(image.lastError().getErrorCode(), NoError);
+
+    setConfig(R"({"ImageRecognition": {"errorRate": 1, "errorCode": 5}})");
+    EXPECT_TRUE(image.recognizeImageData(QByteArray(2048, 'x'), "What is this?").isEmpty());
+    EXPECT_EQ(image.lastError().getErrorCode(), 5);
+}
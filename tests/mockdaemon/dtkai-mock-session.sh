@@ -0,0 +1,64 @@
+#!/bin/sh
+# SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+#
+# SPDX-License-Identifier: LGPL-3.0-or-later
+
+# Runs a command against dtkai-mock-daemon on a private session bus.
+#
+#   dtkai-mock-session.sh [--daemon PATH] [mock options...] -- command [args...]
+#
+# Mock options such as --config, --set or --peer are passed to the daemon.
+# The exit status is the command's.
+
+set -u
+
+if [ -z "${DTKAI_MOCK_PRIVATE_BUS:-}" ]; then
+    if ! command -v dbus-run-session >/dev/null 2>&1; then
+        echo "dbus-run-session not found" >&2
+        exit 1
+    fi
+    DTKAI_MOCK_PRIVATE_BUS=1 exec dbus-run-session -- "$0" "$@"
+fi
+
+daemon="$(dirname "$0")/dtkai-mock-daemon"
+options=""
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+    case "$1" in
+        --daemon)
+            daemon="$2"
+            shift 2
+            ;;
+        *)
+            # Quoted for the eval below.
+            options="$options '$(printf '%s' "$1" | sed "s/'/'\\\\''/g")'"
+            shift
+            ;;
+    esac
+done
+if [ $# -eq 0 ]; then
+    echo "usage: $0 [--daemon PATH] [mock options...] -- command [args...]" >&2
+    exit 2
+fi
+shift
+
+ready="$(mktemp -u "${TMPDIR:-/tmp}/dtkai-mock.XXXXXX")"
+eval "\"\$daemon\" $options --ready-file \"\$ready\" &"
+pid=$!
+trap 'kill "$pid" 2>/dev/null; rm -f "$ready"' EXIT
+
+# Wait up to 10 seconds for the daemon to own its names.
+tries=0
+while [ ! -e "$ready" ]; do
+    if ! kill -0 "$pid" 2>/dev/null; then
+        echo "dtkai-mock-daemon exited before it was ready" >&2
+        exit 1
+    fi
+    tries=$((tries + 1))
+    if [ "$tries" -gt 100 ]; then
+        echo "dtkai-mock-daemon did not get ready" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+"$@"
@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mockdaemon.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <stdio.h>
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("dtkai-mock-daemon");
+    app.setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Stand-in for deepin-ai-daemon without any model behind it. "
+                                     "Run it on a private bus, e.g. with dtkai-mock-session.sh.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    const QCommandLineOption configOption("config", "JSON configuration, see README.md.", "file");
+    const QCommandLineOption setOption("set", "Sets one key, e.g. Chat.latency=200 or errorRate=0.1 for all "
+                                              "capabilities. May be repeated, applied after --config.", "key=value");
+    const QCommandLineOption seedOption("seed", "Seed of the random latency jitter and error injection.", "n");
+    const QCommandLineOption peerOption("peer", "Offer a peer-to-peer connection through GetPeerAddress.");
+    const QCommandLineOption readyOption("ready-file", "Written once all services are registered.", "file");
+    const QCommandLineOption printOption("print-config", "Print the resulting configuration and exit.");
+    parser.addOptions({ configOption, setOption, seedOption, peerOption, readyOption, printOption });
+    parser.process(app);
+
+    MockConfig config;
+    QString error;
+    if (parser.isSet(configOption) && !config.load(parser.value(configOption), &error)) {
+        fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+    for (const QString &assignment : parser.values(setOption)) {
+        if (!config.set(assignment, &error)) {
+            fprintf(stderr, "%s\n", qPrintable(error));
+            return 1;
+        }
+    }
+    if (parser.isSet(seedOption))
+        MockConfig::setSeed(parser.value(seedOption).toUInt());
+
+    if (parser.isSet(printOption)) {
+        printf("%s", QJsonDocument(config.toJson()).toJson().constData());
+        return 0;
+    }
+
+    MockDaemon daemon(config);
+    if (!daemon.start(parser.isSet(peerOption), &error)) {
+        fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+
+    if (parser.isSet(readyOption)) {
+        QSaveFile ready(parser.value(readyOption));
+        if (!ready.open(QIODevice::WriteOnly) || ready.write(qgetenv("DBUS_SESSION_BUS_ADDRESS") + '\n') < 0
+            || !ready.commit()) {
+            fprintf(stderr, "Cannot write %s\n", qPrintable(parser.value(readyOption)));
+            return 1;
+        }
+    }
+
+    return app.exec();
+}
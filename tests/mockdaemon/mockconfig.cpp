@@ -0,0 +1,228 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mockconfig.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QRandomGenerator>
+
+namespace {
+
+struct IntKey
+{
+    const char *name;
+    int MockProfile::*member;
+};
+
+struct DoubleKey
+{
+    const char *name;
+    double MockProfile::*member;
+};
+
+const IntKey kIntKeys[] = {
+    { "latency", &MockProfile::latency },
+    { "jitter", &MockProfile::jitter },
+    { "errorCode", &MockProfile::errorCode },
+    { "tokens", &MockProfile::tokens },
+    { "tokenSize", &MockProfile::tokenSize },
+    { "replySize", &MockProfile::replySize },
+    { "chunkSize", &MockProfile::chunkSize },
+    { "hits", &MockProfile::hits },
+    { "models", &MockProfile::models },
+};
+
+const DoubleKey kDoubleKeys[] = {
+    { "errorRate", &MockProfile::errorRate },
+    { "dbusErrorRate", &MockProfile::dbusErrorRate },
+    { "tokensPerSecond", &MockProfile::tokensPerSecond },
+};
+
+QRandomGenerator &generator()
+{
+    static QRandomGenerator random(QRandomGenerator::global()->generate());
+    return random;
+}
+
+const char *const kWords[] = {
+    "the", "quick", "brown", "fox", "jumps", "over", "a", "lazy", "dog", "while",
+    "deepin", "model", "answers", "every", "question", "with", "some", "text", "that", "flows",
+};
+
+} // namespace
+
+MockProfile::Outcome MockProfile::roll() const
+{
+    const double value = generator().generateDouble();
+    if (value < dbusErrorRate)
+        return DBusError;
+    if (value < dbusErrorRate + errorRate)
+        return Error;
+    return Success;
+}
+
+int MockProfile::delay() const
+{
+    if (jitter <= 0)
+        return qMax(0, latency);
+    return qMax(0, latency) + int(generator().bounded(jitter + 1));
+}
+
+int MockProfile::interval() const
+{
+    return tokensPerSecond > 0 ? qMax(1, qRound(1000 / tokensPerSecond)) : 0;
+}
+
+bool MockProfile::apply(const QJsonObject &obj, QString *error)
+{
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        bool known = false;
+        for (const IntKey &key : kIntKeys) {
+            if (it.key() == QLatin1String(key.name)) {
+                this->*key.member = it.value().toInt(this->*key.member);
+                known = true;
+            }
+        }
+        for (const DoubleKey &key : kDoubleKeys) {
+            if (it.key() == QLatin1String(key.name)) {
+                this->*key.member = it.value().toDouble(this->*key.member);
+                known = true;
+            }
+        }
+        if (!known) {
+            *error = QString("Unknown key \"%1\"").arg(it.key());
+            return false;
+        }
+    }
+    return true;
+}
+
+QJsonObject MockProfile::toJson() const
+{
+    QJsonObject obj;
+    for (const IntKey &key : kIntKeys)
+        obj.insert(key.name, this->*key.member);
+    for (const DoubleKey &key : kDoubleKeys)
+        obj.insert(key.name, this->*key.member);
+    return obj;
+}
+
+QString MockProfile::text(int bytes, int seed)
+{
+    QString result;
+    result.reserve(bytes);
+    const int count = int(sizeof(kWords) / sizeof(kWords[0]));
+    for (int i = seed; result.size() < bytes; ++i) {
+        if (!result.isEmpty())
+            result.append(' ');
+        result.append(QLatin1String(kWords[i % count]));
+    }
+    result.truncate(bytes);
+    return result;
+}
+
+const QStringList &MockConfig::capabilities()
+{
+    static const QStringList names {
+        "SessionManager", "ModelInfo", "Chat", "FunctionCalling", "SpeechToText",
+        "TextToSpeech", "ImageRecognition", "OCR", "EmbeddingPlatform"
+    };
+    return names;
+}
+
+void MockConfig::setSeed(quint32 seed)
+{
+    generator().seed(seed);
+}
+
+bool MockConfig::load(const QString &filePath, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("Cannot open %1: %2").arg(filePath, file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) {
+        *error = QString("Invalid configuration %1: %2").arg(filePath, parseError.errorString());
+        return false;
+    }
+    return merge(doc.object(), error);
+}
+
+bool MockConfig::merge(const QJsonObject &obj, QString *error)
+{
+    // Check everything first, a bad key must not leave half of it applied.
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        if (it.key() != QLatin1String("default") && !capabilities().contains(it.key())) {
+            *error = QString("Unknown capability \"%1\"").arg(it.key());
+            return false;
+        }
+        if (!it.value().isObject()) {
+            *error = QString("%1: not an object").arg(it.key());
+            return false;
+        }
+        MockProfile probe;
+        QString keyError;
+        if (!probe.apply(it.value().toObject(), &keyError)) {
+            *error = QString("%1: %2").arg(it.key(), keyError);
+            return false;
+        }
+    }
+
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        QJsonObject &current = overrides[it.key()];
+        const QJsonObject values = it.value().toObject();
+        for (auto value = values.begin(); value != values.end(); ++value)
+            current.insert(value.key(), value.value());
+    }
+    return true;
+}
+
+bool MockConfig::set(const QString &assignment, QString *error)
+{
+    const int eq = assignment.indexOf('=');
+    if (eq <= 0) {
+        *error = QString("Expected key=value, got \"%1\"").arg(assignment);
+        return false;
+    }
+
+    QString key = assignment.left(eq);
+    const QString value = assignment.mid(eq + 1);
+    QString capability("default");
+    const int dot = key.indexOf('.');
+    if (dot > 0) {
+        capability = key.left(dot);
+        key = key.mid(dot + 1);
+    }
+
+    bool ok = false;
+    const double number = value.toDouble(&ok);
+    if (!ok) {
+        *error = QString("Value of %1 is not a number").arg(assignment.left(eq));
+        return false;
+    }
+    return merge({ { capability, QJsonObject { { key, number } } } }, error);
+}
+
+MockProfile MockConfig::profile(const QString &capability) const
+{
+    MockProfile result;
+    QString ignored;
+    result.apply(overrides.value("default"), &ignored);
+    result.apply(overrides.value(capability), &ignored);
+    return result;
+}
+
+QJsonObject MockConfig::toJson() const
+{
+    QJsonObject obj;
+    for (const QString &capability : capabilities())
+        obj.insert(capability, profile(capability).toJson());
+    return obj;
+}
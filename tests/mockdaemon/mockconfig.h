@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef MOCKCONFIG_H
+#define MOCKCONFIG_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QStringList>
+
+// How one capability of the mock daemon behaves. Every key of the JSON
+// configuration maps to the member of the same name.
+struct MockProfile
+{
+    enum Outcome {
+        Success,
+        Error,          // the error form of the reply, e.g. {"error":code,...}
+        DBusError       // a D-Bus error reply
+    };
+
+    int latency = 10;               // msec before a reply or the first output of a stream
+    int jitter = 0;                 // up to this many msec are added to latency at random
+    double errorRate = 0;           // share of calls answered with the error form of the reply
+    double dbusErrorRate = 0;       // share of calls answered with a D-Bus error
+    int errorCode = 1;              // error code of injected errors
+    double tokensPerSecond = 50;    // stream outputs per second, 0 sends them all at once
+    int tokens = 32;                // chat tokens or synthesized audio chunks per stream
+    int tokenSize = 4;              // bytes of a chat token, partial recognition results grow by as much
+    int replySize = 256;            // bytes of the text of a reply
+    int chunkSize = 3200;           // bytes of a synthesized audio chunk
+    int hits = 10;                  // results of an embedding search
+    int models = 16;                // models of the catalog
+
+    // Decides at random how a call ends.
+    Outcome roll() const;
+    // Msec before the reply, latency plus jitter.
+    int delay() const;
+    // Msec between two stream outputs.
+    int interval() const;
+
+    bool apply(const QJsonObject &obj, QString *error);
+    QJsonObject toJson() const;
+
+    // Filler text of about bytes UTF-8 bytes, the same for the same seed.
+    static QString text(int bytes, int seed = 0);
+};
+
+// Profiles of all capabilities: built-in defaults, then "default", then the
+// capability's own object, e.g. {"default": {"latency": 5}, "Chat": {"tokens": 100}}.
+class MockConfig
+{
+public:
+    // SessionManager, ModelInfo, Chat, ..., EmbeddingPlatform.
+    static const QStringList &capabilities();
+    // Fixes the sequence of random decisions.
+    static void setSeed(quint32 seed);
+
+    bool load(const QString &filePath, QString *error);
+    bool merge(const QJsonObject &obj, QString *error);
+    // Sets one key from "Capability.key=value", or "key=value" for every capability.
+    bool set(const QString &assignment, QString *error);
+
+    MockProfile profile(const QString &capability) const;
+    QJsonObject toJson() const;
+
+private:
+    QHash<QString, QJsonObject> overrides;   // "default" and capability names
+};
+
+#endif // MOCKCONFIG_H
@@ -0,0 +1,324 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mockdaemon.h"
+#include "mockservices.h"
+#include "mocksessions.h"
+
+#include <QCoreApplication>
+#include <QDBusServer>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLoggingCategory>
+#include <QTimer>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(mockDaemon, "dtkai.mockdaemon")
+
+static const char *const kServices[] = {
+    "org.deepin.ai.daemon",
+    "org.deepin.ai.daemon.ModelInfo",
+    // Last, DSessionPool takes this name showing up as the daemon being ready.
+    "org.deepin.ai.daemon.SessionManager",
+};
+
+static const QString kSessionPath("/org/deepin/ai/daemon/Session/");
+
+MockObject::MockObject(const QString &capability, MockDaemon *daemon)
+    : QObject(daemon)
+    , capability(capability)
+    , daemon(daemon)
+{
+}
+
+MockProfile::Outcome MockObject::call(const char *method, MockProfile *profile, bool errorForm)
+{
+    *profile = daemon->config().profile(capability);
+    MockProfile::Outcome outcome = profile->roll();
+    if (outcome == MockProfile::Error && !errorForm)
+        outcome = MockProfile::DBusError;
+
+    daemon->count(capability + '.' + QLatin1String(method), outcome);
+    return outcome;
+}
+
+void MockObject::replyLater(MockProfile::Outcome outcome, const QVariant &value, int delay)
+{
+    if (!calledFromDBus())
+        return;
+
+    setDelayedReply(true);
+    QDBusMessage reply;
+    if (outcome == MockProfile::DBusError) {
+        reply = message().createErrorReply(QDBusError::Failed, "Injected error");
+    } else if (value.isValid()) {
+        reply = message().createReply(value);
+        if (value.userType() == QMetaType::QString)
+            daemon->addSent(value.toString().toUtf8().size());
+    } else {
+        reply = message().createReply();
+    }
+
+    QDBusConnection con = connection();
+    if (delay <= 0) {
+        con.send(reply);
+        return;
+    }
+
+    // The daemon outlives its sessions, a reply is sent even if the session went away.
+    QTimer::singleShot(delay, Qt::PreciseTimer, daemon, [con, reply]() mutable {
+        con.send(reply);
+    });
+}
+
+QByteArray MockObject::readDescriptor(const QDBusUnixFileDescriptor &fd)
+{
+    struct stat st;
+    if (!fd.isValid() || fstat(fd.fileDescriptor(), &st) != 0)
+        return QByteArray();
+
+    // The client may have left the offset anywhere, read from the start.
+    QByteArray data(static_cast<int>(st.st_size), Qt::Uninitialized);
+    qint64 done = 0;
+    while (done < data.size()) {
+        const ssize_t n = pread(fd.fileDescriptor(), data.data() + done, static_cast<size_t>(data.size() - done), done);
+        if (n <= 0)
+            break;
+        done += n;
+    }
+    data.truncate(static_cast<int>(done));
+    return data;
+}
+
+QString MockObject::toJson(const QJsonObject &obj)
+{
+    return QString::fromUtf8(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+}
+
+MockDaemon::MockDaemon(const MockConfig &config, QObject *parent)
+    : QObject(parent)
+    , initial(config)
+    , current(config)
+{
+}
+
+MockDaemon::~MockDaemon() = default;
+
+bool MockDaemon::start(bool peer, QString *error)
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.isConnected()) {
+        *error = QString("No session bus: %1").arg(bus.lastError().message());
+        return false;
+    }
+    connections.append(bus);
+
+    exportObject("/org/deepin/ai/daemon/SessionManager", new MockSessionManager(this));
+    exportObject("/org/deepin/ai/daemon/ModelInfo", new MockModelInfo(this));
+    exportObject("/org/deepin/ai/daemon/EmbeddingPlatform", new MockEmbeddingPlatform(this));
+    exportObject("/org/deepin/ai/daemon/Mock", new MockControl(this));
+
+    if (peer) {
+        server = new QDBusServer(this);
+        if (!server->isConnected()) {
+            *error = QString("Cannot listen for peers: %1").arg(server->lastError().message());
+            return false;
+        }
+        connect(server, &QDBusServer::newConnection, this, &MockDaemon::peerConnected);
+        qCInfo(mockDaemon) << "Listening for peers on" << server->address();
+    }
+
+    for (const char *name : kServices) {
+        if (!bus.registerService(name)) {
+            *error = QString("Cannot own %1, is an ai-daemon running on this bus? %2")
+                             .arg(name, bus.lastError().message());
+            return false;
+        }
+    }
+    return true;
+}
+
+void MockDaemon::reset()
+{
+    current = initial;
+    counters.clear();
+    sessionsCreated = 0;
+    sessionsDestroyed = 0;
+    bytesReceived = 0;
+    bytesSent = 0;
+}
+
+void MockDaemon::count(const QString &method, MockProfile::Outcome outcome)
+{
+    Counter &counter = counters[method];
+    ++counter.calls;
+    if (outcome == MockProfile::Error)
+        ++counter.errors;
+    else if (outcome == MockProfile::DBusError)
+        ++counter.dbusErrors;
+}
+
+QJsonObject MockDaemon::statistics() const
+{
+    QJsonObject calls;
+    for (auto it = counters.begin(); it != counters.end(); ++it) {
+        calls.insert(it.key(), QJsonObject {
+            { "calls", double(it.value().calls) },
+            { "errors", double(it.value().errors) },
+            { "dbusErrors", double(it.value().dbusErrors) },
+        });
+    }
+
+    return QJsonObject {
+        { "calls", calls },
+        { "sessions", QJsonObject {
+            { "active", sessions.size() },
+            { "created", double(sessionsCreated) },
+            { "destroyed", double(sessionsDestroyed) },
+        } },
+        { "peers", connections.size() - 1 },
+        { "bytesReceived", double(bytesReceived) },
+        { "bytesSent", double(bytesSent) },
+    };
+}
+
+QString MockDaemon::createSession(const QString &type)
+{
+    MockObject *session = createMockSession(type, this);
+    if (!session)
+        return QString();
+
+    const QString id = QString("%1_%2").arg(type).arg(++lastSession);
+    sessions.insert(id, session);
+    exportObject(kSessionPath + id, session);
+    ++sessionsCreated;
+    qCDebug(mockDaemon) << "Created session" << id;
+    return id;
+}
+
+bool MockDaemon::destroySession(const QString &id)
+{
+    MockObject *session = sessions.take(id);
+    if (!session)
+        return false;
+
+    const QString path = kSessionPath + id;
+    objects.remove(path);
+    for (QDBusConnection &con : connections)
+        con.unregisterObject(path);
+
+    session->deleteLater();
+    ++sessionsDestroyed;
+    qCDebug(mockDaemon) << "Destroyed session" << id;
+    return true;
+}
+
+QString MockDaemon::peerAddress() const
+{
+    return server ? server->address() : QString();
+}
+
+void MockDaemon::exportObject(const QString &path, QObject *object)
+{
+    objects.insert(path, object);
+    for (QDBusConnection &con : connections)
+        con.registerObject(path, object, QDBusConnection::ExportAllSlots | QDBusConnection::ExportAllSignals);
+}
+
+void MockDaemon::peerConnected(const QDBusConnection &con)
+{
+    // Forget peers that went away, the session bus always stays first.
+    for (int i = connections.size() - 1; i > 0; --i) {
+        if (!connections.at(i).isConnected())
+            connections.removeAt(i);
+    }
+
+    connections.append(con);
+    for (auto it = objects.begin(); it != objects.end(); ++it)
+        connections.last().registerObject(it.key(), it.value(),
+                                          QDBusConnection::ExportAllSlots | QDBusConnection::ExportAllSignals);
+    qCDebug(mockDaemon) << "Peer connected," << connections.size() - 1 << "peers";
+}
+
+MockSessionManager::MockSessionManager(MockDaemon *daemon)
+    : MockObject("SessionManager", daemon)
+{
+}
+
+QString MockSessionManager::CreateSession(const QString &type)
+{
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call("CreateSession", &profile, false);
+    if (outcome != MockProfile::Success) {
+        replyLater(outcome, QVariant(), profile.delay());
+        return QString();
+    }
+
+    const QString id = daemon->createSession(type);
+    if (id.isEmpty()) {
+        sendErrorReply(QDBusError::InvalidArgs, QString("Unknown session type %1").arg(type));
+        return QString();
+    }
+
+    replyLater(outcome, id, profile.delay());
+    return id;
+}
+
+void MockSessionManager::DestroySession(const QString &sessionId)
+{
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call("DestroySession", &profile, false);
+    daemon->destroySession(sessionId);
+    replyLater(outcome, QVariant(), profile.delay());
+}
+
+QStringList MockSessionManager::GetAllSessions()
+{
+    return daemon->sessionIds();
+}
+
+QString MockSessionManager::GetPeerAddress()
+{
+    return daemon->peerAddress();
+}
+
+MockControl::MockControl(MockDaemon *daemon)
+    : QObject(daemon)
+    , daemon(daemon)
+{
+}
+
+bool MockControl::SetConfig(const QString &json)
+{
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(json.toUtf8(), &parseError);
+    QString error = parseError.errorString();
+    if (doc.isObject() && daemon->config().merge(doc.object(), &error))
+        return true;
+
+    sendErrorReply(QDBusError::InvalidArgs, error);
+    return false;
+}
+
+QString MockControl::Config()
+{
+    return QString::fromUtf8(QJsonDocument(daemon->config().toJson()).toJson(QJsonDocument::Compact));
+}
+
+QString MockControl::Statistics()
+{
+    return QString::fromUtf8(QJsonDocument(daemon->statistics()).toJson(QJsonDocument::Compact));
+}
+
+void MockControl::Reset()
+{
+    daemon->reset();
+}
+
+void MockControl::Quit()
+{
+    QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+}
@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef MOCKDAEMON_H
+#define MOCKDAEMON_H
+
+#include "mockconfig.h"
+
+#include <QDBusConnection>
+#include <QDBusContext>
+#include <QDBusUnixFileDescriptor>
+#include <QMap>
+#include <QObject>
+
+class QDBusServer;
+class MockDaemon;
+
+// Base of the exported objects. Each belongs to a capability whose profile
+// decides the latency and the errors of its calls.
+class MockObject : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+public:
+    MockObject(const QString &capability, MockDaemon *daemon);
+
+protected:
+    // Counts a call of method and decides how it ends. Without an error form
+    // of the reply, injected errors become D-Bus errors.
+    MockProfile::Outcome call(const char *method, MockProfile *profile, bool errorForm = true);
+    // Answers the call being handled after delay msec, with a D-Bus error for DBusError.
+    void replyLater(MockProfile::Outcome outcome, const QVariant &value, int delay);
+
+    // Contents of a memfd passed instead of a byte array.
+    static QByteArray readDescriptor(const QDBusUnixFileDescriptor &fd);
+    static QString toJson(const QJsonObject &obj);
+
+    const QString capability;
+    MockDaemon *const daemon;
+};
+
+class MockDaemon : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MockDaemon(const MockConfig &config, QObject *parent = nullptr);
+    ~MockDaemon() override;
+
+    // Owns the ai-daemon names on the session bus and exports the services.
+    // With peer set, session objects are also served over a private connection.
+    bool start(bool peer, QString *error);
+
+    MockConfig &config() { return current; }
+    // Back to the configuration from the command line and empty statistics.
+    void reset();
+
+    void count(const QString &method, MockProfile::Outcome outcome);
+    void addReceived(qint64 bytes) { bytesReceived += bytes; }
+    void addSent(qint64 bytes) { bytesSent += bytes; }
+    QJsonObject statistics() const;
+
+    // New session id, empty for unknown types.
+    QString createSession(const QString &type);
+    bool destroySession(const QString &id);
+    QStringList sessionIds() const { return sessions.keys(); }
+    QString peerAddress() const;
+
+private:
+    struct Counter
+    {
+        quint64 calls = 0;
+        quint64 errors = 0;
+        quint64 dbusErrors = 0;
+    };
+
+    void exportObject(const QString &path, QObject *object);
+    void peerConnected(const QDBusConnection &con);
+
+    MockConfig initial;
+    MockConfig current;
+
+    QList<QDBusConnection> connections;     // the session bus, then the peers
+    QMap<QString, QObject *> objects;       // exported objects by path
+    QMap<QString, MockObject *> sessions;
+    QDBusServer *server = nullptr;
+    quint64 lastSession = 0;
+
+    QMap<QString, Counter> counters;
+    quint64 sessionsCreated = 0;
+    quint64 sessionsDestroyed = 0;
+    qint64 bytesReceived = 0;
+    qint64 bytesSent = 0;
+};
+
+class MockSessionManager : public MockObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.SessionManager")
+public:
+    explicit MockSessionManager(MockDaemon *daemon);
+
+public Q_SLOTS:
+    QString CreateSession(const QString &type);
+    void DestroySession(const QString &sessionId);
+    QStringList GetAllSessions();
+    QString GetPeerAddress();
+};
+
+// Lets a test or benchmark change the configuration while the daemon runs.
+class MockControl : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.Mock")
+public:
+    explicit MockControl(MockDaemon *daemon);
+
+public Q_SLOTS:
+    // Merges a configuration object into the current one.
+    bool SetConfig(const QString &json);
+    QString Config();
+    QString Statistics();
+    void Reset();
+    void Quit();
+
+private:
+    MockDaemon *daemon = nullptr;
+};
+
+#endif // MOCKDAEMON_H
@@ -0,0 +1,225 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mockservices.h"
+
+#include <QJsonDocument>
+
+static const QStringList &modelCapabilities()
+{
+    static const QStringList names {
+        "Chat", "FunctionCalling", "SpeechToText", "TextToSpeech", "ImageRecognition", "OCR", "Embedding"
+    };
+    return names;
+}
+
+static const int kProviders = 4;
+
+MockModelInfo::MockModelInfo(MockDaemon *daemon)
+    : MockObject("ModelInfo", daemon)
+{
+}
+
+QString MockModelInfo::GetSupportedCapabilities()
+{
+    answer("GetSupportedCapabilities",
+           QString::fromUtf8(QJsonDocument(QJsonArray::fromStringList(modelCapabilities())).toJson(QJsonDocument::Compact)));
+    return QString();
+}
+
+QString MockModelInfo::GetAllModels()
+{
+    const int count = daemon->config().profile(capability).models;
+    answer("GetAllModels", toJson({ { "models", catalog(count) } }));
+    return QString();
+}
+
+QString MockModelInfo::GetModelsForCapability(const QString &capability)
+{
+    const int count = daemon->config().profile(this->capability).models;
+    answer("GetModelsForCapability", toJson({ { "models", catalog(count, "capability", capability) } }));
+    return QString();
+}
+
+QString MockModelInfo::GetModelInfo(const QString &modelName)
+{
+    const int count = daemon->config().profile(capability).models;
+    const QJsonArray models = catalog(count, "name", modelName);
+    answer("GetModelInfo", toJson(models.isEmpty() ? QJsonObject() : models.first().toObject()));
+    return QString();
+}
+
+QString MockModelInfo::GetCurrentModelForCapability(const QString &capability)
+{
+    const int count = daemon->config().profile(this->capability).models;
+    QString current;
+    for (const QJsonValue &model : catalog(count, "capability", capability)) {
+        if (model.toObject().value("isAvailable").toBool()) {
+            current = model.toObject().value("name").toString();
+            break;
+        }
+    }
+    answer("GetCurrentModelForCapability", current);
+    return QString();
+}
+
+QStringList MockModelInfo::GetProviderList()
+{
+    const int count = daemon->config().profile(capability).models;
+    QStringList providers;
+    for (int i = 0; i < qMin(count, kProviders); ++i)
+        providers.append(QString("provider%1").arg(i));
+    answer("GetProviderList", providers);
+    return QStringList();
+}
+
+QString MockModelInfo::GetModelsForProvider(const QString &provider)
+{
+    const int count = daemon->config().profile(capability).models;
+    answer("GetModelsForProvider", toJson({ { "models", catalog(count, "provider", provider) } }));
+    return QString();
+}
+
+QJsonArray MockModelInfo::catalog(int count, const QString &key, const QString &filter) const
+{
+    QJsonArray models;
+    const QStringList &capabilities = modelCapabilities();
+    for (int i = 0; i < count; ++i) {
+        const QString capability = capabilities.at(i % capabilities.size());
+        const QJsonObject model {
+            { "name", QString("mock-%1-%2").arg(capability.toLower()).arg(i) },
+            { "provider", QString("provider%1").arg(i % kProviders) },
+            { "description", MockProfile::text(64, i) },
+            { "capability", capability },
+            { "isAvailable", i % 5 != 4 },
+            { "deployType", i % 2 ? "Cloud" : "Local" },
+            { "parameters", QJsonObject { { "temperature", 0.7 }, { "max_tokens", 2048 }, { "context_length", 8192 } } },
+        };
+        if (key.isEmpty() || model.value(key).toString() == filter)
+            models.append(model);
+    }
+    return models;
+}
+
+void MockModelInfo::answer(const char *method, const QVariant &value)
+{
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call(method, &profile, false);
+    replyLater(outcome, value, profile.delay());
+}
+
+MockEmbeddingPlatform::MockEmbeddingPlatform(MockDaemon *daemon)
+    : MockObject("EmbeddingPlatform", daemon)
+{
+}
+
+QString MockEmbeddingPlatform::embeddingModels()
+{
+    const QJsonObject model { { "name", "mock-embedding" }, { "dimension", 768 } };
+    answer("embeddingModels", { { "models", QJsonArray { model } } });
+    return QString();
+}
+
+QString MockEmbeddingPlatform::uploadDocuments(const QString &appId, const QStringList &files, const QString &extensionParams)
+{
+    Q_UNUSED(extensionParams)
+    QJsonArray results;
+    QMap<QString, Document> &docs = documents[appId];
+    for (const QString &file : files) {
+        const QString id = QString("doc_%1").arg(++lastDocument);
+        docs.insert(id, { file, QDateTime::currentDateTime() });
+        results.append(QJsonObject { { "documentID", id }, { "file", file } });
+    }
+    answer("uploadDocuments", { { "results", results } });
+    return QString();
+}
+
+QString MockEmbeddingPlatform::deleteDocuments(const QString &appId, const QStringList &documentIds)
+{
+    QJsonArray results;
+    QMap<QString, Document> &docs = documents[appId];
+    for (const QString &id : documentIds)
+        results.append(QJsonObject { { "documentID", id }, { "deleted", docs.remove(id) > 0 } });
+    answer("deleteDocuments", { { "results", results } });
+    return QString();
+}
+
+QString MockEmbeddingPlatform::search(const QString &appId, const QString &query, const QString &extensionParams)
+{
+    daemon->addReceived(query.toUtf8().size() + extensionParams.toUtf8().size());
+    const MockProfile profile = daemon->config().profile(capability);
+    const QStringList ids = documents.value(appId).keys();
+    const QString timestamp = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+    QJsonArray results;
+    for (int i = 0; i < profile.hits; ++i) {
+        const QJsonObject chunk {
+            { "chunk_index", i },
+            { "content", MockProfile::text(profile.replySize, i) },
+            { "tokens", profile.replySize / 4 },
+            { "timestamp", QJsonArray { timestamp } },
+        };
+        results.append(QJsonObject {
+            { "id", ids.isEmpty() ? QString("doc_%1").arg(i) : ids.at(i % ids.size()) },
+            { "model", "mock-embedding" },
+            { "distance", 0.1 + i * 0.001 },
+            { "chunk", chunk },
+        });
+    }
+    answer("search", { { "results", results } });
+    return QString();
+}
+
+bool MockEmbeddingPlatform::cancelTask(const QString &taskId)
+{
+    Q_UNUSED(taskId)
+    MockProfile profile;
+    call("cancelTask", &profile, false);
+    return true;
+}
+
+QString MockEmbeddingPlatform::documentsInfo(const QString &appId, const QStringList &documentIds)
+{
+    const QMap<QString, Document> docs = documents.value(appId);
+    const QStringList ids = documentIds.isEmpty() ? docs.keys() : documentIds;
+
+    QJsonArray results;
+    for (const QString &id : ids) {
+        auto it = docs.find(id);
+        if (it == docs.end())
+            continue;
+        results.append(QJsonObject {
+            { "id", id },
+            { "file_path", it->filePath },
+            { "created_at", it->createdAt.toString(Qt::ISODate) },
+            { "metadata", QJsonObject { { "source", "mock" } } },
+        });
+    }
+    answer("documentsInfo", { { "results", results } });
+    return QString();
+}
+
+QString MockEmbeddingPlatform::buildIndex(const QString &appId, const QString &docId, const QString &extensionParams)
+{
+    Q_UNUSED(appId)
+    Q_UNUSED(extensionParams)
+    answer("buildIndex", { { "success", true }, { "documentID", docId } });
+    return QString();
+}
+
+QString MockEmbeddingPlatform::destroyIndex(const QString &appId, bool allIndex, const QString &extensionParams)
+{
+    Q_UNUSED(extensionParams)
+    if (allIndex)
+        documents.remove(appId);
+    answer("destroyIndex", { { "success", true } });
+    return QString();
+}
+
+void MockEmbeddingPlatform::answer(const char *method, const QJsonObject &obj)
+{
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call(method, &profile, false);
+    replyLater(outcome, toJson(obj), profile.delay());
+}
@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef MOCKSERVICES_H
+#define MOCKSERVICES_H
+
+#include "mockdaemon.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QJsonArray>
+
+// Catalog of profile.models models spread over the capabilities and four providers.
+class MockModelInfo : public MockObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.ModelInfo")
+public:
+    explicit MockModelInfo(MockDaemon *daemon);
+
+public Q_SLOTS:
+    QString GetSupportedCapabilities();
+    QString GetAllModels();
+    QString GetModelsForCapability(const QString &capability);
+    QString GetModelInfo(const QString &modelName);
+    QString GetCurrentModelForCapability(const QString &capability);
+    QStringList GetProviderList();
+    QString GetModelsForProvider(const QString &provider);
+
+private:
+    // Models matching filter, all of them when it is empty.
+    QJsonArray catalog(int count, const QString &key = QString(), const QString &filter = QString()) const;
+    void answer(const char *method, const QVariant &value);
+};
+
+// Documents live in memory per app id, searches return profile.hits chunks
+// of profile.replySize bytes whatever was uploaded.
+class MockEmbeddingPlatform : public MockObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.EmbeddingPlatform")
+public:
+    explicit MockEmbeddingPlatform(MockDaemon *daemon);
+
+public Q_SLOTS:
+    QString embeddingModels();
+    QString uploadDocuments(const QString &appId, const QStringList &files, const QString &extensionParams);
+    QString deleteDocuments(const QString &appId, const QStringList &documentIds);
+    QString search(const QString &appId, const QString &query, const QString &extensionParams);
+    bool cancelTask(const QString &taskId);
+    QString documentsInfo(const QString &appId, const QStringList &documentIds);
+    QString buildIndex(const QString &appId, const QString &docId, const QString &extensionParams);
+    QString destroyIndex(const QString &appId, bool allIndex, const QString &extensionParams);
+
+private:
+    struct Document
+    {
+        QString filePath;
+        QDateTime createdAt;
+    };
+
+    void answer(const char *method, const QJsonObject &obj);
+
+    QHash<QString, QMap<QString, Document>> documents;     // by app id, then document id
+    quint64 lastDocument = 0;
+};
+
+#endif // MOCKSERVICES_H
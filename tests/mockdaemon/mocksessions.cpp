@@ -0,0 +1,607 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "mocksessions.h"
+#include "speech/daudioring_p.h"
+
+#include <QEvent>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#include <functional>
+
+#include <unistd.h>
+
+DAI_USE_NAMESPACE
+
+static const QString kInjectedError("Injected error");
+
+// Calls rung whenever the eventfd of an audio ring becomes readable. Handles the
+// event itself, the signature of QSocketNotifier::activated differs between Qt versions.
+class Doorbell : public QSocketNotifier
+{
+public:
+    Doorbell(int fd, const std::function<void()> &rung)
+        : QSocketNotifier(fd, QSocketNotifier::Read)
+        , rung(rung)
+    {
+    }
+
+protected:
+    bool event(QEvent *e) override
+    {
+        if (e->type() != QEvent::SockAct)
+            return QSocketNotifier::event(e);
+        rung();
+        return true;
+    }
+
+private:
+    std::function<void()> rung;
+};
+
+// {"error":code,"errorMessage":..} of Chat and FunctionCalling.
+static QJsonObject chatError(const MockProfile &profile)
+{
+    return { { "error", profile.errorCode }, { "errorMessage", kInjectedError } };
+}
+
+// {"error_code":code,"error_message":..} of the speech sessions.
+static QJsonObject speechError(int code, const QString &message)
+{
+    return { { "error_code", code }, { "error_message", message } };
+}
+
+// {"error":true,"error_code":code,"error_message":..} of the vision sessions.
+static QJsonObject visionError(const MockProfile &profile)
+{
+    return { { "error", true }, { "error_code", profile.errorCode }, { "error_message", kInjectedError } };
+}
+
+MockObject *createMockSession(const QString &type, MockDaemon *daemon)
+{
+    if (type == QLatin1String("Chat"))
+        return new MockChatSession(daemon);
+    if (type == QLatin1String("FunctionCalling"))
+        return new MockFunctionCallingSession(daemon);
+    if (type == QLatin1String("SpeechToText"))
+        return new MockSpeechToTextSession(daemon);
+    if (type == QLatin1String("TextToSpeech"))
+        return new MockTextToSpeechSession(daemon);
+    if (type == QLatin1String("ImageRecognition"))
+        return new MockImageRecognitionSession(daemon);
+    if (type == QLatin1String("OCR"))
+        return new MockOCRSession(daemon);
+    return nullptr;
+}
+
+MockChatSession::MockChatSession(MockDaemon *daemon)
+    : MockObject("Chat", daemon)
+{
+    streamTimer.setTimerType(Qt::PreciseTimer);
+    connect(&streamTimer, &QTimer::timeout, this, &MockChatSession::streamNext);
+}
+
+QString MockChatSession::chat(const QString &content, const QString &params)
+{
+    daemon->addReceived(content.toUtf8().size() + params.toUtf8().size());
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call("chat", &profile);
+    const QJsonObject reply = outcome == MockProfile::Error
+            ? chatError(profile)
+            : QJsonObject { { "content", MockProfile::text(profile.replySize) } };
+    replyLater(outcome, toJson(reply), profile.delay());
+    return QString();
+}
+
+int MockChatSession::streamChat(const QString &content, const QString &params)
+{
+    daemon->addReceived(content.toUtf8().size() + params.toUtf8().size());
+    const MockProfile::Outcome outcome = call("streamChat", &streamProfile);
+    if (outcome == MockProfile::DBusError) {
+        replyLater(outcome, QVariant(), 0);
+        return 0;
+    }
+
+    // A new stream replaces the one still running, as the daemon has one per session.
+    streamFails = outcome == MockProfile::Error;
+    streamed = 0;
+    streamContent.clear();
+    streamTimer.start(streamProfile.delay());
+    return 0;
+}
+
+void MockChatSession::terminate()
+{
+    MockProfile profile;
+    call("terminate", &profile);
+    streamTimer.stop();
+}
+
+void MockChatSession::streamNext()
+{
+    if (streamFails) {
+        streamTimer.stop();
+        Q_EMIT StreamFinished(streamProfile.errorCode, kInjectedError);
+        return;
+    }
+
+    const int interval = streamProfile.interval();
+    do {
+        if (streamed >= streamProfile.tokens) {
+            streamTimer.stop();
+            daemon->addSent(streamContent.toUtf8().size());
+            Q_EMIT StreamFinished(0, streamContent);
+            return;
+        }
+
+        const QString token = MockProfile::text(streamProfile.tokenSize, streamed);
+        streamContent.append(token);
+        ++streamed;
+        Q_EMIT StreamOutput(token);
+    } while (interval == 0);
+
+    if (streamTimer.interval() != interval)
+        streamTimer.start(interval);
+}
+
+MockFunctionCallingSession::MockFunctionCallingSession(MockDaemon *daemon)
+    : MockObject("FunctionCalling", daemon)
+{
+}
+
+QString MockFunctionCallingSession::Parse(const QString &content, const QString &functions, const QString &params)
+{
+    daemon->addReceived(content.toUtf8().size() + functions.toUtf8().size() + params.toUtf8().size());
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call("Parse", &profile);
+    if (outcome == MockProfile::Error) {
+        replyLater(outcome, toJson(chatError(profile)), profile.delay());
+        return QString();
+    }
+
+    // Calls the first function offered, either {"name":..} or {"function":{"name":..}}.
+    QString name("mock_function");
+    const QJsonArray offered = QJsonDocument::fromJson(functions.toUtf8()).array();
+    if (!offered.isEmpty()) {
+        const QJsonObject first = offered.first().toObject();
+        const QString found = first.contains("function") ? first.value("function").toObject().value("name").toString()
+                                                         : first.value("name").toString();
+        if (!found.isEmpty())
+            name = found;
+    }
+
+    const QJsonObject function {
+        { "name", name },
+        { "arguments", toJson({ { "text", MockProfile::text(profile.replySize) } }) },
+    };
+    replyLater(outcome, toJson({ { "function", function } }), profile.delay());
+    return QString();
+}
+
+void MockFunctionCallingSession::Terminate()
+{
+    MockProfile profile;
+    call("Terminate", &profile);
+}
+
+MockSpeechToTextSession::MockSpeechToTextSession(MockDaemon *daemon)
+    : MockObject("SpeechToText", daemon)
+{
+}
+
+MockSpeechToTextSession::~MockSpeechToTextSession()
+{
+    qDeleteAll(streams);
+    qDeleteAll(closed);
+}
+
+QString MockSpeechToTextSession::recognizeFile(const QString &audioFile, const QString &params)
+{
+    daemon->addReceived(audioFile.toUtf8().size() + params.toUtf8().size());
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call("recognizeFile", &profile);
+    const QJsonObject reply = outcome == MockProfile::Error
+            ? speechError(profile.errorCode, kInjectedError)
+            : QJsonObject { { "text", MockProfile::text(profile.replySize) } };
+    replyLater(outcome, toJson(reply), profile.delay());
+    return QString();
+}
+
+QString MockSpeechToTextSession::startStreamRecognition(const QString &params)
+{
+    daemon->addReceived(params.toUtf8().size());
+    Stream *stream = openStream("startStreamRecognition");
+    return stream ? stream->id : QString();
+}
+
+QString MockSpeechToTextSession::startStreamRecognitionShm(const QString &params, const QDBusUnixFileDescriptor &ringFd,
+                                                           const QDBusUnixFileDescriptor &doorbellFd)
+{
+    daemon->addReceived(params.toUtf8().size());
+    QScopedPointer<DAudioRing> ring(new DAudioRing);
+    if (!ring->attach(ringFd, doorbellFd)) {
+        sendErrorReply(QDBusError::InvalidArgs, "Invalid audio ring");
+        return QString();
+    }
+
+    Stream *stream = openStream("startStreamRecognitionShm");
+    if (!stream)
+        return QString();
+
+    stream->ring.swap(ring);
+    stream->doorbell.reset(new Doorbell(stream->ring->doorbellDescriptor().fileDescriptor(), [this, stream]() {
+        quint64 count = 0;
+        if (::read(stream->ring->doorbellDescriptor().fileDescriptor(), &count, sizeof(count)) < 0)
+            return;
+        drainRing(stream);
+    }));
+    return stream->id;
+}
+
+bool MockSpeechToTextSession::sendAudioData(const QString &streamSessionId, const QByteArray &audioData)
+{
+    Stream *stream = streams.value(streamSessionId);
+    if (!stream)
+        return false;
+
+    receive(stream, audioData.size());
+    return true;
+}
+
+bool MockSpeechToTextSession::sendAudioDataFd(const QString &streamSessionId, const QDBusUnixFileDescriptor &audioFd)
+{
+    Stream *stream = streams.value(streamSessionId);
+    if (!stream)
+        return false;
+
+    receive(stream, readDescriptor(audioFd).size());
+    return true;
+}
+
+QString MockSpeechToTextSession::endStreamRecognition(const QString &streamSessionId)
+{
+    Stream *stream = streams.value(streamSessionId);
+    if (!stream)
+        return toJson(speechError(2, "Unknown stream"));
+
+    MockProfile profile;
+    call("endStreamRecognition", &profile);
+    drainRing(stream);
+
+    const QString text = MockProfile::text(qMax(profile.replySize, stream->results * stream->profile.tokenSize));
+    const QString id = stream->id;
+    const int delay = stream->profile.delay();
+    const QJsonObject reply = stream->fails ? speechError(stream->profile.errorCode, kInjectedError)
+                                            : QJsonObject { { "text", text } };
+    const bool fails = stream->fails;
+    closeStream(id);
+
+    // The completion signal goes out right before the reply.
+    QTimer::singleShot(delay, Qt::PreciseTimer, this, [this, id, text, fails]() {
+        if (!fails)
+            Q_EMIT RecognitionCompleted(id, text);
+    });
+    replyLater(MockProfile::Success, toJson(reply), delay);
+    return QString();
+}
+
+void MockSpeechToTextSession::terminate()
+{
+    MockProfile profile;
+    call("terminate", &profile);
+    for (const QString &id : streams.keys())
+        closeStream(id);
+}
+
+QStringList MockSpeechToTextSession::getSupportedFormats()
+{
+    return { "wav", "pcm", "mp3", "opus" };
+}
+
+MockSpeechToTextSession::Stream *MockSpeechToTextSession::openStream(const char *method)
+{
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call(method, &profile);
+    if (outcome == MockProfile::DBusError) {
+        replyLater(outcome, QVariant(), 0);
+        return nullptr;
+    }
+
+    Stream *stream = new Stream;
+    stream->id = QString("stt_%1").arg(++lastStream);
+    stream->profile = profile;
+    stream->fails = outcome == MockProfile::Error;
+    stream->timer.setTimerType(Qt::PreciseTimer);
+    stream->timer.setSingleShot(true);
+    connect(&stream->timer, &QTimer::timeout, this, [this, stream]() { recognize(stream); });
+    streams.insert(stream->id, stream);
+    return stream;
+}
+
+void MockSpeechToTextSession::receive(Stream *stream, qint64 bytes)
+{
+    daemon->addReceived(bytes);
+    stream->received += bytes;
+
+    // The first audio starts recognition, later audio waits for the next turn.
+    if (stream->results == 0 && !stream->timer.isActive())
+        stream->timer.start(stream->profile.delay());
+    else if (stream->results > 0 && !stream->timer.isActive())
+        stream->timer.start(stream->profile.interval());
+}
+
+void MockSpeechToTextSession::recognize(Stream *stream)
+{
+    if (stream->fails) {
+        const QString id = stream->id;
+        const int code = stream->profile.errorCode;
+        closeStream(id);
+        Q_EMIT RecognitionError(id, code, kInjectedError);
+        return;
+    }
+
+    if (stream->received <= stream->recognized)
+        return;
+
+    stream->recognized = stream->received;
+    ++stream->results;
+    const QString text = MockProfile::text(stream->results * stream->profile.tokenSize);
+    daemon->addSent(text.toUtf8().size());
+    Q_EMIT RecognitionPartialResult(stream->id, text);
+}
+
+void MockSpeechToTextSession::drainRing(Stream *stream)
+{
+    if (!stream->ring)
+        return;
+
+    qint64 bytes = 0;
+    for (QByteArray chunk = stream->ring->read(1 << 16); !chunk.isEmpty(); chunk = stream->ring->read(1 << 16))
+        bytes += chunk.size();
+    if (bytes > 0)
+        receive(stream, bytes);
+}
+
+void MockSpeechToTextSession::closeStream(const QString &id)
+{
+    Stream *stream = streams.take(id);
+    if (!stream)
+        return;
+
+    // Streams mostly close from their own timer, delete them after it returned.
+    stream->timer.stop();
+    if (stream->doorbell)
+        stream->doorbell->setEnabled(false);
+    closed.append(stream);
+    QTimer::singleShot(0, this, [this]() {
+        qDeleteAll(closed);
+        closed.clear();
+    });
+}
+
+MockTextToSpeechSession::MockTextToSpeechSession(MockDaemon *daemon)
+    : MockObject("TextToSpeech", daemon)
+{
+}
+
+MockTextToSpeechSession::~MockTextToSpeechSession()
+{
+    qDeleteAll(streams);
+    qDeleteAll(closed);
+}
+
+QString MockTextToSpeechSession::startStreamSynthesis(const QString &text, const QString &params)
+{
+    daemon->addReceived(text.toUtf8().size() + params.toUtf8().size());
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call("startStreamSynthesis", &profile);
+    if (outcome == MockProfile::DBusError) {
+        replyLater(outcome, QVariant(), 0);
+        return QString();
+    }
+
+    Stream *stream = new Stream;
+    stream->id = QString("tts_%1").arg(++lastStream);
+    stream->profile = profile;
+    stream->fails = outcome == MockProfile::Error;
+    stream->timer.setTimerType(Qt::PreciseTimer);
+    connect(&stream->timer, &QTimer::timeout, this, [this, stream]() { synthesize(stream); });
+    streams.insert(stream->id, stream);
+    stream->timer.start(profile.delay());
+    return stream->id;
+}
+
+QString MockTextToSpeechSession::endStreamSynthesis(const QString &streamSessionId)
+{
+    MockProfile profile;
+    call("endStreamSynthesis", &profile);
+    closeStream(streamSessionId);
+    return toJson({ { "audio_data", QString() } });
+}
+
+void MockTextToSpeechSession::terminate()
+{
+    MockProfile profile;
+    call("terminate", &profile);
+    for (const QString &id : streams.keys())
+        closeStream(id);
+}
+
+QStringList MockTextToSpeechSession::getSupportedVoices()
+{
+    return { "mock_female", "mock_male" };
+}
+
+void MockTextToSpeechSession::synthesize(Stream *stream)
+{
+    const QString id = stream->id;
+    if (stream->fails) {
+        const int code = stream->profile.errorCode;
+        closeStream(id);
+        Q_EMIT SynthesisError(id, code, kInjectedError);
+        return;
+    }
+
+    const int interval = stream->profile.interval();
+    do {
+        if (stream->sent >= stream->profile.tokens) {
+            closeStream(id);
+            Q_EMIT SynthesisCompleted(id, QByteArray());
+            return;
+        }
+
+        // Silence, 16 bit PCM.
+        const QByteArray audio(stream->profile.chunkSize, '\0');
+        ++stream->sent;
+        daemon->addSent(audio.size());
+        Q_EMIT SynthesisResult(id, audio);
+    } while (interval == 0);
+
+    if (stream->timer.interval() != interval)
+        stream->timer.start(interval);
+}
+
+void MockTextToSpeechSession::closeStream(const QString &id)
+{
+    Stream *stream = streams.take(id);
+    if (!stream)
+        return;
+
+    // Streams mostly close from their own timer, delete them after it returned.
+    stream->timer.stop();
+    closed.append(stream);
+    QTimer::singleShot(0, this, [this]() {
+        qDeleteAll(closed);
+        closed.clear();
+    });
+}
+
+MockImageRecognitionSession::MockImageRecognitionSession(MockDaemon *daemon)
+    : MockObject("ImageRecognition", daemon)
+{
+}
+
+QString MockImageRecognitionSession::recognizeImage(const QString &imagePath, const QString &prompt, const QString &params)
+{
+    answer("recognizeImage", imagePath.toUtf8().size() + prompt.toUtf8().size() + params.toUtf8().size());
+    return QString();
+}
+
+QString MockImageRecognitionSession::recognizeImageData(const QByteArray &imageData, const QString &prompt, const QString &params)
+{
+    answer("recognizeImageData", imageData.size() + prompt.toUtf8().size() + params.toUtf8().size());
+    return QString();
+}
+
+QString MockImageRecognitionSession::recognizeImageDataFd(const QDBusUnixFileDescriptor &imageFd, const QString &prompt,
+                                                          const QString &params)
+{
+    answer("recognizeImageDataFd", readDescriptor(imageFd).size() + prompt.toUtf8().size() + params.toUtf8().size());
+    return QString();
+}
+
+QString MockImageRecognitionSession::recognizeImageUrl(const QString &imageUrl, const QString &prompt, const QString &params)
+{
+    answer("recognizeImageUrl", imageUrl.toUtf8().size() + prompt.toUtf8().size() + params.toUtf8().size());
+    return QString();
+}
+
+void MockImageRecognitionSession::terminate()
+{
+    MockProfile profile;
+    call("terminate", &profile);
+}
+
+QStringList MockImageRecognitionSession::getSupportedImageFormats()
+{
+    return { "jpg", "jpeg", "png", "bmp", "webp" };
+}
+
+int MockImageRecognitionSession::getMaxImageSize()
+{
+    return 10 * 1024 * 1024;
+}
+
+void MockImageRecognitionSession::answer(const char *method, qint64 received)
+{
+    daemon->addReceived(received);
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call(method, &profile);
+    const QJsonObject reply = outcome == MockProfile::Error
+            ? visionError(profile)
+            : QJsonObject { { "content", MockProfile::text(profile.replySize) } };
+    replyLater(outcome, toJson(reply), profile.delay());
+}
+
+MockOCRSession::MockOCRSession(MockDaemon *daemon)
+    : MockObject("OCR", daemon)
+{
+}
+
+QString MockOCRSession::recognizeFile(const QString &imageFile, const QString &params)
+{
+    answer("recognizeFile", imageFile.toUtf8().size() + params.toUtf8().size());
+    return QString();
+}
+
+QString MockOCRSession::recognizeImage(const QByteArray &imageData, const QString &params)
+{
+    answer("recognizeImage", imageData.size() + params.toUtf8().size());
+    return QString();
+}
+
+QString MockOCRSession::recognizeImageFd(const QDBusUnixFileDescriptor &imageFd, const QString &params)
+{
+    answer("recognizeImageFd", readDescriptor(imageFd).size() + params.toUtf8().size());
+    return QString();
+}
+
+QString MockOCRSession::recognizeRegion(const QString &imageFile, const QString &region, const QString &params)
+{
+    answer("recognizeRegion", imageFile.toUtf8().size() + region.toUtf8().size() + params.toUtf8().size());
+    return QString();
+}
+
+void MockOCRSession::terminate()
+{
+    MockProfile profile;
+    call("terminate", &profile);
+}
+
+bool MockOCRSession::cancel(const QString &taskId)
+{
+    Q_UNUSED(taskId)
+    return true;
+}
+
+QStringList MockOCRSession::getSupportedLanguages()
+{
+    return { "zh-Hans_en", "en", "zh-Hant" };
+}
+
+QStringList MockOCRSession::getSupportedFormats()
+{
+    return { "jpg", "jpeg", "png", "bmp", "tiff" };
+}
+
+QString MockOCRSession::getCapabilities()
+{
+    return toJson({
+        { "languages", QJsonArray::fromStringList(getSupportedLanguages()) },
+        { "formats", QJsonArray::fromStringList(getSupportedFormats()) },
+        { "regionRecognition", true },
+    });
+}
+
+void MockOCRSession::answer(const char *method, qint64 received)
+{
+    daemon->addReceived(received);
+    MockProfile profile;
+    const MockProfile::Outcome outcome = call(method, &profile);
+    const QJsonObject reply = outcome == MockProfile::Error
+            ? visionError(profile)
+            : QJsonObject { { "text", MockProfile::text(profile.replySize) } };
+    replyLater(outcome, toJson(reply), profile.delay());
+}
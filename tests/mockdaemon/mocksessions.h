@@ -0,0 +1,193 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#ifndef MOCKSESSIONS_H
+#define MOCKSESSIONS_H
+
+#include "mockdaemon.h"
+#include "dtkai_global.h"
+
+#include <QHash>
+#include <QScopedPointer>
+#include <QSocketNotifier>
+#include <QTimer>
+
+DAI_BEGIN_NAMESPACE
+class DAudioRing;
+DAI_END_NAMESPACE
+
+// Session object of type, nullptr for unknown types.
+MockObject *createMockSession(const QString &type, MockDaemon *daemon);
+
+class MockChatSession : public MockObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.Session.Chat")
+public:
+    explicit MockChatSession(MockDaemon *daemon);
+
+public Q_SLOTS:
+    QString chat(const QString &content, const QString &params);
+    int streamChat(const QString &content, const QString &params);
+    void terminate();
+
+Q_SIGNALS:
+    void StreamOutput(const QString &text);
+    void StreamFinished(int error, const QString &content);
+
+private:
+    void streamNext();
+
+    QTimer streamTimer;
+    MockProfile streamProfile;
+    bool streamFails = false;
+    int streamed = 0;
+    QString streamContent;
+};
+
+class MockFunctionCallingSession : public MockObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.Session.FunctionCalling")
+public:
+    explicit MockFunctionCallingSession(MockDaemon *daemon);
+
+public Q_SLOTS:
+    QString Parse(const QString &content, const QString &functions, const QString &params);
+    void Terminate();
+};
+
+class MockSpeechToTextSession : public MockObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.Session.SpeechToText")
+public:
+    explicit MockSpeechToTextSession(MockDaemon *daemon);
+    ~MockSpeechToTextSession() override;
+
+public Q_SLOTS:
+    QString recognizeFile(const QString &audioFile, const QString &params);
+    QString startStreamRecognition(const QString &params);
+    QString startStreamRecognitionShm(const QString &params, const QDBusUnixFileDescriptor &ringFd,
+                                      const QDBusUnixFileDescriptor &doorbellFd);
+    bool sendAudioData(const QString &streamSessionId, const QByteArray &audioData);
+    bool sendAudioDataFd(const QString &streamSessionId, const QDBusUnixFileDescriptor &audioFd);
+    QString endStreamRecognition(const QString &streamSessionId);
+    void terminate();
+    QStringList getSupportedFormats();
+
+Q_SIGNALS:
+    void RecognitionResult(const QString &streamSessionId, const QString &text);
+    void RecognitionPartialResult(const QString &streamSessionId, const QString &partialText);
+    void RecognitionError(const QString &streamSessionId, int errorCode, const QString &errorMessage);
+    void RecognitionCompleted(const QString &streamSessionId, const QString &finalText);
+
+private:
+    // Audio is recognized at most once per profile.interval(), the first
+    // result comes profile.delay() after the first audio.
+    struct Stream
+    {
+        QString id;
+        MockProfile profile;
+        bool fails = false;
+        qint64 received = 0;
+        qint64 recognized = 0;
+        int results = 0;
+        QTimer timer;
+        QScopedPointer<DAI_NAMESPACE::DAudioRing> ring;
+        QScopedPointer<QSocketNotifier> doorbell;
+    };
+
+    // nullptr when the call was answered with a D-Bus error.
+    Stream *openStream(const char *method);
+    void receive(Stream *stream, qint64 bytes);
+    void recognize(Stream *stream);
+    void drainRing(Stream *stream);
+    void closeStream(const QString &id);
+
+    QHash<QString, Stream *> streams;
+    QList<Stream *> closed;     // deleted once their timer returned
+    quint64 lastStream = 0;
+};
+
+class MockTextToSpeechSession : public MockObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.Session.TextToSpeech")
+public:
+    explicit MockTextToSpeechSession(MockDaemon *daemon);
+    ~MockTextToSpeechSession() override;
+
+public Q_SLOTS:
+    QString startStreamSynthesis(const QString &text, const QString &params);
+    QString endStreamSynthesis(const QString &streamSessionId);
+    void terminate();
+    QStringList getSupportedVoices();
+
+Q_SIGNALS:
+    void SynthesisResult(const QString &streamSessionId, const QByteArray &audioData);
+    void SynthesisError(const QString &streamSessionId, int errorCode, const QString &errorMessage);
+    void SynthesisCompleted(const QString &streamSessionId, const QByteArray &finalAudio);
+
+private:
+    struct Stream
+    {
+        QString id;
+        MockProfile profile;
+        bool fails = false;
+        int sent = 0;
+        QTimer timer;
+    };
+
+    void synthesize(Stream *stream);
+    void closeStream(const QString &id);
+
+    QHash<QString, Stream *> streams;
+    QList<Stream *> closed;     // deleted once their timer returned
+    quint64 lastStream = 0;
+};
+
+class MockImageRecognitionSession : public MockObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.Session.ImageRecognition")
+public:
+    explicit MockImageRecognitionSession(MockDaemon *daemon);
+
+public Q_SLOTS:
+    QString recognizeImage(const QString &imagePath, const QString &prompt, const QString &params);
+    QString recognizeImageData(const QByteArray &imageData, const QString &prompt, const QString &params);
+    QString recognizeImageDataFd(const QDBusUnixFileDescriptor &imageFd, const QString &prompt, const QString &params);
+    QString recognizeImageUrl(const QString &imageUrl, const QString &prompt, const QString &params);
+    void terminate();
+    QStringList getSupportedImageFormats();
+    int getMaxImageSize();
+
+private:
+    void answer(const char *method, qint64 received);
+};
+
+class MockOCRSession : public MockObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.deepin.ai.daemon.Session.OCR")
+public:
+    explicit MockOCRSession(MockDaemon *daemon);
+
+public Q_SLOTS:
+    QString recognizeFile(const QString &imageFile, const QString &params);
+    QString recognizeImage(const QByteArray &imageData, const QString &params);
+    QString recognizeImageFd(const QDBusUnixFileDescriptor &imageFd, const QString &params);
+    QString recognizeRegion(const QString &imageFile, const QString &region, const QString &params);
+    void terminate();
+    bool cancel(const QString &taskId);
+    QStringList getSupportedLanguages();
+    QStringList getSupportedFormats();
+    QString getCapabilities();
+
+private:
+    void answer(const char *method, qint64 received);
+};
+
+#endif // MOCKSESSIONS_H
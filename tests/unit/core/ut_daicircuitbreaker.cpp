@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/daicircuitbreaker.h"
+#include "daicircuitbreaker_p.h"
+
+#include <QSignalSpy>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DAICircuitBreaker
+ *
+ * The breaker is process-wide, every test restores its settings
+ * and closes it again so other clients are not affected.
+ */
+class TestDAICircuitBreaker : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        breaker = DAICircuitBreaker::instance();
+        ASSERT_NE(breaker, nullptr) << "DAICircuitBreaker instance should exist";
+
+        failureThreshold = breaker->failureThreshold();
+        openDuration = breaker->openDuration();
+        successThreshold = breaker->successThreshold();
+        breaker->reset();
+    }
+
+    void TearDown() override
+    {
+        breaker->setFailureThreshold(failureThreshold);
+        breaker->setOpenDuration(openDuration);
+        breaker->setSuccessThreshold(successThreshold);
+        breaker->reset();
+        TestBase::TearDown();
+    }
+
+    DAICircuitBreaker *breaker = nullptr;
+    int failureThreshold = 0;
+    int openDuration = 0;
+    int successThreshold = 0;
+};
+
+/**
+ * @brief Test that consecutive failures open the breaker and a success in between does not
+ */
+TEST_F(TestDAICircuitBreaker, opensAfterFailures)
+{
+    breaker->setFailureThreshold(3);
+    breaker->setOpenDuration(60 * 1000);
+    QSignalSpy spy(breaker, &DAICircuitBreaker::stateChanged);
+
+    breaker->recordFailure();
+    breaker->recordFailure();
+    breaker->recordSuccess();
+    breaker->recordFailure();
+    breaker->recordFailure();
+    EXPECT_EQ(breaker->state(), DAICircuitBreaker::Closed) << "A success should reset the failure count";
+    EXPECT_TRUE(breaker->allowRequest());
+
+    breaker->recordFailure();
+    EXPECT_EQ(breaker->state(), DAICircuitBreaker::Open);
+    EXPECT_FALSE(breaker->allowRequest()) << "Open breaker should fail requests fast";
+    ASSERT_EQ(spy.count(), 1);
+    EXPECT_EQ(spy.first().first().value<DAICircuitBreaker::State>(), DAICircuitBreaker::Open);
+}
+
+/**
+ * @brief Test that a single probe is let through after the open duration and decides the state
+ */
+TEST_F(TestDAICircuitBreaker, halfOpenProbe)
+{
+    breaker->setFailureThreshold(1);
+    breaker->setOpenDuration(50);
+
+    breaker->recordFailure();
+    ASSERT_EQ(breaker->state(), DAICircuitBreaker::Open);
+    EXPECT_FALSE(breaker->allowRequest());
+
+    QTest::qWait(80);
+    EXPECT_TRUE(breaker->allowRequest()) << "A probe should be allowed after the open duration";
+    EXPECT_EQ(breaker->state(), DAICircuitBreaker::HalfOpen);
+    EXPECT_FALSE(breaker->allowRequest()) << "Only one probe should run at a time";
+
+    breaker->recordFailure();
+    EXPECT_EQ(breaker->state(), DAICircuitBreaker::Open) << "A failed probe should reopen the breaker";
+
+    QTest::qWait(80);
+    EXPECT_TRUE(breaker->allowRequest());
+    breaker->recordSuccess();
+    EXPECT_EQ(breaker->state(), DAICircuitBreaker::Closed) << "A successful probe should close the breaker";
+}
+
+/**
+ * @brief Test that a zero threshold disables the breaker
+ */
+TEST_F(TestDAICircuitBreaker, disabled)
+{
+    breaker->setFailureThreshold(0);
+    for (int i = 0; i < 100; ++i)
+        breaker->recordFailure();
+
+    EXPECT_EQ(breaker->state(), DAICircuitBreaker::Closed);
+    EXPECT_TRUE(breaker->allowRequest());
+}
+
+/**
+ * @brief Test that only transport errors count as failures
+ */
+TEST_F(TestDAICircuitBreaker, transportFailures)
+{
+    EXPECT_TRUE(DAICircuitBreakerPrivate::isTransportFailure(QDBusError(QDBusError::NoReply, "")));
+    EXPECT_TRUE(DAICircuitBreakerPrivate::isTransportFailure(QDBusError(QDBusError::ServiceUnknown, "")));
+    EXPECT_FALSE(DAICircuitBreakerPrivate::isTransportFailure(QDBusError()));
+    EXPECT_FALSE(DAICircuitBreakerPrivate::isTransportFailure(QDBusError(QDBusError::InvalidArgs, "")))
+        << "An error reply still proves the daemon is alive";
+}
@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/daiencodedparams.h"
+#include "daiencodedparams_p.h"
+#include "nlp/dchatcompletions.h"
+#include "nlp/dchatcompletions_p.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DAIEncodedParams
+ */
+class TestDAIEncodedParams : public TestBase
+{
+};
+
+/**
+ * @brief Test that typed parameters leave out unset members and let extra override them
+ */
+TEST_F(TestDAIEncodedParams, typedParams)
+{
+    EXPECT_TRUE(DAIChatParams().toHash().isEmpty()) << "Unset members should be left out";
+
+    DAIChatParams chat;
+    chat.model = "local-model";
+    chat.temperature = 0;
+    chat.maxTokens = 256;
+    chat.extra.insert(kParamModel, "other-model");
+    QVariantHash hash = chat.toHash();
+    EXPECT_EQ(hash.value(kParamModel).toString(), QString("other-model"));
+    EXPECT_EQ(hash.value(kParamTemperature).toDouble(), 0.0) << "Zero is a valid temperature";
+    EXPECT_EQ(hash.value(kParamMaxTokens).toInt(), 256);
+    EXPECT_FALSE(hash.contains(kParamTopP));
+
+    DAISynthesisParams synthesis;
+    synthesis.voice = "x4_yezi";
+    synthesis.speed = 50;
+    hash = synthesis.toHash();
+    EXPECT_EQ(hash.size(), 2);
+    EXPECT_EQ(hash.value(kParamVoice).toString(), QString("x4_yezi"));
+    EXPECT_EQ(hash.value(kParamSpeed).toInt(), 50);
+
+    DAISpeechParams speech;
+    speech.language = "zh_CN";
+    speech.sampleRate = 16000;
+    DAIEncodedParams encoded(speech);
+    EXPECT_EQ(encoded.value(kParamSampleRate).toInt(), 16000);
+    EXPECT_EQ(QJsonDocument::fromJson(encoded.json()).object().value(kParamLanguage).toString(), QString("zh_CN"));
+}
+
+/**
+ * @brief Test that parameters are serialized once while their hash is not modified
+ */
+TEST_F(TestDAIEncodedParams, encodedOnce)
+{
+    DAIEncodedParams encoded(QVariantHash { { kParamModel, "local-model" }, { kParamTemperature, 0.5 } });
+    EXPECT_FALSE(encoded.isEmpty());
+    EXPECT_TRUE(DAIParamsCache::encode(encoded).isSharedWith(encoded.json()))
+        << "Passing the handle should reuse its encoding";
+
+    DAIEncodedParams copy = encoded;
+    EXPECT_TRUE(copy.json().isSharedWith(encoded.json()));
+
+    QVariantHash modified = encoded;
+    modified.insert(kParamMaxTokens, 16);
+    const QByteArray json = DAIParamsCache::encode(modified);
+    EXPECT_FALSE(json.isSharedWith(encoded.json())) << "A modified copy must be serialized again";
+    EXPECT_EQ(QJsonDocument::fromJson(json).object().value(kParamMaxTokens).toInt(), 16);
+    EXPECT_TRUE(DAIParamsCache::encode(modified).isSharedWith(json)) << "Recently encoded hashes should be cached";
+
+    EXPECT_EQ(DAIParamsCache::encode({}), QByteArray("{}"));
+    EXPECT_TRUE(DAIEncodedParams().isEmpty());
+    EXPECT_EQ(DAIParamsCache::members("{}"), QByteArray());
+    EXPECT_EQ(DAIParamsCache::members("{\"a\":1}"), QByteArray("\"a\":1"));
+}
+
+/**
+ * @brief Test that chat messages of an unchanged history prefix are not encoded again
+ */
+TEST_F(TestDAIEncodedParams, chatMessages)
+{
+    DChatCompletions chat;
+    DChatCompletionsPrivate *d = chat.d.data();
+
+    QList<ChatHistory> history { { kChatRoleUser, "Hello" }, { kChatRoleAssistant, "Hi, how can I help?" } };
+    const DAIEncodedParams params(QVariantHash { { kParamModel, "local-model" } });
+    QJsonObject root = QJsonDocument::fromJson(d->packageParams(history, params).toUtf8()).object();
+    EXPECT_EQ(root.value(kParamModel).toString(), QString("local-model"));
+    QJsonArray messages = root.value("messages").toArray();
+    ASSERT_EQ(messages.size(), 2);
+    EXPECT_EQ(messages.at(1).toObject().value("role").toString(), QString(kChatRoleAssistant));
+    EXPECT_EQ(messages.at(1).toObject().value("content").toString(), QString("Hi, how can I help?"));
+
+    const QByteArray first = d->encodedMessages.first();
+    history.append({ kChatRoleUser, "Tell me a joke" });
+    root = QJsonDocument::fromJson(d->packageParams(history, {}).toUtf8()).object();
+    EXPECT_EQ(root.value("messages").toArray().size(), 3);
+    EXPECT_FALSE(root.contains(kParamModel));
+    EXPECT_TRUE(d->encodedMessages.first().isSharedWith(first)) << "The unchanged prefix should be reused";
+
+    history[0].content = "Good morning";
+    root = QJsonDocument::fromJson(d->packageParams(history, {}).toUtf8()).object();
+    EXPECT_EQ(root.value("messages").toArray().at(0).toObject().value("content").toString(), QString("Good morning"));
+
+    const QVariantHash replaced { { "messages", QVariantList() } };
+    root = QJsonDocument::fromJson(d->packageParams(history, replaced).toUtf8()).object();
+    EXPECT_TRUE(root.value("messages").toArray().isEmpty()) << "Messages in params should replace the history";
+}
@@ -0,0 +1,48 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "daifdpayload_p.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for the file descriptor payload transport
+ */
+class TestDAIFdPayload : public TestBase
+{
+};
+
+/**
+ * @brief Test that payloads are copied into a sealed memfd
+ */
+TEST_F(TestDAIFdPayload, fromData)
+{
+    const QByteArray data = QByteArray(DAIFdPayload::kThreshold * 2, 'x') + "tail";
+    QDBusUnixFileDescriptor payload = DAIFdPayload::fromData(data);
+    ASSERT_TRUE(payload.isValid()) << "memfd should be created";
+
+    const int fd = payload.fileDescriptor();
+    QByteArray readBack(data.size(), 0);
+    ASSERT_EQ(pread(fd, readBack.data(), readBack.size(), 0), data.size());
+    EXPECT_EQ(readBack, data) << "memfd should hold the payload";
+
+    const int seals = fcntl(fd, F_GET_SEALS);
+    EXPECT_TRUE(seals & F_SEAL_WRITE) << "Payload should be sealed against writes";
+    EXPECT_TRUE(seals & F_SEAL_SHRINK) << "Payload should be sealed against truncation";
+    EXPECT_LT(pwrite(fd, "y", 1, 0), 0) << "Writing to a sealed memfd should fail";
+}
+
+/**
+ * @brief Test that small payloads and missing interfaces stay on the inline path
+ */
+TEST_F(TestDAIFdPayload, preferred)
+{
+    EXPECT_FALSE(DAIFdPayload::preferred(nullptr, "recognizeImageFd", DAIFdPayload::kThreshold * 4));
+    EXPECT_FALSE(DAIFdPayload::preferred(nullptr, "recognizeImageFd", 16));
+}
@@ -0,0 +1,103 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "daihedging_p.h"
+#include "nlp/dchatcompletions.h"
+#include "nlp/dfunctioncalling.h"
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for request hedging
+ *
+ * Latencies are process-wide, every test records under its own capability.
+ */
+class TestDAIHedging : public TestBase
+{
+};
+
+/**
+ * @brief Test that only requests to another model than the secondary one are hedged
+ */
+TEST_F(TestDAIHedging, isEnabled)
+{
+    DAIHedgingPolicy policy;
+    EXPECT_FALSE(DAIHedging::isEnabled(policy, {})) << "Hedging should be off by default";
+
+    policy.secondaryModel = "cloud-model";
+    EXPECT_TRUE(DAIHedging::isEnabled(policy, {}));
+    EXPECT_TRUE(DAIHedging::isEnabled(policy, { { "model", "local-model" } }));
+    EXPECT_FALSE(DAIHedging::isEnabled(policy, { { "model", "cloud-model" } }));
+
+    QVariantHash params { { "model", "local-model" }, { "temperature", 0.5 } };
+    QVariantHash secondary = DAIHedging::secondaryParams(policy, params);
+    EXPECT_EQ(secondary.value("model").toString(), QString("cloud-model"));
+    EXPECT_EQ(secondary.value("temperature").toDouble(), 0.5);
+    EXPECT_EQ(DAIHedging::model(params), QString("local-model"));
+}
+
+/**
+ * @brief Test that the hedge delay follows the percentile of recent latencies
+ */
+TEST_F(TestDAIHedging, delay)
+{
+    DAIHedgingPolicy policy;
+    policy.secondaryModel = "cloud-model";
+    policy.percentile = 90;
+    policy.minimumDelay = 0;
+
+    for (int i = 1; i < 8; ++i)
+        DAIHedging::recordLatency("TestDelay", "local-model", i * 100);
+    EXPECT_EQ(DAIHedging::delay("TestDelay", "local-model", policy), -1) << "Too few latencies to hedge";
+
+    for (int i = 8; i <= 10; ++i)
+        DAIHedging::recordLatency("TestDelay", "local-model", i * 100);
+    EXPECT_EQ(DAIHedging::delay("TestDelay", "local-model", policy), 900);
+    EXPECT_EQ(DAIHedging::delay("TestDelay", "other-model", policy), -1) << "Latencies are tracked per model";
+
+    policy.percentile = 50;
+    EXPECT_EQ(DAIHedging::delay("TestDelay", "local-model", policy), 500);
+
+    policy.minimumDelay = 700;
+    EXPECT_EQ(DAIHedging::delay("TestDelay", "local-model", policy), 700) << "Never hedge sooner than minimumDelay";
+
+    // Old latencies leave the window.
+    for (int i = 0; i < 64; ++i)
+        DAIHedging::recordLatency("TestDelay", "local-model", 10);
+    policy.minimumDelay = 0;
+    EXPECT_EQ(DAIHedging::delay("TestDelay", "local-model", policy), 10);
+}
+
+/**
+ * @brief Test that a hedged request fails only once both legs failed
+ */
+TEST_F(TestDAIHedging, hedgeState)
+{
+    DAIHedgeState state;
+    EXPECT_EQ(state.winner, -1);
+    EXPECT_FALSE(state.fail(DAIHedging::Primary)) << "Secondary may still answer";
+    EXPECT_TRUE(state.fail(DAIHedging::Secondary));
+}
+
+/**
+ * @brief Test the hedging policy accessors of the clients
+ */
+TEST_F(TestDAIHedging, clientPolicy)
+{
+    DAIHedgingPolicy policy;
+    policy.secondaryModel = "cloud-model";
+    policy.percentile = 99;
+
+    DChatCompletions chat;
+    EXPECT_TRUE(chat.hedgingPolicy().secondaryModel.isEmpty());
+    chat.setHedgingPolicy(policy);
+    EXPECT_EQ(chat.hedgingPolicy().secondaryModel, QString("cloud-model"));
+    EXPECT_EQ(chat.hedgingPolicy().percentile, 99);
+
+    DFunctionCalling func;
+    func.setHedgingPolicy(policy);
+    EXPECT_EQ(func.hedgingPolicy().secondaryModel, QString("cloud-model"));
+}
@@ -0,0 +1,250 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/daimetrics.h"
+#include "daimetrics_p.h"
+#include "daierror.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DAIMetrics
+ */
+class TestDAIMetrics : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        metrics = DAIMetrics::instance();
+        ASSERT_NE(metrics, nullptr) << "DAIMetrics instance should exist";
+        metrics->setEnabled(true);
+        metrics->reset();
+    }
+
+    void TearDown() override
+    {
+        metrics->setDump(0, DAIMetrics::Prometheus);
+        metrics->setEnabled(true);
+        metrics->reset();
+        TestBase::TearDown();
+    }
+
+    DAIMetrics *metrics = nullptr;
+};
+
+/**
+ * @brief Test that histogram buckets keep small values exact and large ones within their precision
+ */
+TEST_F(TestDAIMetrics, histogramBuckets)
+{
+    for (qint64 value = 0; value < DAIHistogram::kSubBuckets; ++value)
+        EXPECT_EQ(DAIHistogram::bucketValue(DAIHistogram::bucketIndex(value)), value);
+
+    const qint64 values[] = { 64, 100, 1000, 12345, 999999, 60000000, qint64(1) << 38 };
+    for (qint64 value : values) {
+        const qint64 bucket = DAIHistogram::bucketValue(DAIHistogram::bucketIndex(value));
+        EXPECT_LE(qAbs(bucket - value), value / DAIHistogram::kSubBuckets) << "Value " << value;
+    }
+
+    EXPECT_LT(DAIHistogram::bucketIndex(qint64(1) << 60), DAIHistogram::kBuckets) << "Huge values should be clamped";
+    EXPECT_LT(DAIHistogram::bucketIndex(1000), DAIHistogram::bucketIndex(1100));
+}
+
+/**
+ * @brief Test that percentiles pick the value at their rank
+ */
+TEST_F(TestDAIMetrics, histogramPercentiles)
+{
+    DAIHistogram histogram;
+    EXPECT_EQ(histogram.percentile(50), 0) << "Empty histograms report 0";
+
+    for (qint64 value = 1; value <= 1000; ++value)
+        histogram.record(value * 1000);
+
+    EXPECT_EQ(histogram.count(), 1000u);
+    EXPECT_EQ(histogram.min(), 1000);
+    EXPECT_EQ(histogram.max(), 1000000);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 500500.0);
+    EXPECT_NEAR(histogram.percentile(50), 500000, 500000 / DAIHistogram::kSubBuckets);
+    EXPECT_NEAR(histogram.percentile(90), 900000, 900000 / DAIHistogram::kSubBuckets);
+    EXPECT_NEAR(histogram.percentile(99), 990000, 990000 / DAIHistogram::kSubBuckets);
+    EXPECT_NEAR(histogram.percentile(99.9), 999000, 999000 / DAIHistogram::kSubBuckets);
+    EXPECT_EQ(histogram.percentile(100), 1000000) << "The top percentile is clamped to the maximum";
+}
+
+/**
+ * @brief Test that calls, errors and bytes are recorded per series
+ */
+TEST_F(TestDAIMetrics, record)
+{
+    DAIMetricsPrivate::record("DTest.call", 100, 0, 10, 20);
+    DAIMetricsPrivate::record("DTest.call", 300, AIErrorCode::RequestTimeout, 5);
+
+    DAIMetrics::Series series = metrics->series("DTest.call");
+    EXPECT_EQ(series.name, QString("DTest.call"));
+    EXPECT_EQ(series.calls, 2u);
+    EXPECT_EQ(series.errors.value(AIErrorCode::RequestTimeout), 1u);
+    EXPECT_EQ(series.bytesSent, 15u);
+    EXPECT_EQ(series.bytesReceived, 20u);
+    EXPECT_EQ(series.min, 100);
+    EXPECT_EQ(series.max, 300);
+
+    metrics->setEnabled(false);
+    DAIMetricsPrivate::record("DTest.call", 100);
+    EXPECT_EQ(metrics->series("DTest.call").calls, 2u) << "Nothing should be recorded while disabled";
+    EXPECT_EQ(DAIMetricsPrivate::utf8Size("text"), 0);
+    metrics->setEnabled(true);
+
+    EXPECT_EQ(DAIMetricsPrivate::utf8Size(QString::fromUtf8("a\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80")), 10);
+
+    {
+        DAIThreadError error;
+        error = DTK_CORE_NAMESPACE::DError(AIErrorCode::InvalidParameter, "");
+        DAICallMetric metric("DTest.blocking", &error);
+        metric.addSent("abc");
+        metric.addReceived(7);
+    }
+    series = metrics->series("DTest.blocking");
+    EXPECT_EQ(series.calls, 1u);
+    EXPECT_EQ(series.errors.value(AIErrorCode::InvalidParameter), 1u);
+    EXPECT_EQ(series.bytesSent, 3u);
+    EXPECT_EQ(series.bytesReceived, 7u);
+
+    QList<DAIMetrics::Series> list = metrics->snapshot();
+    ASSERT_EQ(list.size(), 2);
+    EXPECT_EQ(list.at(0).name, QString("DTest.blocking")) << "Snapshots should be sorted by name";
+
+    metrics->reset();
+    EXPECT_TRUE(metrics->snapshot().isEmpty());
+}
+
+/**
+ * @brief Test that asynchronous requests record their stages once and their total at the end
+ */
+TEST_F(TestDAIMetrics, pendingRequest)
+{
+    DAIMetricsPrivate::begin(42, "DTest.stream", 8);
+    DAIMetricsPrivate::mark(42, "firstToken");
+    DAIMetricsPrivate::mark(42, "firstToken");
+    DAIMetricsPrivate::addReceived(42, 4);
+    DAIMetricsPrivate::addSent(42, 2);
+    EXPECT_EQ(metrics->series("DTest.stream").calls, 0u) << "Requests should only count once they end";
+
+    DAIMetricsPrivate::end(42, NoError, 6);
+    DAIMetricsPrivate::end(42, AIErrorCode::RequestCancelled);
+    DAIMetricsPrivate::mark(42, "firstToken");
+
+    DAIMetrics::Series series = metrics->series("DTest.stream");
+    EXPECT_EQ(series.calls, 1u) << "Ending twice should be ignored";
+    EXPECT_TRUE(series.errors.isEmpty());
+    EXPECT_EQ(series.bytesSent, 10u);
+    EXPECT_EQ(series.bytesReceived, 10u);
+    EXPECT_EQ(metrics->series("DTest.stream.firstToken").calls, 1u) << "A stage should be recorded once per request";
+    EXPECT_LE(metrics->series("DTest.stream.firstToken").max, series.max);
+
+    DAIMetricsPrivate::begin(0, "DTest.stream");
+    EXPECT_EQ(metrics->snapshot().size(), 2) << "Id 0 is never a request";
+}
+
+/**
+ * @brief Test the Prometheus and JSON output
+ */
+TEST_F(TestDAIMetrics, output)
+{
+    DAIMetricsPrivate::record("DTest.call", 2000, AIErrorCode::APIServerNotAvailable, 10, 0);
+
+    const QByteArray prometheus = metrics->toPrometheus();
+    EXPECT_TRUE(prometheus.contains("# TYPE dtkai_request_duration_seconds summary"));
+    EXPECT_TRUE(prometheus.contains("dtkai_request_duration_seconds{series=\"DTest.call\",quantile=\"0.99\"} 0.002"));
+    EXPECT_TRUE(prometheus.contains("dtkai_request_duration_seconds_count{series=\"DTest.call\"} 1"));
+    EXPECT_TRUE(prometheus.contains("dtkai_request_errors_total{series=\"DTest.call\",code=\"1\"} 1"));
+    EXPECT_TRUE(prometheus.contains("dtkai_bytes_total{series=\"DTest.call\",direction=\"sent\"} 10"));
+    EXPECT_FALSE(prometheus.contains("direction=\"received\"")) << "Empty byte counters should be left out";
+
+    const QJsonObject root = QJsonDocument::fromJson(metrics->toJson()).object();
+    EXPECT_EQ(root.value("unit").toString(), QString("us"));
+    const QJsonArray series = root.value("series").toArray();
+    ASSERT_EQ(series.size(), 1);
+    const QJsonObject obj = series.at(0).toObject();
+    EXPECT_EQ(obj.value("name").toString(), QString("DTest.call"));
+    EXPECT_EQ(obj.value("calls").toInt(), 1);
+    EXPECT_EQ(obj.value("p50").toInt(), 2000);
+    EXPECT_EQ(obj.value("errors").toObject().value("1").toInt(), 1);
+}
+
+/**
+ * @brief Test that the periodic dump is emitted and written to its file
+ */
+TEST_F(TestDAIMetrics, dump)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("metrics.json");
+
+    DAIMetricsPrivate::record("DTest.call", 100);
+    QSignalSpy spy(metrics, &DAIMetrics::dumped);
+    metrics->setDump(10, DAIMetrics::Json, path);
+    ASSERT_TRUE(spy.wait(1000)) << "The dump should be emitted periodically";
+    EXPECT_EQ(QJsonDocument::fromJson(spy.first().first().toByteArray()).object().value("unit").toString(), QString("us"));
+
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_FALSE(QJsonDocument::fromJson(file.readAll()).object().value("series").toArray().isEmpty());
+
+    metrics->setDump(0, DAIMetrics::Json);
+    QTest::qWait(20);
+    spy.clear();
+    QTest::qWait(50);
+    EXPECT_TRUE(spy.isEmpty()) << "An interval of 0 should stop dumping";
+}
+
+/**
+ * @brief Test that stream timing reports token gaps and records them into the series
+ */
+TEST_F(TestDAIMetrics, streamTimer)
+{
+    DAIStreamTimer timer;
+    timer.output();
+    EXPECT_EQ(timer.stats().tokens, 0) << "Outputs before the request was sent are not counted";
+    EXPECT_EQ(timer.stats().timeToFirstToken, -1);
+
+    timer.start();
+    DAIStreamStats stats = timer.stats();
+    EXPECT_EQ(stats.tokens, 0);
+    EXPECT_EQ(stats.timeToFirstToken, -1) << "Nothing was streamed yet";
+
+    timer.output();
+    stats = timer.stats();
+    EXPECT_EQ(stats.tokens, 1);
+    EXPECT_GE(stats.timeToFirstToken, 0);
+    EXPECT_EQ(stats.gapMax, 0);
+    EXPECT_EQ(stats.tokensPerSecond, 0.0) << "A rate needs two tokens";
+
+    for (int i = 0; i < 4; ++i) {
+        QTest::qWait(2);
+        timer.output();
+    }
+    stats = timer.stats();
+    EXPECT_EQ(stats.tokens, 5);
+    EXPECT_GE(stats.gapMin, 1000);
+    EXPECT_LE(stats.gapMin, stats.gapP50);
+    EXPECT_LE(stats.gapP50, stats.gapP90);
+    EXPECT_LE(stats.gapP90, stats.gapP99);
+    EXPECT_EQ(stats.gapP99, stats.gapMax);
+    EXPECT_GT(stats.tokensPerSecond, 0.0);
+
+    timer.recordGaps("DTest.stream");
+    EXPECT_EQ(metrics->series("DTest.stream.interToken").calls, 4u);
+    EXPECT_EQ(metrics->series("DTest.stream.interToken").max, stats.gapMax);
+    EXPECT_EQ(metrics->series("DTest.stream.timePerToken").calls, 1u);
+}
@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/daimodelrouter.h"
+#include "daimodelrouter_p.h"
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DAIModelRouter
+ *
+ * The router is process-wide, every test starts from a clean scoreboard
+ * and a model list of its own instead of asking the daemon.
+ */
+class TestDAIModelRouter : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        router = DAIModelRouter::instance();
+        ASSERT_NE(router, nullptr) << "DAIModelRouter instance should exist";
+
+        smoothing = router->smoothing();
+        staleAfter = router->staleAfter();
+        router->reset();
+        setModels({ "local", "cloud-a", "cloud-b" }, "local");
+    }
+
+    void TearDown() override
+    {
+        router->setSmoothing(smoothing);
+        router->setStaleAfter(staleAfter);
+        router->reset();
+        TestBase::TearDown();
+    }
+
+    void setModels(const QStringList &models, const QString &current)
+    {
+        DAIModelRouterPrivate::Candidates candidates;
+        candidates.models = models;
+        candidates.current = current;
+        candidates.fetched.start();
+        router->d->cache.insert("TestChat", candidates);
+    }
+
+    DAIModelRouter *router = nullptr;
+    double smoothing = 0;
+    int staleAfter = 0;
+};
+
+/**
+ * @brief Test that the scores are moving averages of the outcomes
+ */
+TEST_F(TestDAIModelRouter, score)
+{
+    router->setSmoothing(0.5);
+    router->recordOutcome("TestChat", "local", 100, true);
+    EXPECT_EQ(router->score("TestChat", "local").latency, 100);
+    EXPECT_EQ(router->score("TestChat", "local").errorRate, 0);
+
+    router->recordOutcome("TestChat", "local", 300, false);
+    const DAIModelRouter::Score score = router->score("TestChat", "local");
+    EXPECT_EQ(score.latency, 200);
+    EXPECT_EQ(score.errorRate, 0.5);
+    EXPECT_EQ(score.samples, 2u);
+    EXPECT_EQ(router->score("Other", "local").samples, 0u) << "Scores are kept per capability";
+}
+
+/**
+ * @brief Test that traffic leaves the current model once it misses the SLO
+ */
+TEST_F(TestDAIModelRouter, selectModel)
+{
+    DAIModelSLO slo;
+    slo.latency = 500;
+    EXPECT_EQ(router->selectModel("TestChat", slo), QString("local")) << "Unmeasured current model should be tried first";
+
+    router->recordOutcome("TestChat", "local", 200, true);
+    router->recordOutcome("TestChat", "cloud-a", 100, true);
+    EXPECT_EQ(router->selectModel("TestChat", slo), QString("local")) << "Current model meeting the SLO should be kept";
+
+    router->setSmoothing(1);
+    router->recordOutcome("TestChat", "local", 900, true);
+    EXPECT_EQ(router->selectModel("TestChat", slo), QString("cloud-a")) << "Slow current model should be left";
+
+    router->recordOutcome("TestChat", "cloud-a", 100, false);
+    EXPECT_EQ(router->selectModel("TestChat", slo), QString("cloud-b")) << "Unmeasured model should be explored";
+
+    router->recordOutcome("TestChat", "cloud-b", 2000, true);
+    EXPECT_EQ(router->selectModel("TestChat", slo), QString("local")) << "Least bad model when none meets the SLO";
+
+    router->setStaleAfter(0);
+    router->recordOutcome("TestChat", "cloud-a", 100, true);
+    EXPECT_EQ(router->selectModel("TestChat", slo), QString("local")) << "Stale scores should not count";
+}
+
+/**
+ * @brief Test that route() injects the model and respects an explicit one
+ */
+TEST_F(TestDAIModelRouter, route)
+{
+    router->setSmoothing(1);
+    router->recordOutcome("TestChat", "local", 900, true);
+    router->recordOutcome("TestChat", "cloud-a", 100, true);
+    router->recordOutcome("TestChat", "cloud-b", 300, true);
+
+    DAIModelSLO slo;
+    slo.latency = 500;
+    QVariantHash params { { "temperature", 0.2 } };
+    EXPECT_EQ(router->route("TestChat", &params, slo), QString("cloud-a"));
+    EXPECT_EQ(params.value("model").toString(), QString("cloud-a"));
+
+    QVariantHash fixed { { "model", "local" } };
+    EXPECT_EQ(router->route("TestChat", &fixed, slo), QString("local"));
+    EXPECT_EQ(fixed.value("model").toString(), QString("local"));
+
+    setModels({}, QString());
+    QVariantHash none;
+    EXPECT_TRUE(router->route("TestChat", &none, slo).isEmpty());
+    EXPECT_FALSE(none.contains("model")) << "Without candidates the daemon should choose";
+}
@@ -0,0 +1,167 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/dairequestoptions.h"
+#include "dairequestoptions_p.h"
+#include "daierror.h"
+
+#include <QThread>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for per-request deadlines and cancellation tokens
+ */
+class TestDAIRequestOptions : public TestBase
+{
+};
+
+/**
+ * @brief Test that copies of a token share their state
+ */
+TEST_F(TestDAIRequestOptions, tokenCopies)
+{
+    DAICancellationToken token;
+    DAIRequestOptions options;
+    options.cancellation = token;
+
+    EXPECT_FALSE(options.cancellation.isCancelled());
+    token.cancel();
+    EXPECT_TRUE(options.cancellation.isCancelled()) << "Cancelling one copy should cancel all of them";
+    EXPECT_FALSE(DAICancellationToken().isCancelled()) << "A new token should not share state";
+}
+
+/**
+ * @brief Test that onCancelled runs exactly once, also for tokens that are already cancelled
+ */
+TEST_F(TestDAIRequestOptions, onCancelled)
+{
+    QObject context;
+    DAICancellationToken token;
+    int calls = 0;
+    token.onCancelled(&context, [&calls]() { ++calls; });
+
+    token.cancel();
+    token.cancel();
+    EXPECT_EQ(calls, 1);
+
+    int lateCalls = 0;
+    token.onCancelled(&context, [&lateCalls]() { ++lateCalls; });
+    EXPECT_TRUE(QTest::qWaitFor([&lateCalls]() { return lateCalls == 1; }, 1000))
+        << "Watching a cancelled token should still invoke the callback";
+    QTest::qWait(10);
+    EXPECT_EQ(lateCalls, 1);
+}
+
+/**
+ * @brief Test that option errors are reported before anything is sent
+ */
+TEST_F(TestDAIRequestOptions, optionsError)
+{
+    DAIRequestOptions options;
+    EXPECT_EQ(requestOptionsError(options).getErrorCode(), NoError);
+    EXPECT_EQ(requestTimeout(options, 1000), 1000) << "Without deadline the default timeout should apply";
+
+    options.deadline = QDeadlineTimer(0);
+    EXPECT_EQ(requestOptionsError(options).getErrorCode(), RequestTimeout);
+    EXPECT_EQ(requestTimeout(options, 1000), 1) << "An expired deadline should still leave a valid timeout";
+
+    options.deadline = QDeadlineTimer(60 * 1000);
+    EXPECT_LE(requestTimeout(options, 1000), 1000) << "The deadline should never extend the default timeout";
+
+    options.cancellation.cancel();
+    EXPECT_EQ(requestOptionsError(options).getErrorCode(), RequestCancelled);
+}
+
+/**
+ * @brief Test that a watched request is aborted once, on its deadline or on cancel
+ */
+TEST_F(TestDAIRequestOptions, watches)
+{
+    QObject context;
+    DAIRequestWatches watches;
+    QList<int> aborted;
+    auto abort = [&aborted](const DTK_CORE_NAMESPACE::DError &error) {
+        aborted.append(error.getErrorCode());
+    };
+
+    DAIRequestOptions expiring;
+    expiring.deadline = QDeadlineTimer(20);
+    watches.watch(1, expiring, &context, abort);
+
+    DAICancellationToken token;
+    DAIRequestOptions cancellable;
+    cancellable.cancellation = token;
+    watches.watch(2, cancellable, &context, abort);
+
+    DAIRequestOptions released;
+    released.deadline = QDeadlineTimer(20);
+    watches.watch(3, released, &context, abort);
+    watches.release(3);
+
+    EXPECT_TRUE(QTest::qWaitFor([&aborted]() { return aborted.size() == 1; }, 1000));
+    EXPECT_EQ(aborted.value(0), RequestTimeout);
+
+    token.cancel();
+    EXPECT_TRUE(QTest::qWaitFor([&aborted]() { return aborted.size() == 2; }, 1000));
+    EXPECT_EQ(aborted.value(1), RequestCancelled);
+
+    QTest::qWait(50);
+    EXPECT_EQ(aborted.size(), 2) << "Released requests should never be aborted";
+}
+
+/**
+ * @brief Test that a token only held by the options of the caller still cancels
+ */
+TEST_F(TestDAIRequestOptions, watchesCallerToken)
+{
+    QObject context;
+    DAIRequestWatches watches;
+    QList<int> aborted;
+    auto abort = [&aborted](const DTK_CORE_NAMESPACE::DError &error) {
+        aborted.append(error.getErrorCode());
+    };
+
+    DAIRequestOptions options;
+    options.deadline = QDeadlineTimer(40LL * 24 * 3600 * 1000);
+    watches.watch(1, options, &context, abort);
+
+    DAIRequestOptions plain;
+    watches.watch(2, plain, &context, abort);
+
+    QTest::qWait(20);
+    EXPECT_TRUE(aborted.isEmpty()) << "A deadline beyond the range of QTimer should not expire early";
+
+    options.cancellation.cancel();
+    plain.cancellation.cancel();
+    EXPECT_TRUE(QTest::qWaitFor([&aborted]() { return aborted.size() == 2; }, 1000));
+    EXPECT_EQ(aborted.value(0), RequestCancelled);
+    EXPECT_EQ(aborted.value(1), RequestCancelled);
+}
+
+/**
+ * @brief Test that a request without deadline issued from a worker thread is watched in the thread of the client
+ */
+TEST_F(TestDAIRequestOptions, watchFromWorker)
+{
+    QObject context;
+    DAIRequestWatches watches;
+    QList<int> aborted;
+    DAIRequestOptions plain;
+
+    QScopedPointer<QThread> worker(QThread::create([&]() {
+        watches.watch(1, plain, &context, [&aborted](const DTK_CORE_NAMESPACE::DError &error) {
+            aborted.append(error.getErrorCode());
+        });
+    }));
+    worker->start();
+    ASSERT_TRUE(worker->wait(1000));
+    EXPECT_EQ(watches.watches.value(1)->thread(), context.thread()) << "The watch should move to the client";
+
+    plain.cancellation.cancel();
+    EXPECT_TRUE(QTest::qWaitFor([&aborted]() { return aborted.size() == 1; }, 1000)) << "Cancellation should reach the client";
+    EXPECT_EQ(aborted.value(0), RequestCancelled);
+}
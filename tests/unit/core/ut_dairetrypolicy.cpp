@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/dairetrypolicy.h"
+#include "dairetrypolicy_p.h"
+
+#include <QDBusConnection>
+#include <QDBusInterface>
+#include <QDBusMessage>
+#include <QMutex>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DAIRetryPolicy
+ *
+ * Policy and breaker are process-wide, every test restores their settings.
+ */
+class TestDAIRetryPolicy : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        policy = DAIRetryPolicy::instance();
+        ASSERT_NE(policy, nullptr) << "DAIRetryPolicy instance should exist";
+
+        maxAttempts = policy->maxAttempts();
+        baseDelay = policy->baseDelay();
+        maximumDelay = policy->maximumDelay();
+        retryBudget = policy->retryBudget();
+        budget = policy->d->budget;
+        failureThreshold = DAICircuitBreaker::instance()->failureThreshold();
+
+        policy->setBaseDelay(0);
+        DAICircuitBreaker::instance()->setFailureThreshold(1000);
+        DAICircuitBreaker::instance()->reset();
+    }
+
+    void TearDown() override
+    {
+        policy->setMaxAttempts(maxAttempts);
+        policy->setBaseDelay(baseDelay);
+        policy->setMaximumDelay(maximumDelay);
+        policy->setRetryBudget(retryBudget);
+        policy->d->budget = budget;
+        DAICircuitBreaker::instance()->setFailureThreshold(failureThreshold);
+        DAICircuitBreaker::instance()->reset();
+        TestBase::TearDown();
+    }
+
+    // Runs a call failing with error type through callWithRetry, returns the number of attempts.
+    int attempts(QDBusError::ErrorType type, const QDeadlineTimer &deadline = QDeadlineTimer(QDeadlineTimer::Forever))
+    {
+        DAIRequestOptions options;
+        options.deadline = deadline;
+        return attempts(type, options);
+    }
+
+    int attempts(QDBusError::ErrorType type, const DAIRequestOptions &options)
+    {
+        int count = 0;
+        callWithRetry([&count, type]() {
+            ++count;
+            if (type == QDBusError::NoError)
+                return QDBusPendingCall::fromCompletedCall(QDBusMessage::createMethodCall("org.deepin.test", "/", "org.deepin.test", "test").createReply());
+            return QDBusPendingCall::fromError(QDBusMessage::createError(type, "test"));
+        }, options);
+        return count;
+    }
+
+    DAIRetryPolicy *policy = nullptr;
+    int maxAttempts = 0;
+    int baseDelay = 0;
+    int maximumDelay = 0;
+    double retryBudget = 0;
+    double budget = 0;
+    int failureThreshold = 0;
+};
+
+/**
+ * @brief Test that only calls the daemon never answered are retried
+ */
+TEST_F(TestDAIRetryPolicy, transportFailures)
+{
+    policy->setMaxAttempts(3);
+    const DAIRetryPolicy::Statistics before = policy->statistics();
+
+    EXPECT_EQ(attempts(QDBusError::NoReply), 3) << "Timeouts should be retried up to maxAttempts";
+    EXPECT_EQ(attempts(QDBusError::InvalidArgs), 1) << "Error replies should not be retried";
+    EXPECT_EQ(attempts(QDBusError::NoError), 1);
+
+    const DAIRetryPolicy::Statistics after = policy->statistics();
+    EXPECT_EQ(after.calls - before.calls, 3u);
+    EXPECT_EQ(after.retries - before.retries, 2u);
+
+    policy->setMaxAttempts(1);
+    EXPECT_EQ(attempts(QDBusError::NoReply), 1) << "One attempt disables retries";
+}
+
+/**
+ * @brief Test that retries stop once the budget is spent
+ */
+TEST_F(TestDAIRetryPolicy, budget)
+{
+    policy->setMaxAttempts(5);
+    policy->setRetryBudget(0);
+    policy->d->budget = 2;
+    const quint64 exhausted = policy->statistics().budgetExhausted;
+
+    EXPECT_EQ(attempts(QDBusError::NoReply), 3) << "Two retries left in the budget";
+    EXPECT_EQ(attempts(QDBusError::NoReply), 1) << "Empty budget should stop retries";
+    EXPECT_EQ(policy->statistics().budgetExhausted - exhausted, 2u);
+
+    policy->setRetryBudget(0.5);
+    attempts(QDBusError::NoError);
+    EXPECT_EQ(attempts(QDBusError::NoReply), 2) << "Two calls earn one retry";
+}
+
+/**
+ * @brief Test that no retry outlives the deadline and none runs against an open breaker
+ */
+TEST_F(TestDAIRetryPolicy, deadlineAndBreaker)
+{
+    policy->setMaxAttempts(3);
+    policy->setBaseDelay(1000);
+    policy->setMaximumDelay(1000);
+    EXPECT_EQ(attempts(QDBusError::NoReply, QDeadlineTimer(0)), 1) << "Expired deadline should stop retries";
+
+    policy->setBaseDelay(0);
+    DAICircuitBreaker::instance()->setFailureThreshold(1);
+    DAICircuitBreaker::instance()->recordFailure();
+    ASSERT_EQ(DAICircuitBreaker::instance()->state(), DAICircuitBreaker::Open);
+    EXPECT_EQ(attempts(QDBusError::NoReply), 1) << "Open breaker should stop retries";
+}
+
+/**
+ * @brief Test that the attempt which is not retried still reaches the breaker
+ */
+TEST_F(TestDAIRetryPolicy, lastAttemptRecorded)
+{
+    policy->setMaxAttempts(1);
+    DAICircuitBreaker::instance()->setFailureThreshold(1);
+    EXPECT_EQ(attempts(QDBusError::NoReply), 1);
+    EXPECT_EQ(DAICircuitBreaker::instance()->state(), DAICircuitBreaker::Open) << "The only attempt should count as a failure";
+
+    DAICircuitBreaker::instance()->reset();
+    policy->setMaxAttempts(3);
+    DAICircuitBreaker::instance()->setFailureThreshold(3);
+    EXPECT_EQ(attempts(QDBusError::NoReply), 3);
+    EXPECT_EQ(DAICircuitBreaker::instance()->state(), DAICircuitBreaker::Open) << "Every attempt should count as a failure";
+}
+
+/**
+ * @brief Test that a cancelled request is not retried
+ */
+TEST_F(TestDAIRetryPolicy, cancellation)
+{
+    policy->setMaxAttempts(3);
+    DAIRequestOptions options;
+    options.cancellation.cancel();
+    EXPECT_EQ(attempts(QDBusError::NoReply, options), 1) << "Cancelled request should stop retries";
+}
+
+/**
+ * @brief Test that every attempt waits no longer than the deadline allows
+ */
+TEST_F(TestDAIRetryPolicy, attemptTimeout)
+{
+    QDBusInterface proxy("org.deepin.test", "/", "org.deepin.test", QDBusConnection("dtkai-test-none"));
+    proxy.setTimeout(30000);
+    policy->setMaxAttempts(2);
+
+    DAIRequestOptions options;
+    options.deadline = QDeadlineTimer(5000);
+    QList<int> timeouts;
+    QMutex lock;
+    callWithRetry([&]() {
+        timeouts.append(proxy.timeout());
+        const bool free = lock.tryLock();
+        if (free)
+            lock.unlock();
+        EXPECT_FALSE(free) << "The issue should hold the lock of the proxy";
+        return QDBusPendingCall::fromError(QDBusMessage::createError(QDBusError::NoReply, "test"));
+    }, options, &proxy, &lock);
+
+    ASSERT_EQ(timeouts.size(), 2);
+    for (int timeout : timeouts) {
+        EXPECT_GT(timeout, 0);
+        EXPECT_LE(timeout, 5000) << "An attempt should not outlive the deadline";
+    }
+    EXPECT_EQ(proxy.timeout(), 30000) << "The timeout of the proxy should be restored";
+
+    callWithRetry([&]() {
+        EXPECT_EQ(proxy.timeout(), 30000) << "Without a deadline the proxy keeps its timeout";
+        return QDBusPendingCall::fromError(QDBusMessage::createError(QDBusError::InvalidArgs, "test"));
+    }, DAIRequestOptions(), &proxy, &lock);
+}
@@ -0,0 +1,227 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/daischeduler.h"
+#include "daischeduler_p.h"
+#include "daiasync_p.h"
+
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <QDBusMessage>
+#include <QDBusPendingCall>
+#include <QTest>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DAIScheduler
+ *
+ * The scheduler is process-wide, every test uses a capability of its own.
+ */
+class TestDAIScheduler : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        scheduler = DAIScheduler::instance();
+        ASSERT_NE(scheduler, nullptr) << "DAIScheduler instance should exist";
+    }
+
+    quint64 submit(const QString &capability, DAIRequestPriority priority, QStringList *started, const QString &name)
+    {
+        DAIRequestOptions options;
+        options.priority = priority;
+        const quint64 id = nextRequestId();
+        DAISchedulerPrivate::submit(id, capability, options, &context, [started, name]() {
+            started->append(name);
+        });
+        return id;
+    }
+
+    DAIScheduler *scheduler = nullptr;
+    QObject context;
+};
+
+/**
+ * @brief Test that requests start right away without limits
+ */
+TEST_F(TestDAIScheduler, unlimited)
+{
+    QStringList started;
+    const quint64 id = submit("test-unlimited", DAIRequestPriority::Batch, &started, "a");
+    EXPECT_EQ(started, QStringList { "a" }) << "Request should start before submit returns";
+    EXPECT_EQ(scheduler->statistics("test-unlimited").running, 1);
+
+    DAISchedulerPrivate::finish(id);
+    EXPECT_EQ(scheduler->statistics("test-unlimited").running, 0);
+    EXPECT_EQ(scheduler->statistics("test-unlimited").dispatched, 1u);
+}
+
+/**
+ * @brief Test that queued requests start by priority once a slot frees up
+ */
+TEST_F(TestDAIScheduler, concurrencyLimit)
+{
+    const QString capability("test-concurrency");
+    scheduler->setConcurrencyLimit(capability, 1);
+    EXPECT_EQ(scheduler->concurrencyLimit(capability), 1);
+
+    QStringList started;
+    const quint64 first = submit(capability, DAIRequestPriority::Interactive, &started, "first");
+    const quint64 batch = submit(capability, DAIRequestPriority::Batch, &started, "batch");
+    const quint64 interactive = submit(capability, DAIRequestPriority::Interactive, &started, "interactive");
+    EXPECT_EQ(started, QStringList { "first" });
+    EXPECT_EQ(scheduler->statistics(capability).queued, 2);
+
+    DAISchedulerPrivate::finish(first);
+    EXPECT_TRUE(QTest::qWaitFor([&started]() { return started.size() == 2; }, 1000));
+    EXPECT_EQ(started.last(), QString("interactive")) << "Interactive request should overtake batch work";
+
+    DAISchedulerPrivate::finish(interactive);
+    EXPECT_TRUE(QTest::qWaitFor([&started]() { return started.size() == 3; }, 1000));
+    EXPECT_EQ(started.last(), QString("batch"));
+    DAISchedulerPrivate::finish(batch);
+
+    const DAIScheduler::Statistics stats = scheduler->statistics(capability);
+    EXPECT_EQ(stats.queued, 0);
+    EXPECT_EQ(stats.running, 0);
+    EXPECT_EQ(stats.dispatched, 3u);
+    scheduler->setConcurrencyLimit(capability, 0);
+}
+
+/**
+ * @brief Test that a request dropped while queued never starts
+ */
+TEST_F(TestDAIScheduler, dropQueued)
+{
+    const QString capability("test-drop");
+    scheduler->setConcurrencyLimit(capability, 1);
+
+    QStringList started;
+    const quint64 first = submit(capability, DAIRequestPriority::Interactive, &started, "first");
+    const quint64 dropped = submit(capability, DAIRequestPriority::Interactive, &started, "dropped");
+    DAISchedulerPrivate::finish(dropped);
+    DAISchedulerPrivate::finish(first);
+    QTest::qWait(50);
+
+    EXPECT_EQ(started, QStringList { "first" });
+    EXPECT_EQ(scheduler->statistics(capability).expired, 1u);
+    scheduler->setConcurrencyLimit(capability, 0);
+}
+
+/**
+ * @brief Test that blocking callers give up when their deadline expires in the queue
+ */
+TEST_F(TestDAIScheduler, blockingDeadline)
+{
+    const QString capability("test-blocking");
+    scheduler->setConcurrencyLimit(capability, 1);
+
+    const quint64 held = DAISchedulerPrivate::acquire(capability, DAIRequestOptions());
+    EXPECT_NE(held, 0u);
+
+    DAIRequestOptions options;
+    options.deadline = QDeadlineTimer(50);
+    EXPECT_EQ(DAISchedulerPrivate::acquire(capability, options), 0u) << "Deadline should expire in the queue";
+    EXPECT_EQ(scheduler->statistics(capability).expired, 1u);
+
+    DAISchedulerPrivate::finish(held);
+    {
+        DAISchedulerSlot slot(capability, options);
+        EXPECT_TRUE(slot.isAdmitted() || options.deadline.hasExpired());
+    }
+    EXPECT_EQ(scheduler->statistics(capability).running, 0);
+    scheduler->setConcurrencyLimit(capability, 0);
+}
+
+/**
+ * @brief Test that only the thread of the scheduler refuses to wait for a concurrency slot
+ */
+TEST_F(TestDAIScheduler, blockingOwnerThread)
+{
+    const QString capability("test-owner");
+    scheduler->setConcurrencyLimit(capability, 1);
+    ASSERT_EQ(scheduler->thread(), QThread::currentThread());
+
+    const quint64 held = DAISchedulerPrivate::acquire(capability, DAIRequestOptions());
+    EXPECT_NE(held, 0u);
+    {
+        DAISchedulerSlot slot(capability, DAIRequestOptions());
+        EXPECT_FALSE(slot.isAdmitted()) << "The scheduler thread should not wait for a slot it has to free";
+        EXPECT_EQ(slot.error().getErrorCode(), int(RequestRejected)) << "A refusal should not look like a daemon outage";
+    }
+
+    quint64 waited = 0;
+    QThread *worker = QThread::create([&waited, capability]() {
+        waited = DAISchedulerPrivate::acquire(capability, DAIRequestOptions());
+    });
+    worker->start();
+    EXPECT_FALSE(worker->wait(50)) << "Other threads should wait for a slot";
+
+    DAISchedulerPrivate::finish(held);
+    EXPECT_TRUE(worker->wait(1000));
+    EXPECT_NE(waited, 0u);
+    delete worker;
+
+    DAISchedulerPrivate::finish(waited);
+    EXPECT_EQ(scheduler->statistics(capability).running, 0);
+    scheduler->setConcurrencyLimit(capability, 0);
+}
+
+/**
+ * @brief Test that the token bucket spaces out requests
+ */
+TEST_F(TestDAIScheduler, rateLimit)
+{
+    const QString capability("test-rate");
+    scheduler->setRateLimit(capability, 20, 1);
+    EXPECT_DOUBLE_EQ(scheduler->rateLimit(capability), 20);
+    EXPECT_EQ(scheduler->rateBurst(capability), 1);
+
+    QStringList started;
+    const quint64 first = submit(capability, DAIRequestPriority::Interactive, &started, "first");
+    const quint64 second = submit(capability, DAIRequestPriority::Interactive, &started, "second");
+    EXPECT_EQ(started, QStringList { "first" }) << "Burst of one should hold back the second request";
+
+    EXPECT_TRUE(QTest::qWaitFor([&started]() { return started.size() == 2; }, 1000))
+        << "Second request should start once a token refilled";
+    EXPECT_GT(scheduler->statistics(capability).maxWaitTime, 0);
+
+    DAISchedulerPrivate::finish(first);
+    DAISchedulerPrivate::finish(second);
+    scheduler->setRateLimit(capability, 0);
+}
+
+/**
+ * @brief Test that a request admitted in a pool thread is watched in the thread of its client
+ */
+TEST_F(TestDAIScheduler, submitFromThreadPool)
+{
+    const QString capability("test-pool");
+    Qt::HANDLE finishedIn = nullptr;
+    quint64 id = 0;
+
+    QThreadPool::globalInstance()->start([this, capability, &finishedIn, &id]() {
+        id = nextRequestId();
+        DAISchedulerPrivate::submit(id, capability, DAIRequestOptions(), &context, [this, &finishedIn]() {
+            const QDBusPendingCall call = QDBusPendingCall::fromError(
+                        QDBusMessage::createError(QDBusError::Failed, "test"));
+            watchPendingCall(call, &context, [&finishedIn](const QDBusPendingCall &) {
+                finishedIn = QThread::currentThreadId();
+            });
+        });
+    });
+    ASSERT_TRUE(QThreadPool::globalInstance()->waitForDone(1000));
+
+    EXPECT_TRUE(QTest::qWaitFor([&finishedIn]() { return finishedIn != nullptr; }, 1000))
+        << "A watcher created off the client thread should still deliver";
+    EXPECT_EQ(finishedIn, QThread::currentThreadId());
+
+    DAISchedulerPrivate::finish(id);
+    EXPECT_EQ(scheduler->statistics(capability).running, 0);
+}
@@ -0,0 +1,169 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/dmodelmanager.h"
+#include "daisingleflight_p.h"
+
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QThread>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for in-flight request coalescing
+ */
+class TestDAISingleFlight : public TestBase
+{
+};
+
+/**
+ * @brief Test that every call runs while coalescing is disabled
+ */
+TEST_F(TestDAISingleFlight, disabled)
+{
+    DAISingleFlight flight;
+    EXPECT_FALSE(flight.isEnabled()) << "Coalescing should be opt-in";
+
+    int runs = 0;
+    std::function<int()> call = [&runs]() { return ++runs; };
+    EXPECT_EQ(flight.run<int>("key", call), 1);
+    EXPECT_EQ(flight.run<int>("key", call), 2);
+    EXPECT_EQ(flight.statistics().calls, 0u);
+    EXPECT_EQ(flight.statistics().hits, 0u);
+}
+
+/**
+ * @brief Test that concurrent identical calls share one result and finished calls are not cached
+ */
+TEST_F(TestDAISingleFlight, concurrentCalls)
+{
+    DAISingleFlight flight;
+    flight.setEnabled(true);
+
+    QAtomicInt runs;
+    QSemaphore started;
+    QSemaphore release;
+    std::function<QString()> call = [&]() {
+        runs.ref();
+        started.release();
+        release.acquire();
+        return QString("result");
+    };
+
+    QString first;
+    QThread *owner = QThread::create([&]() { first = flight.run<QString>("key", call); });
+    owner->start();
+    started.acquire();
+
+    QString second;
+    QThread *waiter = QThread::create([&]() { second = flight.run<QString>("key", call); });
+    waiter->start();
+    EXPECT_TRUE(QTest::qWaitFor([&flight]() { return flight.statistics().hits == 1; }, 1000))
+        << "Second call should join the one in flight";
+
+    release.release();
+    owner->wait();
+    waiter->wait();
+    delete owner;
+    delete waiter;
+
+    EXPECT_EQ(runs.loadAcquire(), 1);
+    EXPECT_EQ(first, QString("result"));
+    EXPECT_EQ(second, QString("result"));
+    EXPECT_EQ(flight.statistics().calls, 1u);
+
+    release.release();
+    EXPECT_EQ(flight.run<QString>("key", call), QString("result"));
+    EXPECT_EQ(runs.loadAcquire(), 2) << "Finished calls should not be cached";
+}
+
+/**
+ * @brief Test that keys tell methods and arguments apart
+ */
+TEST_F(TestDAISingleFlight, keys)
+{
+    EXPECT_EQ(DAISingleFlight::key("search", { "app", "q" }), DAISingleFlight::key("search", { "app", "q" }));
+    EXPECT_NE(DAISingleFlight::key("search", { "app", "q" }), DAISingleFlight::key("search", { "ap", "pq" }));
+    EXPECT_NE(DAISingleFlight::key("a", {}), DAISingleFlight::key("b", {}));
+    EXPECT_EQ(DAISingleFlight::digest("image"), DAISingleFlight::digest(QByteArray("image")));
+}
+
+/**
+ * @brief Test the opt-in switch of DModelManager
+ */
+TEST_F(TestDAISingleFlight, modelManager)
+{
+    const bool enabled = DModelManager::isRequestCoalescingEnabled();
+    DModelManager::setRequestCoalescingEnabled(true);
+    EXPECT_TRUE(DModelManager::isRequestCoalescingEnabled());
+
+    const DAICoalescingStatistics before = DModelManager::coalescingStatistics();
+    DModelManager::availableModels("Chat");
+    EXPECT_EQ(DModelManager::coalescingStatistics().calls, before.calls + 1);
+
+    DModelManager::setRequestCoalescingEnabled(enabled);
+}
+
+/**
+ * @brief Test that a waiting caller runs the call itself when the shared result is rejected
+ */
+TEST_F(TestDAISingleFlight, unshareableResult)
+{
+    DAISingleFlight flight;
+    flight.setEnabled(true);
+
+    QAtomicInt runs;
+    QSemaphore started;
+    QSemaphore release;
+    std::function<QString()> leader = [&]() {
+        runs.ref();
+        started.release();
+        release.acquire();
+        return QString("expired");
+    };
+    std::function<QString()> follower = [&]() {
+        runs.ref();
+        return QString("result");
+    };
+    std::function<bool(const QString &)> shareable = [](const QString &result) {
+        return result != QString("expired");
+    };
+
+    QString first;
+    QThread *owner = QThread::create([&]() { first = flight.run<QString>("key", leader, shareable); });
+    owner->start();
+    started.acquire();
+
+    QString second;
+    QThread *waiter = QThread::create([&]() { second = flight.run<QString>("key", follower, shareable); });
+    waiter->start();
+    EXPECT_TRUE(QTest::qWaitFor([&flight]() { return flight.statistics().hits == 1; }, 1000));
+
+    release.release();
+    owner->wait();
+    waiter->wait();
+    delete owner;
+    delete waiter;
+
+    EXPECT_EQ(first, QString("expired"));
+    EXPECT_EQ(second, QString("result")) << "Waiting caller should not get an unshareable result";
+    EXPECT_EQ(runs.loadAcquire(), 2);
+}
+
+/**
+ * @brief Test that an empty key is never coalesced
+ */
+TEST_F(TestDAISingleFlight, emptyKey)
+{
+    DAISingleFlight flight;
+    flight.setEnabled(true);
+
+    int runs = 0;
+    std::function<int()> call = [&runs]() { return ++runs; };
+    EXPECT_EQ(flight.run<int>(QString(), call), 1);
+    EXPECT_EQ(flight.statistics().calls, 0u);
+}
@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "daithreaderror_p.h"
+#include "daierror.h"
+
+#include <QThread>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DAIThreadError
+ */
+class TestDAIThreadError : public TestBase
+{
+protected:
+    // Runs func on a thread of its own and waits for it.
+    static void runOnThread(const std::function<void()> &func)
+    {
+        QScopedPointer<QThread> thread(QThread::create(func));
+        thread->start();
+        thread->wait();
+    }
+};
+
+/**
+ * @brief Test that each thread sees the result of its own latest call
+ */
+TEST_F(TestDAIThreadError, perThread)
+{
+    DAIThreadError error(NoError, "");
+    EXPECT_EQ(error.getErrorCode(), NoError);
+
+    error = DTK_CORE_NAMESPACE::DError(InvalidParameter, "bad");
+    int otherBefore = -1;
+    int otherAfter = -1;
+    runOnThread([&]() {
+        otherBefore = error.getErrorCode();
+        error = DTK_CORE_NAMESPACE::DError(RequestTimeout, "");
+        otherAfter = error.getErrorCode();
+    });
+
+    EXPECT_EQ(otherBefore, NoError) << "Errors of other threads should not leak";
+    EXPECT_EQ(otherAfter, RequestTimeout);
+    EXPECT_EQ(error.getErrorCode(), InvalidParameter) << "Another thread should not overwrite ours";
+    EXPECT_EQ(error.getErrorMessage(), QString("bad"));
+}
+
+/**
+ * @brief Test that completions are seen by threads without a result of their own
+ */
+TEST_F(TestDAIThreadError, publish)
+{
+    DAIThreadError error(NoError, "");
+    error = DTK_CORE_NAMESPACE::DError(InvalidParameter, "");
+
+    runOnThread([&]() {
+        error.publish(DTK_CORE_NAMESPACE::DError(APIServerNotAvailable, "gone"));
+    });
+    EXPECT_EQ(error.getErrorCode(), InvalidParameter) << "A completion elsewhere should not replace our result";
+
+    DTK_CORE_NAMESPACE::DError other(NoError, "");
+    runOnThread([&]() { other = error; });
+    EXPECT_EQ(other.getErrorCode(), APIServerNotAvailable);
+    EXPECT_EQ(other.getErrorMessage(), QString("gone"));
+
+    error.publish(DTK_CORE_NAMESPACE::DError(RequestTimeout, ""));
+    EXPECT_EQ(error.getErrorCode(), RequestTimeout) << "A completion in this thread is its latest result";
+}
+
+/**
+ * @brief Test that the result of a thread is dropped when the thread finishes
+ */
+TEST_F(TestDAIThreadError, threadFinished)
+{
+    DAIThreadError error(NoError, "");
+    error = DTK_CORE_NAMESPACE::DError(InvalidParameter, "");
+    runOnThread([&]() {
+        error = DTK_CORE_NAMESPACE::DError(RequestTimeout, "");
+        error.publish(DTK_CORE_NAMESPACE::DError(RequestCancelled, ""));
+    });
+
+    EXPECT_EQ(error.d->threads.size(), 1) << "Only the result of the running thread should be kept";
+    EXPECT_EQ(error.d->published.getErrorCode(), RequestCancelled);
+}
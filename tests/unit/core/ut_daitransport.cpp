@@ -0,0 +1,191 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/daitransport.h"
+#include "daitransport_p.h"
+
+#include <QPointer>
+#include <QSemaphore>
+#include <QThread>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DAITransport
+ */
+class TestDAITransport : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        transport = DAITransport::instance();
+        ASSERT_NE(transport, nullptr) << "DAITransport instance should exist";
+        ioThreadEnabled = transport->isIOThreadEnabled();
+        connectionMode = transport->connectionMode();
+        perThreadConnections = transport->isPerThreadConnectionsEnabled();
+    }
+
+    void TearDown() override
+    {
+        transport->setIOThreadEnabled(ioThreadEnabled);
+        transport->setConnectionMode(connectionMode);
+        transport->setPerThreadConnectionsEnabled(perThreadConnections);
+        TestBase::TearDown();
+    }
+
+    DAITransport *transport = nullptr;
+    bool ioThreadEnabled = false;
+    DAITransport::ConnectionMode connectionMode = DAITransport::SessionBus;
+    bool perThreadConnections = false;
+};
+
+/**
+ * @brief Test that proxies stay on the caller thread unless the I/O thread is enabled
+ */
+TEST_F(TestDAITransport, adopt)
+{
+    transport->setIOThreadEnabled(false);
+    EXPECT_FALSE(transport->isIOThreadEnabled());
+
+    QObject local;
+    DAITransportPrivate::adopt(&local);
+    EXPECT_EQ(local.thread(), QThread::currentThread());
+    EXPECT_EQ(DAITransportPrivate::signalConnection(&local), Qt::AutoConnection);
+
+    transport->setIOThreadEnabled(true);
+    QScopedPointer<QObject, DAIProxyDeleter> proxy(new QObject);
+    DAITransportPrivate::adopt(proxy.data());
+    EXPECT_NE(proxy->thread(), QThread::currentThread()) << "Proxy should be moved to the I/O thread";
+    EXPECT_TRUE(proxy->thread()->isRunning());
+    EXPECT_EQ(DAITransportPrivate::signalConnection(proxy.data()), Qt::DirectConnection)
+        << "Proxy signals should be handled on the I/O thread";
+
+    QScopedPointer<QObject, DAIProxyDeleter> second(new QObject);
+    DAITransportPrivate::adopt(second.data());
+    EXPECT_EQ(second->thread(), proxy->thread()) << "All proxies should share one I/O thread";
+}
+
+/**
+ * @brief Test that proxies on the I/O thread are deleted there
+ */
+TEST_F(TestDAITransport, deleter)
+{
+    transport->setIOThreadEnabled(true);
+    QScopedPointer<QObject, DAIProxyDeleter> proxy(new QObject);
+    DAITransportPrivate::adopt(proxy.data());
+
+    QPointer<QObject> watched(proxy.data());
+    proxy.reset();
+    EXPECT_TRUE(QTest::qWaitFor([&watched]() { return watched.isNull(); }, 1000))
+        << "Proxy should be deleted by the I/O thread";
+}
+
+/**
+ * @brief Test that session proxies use the session bus unless a peer connection is available
+ */
+TEST_F(TestDAITransport, connectionMode)
+{
+    transport->setConnectionMode(DAITransport::SessionBus);
+    EXPECT_EQ(transport->connectionMode(), DAITransport::SessionBus);
+
+    QDBusConnection bus = DAITransportPrivate::sessionConnection();
+    EXPECT_EQ(bus.name(), QDBusConnection::sessionBus().name());
+    EXPECT_EQ(DAITransportPrivate::serviceName(bus), QString("org.deepin.ai.daemon.SessionManager"));
+
+    transport->setConnectionMode(DAITransport::PeerToPeer);
+    EXPECT_EQ(transport->connectionMode(), DAITransport::PeerToPeer);
+
+    QDBusConnection con = DAITransportPrivate::sessionConnection();
+    if (con.name() != QDBusConnection::sessionBus().name()) {
+        EXPECT_TRUE(con.isConnected()) << "Peer connection should only be used while connected";
+        EXPECT_TRUE(DAITransportPrivate::serviceName(con).isEmpty()) << "Peers have no bus names";
+    }
+
+    transport->setConnectionMode(DAITransport::SessionBus);
+    EXPECT_EQ(DAITransportPrivate::sessionConnection().name(), QDBusConnection::sessionBus().name());
+}
+
+/**
+ * @brief Test that worker threads get a connection of their own only when enabled
+ */
+TEST_F(TestDAITransport, threadConnection)
+{
+    QString name;
+    transport->setPerThreadConnectionsEnabled(true);
+    EXPECT_TRUE(transport->isPerThreadConnectionsEnabled());
+    EXPECT_EQ(DAITransportPrivate::threadConnection(&name).name(), QDBusConnection::sessionBus().name());
+    EXPECT_TRUE(name.isEmpty()) << "The main thread should use the shared connection";
+
+    QString workerName;
+    QString connectionName;
+    bool connected = false;
+    QScopedPointer<QThread> worker(QThread::create([&]() {
+        QDBusConnection con = DAITransportPrivate::threadConnection(&workerName);
+        connectionName = con.name();
+        connected = con.isConnected();
+        DAITransportPrivate::closeThreadConnection(workerName);
+    }));
+    worker->start();
+    worker->wait();
+    if (QDBusConnection::sessionBus().isConnected()) {
+        EXPECT_TRUE(connected);
+        EXPECT_FALSE(workerName.isEmpty());
+        EXPECT_EQ(connectionName, workerName);
+        EXPECT_FALSE(QDBusConnection(workerName).isConnected()) << "Closed connections should be gone";
+    }
+
+    transport->setPerThreadConnectionsEnabled(false);
+    worker.reset(QThread::create([&]() {
+        connectionName = DAITransportPrivate::threadConnection(&workerName).name();
+    }));
+    worker->start();
+    worker->wait();
+    EXPECT_TRUE(workerName.isEmpty());
+    EXPECT_EQ(connectionName, QDBusConnection::sessionBus().name());
+}
+
+/**
+ * @brief Test that closing a handler guard waits for a running handler and blocks later ones
+ */
+TEST_F(TestDAITransport, handlerGuard)
+{
+    QSharedPointer<DAIHandlerGuard> guard(new DAIHandlerGuard);
+    QSemaphore entered;
+    QSemaphore proceed;
+    QAtomicInt finished;
+    int runs = 0;
+
+    QThread *handler = QThread::create([&]() {
+        guard->run([&]() {
+            ++runs;
+            entered.release();
+            proceed.acquire();
+            finished.storeRelease(1);
+        });
+    });
+    handler->start();
+    entered.acquire();
+
+    QThread *closer = QThread::create([&]() {
+        guard->close();
+    });
+    closer->start();
+    EXPECT_FALSE(closer->wait(50)) << "close() should wait for the running handler";
+
+    proceed.release();
+    EXPECT_TRUE(closer->wait(1000));
+    EXPECT_EQ(finished.loadAcquire(), 1);
+
+    guard->run([&]() {
+        ++runs;
+    });
+    EXPECT_EQ(runs, 1) << "No handler should run once the guard is closed";
+
+    handler->wait();
+    delete handler;
+    delete closer;
+}
@@ -7,6 +7,7 @@
 
 #include "dtkai/dmodelmanager.h"
 #include "dtkai/daierror.h"
+#include "dmodelmanager_p.h"
 
 #include <thread>
 #include <atomic>
@@ -442,4 +443,26 @@ TEST_F(TestDModelManager, getModelsForProvider)
     }) << "getModelsForProvider() should handle empty provider gracefully";
     
     qInfo() << "Models for empty provider:" << emptyModels.size();
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Test parsing of the catalog replies of the ModelInfo service
+ */
+TEST_F(TestDModelManager, parseModelsFromJson)
+{
+    const QString reply = R"({"models":[)"
+                          R"({"name":"a","provider":"p","capability":"Chat","isAvailable":true,"deployType":"Cloud",)"
+                          R"("parameters":{"temperature":0.7}},)"
+                          R"({"provider":"p"},)"
+                          R"({"name":"b","capability":"OCR","deployType":"Other"}]})";
+    const QList<ModelInfo> models = DModelManagerPrivate::parseModelsFromJson(reply);
+    ASSERT_EQ(models.size(), 2) << "Models without a name should be skipped";
+    EXPECT_EQ(models.first().modelName, QString("a"));
+    EXPECT_EQ(models.first().deployType, DeployType::Cloud);
+    EXPECT_TRUE(models.first().isAvailable);
+    EXPECT_DOUBLE_EQ(models.first().parameters.value("temperature").toDouble(), 0.7);
+    EXPECT_EQ(models.last().deployType, DeployType::Custom);
+
+    EXPECT_TRUE(DModelManagerPrivate::parseModelsFromJson("not json").isEmpty());
+    EXPECT_TRUE(DModelManagerPrivate::parseModelFromJson("{}").modelName.isEmpty());
+}
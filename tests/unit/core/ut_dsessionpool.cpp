@@ -0,0 +1,174 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/dsessionpool.h"
+#include "dsessionpool_p.h"
+
+#include <QMutexLocker>
+#include <QSignalSpy>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DSessionPool interface
+ *
+ * This class tests the configuration and bookkeeping of the
+ * process-wide session pool.
+ */
+class TestDSessionPool : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        pool = DSessionPool::instance();
+        ASSERT_NE(pool, nullptr) << "DSessionPool instance should exist";
+
+        minimumSize = pool->minimumSize();
+        maximumSize = pool->maximumSize();
+        idleTimeout = pool->idleTimeout();
+    }
+
+    void TearDown() override
+    {
+        pool->setMinimumSize(minimumSize);
+        pool->setMaximumSize(maximumSize);
+        pool->setIdleTimeout(idleTimeout);
+        pool->clear();
+        // The pool is shared by every test, reopen it as if the process went on.
+        pool->d->closed = false;
+        TestBase::TearDown();
+    }
+
+    DSessionPool *pool = nullptr;
+    int minimumSize = 0;
+    int maximumSize = 0;
+    int idleTimeout = 0;
+};
+
+/**
+ * @brief Test DSessionPool::instance() returns a process-wide singleton
+ */
+TEST_F(TestDSessionPool, instance)
+{
+    EXPECT_EQ(DSessionPool::instance(), pool) << "instance() should always return the same pool";
+}
+
+/**
+ * @brief Test pool size and timeout configuration
+ */
+TEST_F(TestDSessionPool, configuration)
+{
+    pool->setMinimumSize(2);
+    pool->setMaximumSize(8);
+    pool->setIdleTimeout(5000);
+    EXPECT_EQ(pool->minimumSize(), 2);
+    EXPECT_EQ(pool->maximumSize(), 8);
+    EXPECT_EQ(pool->idleTimeout(), 5000);
+
+    // Negative values are clamped
+    pool->setMinimumSize(-1);
+    pool->setMaximumSize(-1);
+    pool->setIdleTimeout(-1);
+    EXPECT_EQ(pool->minimumSize(), 0);
+    EXPECT_EQ(pool->maximumSize(), 0);
+    EXPECT_EQ(pool->idleTimeout(), 0);
+}
+
+/**
+ * @brief Test lease bookkeeping of acquire() and release()
+ *
+ * A second acquire after a release must be served from the pool
+ * when the daemon is available.
+ */
+TEST_F(TestDSessionPool, acquireRelease)
+{
+    const QString type = "Chat";
+    pool->setMaximumSize(4);
+
+    const DSessionPool::Statistics before = pool->statistics(type);
+    const QString first = pool->acquire(type);
+    if (first.isEmpty()) {
+        qInfo() << "Info: AI daemon not available - only checking miss accounting";
+        EXPECT_EQ(pool->statistics(type).misses, before.misses + 1);
+        return;
+    }
+
+    EXPECT_EQ(pool->statistics(type).leased, before.leased + 1);
+    pool->release(type, first);
+    EXPECT_EQ(pool->statistics(type).idle, before.idle + 1);
+
+    const QString second = pool->acquire(type);
+    EXPECT_EQ(second, first) << "Released session should be reused";
+    EXPECT_EQ(pool->statistics(type).hits, before.hits + 1);
+    pool->release(type, second);
+}
+
+/**
+ * @brief Test that unknown session ids are never pooled
+ */
+TEST_F(TestDSessionPool, releaseUnknown)
+{
+    const QString type = "OCR";
+    const int idle = pool->statistics(type).idle;
+
+    pool->release(type, QString());
+    pool->release(type, "not-a-leased-session");
+    EXPECT_EQ(pool->statistics(type).idle, idle) << "Unknown sessions should not enter the pool";
+}
+
+/**
+ * @brief Test that a daemon restart drops every session
+ *
+ * The service watcher notifications are simulated, sessions leased
+ * before the restart must not come back into the pool.
+ */
+TEST_F(TestDSessionPool, daemonRestart)
+{
+    const QString type = "Chat";
+    QSignalSpy stoppedSpy(pool, &DSessionPool::daemonStopped);
+    QSignalSpy startedSpy(pool, &DSessionPool::daemonStarted);
+
+    const QString leased = pool->acquire(type);
+    const quint64 generation = pool->generation();
+
+    pool->d->serviceUnregistered();
+    EXPECT_EQ(stoppedSpy.count(), 1);
+    EXPECT_FALSE(pool->isDaemonAvailable());
+    EXPECT_EQ(pool->generation(), generation + 1) << "Daemon loss should start a new generation";
+    EXPECT_EQ(pool->statistics(type).idle, 0);
+    EXPECT_EQ(pool->statistics(type).leased, 0);
+
+    pool->release(type, leased);
+    EXPECT_EQ(pool->statistics(type).idle, 0) << "Stale sessions should not enter the pool";
+
+    pool->d->serviceRegistered();
+    EXPECT_EQ(startedSpy.count(), 1);
+    EXPECT_TRUE(pool->isDaemonAvailable());
+    EXPECT_EQ(pool->generation(), generation + 1);
+}
+
+/**
+ * @brief Test that sessions released after clear() are not pooled
+ *
+ * clear() runs on aboutToQuit while requests may still hold sessions,
+ * those must not end up in the pool where nobody destroys them.
+ */
+TEST_F(TestDSessionPool, releaseAfterClear)
+{
+    const QString type = "Chat";
+    pool->setMaximumSize(4);
+
+    {
+        QMutexLocker lk(&pool->d->mtx);
+        pool->d->buckets[type].leased.insert("leased-during-quit");
+    }
+    pool->clear();
+    pool->release(type, "leased-during-quit");
+
+    EXPECT_EQ(pool->statistics(type).idle, 0) << "A closed pool should not keep released sessions";
+    EXPECT_EQ(pool->statistics(type).leased, 0);
+}
@@ -0,0 +1,213 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/dstreamreader.h"
+#include "dstreamreader_p.h"
+#include "dtkai/nlp/dchatcompletions.h"
+#include "dtkai/daitransport.h"
+
+#include <QSignalSpy>
+#include <QThread>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DStreamReader
+ *
+ * Data is fed the way the attached client would, from the delivering thread.
+ */
+class TestDStreamReader : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        reader = new DStreamReader();
+    }
+
+    void TearDown() override
+    {
+        delete reader;
+        reader = nullptr;
+        TestBase::TearDown();
+    }
+
+    DStreamReader *reader = nullptr;
+};
+
+/**
+ * @brief Test that buffered data is read in order and readyRead is not emitted per chunk
+ */
+TEST_F(TestDStreamReader, read)
+{
+    QSignalSpy ready(reader, &DStreamReader::readyRead);
+    reader->d->append("Hello ");
+    reader->d->append("World");
+    EXPECT_EQ(reader->bytesAvailable(), 11);
+
+    EXPECT_TRUE(QTest::qWaitFor([&ready]() { return ready.count() > 0; }, 1000));
+    QTest::qWait(10);
+    EXPECT_EQ(ready.count(), 1) << "One notification for data queued together";
+
+    EXPECT_EQ(reader->read(3), QByteArray("Hel"));
+    EXPECT_EQ(reader->read(), QByteArray("lo World"));
+    EXPECT_EQ(reader->bytesAvailable(), 0);
+    EXPECT_FALSE(reader->atEnd());
+
+    QSignalSpy finished(reader, &DStreamReader::finished);
+    reader->d->finish(0);
+    EXPECT_TRUE(reader->atEnd());
+    EXPECT_EQ(reader->error(), 0);
+    EXPECT_TRUE(QTest::qWaitFor([&finished]() { return finished.count() == 1; }, 1000));
+}
+
+/**
+ * @brief Test the drop policies keep the buffer bounded
+ */
+TEST_F(TestDStreamReader, dropPolicies)
+{
+    reader->setCapacity(8);
+    reader->setOverflowPolicy(DStreamReader::DropNewest);
+    reader->d->append("1234");
+    reader->d->append("5678");
+    reader->d->append("9");
+    EXPECT_EQ(reader->bytesAvailable(), 8);
+    EXPECT_EQ(reader->droppedBytes(), 1u);
+
+    reader->setOverflowPolicy(DStreamReader::DropOldest);
+    reader->d->append("abcd");
+    EXPECT_EQ(reader->read(), QByteArray("5678abcd"));
+    EXPECT_EQ(reader->droppedBytes(), 5u);
+
+    reader->setOverflowPolicy(DStreamReader::Block);
+    reader->d->append("12345678");
+    reader->d->append("x");
+    EXPECT_EQ(reader->read(), QByteArray("x")) << "Block cannot wait in the thread of the reader";
+    EXPECT_EQ(reader->droppedBytes(), 13u);
+}
+
+/**
+ * @brief Test that a delivering thread waits until the consumer drained the buffer
+ */
+TEST_F(TestDStreamReader, block)
+{
+    reader->setCapacity(4);
+    reader->setLowWatermark(2);
+    reader->setOverflowPolicy(DStreamReader::Block);
+    reader->d->append("1234");
+
+    QScopedPointer<QThread> producer(QThread::create([this]() {
+        reader->d->append("5678");
+    }));
+    producer->start();
+    EXPECT_FALSE(producer->wait(100)) << "Producer should wait for room";
+
+    EXPECT_EQ(reader->read(1), QByteArray("1"));
+    EXPECT_FALSE(producer->wait(100)) << "Producer should wait for the low watermark";
+
+    EXPECT_EQ(reader->read(2), QByteArray("23"));
+    EXPECT_TRUE(producer->wait(1000));
+    EXPECT_EQ(reader->read(), QByteArray("45678"));
+    EXPECT_EQ(reader->droppedBytes(), 0u);
+}
+
+/**
+ * @brief Test that Block does not stall the shared I/O thread
+ */
+TEST_F(TestDStreamReader, blockOnIoThread)
+{
+    EXPECT_EQ(reader->overflowPolicy(), DStreamReader::DropOldest) << "Drop should be the default";
+    reader->setCapacity(4);
+    reader->setOverflowPolicy(DStreamReader::Block);
+    reader->d->append("1234");
+
+    QScopedPointer<QObject, QScopedPointerDeleteLater> delivery(new QObject);
+    delivery->moveToThread(DAITransport::instance()->d->ioThread());
+    QMetaObject::invokeMethod(delivery.data(), [this]() {
+        reader->d->append("5678");
+    }, Qt::BlockingQueuedConnection);
+
+    EXPECT_EQ(reader->read(), QByteArray("5678"));
+    EXPECT_EQ(reader->droppedBytes(), 4u);
+}
+
+/**
+ * @brief Test waiting for data and for the end of the stream
+ */
+TEST_F(TestDStreamReader, waitForData)
+{
+    EXPECT_FALSE(reader->waitForData(10)) << "Nothing should arrive";
+
+    QScopedPointer<QThread> producer(QThread::create([this]() {
+        QThread::msleep(20);
+        reader->d->append("data");
+    }));
+    producer->start();
+    EXPECT_TRUE(reader->waitForData(1000));
+    producer->wait();
+    EXPECT_EQ(reader->read(), QByteArray("data"));
+
+    reader->d->finish(5);
+    EXPECT_FALSE(reader->waitForData()) << "Ended stream should not block";
+    EXPECT_EQ(reader->error(), 5);
+}
+
+/**
+ * @brief Test that text split inside a character is returned whole
+ */
+TEST_F(TestDStreamReader, readText)
+{
+    const QByteArray text = QString("你好").toUtf8();
+    reader->d->append(text.left(4));
+    EXPECT_EQ(reader->readText(), QString("你"));
+    EXPECT_EQ(reader->bytesAvailable(), 1);
+
+    reader->d->append(text.mid(4));
+    EXPECT_EQ(reader->readText(), QString("好"));
+    EXPECT_EQ(DStreamReaderPrivate::incompleteTail("abc"), 0);
+    EXPECT_EQ(DStreamReaderPrivate::incompleteTail(text), 0);
+    EXPECT_EQ(DStreamReaderPrivate::incompleteTail(text.left(5)), 2);
+}
+
+/**
+ * @brief Test that a chunk larger than the buffer keeps its newest bytes under DropOldest
+ */
+TEST_F(TestDStreamReader, oversizedChunk)
+{
+    reader->setCapacity(4);
+    reader->setOverflowPolicy(DStreamReader::DropOldest);
+    reader->d->append("ab");
+    reader->d->append("123456");
+    EXPECT_EQ(reader->bytesAvailable(), 4) << "The buffer should stay bounded";
+    EXPECT_EQ(reader->read(), QByteArray("3456"));
+    EXPECT_EQ(reader->droppedBytes(), 4u);
+}
+
+/**
+ * @brief Test that destroying the reader waits for a delivery under way in another thread
+ */
+TEST_F(TestDStreamReader, destroyWhileDelivering)
+{
+    DChatCompletions chat;
+    const quint64 id = 7;
+    reader->setCapacity(4);
+    reader->setLowWatermark(0);
+    reader->setOverflowPolicy(DStreamReader::Block);
+    ASSERT_TRUE(reader->attach(&chat, id));
+
+    QAtomicInt running(1);
+    QScopedPointer<QThread> producer(QThread::create([&]() {
+        while (running.loadAcquire())
+            Q_EMIT chat.requestStreamOutput(id, QStringLiteral("data"));
+    }));
+    producer->start();
+    QTest::qWait(20);
+
+    delete reader;
+    reader = nullptr;
+    running.storeRelease(0);
+    EXPECT_TRUE(producer->wait(1000)) << "Deliveries should end with the reader";
+}
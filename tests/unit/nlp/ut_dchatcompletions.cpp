@@ -8,13 +8,17 @@
 #include "dtkai/nlp/dchatcompletions.h"
 #include "dtkai/dtkaitypes.h"
 #include "dtkai/DAIError"
+#include "nlp/dchatcompletions_p.h"
 
 #include <QSignalSpy>
 #include <QTimer>
 #include <QTest>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <QHash>
 #include <QVariantHash>
+#include <QThread>
+#include <QThreadPool>
 
 DAI_USE_NAMESPACE
 
@@ -240,6 +244,157 @@ TEST_F(TestDChatCompletions, synchronousChat)
     qInfo() << "Synchronous chat tests completed";
 }
 
+/**
+ * @brief Test asynchronous chat functionality
+ * 
+ * This test verifies that chatAsync returns immediately and
+ * delivers the reply through the completion callback.
+ */
+TEST_F(TestDChatCompletions, asynchronousChat)
+{
+    qInfo() << "Testing DChatCompletions asynchronous chat";
+    
+    bool called = false;
+    QString response;
+    quint64 requestId = chat->chatAsync("Hello, how are you today?",
+                                        [&](const QString &result, const DTK_CORE_NAMESPACE::DError &error) {
+        called = true;
+        response = result;
+        qDebug() << "Async chat finished with error code:" << error.getErrorCode();
+    });
+    
+    if (!requestId) {
+        EXPECT_EQ(chat->lastError().getErrorCode(), APIServerNotAvailable)
+            << "Failed dispatch should report APIServerNotAvailable";
+        qDebug() << "AI daemon not available - skipping async reply check";
+        return;
+    }
+    
+    EXPECT_FALSE(called) << "Callback should not run before returning to the event loop";
+    EXPECT_TRUE(QTest::qWaitFor([&]() { return called; }, 35000)) << "Callback should be invoked";
+    if (!response.isEmpty())
+        validateChatResponse(response);
+    
+    qInfo() << "Asynchronous chat tests completed";
+}
+
+/**
+ * @brief Test asynchronous chat issued from a thread pool
+ * 
+ * This test verifies that a request issued from a QThreadPool task,
+ * which has no event loop, still delivers its reply in the thread
+ * of the DChatCompletions object.
+ */
+TEST_F(TestDChatCompletions, asynchronousChatFromThreadPool)
+{
+    qInfo() << "Testing DChatCompletions asynchronous chat from a thread pool";
+    
+    bool called = false;
+    Qt::HANDLE calledIn = nullptr;
+    quint64 requestId = 0;
+    QThreadPool::globalInstance()->start([&]() {
+        requestId = chat->chatAsync("Hello, how are you today?",
+                                    [&](const QString &, const DTK_CORE_NAMESPACE::DError &) {
+            calledIn = QThread::currentThreadId();
+            called = true;
+        });
+    });
+    ASSERT_TRUE(QThreadPool::globalInstance()->waitForDone(5000));
+    
+    if (!requestId) {
+        qDebug() << "AI daemon not available - skipping thread pool reply check";
+        return;
+    }
+    
+    EXPECT_TRUE(QTest::qWaitFor([&]() { return called; }, 35000)) << "Callback should be invoked";
+    EXPECT_EQ(calledIn, QThread::currentThreadId()) << "Callback should run in the thread of the object";
+    
+    qInfo() << "Thread pool asynchronous chat tests completed";
+}
+
+/**
+ * @brief Test concurrent requests on one DChatCompletions object
+ * 
+ * This test verifies that every request gets its own id, that
+ * replies are routed to the right callback and that a terminated
+ * request reports RequestCancelled without disturbing the others.
+ */
+TEST_F(TestDChatCompletions, concurrentRequests)
+{
+    qInfo() << "Testing DChatCompletions concurrent requests";
+    
+    QHash<quint64, int> replies;
+    QList<quint64> cancelled;
+    auto track = [&](quint64 *id) {
+        return [&, id](const QString &, const DTK_CORE_NAMESPACE::DError &error) {
+            replies[*id]++;
+            if (error.getErrorCode() == RequestCancelled)
+                cancelled.append(*id);
+        };
+    };
+    
+    quint64 first = 0;
+    quint64 second = 0;
+    first = chat->chatAsync("Count from one to three", track(&first));
+    second = chat->chatAsync("Name three colors", track(&second));
+    
+    if (!first || !second) {
+        qDebug() << "AI daemon not available - skipping concurrent request check";
+        return;
+    }
+    
+    EXPECT_NE(first, second) << "Each request should get a unique id";
+    
+    chat->terminateRequest(first);
+    EXPECT_EQ(cancelled, QList<quint64>{first}) << "Terminated request should be cancelled immediately";
+    EXPECT_EQ(chat->lastError().getErrorCode(), RequestCancelled);
+    
+    EXPECT_TRUE(QTest::qWaitFor([&]() { return replies.value(second) > 0; }, 35000))
+        << "Remaining request should still complete";
+    QTest::qWait(100);
+    EXPECT_EQ(replies.value(first), 1) << "Terminated request callback should run exactly once";
+    EXPECT_EQ(replies.value(second), 1);
+    
+    // Unknown ids are ignored
+    EXPECT_NO_THROW(chat->terminateRequest(0));
+    
+    qInfo() << "Concurrent request tests completed";
+}
+
+/**
+ * @brief Test per-request deadlines and cancellation
+ *
+ * Expired or cancelled options fail before anything is sent, a deadline
+ * that expires in flight finishes only that request with RequestTimeout.
+ */
+TEST_F(TestDChatCompletions, requestOptions)
+{
+    DAIRequestOptions expired;
+    expired.deadline = QDeadlineTimer(0);
+    EXPECT_EQ(chat->chatAsync("Hello", [](const QString &, const DTK_CORE_NAMESPACE::DError &) {}, {}, {}, expired), 0u);
+    EXPECT_EQ(chat->lastError().getErrorCode(), RequestTimeout);
+
+    DAIRequestOptions cancelled;
+    cancelled.cancellation.cancel();
+    EXPECT_TRUE(chat->chat("Hello", {}, {}, cancelled).isEmpty());
+    EXPECT_EQ(chat->lastError().getErrorCode(), RequestCancelled);
+
+    int error = -1;
+    DAIRequestOptions tight;
+    tight.deadline = QDeadlineTimer(1);
+    const quint64 id = chat->chatAsync("Write a long story", [&error](const QString &, const DTK_CORE_NAMESPACE::DError &err) {
+        error = err.getErrorCode();
+    }, {}, {}, tight);
+
+    if (!id) {
+        qDebug() << "AI daemon not available - skipping in-flight deadline check";
+        return;
+    }
+
+    EXPECT_TRUE(QTest::qWaitFor([&error]() { return error != -1; }, 5000)) << "Deadline should finish the request";
+    EXPECT_EQ(error, RequestTimeout);
+}
+
 /**
  * @brief Test streaming chat functionality
  * 
@@ -536,3 +691,87 @@ TEST_F(TestDChatCompletions, parameterValidation)
     
     qInfo() << "Parameter validation tests completed";
 }
+
+/**
+ * @brief Test that a finished stream reports its token timing before requestStreamFinished
+ */
+TEST_F(TestDChatCompletions, streamStats)
+{
+    DChatCompletionsPrivate *d = chat->d.data();
+    QSignalSpy statsSpy(chat, &DChatCompletions::requestStreamStats);
+    QSignalSpy outputSpy(chat, &DChatCompletions::requestStreamOutput);
+    QSignalSpy finishedSpy(chat, &DChatCompletions::requestStreamFinished);
+
+    // A stream that was sent without a daemon, its outputs are fed by hand.
+    const quint64 id = 4242;
+    auto *request = new DChatCompletionsPrivate::StreamRequest;
+    request->timing.start();
+    d->streams.insert(id, request);
+
+    for (int i = 0; i < 3; ++i) {
+        QTest::qWait(5);
+        d->streamLegOutput(id, DAIHedging::Primary, QString("token%1").arg(i));
+    }
+    d->finishStream(id, NoError, QString());
+
+    EXPECT_EQ(outputSpy.count(), 3);
+    ASSERT_EQ(statsSpy.count(), 1) << "Stats should be emitted once per stream";
+    ASSERT_EQ(finishedSpy.count(), 1);
+    EXPECT_EQ(statsSpy.first().at(0).toULongLong(), id);
+
+    const DAIStreamStats stats = statsSpy.first().at(1).value<DAIStreamStats>();
+    EXPECT_EQ(stats.tokens, 3);
+    EXPECT_GE(stats.timeToFirstToken, 5000);
+    EXPECT_GE(stats.gapMin, 4000);
+    EXPECT_LE(stats.gapMin, stats.gapP50);
+    EXPECT_LE(stats.gapP99, stats.gapMax);
+    EXPECT_GE(stats.duration, stats.timeToFirstToken + stats.gapMin * 2);
+    EXPECT_GT(stats.tokensPerSecond, 0.0);
+    EXPECT_LT(stats.tokensPerSecond, 250.0) << "Two gaps of at least 4 ms";
+
+    d->finishStream(id, NoError, QString());
+    EXPECT_EQ(statsSpy.count(), 1) << "A finished stream should not report again";
+}
+
+/**
+ * @brief Test that a hedged request samples the latency of its primary model once
+ */
+TEST_F(TestDChatCompletions, hedgedLatencySampledOnce)
+{
+    DChatCompletionsPrivate *d = chat->d.data();
+    const QString model = "hedge-sampled-once";
+    const DAIHedgingPolicy policy;
+    for (int i = 0; i < 6; ++i)
+        DAIHedging::recordLatency("Chat", model, 200);
+
+    // The secondary wins, then the primary answers late.
+    const quint64 id = 4343;
+    auto *hedge = new DChatCompletionsPrivate::HedgedCall;
+    hedge->model = model;
+    hedge->sent.start();
+    d->calls.insert(id, nullptr);
+    d->hedges.insert(id, hedge);
+    d->finishLeg(id, DAIHedging::Secondary, "secondary", 150, "secondary answer", DTK_CORE_NAMESPACE::DError(NoError, ""));
+    d->finishLeg(id, DAIHedging::Primary, model, 400, "primary answer", DTK_CORE_NAMESPACE::DError(NoError, ""));
+    EXPECT_EQ(DAIHedging::delay("Chat", model, policy), -1) << "Seven samples, the late primary should not add one";
+
+    const quint64 plain = 4344;
+    d->calls.insert(plain, nullptr);
+    d->finishLeg(plain, DAIHedging::Primary, model, 300, "answer", DTK_CORE_NAMESPACE::DError(NoError, ""));
+    EXPECT_GE(DAIHedging::delay("Chat", model, policy), policy.minimumDelay) << "An answered primary should add one sample";
+}
+
+/**
+ * @brief Test that a blocking chat() keeps the shared session from being seen as idle
+ */
+TEST_F(TestDChatCompletions, blockingCallsNotIdle)
+{
+    DChatCompletionsPrivate *d = chat->d.data();
+    QMutexLocker lk(&d->mtx);
+    EXPECT_TRUE(d->isIdle());
+
+    ++d->blocking;
+    EXPECT_FALSE(d->isIdle()) << "A caller giving up must not stop another blocking call";
+    --d->blocking;
+    EXPECT_TRUE(d->isIdle());
+}
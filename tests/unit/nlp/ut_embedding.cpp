@@ -8,6 +8,7 @@
 #include "dtkai/nlp/dembeddingplatform.h"
 #include "dtkai/dtkaitypes.h"
 #include "dtkai/daierror.h"
+#include "nlp/dembeddingplatform_p.h"
 
 #include <QSignalSpy>
 #include <QTimer>
@@ -318,3 +319,80 @@ TEST_F(TestDEmbeddingPlatform, destroyIndex)
     
     qInfo() << "Index destruction tests completed";
 }
+
+/**
+ * @brief Test that every platform object shares one generated proxy per connection
+ */
+TEST_F(TestDEmbeddingPlatform, cachedInterface)
+{
+    OrgDeepinAiDaemonEmbeddingPlatformInterface *ifs = DEmbeddingPlatformPrivate::platformInterface();
+    ASSERT_NE(ifs, nullptr);
+    EXPECT_EQ(ifs, DEmbeddingPlatformPrivate::platformInterface()) << "Proxy should be created only once";
+    EXPECT_EQ(ifs->path(), QString("/org/deepin/ai/daemon/EmbeddingPlatform"));
+}
+
+/**
+ * @brief Test parsing of search replies shared by search and searchAsync
+ */
+TEST_F(TestDEmbeddingPlatform, parseSearchResults)
+{
+    DTK_CORE_NAMESPACE::DError err;
+    const QString response = R"({"results":[{"id":"doc","model":"m","distance":0.5,)"
+                             R"("chunk":{"chunk_index":2,"content":"text","tokens":3}}]})";
+    QList<DEmbeddingPlatform::SearchResult> results = DEmbeddingPlatformPrivate::parseSearchResults(response, &err);
+    EXPECT_EQ(err.getErrorCode(), NoError);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results.first().id, QString("doc"));
+    EXPECT_EQ(results.first().chunk.chunkIndex, 2);
+    EXPECT_EQ(results.first().chunk.content, QString("text"));
+
+    results = DEmbeddingPlatformPrivate::parseSearchResults("not json", &err);
+    EXPECT_TRUE(results.isEmpty());
+    EXPECT_NE(err.getErrorCode(), NoError);
+}
+
+/**
+ * @brief Test parsing of documentsInfo replies
+ */
+TEST_F(TestDEmbeddingPlatform, parseDocumentsInfo)
+{
+    DTK_CORE_NAMESPACE::DError err;
+    const QString response = R"({"results":[{"id":"doc","file_path":"/tmp/a.txt","created_at":"2025-06-01T12:00:00",)"
+                             R"("metadata":{"source":"upload"}},{"id":"bare"}]})";
+    QList<DEmbeddingPlatform::DocumentInfo> infos = DEmbeddingPlatformPrivate::parseDocumentsInfo(response, &err);
+    EXPECT_EQ(err.getErrorCode(), NoError);
+    ASSERT_EQ(infos.size(), 2);
+    EXPECT_EQ(infos.first().filePath, QString("/tmp/a.txt"));
+    ASSERT_TRUE(infos.first().createdAt.has_value());
+    EXPECT_EQ(infos.first().createdAt->date(), QDate(2025, 6, 1));
+    EXPECT_EQ(infos.first().metadata.value("source").toString(), QString("upload"));
+    EXPECT_FALSE(infos.last().createdAt.has_value());
+
+    infos = DEmbeddingPlatformPrivate::parseDocumentsInfo(R"({"status":"ok"})", &err);
+    EXPECT_TRUE(infos.isEmpty());
+    EXPECT_NE(err.getErrorCode(), NoError);
+}
+
+/**
+ * @brief Test asynchronous search and its termination
+ */
+TEST_F(TestDEmbeddingPlatform, searchAsync)
+{
+    bool called = false;
+    quint64 id = embedding->searchAsync("test-app-001", "test", [&called](const QList<DEmbeddingPlatform::SearchResult> &, const DTK_CORE_NAMESPACE::DError &) {
+        called = true;
+    });
+    if (id == 0) {
+        qDebug() << "Request not sent:" << embedding->lastError().getErrorMessage();
+        return;
+    }
+    EXPECT_TRUE(QTest::qWaitFor([&called]() { return called; }, 30000)) << "Callback should be invoked";
+
+    int code = -1;
+    id = embedding->searchAsync("test-app-001", "test", [&code](const QList<DEmbeddingPlatform::SearchResult> &, const DTK_CORE_NAMESPACE::DError &err) {
+        code = err.getErrorCode();
+    });
+    ASSERT_NE(id, 0u);
+    embedding->terminateRequest(id);
+    EXPECT_EQ(code, RequestCancelled) << "Terminated request should be finished right away";
+}
@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "speech/daudioring_p.h"
+
+#include <unistd.h>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for the shared-memory audio ring
+ *
+ * Producer and consumer are two mappings of the same memfd,
+ * just like the client and the daemon.
+ */
+class TestDAudioRing : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        ASSERT_TRUE(producer.create(16)) << "Ring should be created";
+        ASSERT_TRUE(consumer.attach(producer.memoryDescriptor(), producer.doorbellDescriptor()))
+            << "Ring should be mapped by the consumer";
+    }
+
+    quint64 drainDoorbell()
+    {
+        quint64 count = 0;
+        if (read(consumer.doorbellDescriptor().fileDescriptor(), &count, sizeof(count)) != sizeof(count))
+            return 0;
+        return count;
+    }
+
+    DAudioRing producer;
+    DAudioRing consumer;
+};
+
+/**
+ * @brief Test that written bytes reach the consumer in order across the wrap point
+ */
+TEST_F(TestDAudioRing, writeRead)
+{
+    EXPECT_EQ(consumer.capacity(), 16u);
+
+    EXPECT_TRUE(producer.write("0123456789"));
+    EXPECT_EQ(consumer.read(6), QByteArray("012345"));
+    EXPECT_TRUE(producer.write("abcdefghij")) << "Write should wrap around the end of the ring";
+    EXPECT_EQ(consumer.bytesAvailable(), 14u);
+    EXPECT_EQ(consumer.read(100), QByteArray("6789abcdefghij"));
+    EXPECT_TRUE(consumer.read(100).isEmpty());
+
+    EXPECT_EQ(drainDoorbell(), 2u) << "Every write should ring the doorbell";
+}
+
+/**
+ * @brief Test that a full ring rejects writes instead of overwriting unread audio
+ */
+TEST_F(TestDAudioRing, full)
+{
+    EXPECT_TRUE(producer.write(QByteArray(12, 'x')));
+    EXPECT_FALSE(producer.write(QByteArray(5, 'y'))) << "Writes larger than the free space should fail";
+    EXPECT_TRUE(producer.write(QByteArray(4, 'y')));
+    EXPECT_EQ(consumer.read(16), QByteArray(12, 'x') + QByteArray(4, 'y'));
+}
+
+/**
+ * @brief Test that closing is visible to the consumer and stops further writes
+ */
+TEST_F(TestDAudioRing, close)
+{
+    EXPECT_FALSE(consumer.isClosed());
+    producer.close();
+    EXPECT_TRUE(consumer.isClosed());
+    EXPECT_EQ(drainDoorbell(), 1u) << "Closing should wake the consumer";
+    EXPECT_FALSE(producer.write("late"));
+}
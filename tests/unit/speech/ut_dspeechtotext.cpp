@@ -340,6 +340,36 @@ TEST_F(TestDSpeechToText, streamRecognition)
     qInfo() << "Stream recognition tests completed";
 }
 
+/**
+ * @brief Test stream recognition over the shared-memory transport
+ * 
+ * This test verifies that the transport setting is kept and that
+ * streams still work when the daemon falls back to D-Bus.
+ */
+TEST_F(TestDSpeechToText, sharedMemoryStream)
+{
+    qInfo() << "Testing DSpeechToText shared-memory stream transport";
+    
+    EXPECT_EQ(stt->streamTransport(), DSpeechToText::DBusTransport) << "D-Bus should be the default transport";
+    stt->setStreamTransport(DSpeechToText::SharedMemoryTransport);
+    EXPECT_EQ(stt->streamTransport(), DSpeechToText::SharedMemoryTransport);
+    
+    bool started = stt->startStreamRecognition(createSampleAudioParameters());
+    if (!started) {
+        qDebug() << "AI daemon not available - skipping shared-memory stream check";
+        validateErrorState(true);
+        return;
+    }
+    
+    EXPECT_TRUE(stt->sendAudioData(generateMockAudioData(1))) << "Audio should be accepted by either transport";
+    QString finalResult = stt->endStreamRecognition();
+    qDebug() << "Shared-memory stream result:" << finalResult;
+    
+    EXPECT_FALSE(stt->sendAudioData(generateMockAudioData(1))) << "Audio after the end should be rejected";
+    
+    qInfo() << "Shared-memory stream tests completed";
+}
+
 /**
  * @brief Test terminate functionality
  * 
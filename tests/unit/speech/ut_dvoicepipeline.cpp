@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: 2025 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "test_base.h"
+
+#include "dtkai/speech/dvoicepipeline.h"
+#include "speech/dvoicepipeline_p.h"
+#include "dtkai/DAIError"
+
+#include <QSignalSpy>
+
+DAI_USE_NAMESPACE
+
+/**
+ * @brief Test class for DVoicePipeline
+ */
+class TestDVoicePipeline : public TestBase
+{
+protected:
+    void SetUp() override
+    {
+        TestBase::SetUp();
+        pipeline = new DVoicePipeline();
+    }
+
+    void TearDown() override
+    {
+        delete pipeline;
+        pipeline = nullptr;
+        TestBase::TearDown();
+    }
+
+    DVoicePipeline *pipeline = nullptr;
+};
+
+/**
+ * @brief Test that the streamed reply is cut at sentence boundaries
+ */
+TEST_F(TestDVoicePipeline, takeSentences)
+{
+    QString buffer("你好。今天天气");
+    EXPECT_EQ(DVoicePipelinePrivate::takeSentences(&buffer), QStringList { "你好。" });
+    EXPECT_EQ(buffer, QString("今天天气"));
+
+    buffer += "很好！Pi is 3.14, right? Yes";
+    EXPECT_EQ(DVoicePipelinePrivate::takeSentences(&buffer), (QStringList { "今天天气很好！", "Pi is 3.14, right?" }));
+    EXPECT_EQ(buffer, QString(" Yes"));
+
+    buffer = "Done. Next";
+    EXPECT_EQ(DVoicePipelinePrivate::takeSentences(&buffer), QStringList { "Done." });
+    buffer = "End.";
+    EXPECT_TRUE(DVoicePipelinePrivate::takeSentences(&buffer).isEmpty()) << "A period may still be followed by digits";
+
+    buffer = QString("a").repeated(50) + "，" + QString("b").repeated(40);
+    const QStringList cut = DVoicePipelinePrivate::takeSentences(&buffer);
+    ASSERT_EQ(cut.size(), 1) << "A long run should be cut at its last pause";
+    EXPECT_EQ(cut.first(), QString("a").repeated(50) + "，");
+    EXPECT_EQ(buffer, QString("b").repeated(40));
+}
+
+/**
+ * @brief Test that synthesized audio is emitted in the order of the reply
+ */
+TEST_F(TestDVoicePipeline, audioOrder)
+{
+    DVoicePipelinePrivate *d = pipeline->d.data();
+    d->beginTurn();
+    d->speechEnded.start();
+    d->chatDone = true;
+    d->segments.append({ 1, {}, false });
+    d->segments.append({ 2, {}, false });
+
+    QSignalSpy audio(pipeline, &DVoicePipeline::audioOutput);
+    QSignalSpy finished(pipeline, &DVoicePipeline::finished);
+
+    d->onSynthesisResult(2, "second");
+    EXPECT_EQ(audio.count(), 0) << "Audio of a later sentence should wait";
+    d->onSynthesisResult(1, "first");
+    ASSERT_EQ(audio.count(), 1);
+    EXPECT_EQ(audio.at(0).at(0).toByteArray(), QByteArray("first"));
+    EXPECT_GE(pipeline->latency().firstAudio, 0);
+
+    d->onSynthesisCompleted(1, {});
+    ASSERT_EQ(audio.count(), 2);
+    EXPECT_EQ(audio.at(1).at(0).toByteArray(), QByteArray("second"));
+    EXPECT_EQ(finished.count(), 0);
+
+    d->onSynthesisCompleted(2, {});
+    ASSERT_EQ(finished.count(), 1);
+    EXPECT_EQ(finished.at(0).at(0).toInt(), 0);
+    EXPECT_FALSE(pipeline->isRunning());
+    EXPECT_GE(pipeline->latency().total, 0);
+    EXPECT_EQ(pipeline->history().size(), 2) << "The turn should be appended to the history";
+}
+
+/**
+ * @brief Test the pipeline outside of a turn
+ */
+TEST_F(TestDVoicePipeline, idle)
+{
+    EXPECT_FALSE(pipeline->isRunning());
+    EXPECT_FALSE(pipeline->sendAudio("audio"));
+    EXPECT_FALSE(pipeline->endSpeech());
+    EXPECT_FALSE(pipeline->respond("   "));
+    EXPECT_EQ(pipeline->latency().firstAudio, -1);
+    EXPECT_NE(pipeline->speechToText(), nullptr);
+    EXPECT_NE(pipeline->chatCompletions(), nullptr);
+    EXPECT_NE(pipeline->textToSpeech(), nullptr);
+
+    QSignalSpy finished(pipeline, &DVoicePipeline::finished);
+    pipeline->stop();
+    EXPECT_EQ(finished.count(), 0) << "Stopping an idle pipeline should do nothing";
+}
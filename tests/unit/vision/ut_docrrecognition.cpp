@@ -249,6 +249,36 @@ TEST_F(TestDOCRRecognition, imageDataRecognition)
     qDebug() << "Image data recognition tests completed";
 }
 
+/**
+ * @brief Test asynchronous OCR recognition
+ */
+TEST_F(TestDOCRRecognition, asyncRecognition)
+{
+    qDebug() << "Testing DOCRRecognition asynchronous recognition";
+    
+    QByteArray imageData = getEmbeddedImageData();
+    ASSERT_FALSE(imageData.isEmpty());
+    
+    // Test: Empty data is rejected without dispatching
+    EXPECT_EQ(ocrRec->recognizeImageAsync(QByteArray(), nullptr), 0u);
+    EXPECT_NE(ocrRec->lastError().getErrorCode(), NoError);
+    
+    // Test: Completion callback delivers the result
+    bool called = false;
+    quint64 requestId = ocrRec->recognizeImageAsync(imageData, [&](const QString &result, const DTK_CORE_NAMESPACE::DError &error) {
+        called = true;
+        qDebug() << "Async recognition result:" << result << "error:" << error.getErrorCode();
+    });
+    
+    if (requestId) {
+        EXPECT_TRUE(QTest::qWaitFor([&]() { return called; }, 35000)) << "Callback should be invoked";
+    } else {
+        qDebug() << "AI daemon not available - skipping async reply check";
+    }
+    
+    qDebug() << "Async recognition tests completed";
+}
+
 /**
  * @brief Test region-based OCR recognition
  */